@@ -15,6 +15,10 @@
 #include "Titan/Scene.h"
 //include the asset manager class
 #include "Titan/AssetSystem.h"
+//include the job system class
+#include "Titan/JobSystem.h"
+//include the profiler class
+#include "Titan/Profiler.h"
 //include glfw
 #include <GLFW/glfw3.h>
  
@@ -11,6 +11,8 @@
 #include "ObjLoader.h"
 #include "Shader.h"
 #include "Material.h"
+//include the job system for the background loading threads
+#include "JobSystem.h"
 
 namespace Titan {
 	//class to control all the assets in any given project
@@ -60,18 +62,37 @@ namespace Titan {
 		static TTN_Material::smatptr GetMaterial(std::string accessName);
 
 		//functions to load a set of assets
-		//loads all the assets in a set without breaking
+		//loads all the assets in a set without breaking, the files are still read and decoded across the worker threads
 		static void LoadSetNow(int set);
-		//loads a set in the background, if a set is already being loaded, then it adds the new set to a loading queue 
-		static void LoadSetInBackground(int set);
+		//loads a set in the background, the files are read and decoded on worker threads and only the opengl uploads happen on the main
+		//thread (within the upload budget each frame), sets with a higher priority are loaded first, if the set is already loading this
+		//just changes it's priority
+		static void LoadSetInBackground(int set, int priority = 0);
+		//stops loading a set in the background, assets from the set that have already been uploaded stay in the system
+		static void CancelSet(int set);
+		//changes the priority of a set that is loading in the background
+		static void SetSetPriority(int set, int priority);
 
 		//update function called from TTN_Application, the function that acutally executes on the loading in the background
 		static void Update();
 
+		//sets the number of milliseconds each frame can spend uploading background assets to opengl (atleast one asset is always
+		//uploaded each frame that has one ready, so a single big asset can still go over)
+		static void SetUploadBudget(float milliseconds) { s_uploadBudget = milliseconds; }
+		//gets the number of milliseconds each frame can spend uploading background assets
+		static float GetUploadBudget() { return s_uploadBudget; }
+		//sets the maximum number of assets being read and decoded on the worker threads at once, 0 uses half the workers
+		static void SetMaxBackgroundLoads(size_t maxLoads) { s_maxInFlight = maxLoads; }
+
 		//gets the number for the current set being loaded, or the set that has finished loading on the frame it was called, returns -1 if no set is being loaded
+		//if multiple sets are loading it returns the one with the highest priority
 		static int GetCurrentSet();
-		//gets whether the system finished loading a set this frame
+		//gets whether the system has finished loading a set
 		static bool GetSetLoaded(int set) { return s_setsLoaded[set]; }
+		//gets wheter or not a set is currently loading in the background
+		static bool GetSetLoading(int set);
+		//gets how much of a set has loaded, from 0 to 1
+		static float GetSetProgress(int set);
 
 	private:
 		//structures for storing asset loading data
@@ -125,16 +146,99 @@ namespace Titan {
 			}
 		};
 
+		//the types of assets a set can load
+		enum class AssetType {
+			TEXTURE_2D,
+			CUBEMAP,
+			MESH,
+			ANIMATED_MESH,
+			SHADER,
+			DEFAULT_SHADER
+		};
+
+		//a single asset being loaded, the files and names are copied in so the worker threads never touch the lists of assets to load
+		struct LoadRequest {
+			//the set it belongs to, and the generation of that set it was made in (cancelling a set moves it onto a new generation)
+			int m_set;
+			unsigned m_generation;
+			//the order it was queued in, so requests with the same priority load in the order they were added
+			uint64_t m_order;
+			//what to load
+			AssetType m_type;
+			std::string m_AccessName;
+			std::string m_FileName;
+			std::string m_SecondFileName;
+			int m_number;
+			TTN_DefaultShaders m_vertDefault;
+			TTN_DefaultShaders m_fragDefault;
+
+			//the data loaded on the worker thread, ready to be uploaded
+			TTN_Texture2DData::st2ddptr m_textureData;
+			TTN_TextureCubeMapData::stcmdptr m_cubemapData;
+			TTN_ObjMeshData m_meshData;
+			std::string m_vertSource;
+			std::string m_fragSource;
+			//wheter or not loading it failed, and why
+			bool m_failed = false;
+			std::string m_error;
+		};
+		typedef std::shared_ptr<LoadRequest> slrptr;
+
+		//the loading state of a set
+		struct SetLoadState {
+			int m_priority = 0;
+			unsigned m_generation = 0;
+			size_t m_total = 0;
+			size_t m_finished = 0;
+			bool m_loading = false;
+		};
+
+		//makes the requests for every asset in a set and queues them
+		static void QueueSet(int set);
+		//marks a request as finished, finishing the set if it was the last one
+		static void FinishRequest(int set);
+		//sorts the pending requests so the highest priority ones are at the front
+		static void SortPendingRequests();
+		//sends pending requests to the worker threads until the maximum number are loading
+		static void DispatchRequests(size_t maxInFlight);
+		//reads and decodes the files for a request, run on a worker thread
+		static void LoadRequestData(LoadRequest& request);
+		//uploads the completed requests to opengl, stopping once the budget (in milliseconds) has been used
+		static void UploadCompletedRequests(float budget);
+		//creates the asset from a completed request and stores it, run on the main thread
+		static void UploadRequest(LoadRequest& request);
+
 	private:
-		//the current loading queue
+		//the sets currently loading, with the highest priority first
 		inline static std::vector<int> s_loadQueue = std::vector<int>();
 		//sets that have been loaded
 		inline static std::unordered_map<int, bool> s_setsLoaded = std::unordered_map<int, bool>();
-		//the index of where the loader in it's current set of assets 
-		inline static int s_CurrentAssetType = 0; //0 = 2D textures, 1 = cubemaps, 2 = non animated mesh, 3 = animated mesh, 4 = non-default shader, 5 = default shader
-		inline static int s_CurrentAssetIndex = -1;
-		//boolean that says it's finished loading a set on this frame
-		inline static bool s_FinishedLoadingSet = false;
+		//the loading state of each set
+		inline static std::unordered_map<int, SetLoadState> s_setStates = std::unordered_map<int, SetLoadState>();
+		//the sets that finished loading during the last update
+		inline static std::vector<int> s_finishedSets = std::vector<int>();
+
+		//requests waiting to be sent to the worker threads
+		inline static std::deque<slrptr> s_pendingRequests = std::deque<slrptr>();
+		//wheter or not the pending requests need to be sorted again
+		inline static bool s_pendingDirty = false;
+		//requests the worker threads have finished, waiting to be uploaded
+		inline static std::vector<slrptr> s_completedRequests = std::vector<slrptr>();
+		//mutex protecting the completed requests, and the condition variable signaled when one is added
+		inline static std::mutex s_completedMutex;
+		inline static std::condition_variable s_completedSignal;
+		//requests taken from the completed list that haven't been uploaded yet
+		inline static std::deque<slrptr> s_uploadQueue = std::deque<slrptr>();
+		//the number of requests that have been sent to the workers and not uploaded yet
+		inline static size_t s_inFlight = 0;
+		//the maximum number of requests loading at once, 0 uses half the workers
+		inline static size_t s_maxInFlight = 0;
+		//counter used to order the requests
+		inline static uint64_t s_requestCounter = 0;
+		//the time each frame can spend uploading, in milliseconds
+		inline static float s_uploadBudget = 4.0f;
+		//staging buffer the textures are uploaded through
+		inline static TTN_PixelUnpackBuffer::spubptr s_stagingBuffer = nullptr;
 
 		//the map of vector of strings for 2D textures to load
 		inline static std::unordered_map<int, std::vector<AccessAndFileName>> s_2DTexturesToLoad = std::unordered_map<int, std::vector<AccessAndFileName>>();
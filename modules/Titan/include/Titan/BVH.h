@@ -0,0 +1,123 @@
+//Titan Engine, by Atlas X Games
+// BVH.h - header for the dynamic bounding volume hierarchy used to quickly find which objects are inside a volume
+#pragma once
+
+//precompile header, this file uses vector and GLM/glm.hpp
+#include "ttn_pch.h"
+
+namespace Titan {
+	//axis aligned bounding box
+	struct TTN_AABB {
+		glm::vec3 min;
+		glm::vec3 max;
+
+		//gets the center and half size of the box
+		glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+		glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+		//gets the surface area of the box, used as the cost of a node when building the tree
+		float GetSurfaceArea() const {
+			glm::vec3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+		//gets wheter or not this box fully contains another
+		bool Contains(const TTN_AABB& other) const {
+			return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+		}
+
+		//gets the box around two boxes
+		static TTN_AABB Union(const TTN_AABB& a, const TTN_AABB& b) {
+			return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+		}
+		//transforms a box, returning a new axis aligned box around the result
+		static TTN_AABB Transform(const TTN_AABB& box, const glm::mat4& matrix);
+	};
+
+	//view frustum, stored as 6 planes facing inwards (xyz normal, w distance)
+	struct TTN_Frustum {
+		glm::vec4 planes[6];
+
+		//extracts the planes from a view projection matrix
+		static TTN_Frustum FromMatrix(const glm::mat4& viewProjection);
+
+		//results of testing a box against the frustum
+		enum class TestResult {
+			OUTSIDE = 0,
+			INTERSECTING = 1,
+			INSIDE = 2
+		};
+		//tests a box against the frustum
+		TestResult Test(const TTN_AABB& box) const;
+	};
+
+	//dynamic bounding volume hierarchy, a binary tree of boxes where each leaf is an object (a proxy), the leaves are stored
+	//slightly larger than the objects so small movements don't require the tree to be changed
+	class TTN_BVH {
+	public:
+		//constructor, margin is how much larger than the object the leaf boxes are
+		TTN_BVH(float margin = 0.1f);
+
+		//adds an object to the tree, returning the id of it's proxy
+		int CreateProxy(const TTN_AABB& box, uint32_t userData);
+		//removes an object from the tree
+		void DestroyProxy(int proxy);
+		//moves an object, refitting the tree if it has left it's leaf's box, returns true if the tree changed
+		bool MoveProxy(int proxy, const TTN_AABB& box);
+
+		//gets the user data of a proxy
+		uint32_t GetUserData(int proxy) const { return m_nodes[proxy].userData; }
+		//gets the (enlarged) box of a proxy
+		const TTN_AABB& GetFatAABB(int proxy) const { return m_nodes[proxy].box; }
+
+		//finds every object whose box is inside or touching the frustum, adding their user data to results, returns the number
+		//of nodes that had to be tested
+		size_t QueryFrustum(const TTN_Frustum& frustum, std::vector<uint32_t>& results) const;
+
+		//gets the number of objects in the tree
+		size_t GetProxyCount() const { return m_proxyCount; }
+		//gets the height of the tree
+		int GetHeight() const { return (m_root == -1) ? 0 : m_nodes[m_root].height; }
+
+	private:
+		//a node in the tree, leaves have no children
+		struct Node {
+			TTN_AABB box;
+			uint32_t userData;
+			//the parent for nodes in the tree, the next free node for nodes on the free list
+			int parent;
+			int child1;
+			int child2;
+			//height of the node, leaves are 0, free nodes are -1
+			int height;
+
+			bool IsLeaf() const { return child1 == -1; }
+		};
+
+		//gets a node from the free list, growing the pool if it's empty
+		int AllocateNode();
+		//returns a node to the free list
+		void FreeNode(int node);
+
+		//inserts a leaf into the tree, picking the sibling that makes the tree's surface area grow the least
+		void InsertLeaf(int leaf);
+		//removes a leaf from the tree
+		void RemoveLeaf(int leaf);
+		//rotates the tree around a node if it's unbalanced, returning the node now in it's place
+		int Balance(int node);
+		//walks up from a node refitting the boxes and heights
+		void Refit(int node);
+
+		//adds the user data of every leaf under a node
+		void CollectLeaves(int node, std::vector<uint32_t>& results) const;
+
+		//the nodes
+		std::vector<Node> m_nodes;
+		//the root of the tree, -1 if the tree is empty
+		int m_root;
+		//the first node on the free list
+		int m_freeList;
+		//the number of objects in the tree
+		size_t m_proxyCount;
+		//how much larger the leaf boxes are than the objects
+		float m_margin;
+	};
+}
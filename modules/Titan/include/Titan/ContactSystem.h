@@ -0,0 +1,100 @@
+//Titan Engine, by Atlas X Games
+// ContactSystem.h - header for the class that tracks which physics bodies are touching and when they start and stop touching
+#pragma once
+
+//precompile header, this file uses entt.hpp, vector, and GLM/glm.hpp
+#include "ttn_pch.h"
+//include the span so the contacts can be read without copying them
+#include "Span.h"
+
+//import the bullet physics engine
+#include <btBulletDynamicsCommon.h>
+
+namespace Titan {
+	//the kind of event a contact pair represents
+	enum class TTN_ContactEvent {
+		BEGIN = 0, //the bodies started touching this step
+		STAY = 1, //the bodies were already touching and still are
+		END = 2 //the bodies were touching last step and no longer are
+	};
+
+	//a single point of contact between two bodies
+	struct TTN_ContactPoint {
+		//the world space position of the contact on each body
+		glm::vec3 positionOnBody1;
+		glm::vec3 positionOnBody2;
+		//the world space contact normal, pointing from body 2 towards body 1
+		glm::vec3 normal;
+		//how far the bodies are overlapping (negative when they are penetrating)
+		float distance;
+		//the impulse the solver applied at the point to push the bodies apart
+		float impulse;
+	};
+
+	//a pair of bodies that are (or just stopped) touching, body1 is always the lower entity number so each pair only appears once
+	struct TTN_ContactPair {
+		//the entities of the bodies
+		entt::entity body1;
+		entt::entity body2;
+		//what happened to the pair this step
+		TTN_ContactEvent event;
+		//the range of the pair's points in the contact point array, ended pairs have no points
+		uint32_t firstPoint;
+		uint32_t numOfPoints;
+	};
+
+	//contact system class, reads bullet's contact manifolds after each step into flat arrays of pairs and points that are reused
+	//every frame, and compares the pairs against the previous frame's to work out which began, stayed, or ended
+	class TTN_ContactSystem {
+	public:
+		//constructor
+		TTN_ContactSystem() = default;
+
+		//ensure moving and copying is not allowed as the spans handed out point into the system
+		TTN_ContactSystem(const TTN_ContactSystem& other) = delete;
+		TTN_ContactSystem(TTN_ContactSystem&& other) = delete;
+		TTN_ContactSystem& operator=(const TTN_ContactSystem& other) = delete;
+		TTN_ContactSystem& operator=(TTN_ContactSystem&& other) = delete;
+
+		//rebuilds the contact pairs and points from the dispatcher's manifolds, should be called once after each simulation step
+		void Update(btDispatcher* dispatcher);
+
+		//forgets all the pairs without emitting end events for them, used when the physics world is torn down
+		void Clear();
+
+		//gets every pair that began, stayed, or ended in the last update, sorted by their entities, the entities of ended pairs
+		//may have been deleted since so their validity should be checked before they are used
+		TTN_Span<const TTN_ContactPair> GetPairs() const { return TTN_Span<const TTN_ContactPair>(m_pairs.data(), m_pairs.size()); }
+		//gets every contact point from the last update
+		TTN_Span<const TTN_ContactPoint> GetPoints() const { return TTN_Span<const TTN_ContactPoint>(m_points.data(), m_points.size()); }
+		//gets the contact points of a single pair
+		TTN_Span<const TTN_ContactPoint> GetPoints(const TTN_ContactPair& pair) const {
+			return TTN_Span<const TTN_ContactPoint>(m_points.data() + pair.firstPoint, pair.numOfPoints);
+		}
+
+		//makes the key a pair of entities is tracked by, the lower entity number goes in the high bits so the key is the same
+		//regardless of the order the bodies are passed in
+		static uint64_t MakePairKey(entt::entity a, entt::entity b);
+
+	private:
+		//a manifold that has at least one touching point, tagged with the key of it's pair so they can be grouped
+		struct ManifoldEntry {
+			uint64_t key;
+			int index;
+			//wheter or not body 0 of the manifold is the higher entity, in which case it's points need to be flipped
+			bool swapped;
+		};
+
+		//appends a pair to the output
+		void AddPair(uint64_t key, TTN_ContactEvent event, uint32_t firstPoint, uint32_t numOfPoints);
+
+		//the touching manifolds found this update, kept to avoid reallocating it every frame
+		std::vector<ManifoldEntry> m_manifolds;
+		//the sorted keys of the pairs touching in the last update, and the ones being built this update
+		std::vector<uint64_t> m_touchingKeys;
+		std::vector<uint64_t> m_previousKeys;
+		//the pairs and points handed out
+		std::vector<TTN_ContactPair> m_pairs;
+		std::vector<TTN_ContactPoint> m_points;
+	};
+}
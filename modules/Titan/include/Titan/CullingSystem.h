@@ -0,0 +1,95 @@
+//Titan Engine, by Atlas X Games
+// CullingSystem.h - header for the class that keeps the renderers of a scene in a bvh and finds which ones the camera can see
+#pragma once
+
+//precompile header, this file uses entt.hpp, vector, and GLM/glm.hpp
+#include "ttn_pch.h"
+//include the bvh and the components it needs
+#include "BVH.h"
+#include "Transform.h"
+#include "Renderer.h"
+
+namespace Titan {
+	//component the culling system attaches to every entity with a renderer, tracking it's proxy in the bvh
+	struct TTN_CullProxy {
+		//the proxy in the bvh, -1 if it isn't in the tree
+		int proxy = -1;
+		//wheter or not it's always drawn (skyboxes, which don't use their transform)
+		bool alwaysVisible = false;
+		//what the bounds were last calculated from, so they can be recalculated if the renderer changes
+		const TTN_Mesh* mesh = nullptr;
+		const TTN_Shader* shader = nullptr;
+		const TTN_Material* material = nullptr;
+		uint32_t materialVersion = 0;
+	};
+
+	//counters from the last cull
+	struct TTN_CullingStats {
+		//the number of renderers in the scene
+		size_t objects = 0;
+		//the number that were visible and drawn
+		size_t visible = 0;
+		//the number that were outside the frustum and skipped
+		size_t culled = 0;
+		//the number of bvh nodes that were tested against the frustum
+		size_t nodesTested = 0;
+	};
+
+	//culling system class, keeps a dynamic bvh of the world space bounds of every renderer in the scene, refitting it as things
+	//move, so the visible set can be found without testing every object
+	class TTN_CullingSystem {
+	public:
+		//constructor, hooks into the registry so proxies get removed from the tree with their entities
+		TTN_CullingSystem(entt::registry* registry);
+
+		//destructor, unhooks from the registry
+		~TTN_CullingSystem();
+
+		//ensure moving and copying is not allowed as the registry holds a reference to the system
+		TTN_CullingSystem(const TTN_CullingSystem& other) = delete;
+		TTN_CullingSystem(TTN_CullingSystem& other) = delete;
+		TTN_CullingSystem& operator=(const TTN_CullingSystem& other) = delete;
+		TTN_CullingSystem& operator=(TTN_CullingSystem&& other) = delete;
+
+		//brings the bvh up to date, adding new renderers, removing old ones, and refitting the ones that moved, should be called
+		//after the transforms have been resolved
+		void Update(const std::vector<entt::entity>& movedEntities);
+
+		//finds every renderer that the view projection matrix can see
+		void Cull(const glm::mat4& viewProjection, std::vector<entt::entity>& visible);
+
+		//gets the counters from the last cull
+		const TTN_CullingStats& GetStats() const { return m_stats; }
+
+	private:
+		//calculates the world space bounds of a renderer
+		TTN_AABB CalculateBounds(TTN_Transform& transform, TTN_Renderer& renderer);
+		//adds an entity's proxy to the tree (or the always visible list)
+		void InsertProxy(entt::entity entity, TTN_CullProxy& proxy, TTN_Transform& transform, TTN_Renderer& renderer);
+		//removes an entity's proxy from the tree (or the always visible list)
+		void RemoveProxy(entt::entity entity, TTN_CullProxy& proxy);
+
+		//recalculates the bounds of a proxy if the renderer's mesh, shader, or material (or the material's height influence) changed
+		void RefreshProxy(entt::entity entity, TTN_CullProxy& proxy, TTN_Transform& transform, TTN_Renderer& renderer);
+
+		//registry callbacks
+		void OnProxyDestroyed(entt::registry& registry, entt::entity entity);
+		void OnRendererReplaced(entt::registry& registry, entt::entity entity);
+
+		//the registry the renderers live in
+		entt::registry* m_registry;
+		//the tree
+		TTN_BVH m_bvh;
+		//entities that skip the tree and are always drawn
+		std::vector<entt::entity> m_alwaysVisible;
+		//buffer the results of the bvh query are written into, kept to avoid reallocating it every frame
+		std::vector<uint32_t> m_queryResults;
+		//counters from the last cull
+		TTN_CullingStats m_stats;
+		//entities whose renderers were replaced since the last update
+		std::vector<entt::entity> m_replacedRenderers;
+		//the renderer and material change counts as of the last update, the proxies only need checking when they've changed
+		uint64_t m_rendererChanges;
+		uint64_t m_materialChanges;
+	};
+}
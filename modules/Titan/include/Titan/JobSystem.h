@@ -0,0 +1,60 @@
+//Titan Engine, by Atlas X Games
+// JobSystem.h - header for the class that manages the worker threads used to split work across the cpu cores
+#pragma once
+
+//precompile header, this file uses vector and functional
+#include "ttn_pch.h"
+//standard threading headers
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+namespace Titan {
+	//job system class, owns a pool of worker threads that jobs can be pushed onto
+	class TTN_JobSystem {
+	public:
+		//starts the worker threads, 0 uses one less than the number of hardware threads (the main thread is the last one),
+		//called by titan's application init but will also be called automatically the first time a job is pushed
+		static void Init(unsigned numOfWorkers = 0);
+
+		//finishes any remaining jobs (dropping background jobs that haven't started) and joins the worker threads, called by titan's application closing
+		static void Shutdown();
+
+		//pushes a single job onto the queue, it will be run on whichever worker picks it up first
+		static void Submit(std::function<void()> job);
+
+		//pushes a long running job (like loading a file) onto the background queue, background jobs are only run by the workers when
+		//there are no regular jobs waiting, and never by a thread helping out in ParallelFor, so they can't stall the main thread
+		static void SubmitBackground(std::function<void()> job);
+
+		//splits the range [0, count) into chunks of at least minChunkSize and runs the function on each chunk
+		//(function(begin, end)) across the workers, the calling thread helps out and the function only returns once every chunk is done
+		static void ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t)>& function);
+
+		//gets the number of worker threads
+		static unsigned GetWorkerCount() { return (unsigned)s_workers.size(); }
+
+	private:
+		//the loop each worker thread runs
+		static void WorkerLoop();
+
+		//tries to pop a job off the queue and run it on the calling thread, returns false if the queue was empty
+		static bool RunPendingJob();
+
+		//worker threads
+		inline static std::vector<std::thread> s_workers;
+		//queue of jobs waiting to be run
+		inline static std::deque<std::function<void()>> s_jobs;
+		//queue of background jobs waiting to be run
+		inline static std::deque<std::function<void()>> s_backgroundJobs;
+		//mutex protecting the queue
+		inline static std::mutex s_mutex;
+		//condition variable the workers sleep on when there's nothing to do
+		inline static std::condition_variable s_wake;
+		//flag telling the workers to exit
+		inline static bool s_stopping = false;
+	};
+}
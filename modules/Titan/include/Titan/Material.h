@@ -5,6 +5,8 @@
 //include texture class
 #include "Texture2D.h"
 #include "TextureCubeMap.h"
+//include the uniform buffer class
+#include "UniformBuffer.h"
 
 namespace Titan {
 	//class for materials on 3D objects
@@ -47,7 +49,31 @@ namespace Titan {
 		TTN_Texture2D::st2dptr GetHeightMap() { return m_HeightMap; }
 		float GetHeightInfluence() { return m_HeightInfluence; }
 
+		//gets a number that changes whenever something that affects the bounds of the objects using the material (the height
+		//influence) changes, and the same for every material, so the culling system knows when it needs to refit anything
+		uint32_t GetBoundsVersion() const { return m_BoundsVersion; }
+		static uint64_t GetBoundsChangeCount() { return s_BoundsChangeCount; }
+
+		//binds the material's uniform block so the default shaders can read it
+		void BindUniforms();
+		//binds the uniform block used for objects without a material
+		static void BindDefaultUniforms();
+
 	private:
+		//the material's uniform block, laid out with std140 to match TTN_MaterialData in the default shaders
+		struct MaterialData {
+			float shininess;
+			float heightInfluence;
+			float padding[2];
+		};
+		//uniform buffer with the material data, updated whenever it's changed
+		TTN_UniformBuffer::subptr m_Ubo;
+		//uniform buffer for objects without a material
+		inline static TTN_UniformBuffer::subptr s_DefaultUbo = nullptr;
+
+		//sends the current material data to the uniform buffer
+		void UpdateUniforms();
+
 		//albedo 
 		TTN_Texture2D::st2dptr m_Albedo;
 		//specular
@@ -59,5 +85,9 @@ namespace Titan {
 		//texture for displacement mapping
 		TTN_Texture2D::st2dptr m_HeightMap;
 		float m_HeightInfluence;
+
+		//bounds change counters, for this material and for every material
+		uint32_t m_BoundsVersion = 0;
+		inline static uint64_t s_BoundsChangeCount = 0;
 	};
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "ttn_pch.h"
 //include the opengl wrap around classes
 #include "VertexArrayObject.h"
+#include "ShaderStorageBuffer.h"
 
 
 namespace Titan {
@@ -34,8 +35,20 @@ namespace Titan {
 		//destructor
 		~TTN_Mesh();
 
+		//the shader storage binding the morph buffer is read from by the default morph animation shaders
+		static const GLuint s_morphBufferBinding = 6;
+
 		//sets up the VAO for the mesh so it can acutally be rendered, called by the user (as they may change details of the mesh)
+		//does nothing if the VAO is already set up with the same frames and the mesh hasn't changed since
 		void SetUpVao(int currentFrame = 0, int nextFrame = 0);
+		//gets a VAO set up with the given frames, for drawing entities on their own frames without setting up the main VAO again,
+		//each pair of frames gets it's own VAO that's kept until the mesh changes
+		const TTN_VertexArrayObject::svaptr& GetMorphVao(int currentFrame, int nextFrame);
+
+		//sets an instance buffer that gets added to the VAO along with the mesh data, so the mesh can be drawn instanced
+		void SetInstanceBuffer(const TTN_VertexBuffer::svbptr& instanceBuffer, const std::vector<BufferAttribute>& attributes);
+		//gets the instance buffer on the VAO
+		const TTN_VertexBuffer::svbptr& GetInstanceBuffer() const { return m_instanceVbo; }
 
 		//SETTERS 
 		//sets the list of uvs for the mesh
@@ -48,12 +61,22 @@ namespace Titan {
 		void AddVertices(std::vector<glm::vec3>& verts);
 		//adds a new set of normals to the class and creates a new vbo for them
 		void AddNormals(std::vector<glm::vec3>& norms);
+		//sets the triangle indices of the mesh and creates an ibo for them, every morph frame shares the same indices
+		void SetIndices(std::vector<uint32_t>& indices);
+		//sets every morph frame of the mesh at once, packing them straight into the morph buffer, only the first frame gets vbos
+		//(the others are only created if the VAO is set up with them)
+		void SetMorphFrames(std::vector<std::vector<glm::vec3>>& positions, std::vector<std::vector<glm::vec3>>& normals);
 
 		//GETTERS
 		//Gets the pointer to the meshes vao
 		TTN_VertexArrayObject::svaptr GetVAOPointer();
 		//Gets the number of the vertices in the mesh
 		int GetVertCount() { return m_Vertices[0].size(); }
+		//Gets the number of morph frames in the mesh
+		int GetNumOfFrames() const { return (int)m_Vertices.size(); }
+		//Gets the buffer with the positions and normals of every morph frame packed into it, so the morph shaders can read whichever
+		//frames each instance is on, packs it first if the frames have changed since it was last packed
+		const TTN_ShaderStorageBuffer::sssbptr& GetMorphBuffer();
 		//Gets wheter or not the mesh has vertex colors
 		bool GetHasVertColors() { return m_HasVertColors; }
 		//Gets a list of the vertex position
@@ -62,6 +85,16 @@ namespace Titan {
 		std::vector<glm::vec3> GetVertexNormals() { return m_Normals[0]; }
 		//Gets a list of the uvs
 		std::vector<glm::vec2> GetVertexUvs() { return m_Uvs; }
+		//Gets wheter or not the mesh is drawn with an index buffer
+		bool GetIsIndexed() const { return m_ibo != nullptr; }
+		//Gets the triangle indices of the mesh (empty if it isn't indexed)
+		const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+		//Gets the number of vertices that get drawn, the index count for indexed meshes and the vertex count otherwise
+		int GetDrawCount() { return GetIsIndexed() ? (int)m_Indices.size() : GetVertCount(); }
+		//Gets the corners of the local space bounding box around every frame of the mesh
+		//(a mesh without any vertices gets an empty box at the origin)
+		glm::vec3 GetBoundsMin() const { return (m_boundsMin.x <= m_boundsMax.x) ? m_boundsMin : glm::vec3(0.0f); }
+		glm::vec3 GetBoundsMax() const { return (m_boundsMin.x <= m_boundsMax.x) ? m_boundsMax : glm::vec3(0.0f); }
 
 	protected:
 		//a vector containing all the vertices on the mesh 
@@ -72,15 +105,47 @@ namespace Titan {
 		std::vector<glm::vec2> m_Uvs;
 		//a vector containing all the vertex colors
 		std::vector<glm::vec3> m_Colors;
+		//a vector containing the triangle indices, shared by every frame
+		std::vector<uint32_t> m_Indices;
 		//a boolean for if the mesh has colors
 		bool m_HasVertColors;
+		//the local space bounding box, grown as vertices are added so it covers every morph frame
+		glm::vec3 m_boundsMin;
+		glm::vec3 m_boundsMax;
 
 		//vbo smart pointers
 		std::vector<TTN_VertexBuffer::svbptr> m_vertVbos;
 		std::vector<TTN_VertexBuffer::svbptr> m_normVbos;
 		TTN_VertexBuffer::svbptr m_UVsVbo;
 		TTN_VertexBuffer::svbptr m_ColVbo;
+		//ibo smart pointer, null if the mesh isn't indexed
+		TTN_IndexBuffer::sibptr m_ibo;
 		//smart pointer with the VAO for the mesh 
 		TTN_VertexArrayObject::svaptr m_vao;
+
+		//instance buffer and it's attributes, added to the VAO after the mesh data
+		TTN_VertexBuffer::svbptr m_instanceVbo;
+		std::vector<BufferAttribute> m_instanceAttributes;
+
+		//the packed morph frames, a position and normal vec4 for each vertex of each frame, and wheter or not they need to be packed again
+		TTN_ShaderStorageBuffer::sssbptr m_morphBuffer;
+		bool m_morphDirty;
+
+		//creates the vbos for a frame if it doesn't have them yet
+		void CreateFrameVbos(int frame);
+		//packs the morph frames into the morph buffer
+		void PackMorphFrames();
+		//loads the mesh's buffers into a vao with the given frames
+		void FillVao(const TTN_VertexArrayObject::svaptr& vao, int currentFrame, int nextFrame);
+
+		//the frames the VAO was last set up with, and wheter or not it needs to be set up again regardless
+		int m_vaoCurrentFrame;
+		int m_vaoNextFrame;
+		bool m_vaoDirty;
+
+		//the VAOs set up with other pairs of frames, keyed by the current frame in the high bits and the next frame in the low bits,
+		//and wheter or not the mesh has changed since they were set up
+		std::unordered_map<uint64_t, TTN_VertexArrayObject::svaptr> m_morphVaos;
+		bool m_morphVaosDirty;
 	};
 }
\ No newline at end of file
@@ -1,21 +1,47 @@
 //Titan Engine, by Atlas X Games
-//ObjLoader.h - header file for the class that parses OBJ files into TTN_Models 
+//ObjLoader.h - header file for the class that parses OBJ files into TTN_Models
 #pragma once
 
-//include the mesh class so we write the data to it 
+//include the mesh class so we write the data to it
 #include "Mesh.h"
 
 namespace Titan {
-	
+
+	//the cpu side data loaded from obj files (or their cache), it doesn't touch opengl so it can be loaded on any thread and then turned
+	//into a mesh on the main thread
+	struct TTN_ObjMeshData {
+		//the positions and normals of the vertices, one set for each morph frame
+		std::vector<std::vector<glm::vec3>> positions;
+		std::vector<std::vector<glm::vec3>> normals;
+		//the uvs of the vertices, shared by every frame
+		std::vector<glm::vec2> uvs;
+		//the triangle indices, shared by every frame
+		std::vector<uint32_t> indices;
+	};
+
 	//class to parse ObjFiles into TTN_Model objects
+	//the files are memory mapped and parsed without any per line allocations, vertices that share the same position, uv, and normal are
+	//merged into an indexed mesh, and the result is saved to a binary .ttnmesh cache beside the obj so later loads can just copy it in
 	class TTN_ObjLoader {
 	public:
-		static TTN_Mesh::smptr LoadFromFile(const std::string& fileName);
+		//loads a mesh from an obj file
+		static TTN_Mesh::smptr LoadFromFile(const std::string& fileName, bool useCache = true);
+
+		//loads a series of obj files as the morph target frames of a single mesh, the files should be named fileName_1.obj, fileName_2.obj, etc.
+		static TTN_Mesh::smptr LoadAnimatedMeshFromFiles(const std::string& fileName, int numOfFiles, bool useCache = true);
+
+		//loads the data for a mesh from an obj file without creating the mesh
+		static void LoadDataFromFile(const std::string& fileName, TTN_ObjMeshData& data, bool useCache = true);
+		//loads the data for a morph target animated mesh from a series of obj files without creating the mesh
+		static void LoadAnimatedDataFromFiles(const std::string& fileName, int numOfFiles, TTN_ObjMeshData& data, bool useCache = true);
+		//creates a mesh from loaded data, uploading it to opengl, should be called on the main thread
+		static TTN_Mesh::smptr CreateMesh(TTN_ObjMeshData& data);
 
-		static TTN_Mesh::smptr LoadAnimatedMeshFromFiles(const std::string& fileName, int numOfFiles);
+		//the version of the binary cache format, caches with any other version are ignored and rewritten
+		static const uint32_t s_cacheVersion = 1;
 
 	protected:
 		TTN_ObjLoader() = default;
 		~TTN_ObjLoader() = default;
 	};
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #include "Titan/ObjLoader.h"
 #include "Titan/Renderer.h"
 #include "Titan/Random.h"
+#include "Titan/ShaderStorageBuffer.h"
 
 namespace Titan {
 	//enum for the particle emitter type
@@ -18,6 +19,12 @@ namespace Titan {
 		CUBE = 3
 	};
 
+	//enum for where a particle system's particles are simulated
+	enum class TTN_ParticleBackend {
+		CPU = 0, //simulated on the worker threads and streamed to the gpu each frame
+		GPU = 1 //simulated and drawn entirely on the gpu with compute shaders (requires OpenGL 4.3)
+	};
+
 	struct TTN_ParticleTemplate {
 		glm::vec4 _StartColor, _StartColor2;
 		glm::vec4 _EndColor, _EndColor2;
@@ -167,6 +174,8 @@ namespace Titan {
 		void SetEmissionRate(float emissionRate);
 		void SetEmitterRotation(glm::vec3 rotation);
 		void SetPaused(bool paused);
+		//sets where the particles are simulated, switching backends clears any living particles
+		void SetBackend(TTN_ParticleBackend backend);
 
 		//getters
 		float GetEmitterAngle() { return m_EmitterAngle; }
@@ -177,6 +186,10 @@ namespace Titan {
 		float GetEmissionRate() { return m_emissionRate; }
 		glm::vec3 GetEmitterRotation() { return glm::degrees(m_rotation); }
 		bool GetPaused() { return m_paused; }
+		TTN_ParticleBackend GetBackend() { return m_backend; }
+
+		//gets wheter or not the gpu backend can be used on this machine
+		static bool GetGPUBackendSupported();
 
 		//function pointer setters
 		void VelocityReadGraphCallback(float (*function)(float));
@@ -196,27 +209,103 @@ namespace Titan {
 		//emits that number of particles at that time
 		void Burst(size_t numOfParticles);
 
-	private:
-		//particle artibutes
-		glm::vec3* Positions;
-
-		glm::vec4* StartColors;
-		glm::vec4* EndColors;
+		//gets the number of particles currently alive, with the gpu backend this is the latest count the gpu has finished
+		//copying back (usually from a frame or two ago) so it never stalls waiting on the gpu
+		size_t GetActiveParticleCount();
 
-		glm::vec3* StartVelocities;
-		glm::vec3* EndVelocities;
-
-		float* StartScales;
-		float* EndScales;
-
-		float* timeAlive;
-		float* lifeTimes;
-		bool* Active;
-
-		//render data
-		glm::vec3* particle_pos;
-		glm::vec4* particle_col;
-		float* particle_scale;
+	private:
+		//particle artibutes, stored as a structure of arrays that is kept compacted so the first m_aliveCount elements are
+		//always the living particles
+		std::vector<glm::vec3> Positions;
+
+		std::vector<glm::vec4> StartColors;
+		std::vector<glm::vec4> EndColors;
+
+		std::vector<glm::vec3> StartVelocities;
+		std::vector<glm::vec3> EndVelocities;
+
+		std::vector<float> StartScales;
+		std::vector<float> EndScales;
+
+		std::vector<float> timeAlive;
+		std::vector<float> lifeTimes;
+		//flags set by the update chunks for particles that reached the end of their lifetime this frame
+		std::vector<uint8_t> Dead;
+
+		//render data for a single particle, interpolated during the update and written straight into the instance buffer
+		struct ParticleInstance {
+			glm::vec4 color;
+			glm::vec3 position;
+			float scale;
+		};
+
+		//the number of particles currently alive
+		size_t m_aliveCount;
+
+		//the readgraphs baked into lookup tables so the update doesn't need to call them for every particle
+		std::vector<float> m_veloGraph;
+		std::vector<float> m_colorGraph;
+		std::vector<float> m_scaleGraph;
+		//the number of samples in each baked readgraph
+		static const size_t s_readGraphSamples = 257;
+		//the minimum number of particles each update job handles
+		static const size_t s_updateChunkSize = 2048;
+
+		//gpu backend data
+		//the counters the compute shaders use, the first four members are the indirect draw command
+		struct GPUCounters {
+			GLuint vertexCount;
+			GLuint instanceCount;
+			GLuint firstVertex;
+			GLuint baseInstance;
+			GLuint aliveCount;
+			GLint deadCount;
+		};
+		//the size of a particle in the gpu particle buffer, must match the particle struct in the shaders
+		static const size_t s_gpuParticleSize = sizeof(glm::vec4) * 7;
+		//the number of threads in each compute shader work group
+		static const GLuint s_gpuWorkGroupSize = 64;
+		//where the particles are simulated
+		TTN_ParticleBackend m_backend;
+		//the particle states
+		TTN_ShaderStorageBuffer::sssbptr m_gpuParticles;
+		//the lists of living particle indices, one is updated while the other is filled with the survivors and drawn
+		TTN_ShaderStorageBuffer::sssbptr m_gpuAliveLists[2];
+		//the list of free particle indices
+		TTN_ShaderStorageBuffer::sssbptr m_gpuDeadList;
+		//the counters and indirect draw command
+		TTN_ShaderStorageBuffer::sssbptr m_gpuCounters;
+		//the baked readgraphs
+		TTN_ShaderStorageBuffer::sssbptr m_gpuReadGraphs;
+		//vao with just the mesh data, the instance data is read straight from the particle buffer
+		TTN_VertexArrayObject::svaptr m_gpuVao;
+		//which of the alive lists was filled by the last update (and is the one that gets drawn)
+		int m_gpuAliveList;
+		//the number of particles waiting to be emitted on the next update
+		size_t m_gpuPendingEmits;
+		//wheter or not the readgraphs have changed since they were last uploaded
+		bool m_gpuReadGraphsDirty;
+		//the number of frames of alive counts that can be waiting to be read back at once
+		static const size_t s_gpuCountReadbacks = 3;
+		//persistently mapped buffer the alive count is copied into each update, one slot per readback
+		GLuint m_gpuCountReadback;
+		GLuint* m_gpuCountData;
+		//fences for each slot, null when the slot isn't waiting on the gpu
+		GLsync m_gpuCountFences[s_gpuCountReadbacks];
+		//the slot the next update copies into
+		size_t m_gpuCountSlot;
+		//the latest alive count that was read back
+		size_t m_gpuActiveCount;
+		//the compute and rendering shaders for the gpu backend
+		inline static TTN_Shader::sshptr s_particleEmitProgram;
+		inline static TTN_Shader::sshptr s_particleUpdateProgram;
+		inline static TTN_Shader::sshptr s_particleGPUShaderProgram;
+		//precompiled uniforms for the emit program, slots match the order of EmitUniforms
+		enum EmitUniforms {
+			EMIT_COUNT = 0, EMIT_SEED, EMIT_SHAPE, EMIT_ANGLE, EMIT_SCALE, EMIT_ROTATION, EMIT_START_COLOR, EMIT_START_COLOR2,
+			EMIT_END_COLOR, EMIT_END_COLOR2, EMIT_START_SIZE, EMIT_END_SIZE, EMIT_START_SPEED, EMIT_END_SPEED, EMIT_LIFETIME
+		};
+		inline static TTN_UniformSet::susptr s_emitUniforms;
 
 		//setable system data
 		glm::vec3 m_rotation;
@@ -231,7 +320,6 @@ namespace Titan {
 		bool m_paused;
 
 		//other data
-		size_t m_activeParticleIndex;
 		float m_durationRemaining;		
 		size_t m_maxParticlesCount;
 		inline static TTN_Shader::sshptr s_particleShaderProgram;
@@ -240,9 +328,9 @@ namespace Titan {
 		TTN_VertexBuffer::svbptr VertexPosVBO;
 		TTN_VertexBuffer::svbptr VertexNormVBO;
 		TTN_VertexBuffer::svbptr VertexUVVBO;
-		TTN_VertexBuffer::svbptr ColorInstanceBuffer;
-		TTN_VertexBuffer::svbptr PositionInstanceBuffer;
-		TTN_VertexBuffer::svbptr ScaleInstanceBuffer;
+		TTN_VertexBuffer::svbptr InstanceBuffer;
+		//the number of vertices in the particle vbos
+		size_t m_meshVertexCount = 0;
 
 		//function pointers for lerp
 		float (*readGraphVelo)(float);
@@ -251,6 +339,30 @@ namespace Titan {
 		float (*readGraphScale)(float);
 
 		void SetUpRenderingStuff();
+		//loads the particle template's mesh into the particle vbos, expanding it into a plain triangle list if it is indexed
+		//(the gpu backend's indirect draw command is laid out for non-indexed draws)
+		void LoadParticleMesh();
+		//reserves the memory for all the particle data
+		void SetUpParticleData();
+		//samples a readgraph into a lookup table
+		static void BakeReadGraph(std::vector<float>& graph, float (*function)(float));
+		//ages the particles in the range [begin, end), flagging any that have reached the end of their lifetime
+		void AgeParticles(size_t begin, size_t end, float deltaTime);
+		//moves the particles in the range [begin, end) and writes their render data into the instance buffer
+		void UpdateParticles(size_t begin, size_t end, float deltaTime, ParticleInstance* instances);
+		//removes a particle by moving the last living particle into it's place
+		void KillParticle(size_t index);
+
+		//creates the buffers for the gpu backend
+		void SetUpGPUBackend();
+		//resets the gpu buffers so every particle is dead
+		void ResetGPUParticles();
+		//emits any pending particles and updates the living ones with the compute shaders
+		void UpdateGPU(float deltaTime);
+		//reads back any alive counts the gpu has finished copying, without waiting on the ones it hasn't
+		void ReadBackGPUCount();
+		//deletes the fences on any alive counts still waiting to be read back
+		void ClearGPUCountReadbacks();
 	};
 
 	//class for a particle system compomenet
@@ -12,6 +12,7 @@
 #include "Mesh.h"
 #include "Material.h"
 #include "Renderer.h"
+#include "ShapeCache.h"
 
 //import the bullet physics engine
 #include <btBulletDynamicsCommon.h>
@@ -23,15 +24,46 @@ namespace Titan {
 		KINEMATIC = 2
 	};
 
+	//motion state that bullet writes the (interpolated) transforms of moving bodies into, it records which entities bullet moved so
+	//the scene only has to copy those back into their transforms, sleeping bodies aren't written to so they cost nothing
+	class TTN_MotionState : public btDefaultMotionState {
+	public:
+		//constructor, starts the motion state at the given transform
+		TTN_MotionState(const btTransform& startTrans) : btDefaultMotionState(startTrans), m_entity(entt::null), m_movedList(nullptr) {}
+
+		//called by bullet whenever the body moves
+		void setWorldTransform(const btTransform& centerOfMassWorldTrans) override {
+			btDefaultMotionState::setWorldTransform(centerOfMassWorldTrans);
+			//let the scene know it's moved
+			if (m_movedList != nullptr)
+				m_movedList->push_back(m_entity);
+		}
+
+		//sets the entity that gets recorded when the body moves
+		void SetEntity(entt::entity entity) { m_entity = entity; }
+		//sets the list moved entities get recorded in, set by the scene when the body is added to it's world
+		void SetMovedList(std::vector<entt::entity>* movedList) { m_movedList = movedList; }
+
+	protected:
+		//the entity with the body
+		entt::entity m_entity;
+		//the list moved entities are recorded in
+		std::vector<entt::entity>* m_movedList;
+	};
+
 	class TTN_Physics
 	{
 	public:
 		//default constructor
 		TTN_Physics();
 
-		//contrustctor with data
+		//contrustctor with data, makes a box collider the size of the scale
 		TTN_Physics(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, entt::entity entityNum, TTN_PhysicsBodyType bodyType = TTN_PhysicsBodyType::DYNAMIC, float mass = 1.0f);
 
+		//contrustctor with data and a collider from the shape cache, the shape is used as is so it should already be the right size
+		TTN_Physics(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, entt::entity entityNum, TTN_ShapeCache::sshapeptr shape,
+			TTN_PhysicsBodyType bodyType = TTN_PhysicsBodyType::DYNAMIC, float mass = 1.0f);
+
 		~TTN_Physics();
 
 		//copy, move, and assingment constrcutors for ENTT
@@ -39,7 +71,7 @@ namespace Titan {
 		TTN_Physics(TTN_Physics&&) = default;
 		TTN_Physics& operator=(TTN_Physics&) = default;
 
-		//update function, keeps data up to date, call once a frame
+		//update function, copies the transform out of bullet, called by the scene whenever bullet moves the body
 		void Update(float deltaTime);
 
 		//getters
@@ -58,6 +90,8 @@ namespace Titan {
 		}
 		float GetMass() { return m_Mass; }
 		btRigidBody* GetRigidBody() { return m_body; }
+		const TTN_ShapeCache::sshapeptr& GetShape() { return m_shape; }
+		TTN_MotionState* GetMotionState() { return m_MotionState; }
 		bool GetIsInWorld() { return m_InWorld; }
 		glm::vec3 GetLinearVelocity();
 		glm::vec3 GetAngularVelocity();
@@ -89,62 +123,13 @@ namespace Titan {
 		//bullet data
 		float m_Mass; //mass of the object
 		bool m_hasGravity; //is the object affected by gravity
-		btCollisionShape* m_colShape; //the shape of it's collider, includes scale
+		TTN_ShapeCache::sshapeptr m_shape; //the shape of it's collider, includes scale, shared with every other body with the same collider
+		btCollisionShape* m_colShape; //raw pointer to that shape
 		btTransform m_bulletTrans;  //it's internal transform, does not include scale
-		btDefaultMotionState* m_MotionState; //motion state for it, need to extract the transform out of this every update if the body is dynamic
+		TTN_MotionState* m_MotionState; //motion state for it, bullet writes the transform of dynamic bodies into this as they move
 		btRigidBody* m_body; //rigidbody, acutally does the collision stuff, have to get the transform out of this every update if the body is static
 		bool m_InWorld; //boolean marking if it's been added to the bullet physics world yet, used to make sure that the physics body
 
 		entt::entity m_entity; //the entity number that gets stored as a void pointer in bullet so that it can be used to indentify the objects later
 	};
-
-	class TTN_Collision {
-	public:
-		//defines a special easier to use name for the shared(smart) pointer to the class
-		typedef std::shared_ptr<TTN_Collision> scolptr;
-
-		//creates and returns a shared(smart) pointer to the class
-		static inline scolptr Create() {
-			return std::make_shared<TTN_Collision>();
-		}
-	public:
-		//ensure moving and copying is not allowed so we can control destructor calls through pointers
-		TTN_Collision(const TTN_Collision& other) = delete;
-		TTN_Collision(TTN_Collision& other) = delete;
-		TTN_Collision& operator=(const TTN_Collision& other) = delete;
-		TTN_Collision& operator=(TTN_Collision&& other) = delete;
-
-	public:
-		//constructor
-		TTN_Collision();
-
-		//destructor
-		~TTN_Collision() = default;
-
-		//getters
-		const entt::entity GetBody1() { return b1; }
-		const entt::entity GetBody2() { return b2; }
-
-		//setters
-		void SetBody1(const entt::entity body);
-		void SetBody2(const entt::entity body);
-
-		//checks if two collisions pointers represent a collision between the same objects
-		static bool same(scolptr collision1, scolptr collision2) {
-			//compare the entity numbers
-			if ((collision1->b1 == collision2->b1 && collision1->b2 == collision2->b2) ||
-				(collision1->b1 == collision2->b2 && collision1->b2 == collision2->b1)) {
-				//if they match across the collisions, then return true
-				return true;
-			}
-			else
-				//otherwise return false
-				return false;
-		}
-
-	protected:
-		//rigidbodies for the colliding objects (which should also contain a reference to the entity)
-		entt::entity b1;
-		entt::entity b2;
-	};
 }
\ No newline at end of file
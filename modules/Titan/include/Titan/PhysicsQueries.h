@@ -0,0 +1,88 @@
+//Titan Engine, by Atlas X Games
+// PhysicsQueries.h - header for the class that runs batches of raycasts, sweeps, and overlap tests against a physics world
+#pragma once
+
+//precompile header, this file uses entt.hpp, vector, and GLM/glm.hpp
+#include "ttn_pch.h"
+//include the span for the query and result arrays, and the shape cache for the shapes sweeps and overlaps use
+#include "Span.h"
+#include "ShapeCache.h"
+
+//import the bullet physics engine
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+
+namespace Titan {
+	//a ray from one point to another
+	struct TTN_RaycastQuery {
+		glm::vec3 from = glm::vec3(0.0f);
+		glm::vec3 to = glm::vec3(0.0f);
+		//an entity the ray passes through, such as the one casting it
+		entt::entity ignore = entt::null;
+		//the collision filter group of the ray and the groups it can hit, checked against each body's own group and mask the same
+		//way bullet's ray test checks them (triggers are hit like any other body unless the mask leaves them out)
+		int group = btBroadphaseProxy::DefaultFilter;
+		int mask = btBroadphaseProxy::AllFilter;
+	};
+
+	//a convex shape moved from one point to another
+	struct TTN_SweepQuery {
+		//the shape, must be convex (a box, sphere, capsule, or convex hull)
+		TTN_ShapeCache::sshapeptr shape;
+		glm::vec3 from = glm::vec3(0.0f);
+		glm::vec3 to = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		//an entity the shape passes through, such as the one sweeping it
+		entt::entity ignore = entt::null;
+		//the collision filter group of the shape and the groups it can hit, checked the same way as a raycast's
+		int group = btBroadphaseProxy::DefaultFilter;
+		int mask = btBroadphaseProxy::AllFilter;
+	};
+
+	//a convex shape placed in the world to find what it overlaps
+	struct TTN_OverlapQuery {
+		//the shape, must be convex (a box, sphere, capsule, or convex hull)
+		TTN_ShapeCache::sshapeptr shape;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		//an entity that's never reported, such as the one making the query
+		entt::entity ignore = entt::null;
+	};
+
+	//the closest hit of a raycast or sweep
+	struct TTN_QueryHit {
+		//wheter or not anything was hit, if not the rest of the values aren't set
+		bool hit = false;
+		//the entity that was hit
+		entt::entity entity = entt::null;
+		//the world space point and surface normal of the hit
+		glm::vec3 point = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		//how far along the ray or sweep the hit was, from 0 at the start to 1 at the end
+		float fraction = 1.0f;
+	};
+
+	//physics queries class, runs arrays of queries split across the job system's workers, each one walks the broadphase trees and
+	//tests the bodies it reaches with bullet's narrowphase directly, as the broadphase's own ray test shares a single stack and isn't
+	//safe to call from several threads, the world must not be stepped while queries are running
+	class TTN_PhysicsQueries {
+	public:
+		//casts every ray, writing the closest hit of each into the matching element of hits
+		static void Raycast(btDbvtBroadphase* broadphase, TTN_Span<const TTN_RaycastQuery> queries, TTN_Span<TTN_QueryHit> hits);
+
+		//sweeps every shape, writing the closest hit of each into the matching element of hits
+		static void Sweep(btDbvtBroadphase* broadphase, TTN_Span<const TTN_SweepQuery> queries, TTN_Span<TTN_QueryHit> hits);
+
+		//finds the entities each shape overlaps, query i writes up to maxResultsPerQuery entities into results starting at
+		//i * maxResultsPerQuery and the number it wrote into resultCounts[i]
+		static void Overlap(btDbvtBroadphase* broadphase, TTN_Span<const TTN_OverlapQuery> queries, TTN_Span<entt::entity> results,
+			size_t maxResultsPerQuery, TTN_Span<uint32_t> resultCounts);
+
+		//the smallest number of queries given to each worker at once, so small batches don't get split up more than they're worth
+		static const size_t s_minQueriesPerJob = 16;
+
+	protected:
+		TTN_PhysicsQueries() = default;
+		~TTN_PhysicsQueries() = default;
+	};
+}
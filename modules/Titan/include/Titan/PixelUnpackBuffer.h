@@ -0,0 +1,59 @@
+//Titan Engine, by Atlas X Games
+// PixelUnpackBuffer.h - header for the class that stages texture data in a buffer so it can be uploaded to textures asynchronously
+#pragma once
+
+//import the buffer base class, which also includes the precompile header, which has the other features we need here
+//including glad/glad.h, vector, and memory
+#include "IBuffer.h"
+
+namespace Titan {
+
+	//class for a pixel unpack buffer (PBO), a persistently mapped ring of regions that texture data gets copied into before being uploaded,
+	//so the texture upload reads from gpu memory and the driver can do the transfer without stalling the calling thread
+	class TTN_PixelUnpackBuffer : public TTN_IBuffer {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_PixelUnpackBuffer> spubptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline spubptr Create(size_t regionSize = 16 * 1024 * 1024, size_t numOfRegions = 3) {
+			return std::make_shared<TTN_PixelUnpackBuffer>(regionSize, numOfRegions);
+		}
+
+	public:
+		//constructor, allocates immutable storage for all the regions and maps it
+		TTN_PixelUnpackBuffer(size_t regionSize, size_t numOfRegions);
+
+		//destructor, unmaps the buffer and deletes any fences
+		~TTN_PixelUnpackBuffer();
+
+		//copies data into the next region and binds the buffer, returning the offset of the region so it can be passed to the texture
+		//upload in place of a pointer, returns false (without binding anything) if the data doesn't fit in a region or the gpu is still
+		//reading from the next region, in which case the data should just be uploaded normally
+		bool Stage(const void* data, size_t size, size_t& offset);
+
+		//places a fence after the texture upload that read the last staged region and unbinds the buffer, should be called after
+		//every upload that used a staged region
+		void FinishUpload();
+
+		//gets the size of each region in bytes
+		size_t GetRegionSize() const { return m_regionSize; }
+
+		//unbinds the current pixel unpack buffer
+		static void UnBind() {
+			TTN_IBuffer::UnBind(GL_PIXEL_UNPACK_BUFFER);
+		}
+
+	private:
+		//pointer to the persistently mapped storage
+		uint8_t* m_mappedData;
+		//the size of each region in bytes
+		size_t m_regionSize;
+		//the number of regions in the ring
+		size_t m_numOfRegions;
+		//the region that was last staged
+		size_t m_currentRegion;
+		//fences for each region, null when the region isn't waiting on the gpu
+		std::vector<GLsync> m_fences;
+	};
+}
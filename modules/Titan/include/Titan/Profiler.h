@@ -0,0 +1,220 @@
+//Titan Engine, by Atlas X Games
+// Profiler.h - header for the frame profiler, which times scopes on the cpu (on any thread) and passes on the gpu
+#pragma once
+
+//precompile header, this file uses vector, string, memory, and cstdint
+#include "ttn_pch.h"
+//standard threading headers
+#include <atomic>
+#include <mutex>
+#include <deque>
+
+//the profiler is compiled in by default so it can be used in release builds, it only records anything while it's enabled and
+//costs a single flag check per scope when it isn't, define TTN_DISABLE_PROFILER to compile every scope out entirely
+#ifndef TTN_DISABLE_PROFILER
+#define TTN_PROFILE_CONCAT_INNER(a, b) a##b
+#define TTN_PROFILE_CONCAT(a, b) TTN_PROFILE_CONCAT_INNER(a, b)
+//times the rest of the enclosing scope on the cpu, the name must be a string literal (only the pointer is stored)
+#define TTN_PROFILE_SCOPE(name) Titan::TTN_ProfileScope TTN_PROFILE_CONCAT(ttnProfileScope, __LINE__)(name)
+//times the rest of the enclosing function on the cpu
+#define TTN_PROFILE_FUNCTION() TTN_PROFILE_SCOPE(__FUNCTION__)
+//times the gl commands issued in the rest of the enclosing scope on the gpu, only call from the thread that owns the gl context
+#define TTN_PROFILE_GPU_SCOPE(name) Titan::TTN_GPUProfileScope TTN_PROFILE_CONCAT(ttnGPUProfileScope, __LINE__)(name)
+#else
+#define TTN_PROFILE_SCOPE(name) ((void)0)
+#define TTN_PROFILE_FUNCTION() ((void)0)
+#define TTN_PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+namespace Titan {
+	//a single timed scope, times are in nanoseconds since the profiler was initialized
+	struct TTN_ProfileEvent {
+		const char* name;
+		int64_t start;
+		int64_t end;
+		//how many scopes this one is nested inside of
+		uint32_t depth;
+	};
+
+	//everything recorded during one frame
+	struct TTN_ProfileFrame {
+		uint64_t index = 0;
+		int64_t start = 0;
+		int64_t end = 0;
+		//cpu events, one list per thread (indexed the same as the profiler's threads)
+		std::vector<std::vector<TTN_ProfileEvent>> cpuEvents;
+		//gpu events, these come in a few frames late as we don't want to wait on the gpu for them
+		std::vector<TTN_ProfileEvent> gpuEvents;
+		bool gpuResolved = false;
+	};
+
+	//frame profiler class, collects the scopes from every thread each frame and keeps a history of recent frames
+	class TTN_Profiler {
+	public:
+		//sets up the profiler, needs a gl context for the gpu timer queries, called by titan's application init
+		static void Init();
+
+		//deletes the gpu queries and every recorded frame, called by titan's application closing
+		static void Shutdown();
+
+		//turns recording on or off, scopes do almost nothing while it's off
+		static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+		static bool GetEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+		//pauses adding frames to the history (so a spike can be looked at) without turning recording off
+		static void SetPaused(bool paused) { s_paused = paused; }
+		static bool GetPaused() { return s_paused; }
+
+		//marks the start and end of a frame, called by titan's application update
+		static void BeginFrame();
+		static void EndFrame();
+
+		//names the calling thread in the timeline and trace exports
+		static void SetThreadName(const std::string& name);
+
+		//draws the profiler window (frame graph, timeline, and scope totals) if it's open, called by titan's application update
+		static void DrawImGui();
+		static void SetWindowOpen(bool open) { s_windowOpen = open; }
+		static bool GetWindowOpen() { return s_windowOpen; }
+
+		//writes every frame in the history to a json file that can be opened in chrome://tracing (or perfetto), returns false if the file couldn't be written
+		static bool SaveChromeTrace(const std::string& fileName);
+
+		//gets the frames in the history, oldest first
+		static const std::deque<TTN_ProfileFrame>& GetHistory() { return s_history; }
+
+		//gets the current time in nanoseconds since the profiler was initialized
+		static int64_t Now();
+
+		//used by the scope classes, don't call these directly
+		static void BeginScope();
+		static void EndScope(const char* name, int64_t start);
+		static int BeginGPUScope(const char* name);
+		static void EndGPUScope(int query);
+
+	private:
+		//the number of events each thread can have waiting before the oldest get dropped
+		static const uint64_t ThreadBufferSize = 16384;
+		//the number of frames we keep in the history
+		static const size_t HistorySize = 300;
+		//the number of frames we give the gpu to finish before reading its queries
+		static const size_t GPUFramesInFlight = 4;
+
+		//events from a single thread, the thread writes into it and the main thread reads from it at the end of each frame,
+		//as there's only ever one of each they can share it without locking
+		struct ThreadBuffer {
+			std::string name;
+			std::unique_ptr<TTN_ProfileEvent[]> events;
+			std::atomic<uint64_t> write{ 0 };
+			//only touched by the main thread
+			uint64_t read = 0;
+			//only touched by the owning thread
+			uint32_t depth = 0;
+		};
+
+		//a gpu scope waiting on its results
+		struct GPUScope {
+			const char* name;
+			GLuint startQuery;
+			GLuint endQuery;
+			uint32_t depth;
+		};
+
+		//the gpu scopes from one frame
+		struct GPUFrame {
+			uint64_t frameIndex = 0;
+			//added to gpu timestamps to put them on the same clock as the cpu
+			int64_t gpuToCpuOffset = 0;
+			std::vector<GLuint> queries;
+			size_t usedQueries = 0;
+			std::vector<GPUScope> scopes;
+			bool pending = false;
+		};
+
+		//gets the calling thread's buffer, making it the first time the thread records something
+		static ThreadBuffer& GetThreadBuffer();
+
+		//moves the events each thread recorded since the last frame into a frame
+		static void CollectCPUEvents(TTN_ProfileFrame* frame);
+
+		//reads back the oldest frame of gpu queries if they're ready
+		static void ResolveGPUFrame(GPUFrame& gpuFrame);
+
+		//finds a frame in the history by its index
+		static TTN_ProfileFrame* FindFrame(uint64_t index);
+
+		inline static std::atomic<bool> s_enabled{ false };
+		inline static bool s_paused = false;
+		inline static bool s_windowOpen = false;
+		inline static bool s_initialized = false;
+
+		//every thread that has recorded something, guarded by the mutex (only taken when a thread first records something or at the end of a frame)
+		static std::vector<std::unique_ptr<ThreadBuffer>> s_threads;
+		inline static std::mutex s_threadMutex;
+		//the number of events dropped because a thread's buffer filled up before the end of the frame
+		inline static uint64_t s_droppedEvents = 0;
+
+		//the frame currently being recorded
+		inline static uint64_t s_frameIndex = 0;
+		inline static int64_t s_frameStart = 0;
+		inline static bool s_inFrame = false;
+
+		//gpu query pool, one set of queries per frame in flight
+		static GPUFrame s_gpuFrames[GPUFramesInFlight];
+		inline static uint32_t s_gpuDepth = 0;
+
+		//recent frames, oldest first
+		inline static std::deque<TTN_ProfileFrame> s_history;
+		//the frame selected in the window, counting back from the newest
+		inline static int s_selectedFrame = 0;
+	};
+
+	//times a scope on the cpu, use through TTN_PROFILE_SCOPE
+	class TTN_ProfileScope {
+	public:
+		TTN_ProfileScope(const char* name)
+			: m_name(name), m_start(-1)
+		{
+			if (TTN_Profiler::GetEnabled()) {
+				TTN_Profiler::BeginScope();
+				m_start = TTN_Profiler::Now();
+			}
+		}
+
+		~TTN_ProfileScope()
+		{
+			if (m_start >= 0)
+				TTN_Profiler::EndScope(m_name, m_start);
+		}
+
+		TTN_ProfileScope(const TTN_ProfileScope&) = delete;
+		TTN_ProfileScope& operator=(const TTN_ProfileScope&) = delete;
+
+	private:
+		const char* m_name;
+		int64_t m_start;
+	};
+
+	//times a scope on the gpu, use through TTN_PROFILE_GPU_SCOPE
+	class TTN_GPUProfileScope {
+	public:
+		TTN_GPUProfileScope(const char* name)
+			: m_query(-1)
+		{
+			if (TTN_Profiler::GetEnabled())
+				m_query = TTN_Profiler::BeginGPUScope(name);
+		}
+
+		~TTN_GPUProfileScope()
+		{
+			if (m_query >= 0)
+				TTN_Profiler::EndGPUScope(m_query);
+		}
+
+		TTN_GPUProfileScope(const TTN_GPUProfileScope&) = delete;
+		TTN_GPUProfileScope& operator=(const TTN_GPUProfileScope&) = delete;
+
+	private:
+		int m_query;
+	};
+}
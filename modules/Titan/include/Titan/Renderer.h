@@ -44,9 +44,38 @@ namespace Titan {
 		//gets the render layer
 		const int GetRenderLayer() const { return m_RenderLayer; }
 
-		void Render(glm::mat4 model, glm::mat4 VP);
+		//gets a number that changes whenever any renderer is given a new mesh, shader, or material, so the culling system knows
+		//when it needs to check if any bounds changed
+		static uint64_t GetChangeCount() { return s_changeCount; }
+
+		void Render(glm::mat4 model, glm::mat4 VP, const TTN_VertexArrayObject::svaptr& vao = nullptr);
+
+		//per instance data for instanced draws, read by the default vertex shaders when u_Instanced is set
+		struct InstanceData {
+			glm::mat4 model;
+			glm::mat3 normalMat;
+			//morph animation state, x the current frame, y the next frame, z the interpolation parameter between them, read by the
+			//default morph animation shaders and ignored by the others
+			glm::vec3 morph;
+		};
+
+		//sets up the buffer used for instanced draws, called by titan's application init
+		static void InitRenderer(size_t maxInstancesPerFrame = 16384);
+		//gets wheter or not a shader reads the per instance data (the default vertex shaders, other than the skybox, do)
+		static bool GetShaderSupportsInstancing(const TTN_Shader::sshptr& shader);
+		//gets the streaming buffer the per instance data is written into
+		static TTN_VertexBuffer::svbptr GetInstanceBuffer() { return s_instanceBuffer; }
+		//gets the attributes that describe the per instance data to a VAO
+		static const std::vector<BufferAttribute>& GetInstanceAttributes() { return s_instanceAttributes; }
 
 	private:
+		//streaming buffer with the per instance data for the frame
+		inline static TTN_VertexBuffer::svbptr s_instanceBuffer = nullptr;
+		//attributes for the per instance data
+		inline static std::vector<BufferAttribute> s_instanceAttributes;
+		//the number of times any renderer's mesh, shader, or material has been set
+		inline static uint64_t s_changeCount = 0;
+
 		//a pointer to the shader that should be used to render this object
 		TTN_Shader::sshptr m_Shader;
 		//a pointer to the mesh that this should render
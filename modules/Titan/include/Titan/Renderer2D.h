@@ -2,10 +2,9 @@
 // Renderer2D.h - header for the class that allows 2D sprites to be rendered 
 #pragma once
 
-//include the texture2D, shader, and VAO classes
-#include "Shader.h"
+//include the texture2D and sprite batcher classes
 #include "Texture2D.h"
-#include "VertexArrayObject.h"
+#include "SpriteBatcher.h"
 
 namespace Titan {
 	//class for rendering 2D sprites
@@ -35,11 +34,13 @@ namespace Titan {
 		glm::vec4 GetColor() { return m_color; }
 		int GetRenderOrderLayer() { return m_RenderLayer; }
 
-		//renders the sprite
+		//renders the sprite on it's own, scenes submit all their sprites to the batcher together instead
 		void Render(glm::mat4 model, glm::mat4 VP);
 
 		//set up for rendering (called on engine side)
 		static void InitRenderer2D();
+		//gets the batcher sprites are drawn through
+		static TTN_SpriteBatcher* GetSpriteBatcher() { return s_batcher.get(); }
 
 		//gets the texture
 		const TTN_Texture2D::st2dptr GetTexture() const { return m_sprite; }
@@ -56,12 +57,7 @@ namespace Titan {
 		//the render layer, to help control the order things should render
 		int m_RenderLayer;
 
-		//the shader program used to render sprites
-		inline static TTN_Shader::sshptr s_shader = nullptr;
-
-		//The vbos and vaos for sprites
-		inline static TTN_VertexBuffer::svbptr s_vertPos = nullptr;
-		inline static TTN_VertexBuffer::svbptr s_Uvs = nullptr;
-		inline static TTN_VertexArrayObject::svaptr s_vao = nullptr;
+		//the batcher that sorts and draws the sprites
+		inline static TTN_SpriteBatcher::ssbptr s_batcher = nullptr;
 	};
 }
\ No newline at end of file
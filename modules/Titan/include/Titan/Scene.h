@@ -6,6 +6,10 @@
 #include "ttn_pch.h"
 //include all the component class definitions we need
 #include "Transform.h"
+#include "TransformSystem.h"
+#include "CullingSystem.h"
+#include "ContactSystem.h"
+#include "PhysicsQueries.h"
 #include "Renderer.h"
 #include "Renderer2D.h"
 #include "Camera.h"
@@ -16,6 +20,7 @@
 #include "Particle.h"
 //include all the graphics features we need
 #include "Shader.h"
+#include "UniformBuffer.h"
 namespace Titan {
 	typedef entt::basic_group<entt::entity, entt::exclude_t<>, entt::get_t<>, TTN_Transform, TTN_Renderer> RenderGroupType;
 
@@ -117,14 +122,48 @@ namespace Titan {
 		//gets the camera entity
 		const entt::entity& GetCamEntity() { return m_Cam; }
 
+		//sets the parent of an entity's transform
+		void SetParent(entt::entity child, entt::entity parent);
+		//resolves the global matrices of all the transforms in the scene, called automatically before rendering but can be called
+		//manually if up to date global matrices for child transforms are needed earlier in the frame
+		void ResolveTransforms();
+
+		//sets wheter or not renderers outside the camera's view are skipped when rendering
+		void SetFrustumCulling(bool enabled) { m_FrustumCulling = enabled; }
+		//gets wheter or not frustum culling is on
+		bool GetFrustumCulling() const { return m_FrustumCulling; }
+		//gets the counters from the last frame's culling (how many objects were tested, visible, and culled)
+		const TTN_CullingStats& GetCullingStats() const { return m_CullingSystem->GetStats(); }
+
 		//bullet physics stuff
 		//set the gravity
 		void SetGravity(glm::vec3 gravity);
 		//gets the gravity
 		glm::vec3 GetGravity();
-
-		//gets all the collisions for the frame
-		std::vector<TTN_Collision::scolptr> GetCollisions() { return collisions; }
+		//sets the fixed timestep the physics simulation advances by, rendering interpolates between steps so it doesn't need to match the frame rate
+		void SetPhysicsTimeStep(float timeStep) { m_PhysicsTimeStep = timeStep; }
+		//gets the fixed physics timestep
+		float GetPhysicsTimeStep() const { return m_PhysicsTimeStep; }
+		//sets the most fixed steps the physics simulation can take in a single frame, if a frame takes longer than that the simulation slows down
+		//rather than falling further and further behind
+		void SetPhysicsMaxSubSteps(int maxSubSteps) { m_PhysicsMaxSubSteps = maxSubSteps; }
+		//gets the most fixed steps the physics simulation can take in a single frame
+		int GetPhysicsMaxSubSteps() const { return m_PhysicsMaxSubSteps; }
+
+		//gets the pairs of bodies that began, stayed, or ended contact in the last physics update, the span is only valid until the next update
+		TTN_Span<const TTN_ContactPair> GetContactPairs() const { return m_ContactSystem->GetPairs(); }
+		//gets the contact points of one of those pairs
+		TTN_Span<const TTN_ContactPoint> GetContactPoints(const TTN_ContactPair& pair) const { return m_ContactSystem->GetPoints(pair); }
+
+		//casts a batch of rays against the physics world across the job system's workers, writing the closest hit of each into hits
+		void Raycast(TTN_Span<const TTN_RaycastQuery> queries, TTN_Span<TTN_QueryHit> hits);
+		//casts a single ray against the physics world
+		TTN_QueryHit Raycast(const TTN_RaycastQuery& query);
+		//sweeps a batch of convex shapes through the physics world, writing the closest hit of each into hits
+		void Sweep(TTN_Span<const TTN_SweepQuery> queries, TTN_Span<TTN_QueryHit> hits);
+		//finds the entities a batch of convex shapes overlap, query i writes up to maxResultsPerQuery entities into results starting at
+		//i * maxResultsPerQuery and the number it wrote into resultCounts[i]
+		void Overlap(TTN_Span<const TTN_OverlapQuery> queries, TTN_Span<entt::entity> results, size_t maxResultsPerQuery, TTN_Span<uint32_t> resultCounts);
 
 		//set wheter or not the scene is paused
 		void SetPaused(bool paused) { m_Paused = paused; }
@@ -142,6 +181,16 @@ namespace Titan {
 		//entt group that has all the entities with renderer and transform components so we can edit and render them live
 		std::unique_ptr<RenderGroupType> m_RenderGroup;
 
+		//system that stores and resolves the transform hierarchy
+		std::unique_ptr<TTN_TransformSystem> m_TransformSystem;
+
+		//system that keeps the renderers in a bvh so the ones outside the camera's view can be skipped
+		std::unique_ptr<TTN_CullingSystem> m_CullingSystem;
+		//wheter or not culling is on
+		bool m_FrustumCulling = true;
+		//the entities that passed the last cull, kept to avoid reallocating it every frame
+		std::vector<entt::entity> m_VisibleEntities;
+
 		//boolean to store wheter or not this scene should currently be rendered
 		bool m_ShouldRender; 
 
@@ -163,88 +212,71 @@ namespace Titan {
 		btSequentialImpulseConstraintSolver* solver;
 		//physics world
 		btDiscreteDynamicsWorld* m_physicsWorld;
-
-		//vector of titan collision objects, containing pointers to the rigid bodies (from which you can get entity numbers) and glm vec3s for collision normals
-		std::vector<TTN_Collision::scolptr> collisions;
-
-		//constructs the TTN_Collision objects
-		void ConstructCollisions();
-
-		//reconstructs the scenegraph, use every time entt reshuffles
-		void ReconstructScenegraph();
-
-#pragma region Sorts
-		//functions to perform a merge sort on a vector of entities based on their z positions 
-		//slightly modified from code from GeeksForGeeks: https://www.geeksforgeeks.org/merge-sort/
-
-		//merge function
-		void mergeEntitiesZ(std::vector<entt::entity>& list, int left, int middle, int right) {
-			//calculate the lenghts of 2 temprorary vectors
-			int lenght1 = middle - left + 1;
-			int lenght2 = right - middle;
-
-			//create the temporary vectors
-			std::vector<entt::entity> tempLeftList = std::vector<entt::entity>(lenght1);
-			std::vector<entt::entity> tempRightList = std::vector<entt::entity>(lenght2);
-
-			//copy data over to the temp vectors
-			for (int i = 0; i < lenght1; i++)
-				tempLeftList[i] = list[left + i];
-			for (int i = 0; i < lenght2; i++)
-				tempRightList[i] = list[middle + 1 + i];
-
-			//set inital indexes for each vector
-			int leftIndex = 0; //left temp
-			int rightIndex = 0; //right temp
-			int mergedIndex = left; //merged subvector
-
-			//merge the temp vectors back into list
-
-			//loop through comparing both sides
-			while (leftIndex < lenght1 && rightIndex < lenght2) {
-				//if the left has a smaller or equal z value, add it back to the merged vector 
-				if (Get<TTN_Transform>(tempLeftList[leftIndex]).GetGlobalPos().z <= Get<TTN_Transform>(tempRightList[rightIndex]).GetGlobalPos().z) {
-					list[mergedIndex] = tempLeftList[leftIndex];
-					leftIndex++;
-				}
-				//otherwise add the right back to the merged vector
-				else {
-					list[mergedIndex] = tempRightList[rightIndex];
-					rightIndex++;
-				}
-				//either way increment the merged index
-				mergedIndex++;
-			}
-
-			//when one side has completed, add any remaining elements from either side
-			while (leftIndex < lenght1) {
-				list[mergedIndex] = tempLeftList[leftIndex];
-				leftIndex++;
-				mergedIndex++;
-			}
-			while (rightIndex < lenght2) {
-				list[mergedIndex] = tempRightList[rightIndex];
-				rightIndex++;
-				mergedIndex++;
-			}
-		}
-
-		//merge sort function
-		void mergeSortEntitiesZ(std::vector<entt::entity>& list, int left, int right) {
-			//base case, returns recursively 
-			if (left >= right) {
-				return;
+		//the fixed timestep and the cap on how many of them can be taken each frame
+		float m_PhysicsTimeStep = 1.0f / 60.0f;
+		int m_PhysicsMaxSubSteps = 4;
+		//the entities whose bodies bullet moved during the last step, filled in by their motion states
+		std::vector<entt::entity> m_MovedBodies;
+
+		//system that reads the contacts out of bullet after each step
+		std::unique_ptr<TTN_ContactSystem> m_ContactSystem;
+
+		//an entry in the render queue, the layer, shader, material, and mesh make up the key it's sorted by so entities that
+		//share state end up next to each other and can be drawn together
+		struct RenderQueueItem {
+			int layer;
+			TTN_Shader* shader;
+			TTN_Material* material;
+			TTN_Mesh* mesh;
+			entt::entity entity;
+			TTN_Transform* transform;
+			TTN_Renderer* renderer;
+			//the morph animation state, x the current frame, y the next frame, z the interpolation parameter (all zero without an animator)
+			glm::vec3 morph;
+
+			//compares the sort keys
+			bool operator<(const RenderQueueItem& other) const {
+				if (layer != other.layer) return layer < other.layer;
+				if (shader != other.shader) return shader < other.shader;
+				if (material != other.material) return material < other.material;
+				return mesh < other.mesh;
 			}
-			//calculate a middle value
-			int middle = (left + right - 1) / 2;
-			//call mergesort on both sides
-			mergeSortEntitiesZ(list, left, middle);
-			mergeSortEntitiesZ(list, middle + 1, right);
-			//merge the two sides
-			mergeEntitiesZ(list, left, middle, right);
-		}
-
-#pragma endregion Sorts
+		};
+		//the render queue, kept between frames so it doesn't need to be reallocated
+		std::vector<RenderQueueItem> m_RenderQueue;
+		//gets the morph animation state of an entity for the render queue
+		glm::vec3 GetMorphState(entt::entity entity);
+		//binds a mesh's packed morph frames if the shader is one of the default morph animation shaders, returning wheter or not it was
+		bool BindMorphFrames(TTN_Shader* shader, TTN_Mesh* mesh);
+
+		//the per frame uniform block, laid out with std140 to match TTN_FrameData in the default shaders
+		struct FrameLightData {
+			//xyz position, w ambient strength
+			glm::vec4 position;
+			//rgb color, w specular strength
+			glm::vec4 color;
+			//x constant, y linear, z quadratic attenuation
+			glm::vec4 attenuation;
+		};
+		struct FrameData {
+			glm::mat4 view;
+			glm::mat4 projection;
+			glm::mat4 viewProjection;
+			//xyz camera position
+			glm::vec4 camPos;
+			//rgb scene ambient color, a scene ambient strength
+			glm::vec4 ambient;
+			//x number of lights
+			glm::ivec4 numOfLights;
+			FrameLightData lights[16];
+		};
+		//uniform buffer with the frame data, updated once at the start of each render
+		TTN_UniformBuffer::subptr m_FrameUbo = nullptr;
+
+		//fills the frame uniform buffer with the camera and lighting data and binds it
+		void UpdateFrameUniforms(const glm::mat4& view, const glm::mat4& projection);
+		//sends the material data to a shader and binds it's textures
+		void ApplyMaterialUniforms(TTN_Shader* shader, TTN_Material* material);
 	};
 
 #pragma region ECS_functions_def
@@ -254,8 +286,6 @@ namespace Titan {
 	{
 		//assign the component to the entity
 		m_Registry->emplace<T>(entity);
-		//reconstruct scenegraph as entt was shuffled
-		ReconstructScenegraph();
 	}
 
 	//function to attach a copy of an object to an entity as a component
@@ -264,8 +294,6 @@ namespace Titan {
 	{
 		//assign the component to the entity 
 		m_Registry->emplace_or_replace<T>(entity, copy);
-		//reconstruct scenegraph as entt was shuffled
-		ReconstructScenegraph();
 	}
 
 	//function to get a reference to a given component from an entity
@@ -289,8 +317,6 @@ namespace Titan {
 	{
 		//remove the component from the entity
 		m_Registry->remove<T>(entity);
-		//reconstruct scenegraph as entt was shuffled
-		ReconstructScenegraph();
 	}
 #pragma endregion ECS_functions_def
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
 //Titan Engine, by Atlas X Games
-// Scene.h - header for the class that represents openGL shaders
+// Shader.h - header for the class that represents openGL shaders
 #pragma once
 
 //precompile header, this file uses glad/glad.h, memory, string, unordered_map, and GLM/glm.hpp
@@ -23,6 +23,32 @@ namespace Titan {
 		VERT_MORPH_ANIMATION_COLOR = 11
 	};
 
+	//interned uniform name, every name gets a stable index the first time it's used so shaders can look up their uniform locations
+	//in a flat array instead of hashing the name on every set, create them once (ex. as statics) and reuse them
+	class TTN_UniformId {
+	public:
+		//default constructor, an invalid id that no shader has
+		TTN_UniformId() : m_index(-1) {}
+		//constructor, interns the name
+		explicit TTN_UniformId(const std::string& name) : m_index(Intern(name)) {}
+
+		//gets the index of the id
+		int GetIndex() const { return m_index; }
+		//gets the name the id was interned from
+		const std::string& GetName() const;
+		//gets wheter or not the id is valid
+		bool IsValid() const { return m_index != -1; }
+
+		//interns a name, returning it's index
+		static int Intern(const std::string& name);
+		//gets the number of names that have been interned
+		static size_t GetCount();
+
+	private:
+		//the index of the name
+		int m_index;
+	};
+
 	//class to wrap around an opengl shader
 	class TTN_Shader final {
 	public:
@@ -59,19 +85,36 @@ namespace Titan {
 		//loads a default shader
 		bool LoadDefaultShader(TTN_DefaultShaders shader);
 
-		//Links the stages together creating the pipeline and making the shader program useable
+		//Links the stages together creating the pipeline and making the shader program useable, a program either needs both a
+		//vertex and fragment shader, or just a compute shader
 		//returns true if sucessful, false if not
 		bool Link();
 
 		//Binds the shader program so we can acutally use it
 		void Bind();
 
+		//Binds a compute shader program and dispatches the given number of work groups
+		void Dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1);
+
 		//Unbinds the shader program so we can use another
 		static void UnBind();
 
 		//Gets the OpenGL handle that it's wrapping around
 		GLuint GetHandle() const { return _handle; }
 
+		//Gets the location of a uniform from it's id, -1 if the shader doesn't have it
+		int GetUniformLocation(TTN_UniformId id) const {
+			return (id.GetIndex() >= 0 && id.GetIndex() < (int)_uniformsById.size()) ? _uniformsById[id.GetIndex()].location : -1;
+		}
+		//Gets the openGL type of a uniform from it's id (ex. GL_FLOAT_VEC3), 0 if the shader doesn't have it
+		GLenum GetUniformType(TTN_UniformId id) const {
+			return (id.GetIndex() >= 0 && id.GetIndex() < (int)_uniformsById.size()) ? _uniformsById[id.GetIndex()].type : 0;
+		}
+		//Gets the array size of a uniform from it's id, 0 if the shader doesn't have it
+		int GetUniformArraySize(TTN_UniformId id) const {
+			return (id.GetIndex() >= 0 && id.GetIndex() < (int)_uniformsById.size()) ? _uniformsById[id.GetIndex()].arraySize : 0;
+		}
+
 		//Gets the default status of the vertex shader
 		int GetVertexShaderDefaultStatus() { return vertexShaderTTNIndentity; }
 		//Gets the default status of the fragment shader
@@ -140,11 +183,32 @@ namespace Titan {
 			}
 		}
 
+		//template function for setting a uniform based on it's id and data, doesn't need to look up the name
+		template <typename T>
+		void SetUniform(TTN_UniformId id, const T& value, int count = 1) {
+			int location = GetUniformLocation(id);
+			if (location != -1)
+				SetUniform(location, &value, count);
+		}
+
+		//template function for setting a uniform matrix based on it's id and data, doesn't need to look up the name
+		template <typename T>
+		void SetUniformMatrix(TTN_UniformId id, const T& value, bool transposed = false) {
+			int location = GetUniformLocation(id);
+			if (location != -1)
+				SetUniformMatrix(location, &value, 1, transposed);
+		}
+
+		//the uniform set writes values straight to the locations it looked up
+		friend class TTN_UniformSet;
+
 	protected:
 		//vertex shader
 		GLuint _vs;
 		//fragment shader
 		GLuint _fs;
+		//compute shader
+		GLuint _cs;
 
 		//marker if they're using a default shader (and which one), 0 is a custom shader, the rest are default shaders
 		int vertexShaderTTNIndentity, fragShaderTTNIdentity;
@@ -158,6 +222,71 @@ namespace Titan {
 
 		//function to get the locations of all the uniforms
 		int __GetUniformLocation(const std::string& name);
+
+		//the active uniforms found when the program was linked, indexed by uniform id
+		struct UniformInfo {
+			int location = -1;
+			GLenum type = 0;
+			int arraySize = 0;
+		};
+		std::vector<UniformInfo> _uniformsById;
+
+		//reads all the active uniforms from the linked program, interning their names and saving their locations
+		void __ReflectUniforms();
+	};
+
+	//class for a precompiled set of uniforms on a shader, the locations and types are looked up once when it's created so the values can
+	//be written with no lookups and then sent together with Apply
+	class TTN_UniformSet {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_UniformSet> susptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline susptr Create(const TTN_Shader::sshptr& shader, const std::vector<TTN_UniformId>& uniforms) {
+			return std::make_shared<TTN_UniformSet>(shader, uniforms);
+		}
+
+	public:
+		//constructor, builds the set for the given uniforms on the shader, the slot of each uniform is it's index in the list
+		TTN_UniformSet(const TTN_Shader::sshptr& shader, const std::vector<TTN_UniformId>& uniforms);
+
+		//writes the value of the uniform in the given slot, it gets sent to the shader on the next Apply
+		template <typename T>
+		void Set(size_t slot, const T& value) {
+			Entry& entry = m_entries[slot];
+			//uniforms the shader doesn't have are skipped
+			if (entry.location == -1) return;
+			LOG_ASSERT(sizeof(T) <= entry.size, "Value for uniform set slot {} is larger than the uniform", slot);
+			memcpy(m_values.data() + entry.offset, &value, sizeof(T));
+			entry.dirty = true;
+		}
+		//bools are stored as ints in glsl
+		void Set(size_t slot, bool value) { Set(slot, (int)value); }
+
+		//sends any values that have changed since the last apply to the shader
+		void Apply();
+
+		//gets the number of uniforms in the set
+		size_t GetCount() const { return m_entries.size(); }
+
+	private:
+		//a uniform in the set
+		struct Entry {
+			int location;
+			GLenum type;
+			int count;
+			size_t offset;
+			size_t size;
+			bool dirty;
+		};
+
+		//the shader the set is for
+		TTN_Shader::sshptr m_shader;
+		//the uniforms
+		std::vector<Entry> m_entries;
+		//the values of all the uniforms, packed together
+		std::vector<uint8_t> m_values;
 	};
 
 }
\ No newline at end of file
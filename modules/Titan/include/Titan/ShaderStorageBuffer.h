@@ -0,0 +1,47 @@
+//Titan Engine, by Atlas X Games
+// ShaderStorageBuffer.h - header for the class that stores a buffer shaders can read and write directly (SSBOs)
+#pragma once
+
+//import the buffer base class, which also includes the precompile header, which has the other features we need here
+//including glad/glad.h and memory
+#include "IBuffer.h"
+
+namespace Titan {
+
+	//class for a shader storage buffer, used to give shaders (especially compute shaders) direct access to large arrays of data
+	class TTN_ShaderStorageBuffer : public TTN_IBuffer {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_ShaderStorageBuffer> sssbptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline sssbptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+			return std::make_shared<TTN_ShaderStorageBuffer>(usage);
+		}
+
+	public:
+		//constructor, creates a new shader storage buffer with the given usage, data will need to be loaded before it can be used
+		TTN_ShaderStorageBuffer(GLenum usage = GL_DYNAMIC_DRAW) : TTN_IBuffer(GL_SHADER_STORAGE_BUFFER, usage)
+			{ }
+
+		//updates part of the buffer without reallocating it, offset and size are in bytes
+		inline void UpdateData(const void* data, size_t offset, size_t size) {
+			glNamedBufferSubData(_handle, offset, size, data);
+		}
+
+		//binds the buffer to an indexed binding point so shaders can access it (layout(binding = x) in GLSL)
+		inline void BindBase(GLuint binding) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _handle);
+		}
+
+		//unbinds whatever buffer is bound to an indexed binding point
+		static inline void UnBindBase(GLuint binding) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+		}
+
+		//unbinds the current shader storage buffer
+		static void UnBind() {
+			TTN_IBuffer::UnBind(GL_SHADER_STORAGE_BUFFER);
+		}
+	};
+}
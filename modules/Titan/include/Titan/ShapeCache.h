@@ -0,0 +1,104 @@
+//Titan Engine, by Atlas X Games
+// ShapeCache.h - header for the class that creates and shares the collision shapes used by physics bodies
+#pragma once
+
+//precompile header, this file uses memory, vector, unordered_map, and GLM/glm.hpp
+#include "ttn_pch.h"
+//mutex so shapes can be requested from any thread
+#include <mutex>
+//include the mesh so colliders can be built from it
+#include "Mesh.h"
+
+//import the bullet physics engine
+#include <btBulletDynamicsCommon.h>
+
+namespace Titan {
+	//a child of a compound collider, a shape with an offset from the body's origin
+	struct TTN_CompoundChild {
+		//the shape
+		std::shared_ptr<btCollisionShape> shape;
+		//the offset
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	};
+
+	//shape cache class, bodies with the same collider share a single bullet shape instead of each creating their own, the cache only
+	//holds weak references so a shape is deleted once the last body using it is
+	class TTN_ShapeCache {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to collision shapes
+		typedef std::shared_ptr<btCollisionShape> sshapeptr;
+
+		//gets a box with the given half extents
+		static sshapeptr GetBox(glm::vec3 halfExtents);
+		//gets a sphere with the given radius
+		static sshapeptr GetSphere(float radius);
+		//gets a capsule along the y axis, height is the distance between the centers of the two end caps
+		static sshapeptr GetCapsule(float radius, float height);
+
+		//gets the convex hull around a mesh's vertices, scaled by scale, the hull is simplified down to the points that matter
+		static sshapeptr GetConvexHull(const TTN_Mesh::smptr& mesh, glm::vec3 scale = glm::vec3(1.0f));
+
+		//gets a triangle mesh collider for a mesh, scaled by scale, these can only be used by static and kinematic bodies, every scale of
+		//the same mesh shares one bvh, if a bvh cache file is passed the bvh is loaded from it when it matches the mesh and saved to it
+		//when it doesn't, so large level colliders don't need to rebuild their bvh every time they're loaded
+		static sshapeptr GetTriangleMesh(const TTN_Mesh::smptr& mesh, glm::vec3 scale = glm::vec3(1.0f), const std::string& bvhCacheFile = "");
+
+		//creates a compound collider out of several shapes, compounds aren't shared as their children can be anything
+		static sshapeptr CreateCompound(const std::vector<TTN_CompoundChild>& children);
+
+		//removes the entries for shapes that have been deleted
+		static void ClearExpired();
+		//gets the number of entries in the cache
+		static size_t GetNumOfEntries();
+
+		//the version of the bvh cache format, caches with any other version are ignored and rewritten
+		static const uint32_t s_bvhCacheVersion = 1;
+
+	private:
+		//the types of shapes that can be cached
+		enum class ShapeType {
+			BOX,
+			SPHERE,
+			CAPSULE,
+			CONVEX_HULL,
+			TRIANGLE_MESH,
+			SCALED_TRIANGLE_MESH
+		};
+
+		//what a shape is looked up by, it's type, dimensions, and the mesh it was made from (if any)
+		struct ShapeKey {
+			ShapeType type;
+			glm::vec3 dimensions;
+			const TTN_Mesh* mesh;
+
+			bool operator==(const ShapeKey& other) const {
+				return type == other.type && dimensions == other.dimensions && mesh == other.mesh;
+			}
+		};
+
+		//hashes a key
+		struct ShapeKeyHash {
+			size_t operator()(const ShapeKey& key) const;
+		};
+
+		//a cached shape, along with the mesh it was made from so a new mesh at the address of a deleted one isn't mistaken for it
+		struct ShapeEntry {
+			std::weak_ptr<btCollisionShape> shape;
+			std::weak_ptr<TTN_Mesh> mesh;
+		};
+
+		//looks up a shape, returning null if it isn't cached (or has been deleted), should be called with the lock held
+		static sshapeptr Find(const ShapeKey& key, const TTN_Mesh::smptr& mesh);
+		//builds the unscaled bvh triangle mesh for a mesh, should be called with the lock held
+		static sshapeptr BuildTriangleMesh(const TTN_Mesh::smptr& mesh, const std::string& bvhCacheFile);
+
+		//the cached shapes
+		inline static std::unordered_map<ShapeKey, ShapeEntry, ShapeKeyHash> s_shapes;
+		//lock for the cache, so bodies can be made on any thread
+		inline static std::mutex s_mutex;
+
+		TTN_ShapeCache() = default;
+		~TTN_ShapeCache() = default;
+	};
+}
@@ -0,0 +1,46 @@
+//Titan Engine, by Atlas X Games
+// Span.h - header for a lightweight non-owning view over a contiguous array
+#pragma once
+
+//precompile header, this file uses vector
+#include "ttn_pch.h"
+
+namespace Titan {
+	//non-owning view over a contiguous run of elements, used to hand out the contents of internal arrays without copying them,
+	//it's only valid until the array it points into next changes
+	template<typename T>
+	class TTN_Span {
+	public:
+		//default constructor, makes an empty span
+		TTN_Span() : m_data(nullptr), m_size(0) {}
+		//constructor, makes a span over size elements starting at data
+		TTN_Span(T* data, size_t size) : m_data(data), m_size(size) {}
+		//constructor, makes a span over the contents of a vector
+		template<typename U>
+		TTN_Span(std::vector<U>& vector) : m_data(vector.data()), m_size(vector.size()) {}
+		template<typename U>
+		TTN_Span(const std::vector<U>& vector) : m_data(vector.data()), m_size(vector.size()) {}
+		//constructor, makes a const span out of a non const one
+		template<typename U>
+		TTN_Span(const TTN_Span<U>& other) : m_data(other.data()), m_size(other.size()) {}
+
+		//iterators so it can be used in range based for loops
+		T* begin() const { return m_data; }
+		T* end() const { return m_data + m_size; }
+
+		//element access
+		T& operator[](size_t index) const { return m_data[index]; }
+		T* data() const { return m_data; }
+
+		//gets the number of elements
+		size_t size() const { return m_size; }
+		//gets wheter or not there are any elements
+		bool empty() const { return m_size == 0; }
+
+	private:
+		//the first element
+		T* m_data;
+		//the number of elements
+		size_t m_size;
+	};
+}
@@ -0,0 +1,152 @@
+//Titan Engine, by Atlas X Games
+// SpriteAtlas.h - header for the class that packs sprite textures into larger atlas textures at runtime so sprites can be batched
+#pragma once
+
+//precompile header, this file uses vector, unordered_map, memory, and GLM/glm.hpp
+#include "ttn_pch.h"
+//include the texture class
+#include "Texture2D.h"
+
+namespace Titan {
+	//where a sprite's texture ended up, the texture to bind and the part of it the sprite covers
+	struct TTN_AtlasRegion {
+		//the texture to bind, either an atlas page or the sprite's own texture if it wasn't packed, null if the sprite can't be drawn
+		const TTN_Texture2D* texture = nullptr;
+		//the uv offset (xy) and scale (zw) of the sprite within the texture
+		glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		//id shared by every region on the same texture, sprites with the same id can be drawn together
+		uint32_t batchId = 0;
+	};
+
+	//sprite atlas class, the first time a sprite texture is used it's pixels are copied into a shelf packed page alongside other
+	//sprites, pages are split by filtering so nearest filtered pixel art doesn't get smoothed, textures that are too big to pack (or
+	//that have mipmaps, as the pages only have the one level) are drawn from their own texture instead
+	//the copy is taken again whenever the texture's generation changes (it's data is loaded or it's filtering is set), textures that
+	//are drawn into some other way (like framebuffer attachments) aren't tracked, so the atlas should be cleared after those change
+	class TTN_SpriteAtlas {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_SpriteAtlas> ssaptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline ssaptr Create(uint32_t pageSize = 2048, uint32_t maxSpriteSize = 512, size_t maxPages = 8) {
+			return std::make_shared<TTN_SpriteAtlas>(pageSize, maxSpriteSize, maxPages);
+		}
+
+	public:
+		//ensuring moving and copying is not allowed so we can control destructor calls through pointers
+		TTN_SpriteAtlas(const TTN_SpriteAtlas& other) = delete;
+		TTN_SpriteAtlas(TTN_SpriteAtlas& other) = delete;
+		TTN_SpriteAtlas& operator=(const TTN_SpriteAtlas& other) = delete;
+		TTN_SpriteAtlas& operator=(TTN_SpriteAtlas&& other) = delete;
+
+	public:
+		//constructor, pages are created as they're needed
+		TTN_SpriteAtlas(uint32_t pageSize, uint32_t maxSpriteSize, size_t maxPages);
+		//default destructor
+		~TTN_SpriteAtlas() = default;
+
+		//gets the region for a texture, packing it into a page if it hasn't been seen before
+		const TTN_AtlasRegion& GetRegion(const TTN_Texture2D::st2dptr& texture);
+
+		//deletes every page and forgets every texture, they'll be packed again the next time they're used
+		void Clear();
+
+		//lets the space given back since the last call be reused (and if the pages have filled up, takes back the space of textures
+		//that have been deleted), called by the sprite batcher before each set of sprites, so sprites that were already submitted
+		//never have their pixels overwritten before they're drawn
+		void ReclaimReleased();
+
+		//gets the number of pages
+		size_t GetNumOfPages() const { return m_pages.size(); }
+		//gets the number of textures the atlas knows about (packed or not)
+		size_t GetNumOfEntries() const { return m_entries.size(); }
+
+		//the number of pixels each sprite is extruded by so filtering doesn't pick up it's neighbours
+		static const uint32_t s_padding = 1;
+
+	private:
+		//a row of sprites in a page
+		struct Shelf {
+			uint32_t y;
+			uint32_t height;
+			uint32_t cursorX;
+		};
+
+		//a block of a page, including the padding
+		struct Block {
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		//a page of the atlas
+		struct Page {
+			TTN_Texture2D::st2dptr texture;
+			bool nearestMin;
+			bool nearestMag;
+			uint32_t batchId;
+			std::vector<Shelf> shelves;
+			//the top of the highest shelf
+			uint32_t nextShelfY;
+			//blocks given back by textures that were deleted or repacked, reused before the shelves grow
+			std::vector<Block> freeBlocks;
+			//blocks given back since the last ReclaimReleased, they might still be drawn this frame
+			std::vector<Block> releasedBlocks;
+		};
+
+		//a texture the atlas knows about
+		struct Entry {
+			//used to check the texture hasn't been deleted and it's address reused
+			std::weak_ptr<TTN_Texture2D> texture;
+			//the texture's generation when it was copied in
+			uint32_t generation = 0;
+			TTN_AtlasRegion region;
+			//the page and block it was packed into, page is -1 if it wasn't packed
+			int page = -1;
+			Block block = { 0, 0, 0, 0 };
+			//wheter it was drawn on it's own because the pages were full, and how many reclaims there had been, so it can try again
+			//once space has been given back
+			bool outOfSpace = false;
+			uint32_t reclaims = 0;
+		};
+
+		//works out where a texture should go and copies it in
+		void Pack(const TTN_Texture2D::st2dptr& texture, Entry& entry);
+		//finds space for a width x height block in a page (the block can be bigger if it's a reused one), returns false if it doesn't fit
+		bool Allocate(Page& page, uint32_t width, uint32_t height, Block& block);
+		//finds space for a block in any page with the given filtering, making a new page if there's room, returns the page or -1
+		int AllocateInPages(bool nearestMin, bool nearestMag, uint32_t width, uint32_t height, Block& block);
+		//gives an entry's block back to it's page
+		void Release(Entry& entry);
+		//forgets every texture that has been deleted, giving their blocks back
+		void ReleaseExpired();
+		//creates a new page
+		Page& AddPage(bool nearestMin, bool nearestMag);
+		//copies a texture's pixels into a page with it's edges extruded
+		void CopyIntoPage(const TTN_Texture2D& texture, const Page& page, uint32_t x, uint32_t y);
+
+		//the width and height of the pages
+		uint32_t m_pageSize;
+		//the largest width or height a texture can have and still be packed
+		uint32_t m_maxSpriteSize;
+		//the most pages that can be made, once they're full textures are drawn on their own
+		size_t m_maxPages;
+
+		//the pages
+		std::vector<Page> m_pages;
+		//every texture that has been seen, by address
+		std::unordered_map<const TTN_Texture2D*, Entry> m_entries;
+		//the next batch id to hand out
+		uint32_t m_nextBatchId;
+		//wheter a texture couldn't be packed because the pages were full since the last reclaim
+		bool m_outOfSpace;
+		//the number of reclaims that gave space back
+		uint32_t m_reclaims;
+
+		//scratch space for copying pixels, kept so it doesn't need to be reallocated for every texture
+		std::vector<uint8_t> m_pixels;
+		std::vector<uint8_t> m_paddedPixels;
+	};
+}
@@ -0,0 +1,97 @@
+//Titan Engine, by Atlas X Games
+// SpriteBatcher.h - header for the class that sorts sprites and draws them in batches
+#pragma once
+
+//precompile header, this file uses vector, memory, and GLM/glm.hpp
+#include "ttn_pch.h"
+//include the shader, vao, and atlas classes
+#include "Shader.h"
+#include "VertexArrayObject.h"
+#include "SpriteAtlas.h"
+
+namespace Titan {
+	//sprite batcher class, sprites are submitted between Begin and End, at End they're sorted back to front with a radix sort on
+	//precomputed keys, their quads are transformed on the cpu and streamed into one vertex buffer, and every run of sprites that
+	//shares an atlas page (or texture) is drawn with a single call
+	class TTN_SpriteBatcher {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_SpriteBatcher> ssbptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline ssbptr Create(size_t maxQuadsPerBatch = 4096) {
+			return std::make_shared<TTN_SpriteBatcher>(maxQuadsPerBatch);
+		}
+
+	public:
+		//ensuring moving and copying is not allowed so we can control destructor calls through pointers
+		TTN_SpriteBatcher(const TTN_SpriteBatcher& other) = delete;
+		TTN_SpriteBatcher(TTN_SpriteBatcher& other) = delete;
+		TTN_SpriteBatcher& operator=(const TTN_SpriteBatcher& other) = delete;
+		TTN_SpriteBatcher& operator=(TTN_SpriteBatcher&& other) = delete;
+
+	public:
+		//constructor, loads the sprite shader and creates the buffers, maxQuadsPerBatch is how many sprites fit in the vertex buffer
+		//at once, more than that still get drawn but take extra trips through the buffer
+		TTN_SpriteBatcher(size_t maxQuadsPerBatch);
+		//default destructor
+		~TTN_SpriteBatcher() = default;
+
+		//starts a new set of sprites to be drawn with the given view projection matrix
+		void Begin(const glm::mat4& VP);
+		//adds a sprite, a unit quad transformed by model, tinted by color
+		void Submit(const TTN_Texture2D::st2dptr& texture, const glm::mat4& model, const glm::vec4& color = glm::vec4(1.0f));
+		//sorts and draws every sprite submitted since Begin
+		void End();
+
+		//gets the atlas the sprite textures are packed into
+		TTN_SpriteAtlas& GetAtlas() { return *m_atlas; }
+		//gets the number of draw calls the last End took
+		size_t GetNumOfDrawCalls() const { return m_numOfDrawCalls; }
+
+	private:
+		//the vertices streamed to the gpu
+		struct SpriteVertex {
+			glm::vec3 position;
+			glm::vec2 uv;
+			glm::vec4 color;
+		};
+
+		//a submitted sprite, the axes of it's transform and where it is in the atlas
+		struct Sprite {
+			glm::vec3 origin;
+			glm::vec3 right;
+			glm::vec3 up;
+			glm::vec4 color;
+			glm::vec4 uvRect;
+			const TTN_Texture2D* texture;
+		};
+
+		//sorts the sprites, filling m_order with their indices in draw order
+		void SortSprites();
+
+		//the atlas
+		TTN_SpriteAtlas::ssaptr m_atlas;
+		//the view projection matrix the sprites are drawn with
+		glm::mat4 m_VP;
+
+		//the sprites submitted since begin, and their sort keys
+		std::vector<Sprite> m_sprites;
+		std::vector<uint64_t> m_keys;
+		//the draw order, and scratch space for the sort, kept between frames so they don't need to be reallocated
+		std::vector<uint32_t> m_order;
+		std::vector<uint32_t> m_orderScratch;
+		std::vector<uint64_t> m_keysScratch;
+
+		//the shader, and the buffers the quads are streamed through
+		TTN_Shader::sshptr m_shader;
+		TTN_VertexBuffer::svbptr m_vbo;
+		TTN_IndexBuffer::sibptr m_ibo;
+		TTN_VertexArrayObject::svaptr m_vao;
+		//the number of quads the vertex buffer can hold
+		size_t m_maxQuads;
+
+		//the number of draw calls the last End took
+		size_t m_numOfDrawCalls;
+	};
+}
@@ -7,6 +7,7 @@
 //include other titan features
 #include "ITexture.h"
 #include "TextureEnums.h"
+#include "PixelUnpackBuffer.h"
 
 
 namespace Titan {
@@ -27,7 +28,7 @@ namespace Titan {
 		~TTN_Texture2DData();
 
 
-		/// Loads image data from an external file
+		/// Loads image data from an external file, this doesn't touch opengl or any global stb state so it is safe to call from worker threads
 		static TTN_Texture2DData::st2ddptr LoadFromFile(const std::string& file, bool flipped = true, bool forceRgba = false);
 
 		
@@ -55,6 +56,9 @@ namespace Titan {
 		const void* GetDataPtr() const { return _data; }
 
 	private:
+		/// Flips the rows of the image so the first row is the bottom of the image
+		void FlipVertically();
+
 		uint32_t    _width, _height;
 		size_t      _dataSize;
 		Texture_Pixel_Format _format;
@@ -115,8 +119,8 @@ namespace Titan {
 
 		//loads a texture from a file
 		static st2dptr LoadFromFile(const std::string& fileName, bool flipped = true, bool forceRgba = false);
-		//loads a texture from a texture data object
-		void LoadData(const TTN_Texture2DData::st2ddptr& data);
+		//loads a texture from a texture data object, if a staging buffer is given the data is uploaded through it when it fits
+		void LoadData(const TTN_Texture2DData::st2ddptr& data, TTN_PixelUnpackBuffer* stagingBuffer = nullptr);
 
 		//Getters for details about the texture
 		//width
@@ -135,6 +139,9 @@ namespace Titan {
 		Texture_Wrap_Mode GetVertWrapMode() const { return m_data.vertWrapMode; }
 		//underlying data
 		const TTN_Texture2DDesc& GetDescription() const { return m_data; }
+		//a number that changes whenever the texture's pixels or filtering change, so copies of it (like the sprite atlas) know
+		//when they're out of date
+		uint32_t GetGeneration() const { return m_generation; }
 
 
 		//setters for the filters and wrap mode
@@ -151,6 +158,7 @@ namespace Titan {
 
 	private:
 		TTN_Texture2DDesc m_data;
+		uint32_t m_generation = 0;
 
 		void RecreateTexture();
 	};
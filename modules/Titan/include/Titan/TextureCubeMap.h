@@ -114,8 +114,8 @@ namespace Titan {
 		//default destructor, ITexture handles destroying data in opengl so we can just use the autogeneterated one
 		~TTN_TextureCubeMap() = default;
 
-		//loads data into the texture
-		void LoadData(const TTN_TextureCubeMapData::stcmdptr& data);
+		//loads data into the texture, if a staging buffer is given the data is uploaded through it when it fits
+		void LoadData(const TTN_TextureCubeMapData::stcmdptr& data, TTN_PixelUnpackBuffer* stagingBuffer = nullptr);
 
 		//loads from a series of 6 images
 		static stcmptr LoadFromImages(const std::string& filePath);
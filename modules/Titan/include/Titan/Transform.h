@@ -6,19 +6,31 @@
 #include "ttn_pch.h"
 
 namespace Titan {
+	//forward declare the system that resolves the hierarchy
+	class TTN_TransformSystem;
 
 	//transform class, defines the transform component 
 	class TTN_Transform {
+		//the transform system writes the resolved global matrices back into the components
+		friend class TTN_TransformSystem;
+
 	public:
 		//constructor 
 		TTN_Transform();
 
 		//constructor that takes all the data and makes a transform out of it
-		TTN_Transform(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale, TTN_Transform* parent = nullptr, entt::entity* parentEntity = nullptr);
+		TTN_Transform(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale, entt::entity parentEntity = entt::null);
 
 		//destructor 
 		~TTN_Transform();
 
+		//copy constructor and assingment, copies are not attached to any transform system until entt constructs them as a component
+		TTN_Transform(const TTN_Transform& other);
+		TTN_Transform& operator=(const TTN_Transform& other);
+		//move constructor and assingment for ENTT, these keep their place in the transform system
+		TTN_Transform(TTN_Transform&&) = default;
+		TTN_Transform& operator=(TTN_Transform&&) = default;
+
 		//SETTERS  
 		//position 
 		void SetPos(glm::vec3 pos);
@@ -26,8 +38,10 @@ namespace Titan {
 		void SetScale(glm::vec3 scale);
 		//rotation
 		void SetRotationQuat(glm::quat rotationQuat);
-		//parent
-		void SetParent(TTN_Transform* parent, entt::entity* parentEntity);
+		//position and rotation together, only recomputing the matrix once
+		void SetPosAndRotation(glm::vec3 pos, glm::quat rotationQuat);
+		//parent, the global matrix of a child is resolved by the scene's transform system once per frame
+		void SetParent(entt::entity parentEntity);
 
 
 		//GETTERS
@@ -44,8 +58,8 @@ namespace Titan {
 		//global transform matrix
 		glm::mat4 GetGlobal();
 		//parent 
-		TTN_Transform* GetParent();
-		entt::entity* GetParentEntity() { return m_parentEntity; }
+		entt::entity GetParentEntity() { return m_parentEntity; }
+		bool HasParent() { return m_parentEntity != entt::null; }
 
 		//rotates by inputed value
 		void RotateRelative(glm::vec3 rotation);
@@ -57,18 +71,17 @@ namespace Titan {
 		void LookAlong(glm::vec3 direction, glm::vec3 up);
 
 	protected:
-		//function that will recalculate the transformation matrix, call from the setters (so whenever a change is made to the object) 
+		//function that will recalculate the local transformation matrix, call from the setters (so whenever a change is made to the object) 
+		//only touches this transform, children are updated when the transform system resolves the hierarchy
 		void Recompute();
 
-		//functions to add or remove children (handled by setParent)
-		void AddChild(TTN_Transform* child);
-		void RemoveChild(TTN_Transform* child);
-
 	private:
 		/// Hierararchy ///
-		TTN_Transform* m_Parent;
-		entt::entity* m_parentEntity; //needed to reconstruct the parenting relationship when entt's interal stuff changes 
-		std::vector<TTN_Transform*> m_Children;
+		entt::entity m_parentEntity; //the entity of the parent, entt::null if this transform has none
+
+		/// Transform system ///
+		TTN_TransformSystem* m_system; //the system tracking this transform, nullptr if it's not a component in a scene
+		int m_slot; //the index of this transform in the system's arrays, -1 if it hasn't been assigned one yet
 
 		/// LOCAL /// 
 		//stores the position
@@ -0,0 +1,81 @@
+//Titan Engine, by Atlas X Games
+// TransformSystem.h - header for the class that resolves the transform hierarchy of a scene
+#pragma once
+
+//precompile header, this file uses GLM/glm.hpp, entt.hpp, vector, and unordered_map
+#include "ttn_pch.h"
+//include unordered set for the parenting loops that have been reported
+#include <unordered_set>
+
+namespace Titan {
+	//forward declare the transform component
+	class TTN_Transform;
+
+	//transform system class, stores the local and global matrices of every transform in a scene in flat arrays sorted so
+	//parents always come before their children, meaning the whole hierarchy can be resolved in one linear pass
+	class TTN_TransformSystem {
+	public:
+		//constructor, hooks into the registry so it knows when transforms are added, replaced, or removed
+		TTN_TransformSystem(entt::registry* registry);
+
+		//destructor, unhooks from the registry
+		~TTN_TransformSystem();
+
+		//ensure moving and copying is not allowed as the transform components store a pointer back to the system
+		TTN_TransformSystem(const TTN_TransformSystem& other) = delete;
+		TTN_TransformSystem(TTN_TransformSystem& other) = delete;
+		TTN_TransformSystem& operator=(const TTN_TransformSystem& other) = delete;
+		TTN_TransformSystem& operator=(TTN_TransformSystem&& other) = delete;
+
+		//recalculates the global matrix of every transform that has changed (or has a parent that changed) since the last call
+		void Resolve();
+
+		//marks that the parenting structure has changed and the arrays need to be rebuilt before the next resolve
+		void MarkHierarchyDirty() { m_hierarchyDirty = true; }
+
+		//copies a new local matrix into the slot and marks it as dirty, called by the transform setters
+		void SetLocal(int slot, const glm::mat4& local);
+
+		//gets the number of transforms the system is tracking
+		size_t GetCount() const { return m_entities.size(); }
+		//gets the entities whose global matrix has changed since the moved list was last cleared
+		const std::vector<entt::entity>& GetMovedEntities() const { return m_moved; }
+		//clears the moved list, called once whatever needed it has caught up
+		void ClearMovedEntities() { m_moved.clear(); }
+
+	private:
+		//rebuilds the depth sorted arrays from the registry
+		void Rebuild();
+
+		//gets the depth of an entity in the hierarchy (0 for roots), using the map to avoid walking the same chain twice
+		int CalculateDepth(entt::entity entity, std::unordered_map<entt::entity, int>& depths, int guard = 0);
+
+		//registry callbacks
+		void OnTransformConstructed(entt::registry& registry, entt::entity entity);
+		void OnTransformDestroyed(entt::registry& registry, entt::entity entity);
+
+		//the registry the transforms live in
+		entt::registry* m_registry;
+
+		//boolean marking if the arrays need to be rebuilt
+		bool m_hierarchyDirty;
+
+		/// Depth sorted arrays, the same index refers to the same transform in all of them ///
+		//the entity that owns each transform
+		std::vector<entt::entity> m_entities;
+		//the index of each transform's parent in these arrays, -1 if it has no parent
+		std::vector<int> m_parents;
+		//the local matrix of each transform
+		std::vector<glm::mat4> m_locals;
+		//the global matrix of each transform
+		std::vector<glm::mat4> m_globals;
+		//flags for which transforms have changed since the last resolve
+		std::vector<uint8_t> m_dirty;
+
+		//the entities that have moved since the list was last cleared (may contain duplicates)
+		std::vector<entt::entity> m_moved;
+
+		//the entities a parenting loop was broken at, so each loop is only warned about once
+		std::unordered_set<entt::entity> m_reportedLoops;
+	};
+}
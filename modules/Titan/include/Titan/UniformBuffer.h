@@ -0,0 +1,57 @@
+//Titan Engine, by Atlas X Games
+// UniformBuffer.h - header for the class that stores blocks of uniforms shaders can share (UBOs)
+#pragma once
+
+//import the buffer base class, which also includes the precompile header, which has the other features we need here
+//including glad/glad.h and memory
+#include "IBuffer.h"
+
+namespace Titan {
+	//the binding points titan's default shaders read their uniform blocks from (layout(std140, binding = x) in GLSL)
+	enum class TTN_UniformBinding {
+		//per frame data, camera matrices, ambient lighting, and the lights
+		FRAME = 0,
+		//per material data, shininess and height map influence
+		MATERIAL = 1
+	};
+
+	//class for a uniform buffer, used to send blocks of uniforms to every shader that reads them with a single update
+	class TTN_UniformBuffer : public TTN_IBuffer {
+	public:
+		//defines a special easier to use name for shared(smart) pointers to the class
+		typedef std::shared_ptr<TTN_UniformBuffer> subptr;
+
+		//creates and returns a shared(smart) pointer to the class
+		static inline subptr Create(GLenum usage = GL_DYNAMIC_DRAW) {
+			return std::make_shared<TTN_UniformBuffer>(usage);
+		}
+
+	public:
+		//constructor, creates a new uniform buffer with the given usage, data will need to be loaded before it can be used
+		TTN_UniformBuffer(GLenum usage = GL_DYNAMIC_DRAW) : TTN_IBuffer(GL_UNIFORM_BUFFER, usage)
+			{ }
+
+		//updates part of the buffer without reallocating it, offset and size are in bytes
+		inline void UpdateData(const void* data, size_t offset, size_t size) {
+			glNamedBufferSubData(_handle, offset, size, data);
+		}
+
+		//binds the buffer to an indexed binding point so shaders can read it
+		inline void BindBase(GLuint binding) {
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, _handle);
+		}
+		inline void BindBase(TTN_UniformBinding binding) {
+			BindBase((GLuint)binding);
+		}
+
+		//unbinds whatever buffer is bound to an indexed binding point
+		static inline void UnBindBase(GLuint binding) {
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, 0);
+		}
+
+		//unbinds the current uniform buffer
+		static void UnBind() {
+			TTN_IBuffer::UnBind(GL_UNIFORM_BUFFER);
+		}
+	};
+}
@@ -98,9 +98,21 @@ namespace Titan {
 
 		//Renders the VAO
 		void Render() const;
-		void RenderInstanced(size_t numOfObjects, size_t numOfVerts = 0) const;
+		//Renders only part of the VAO, count indices starting from first (or count vertices if it doesn't have an IBO), so several
+		//draws with different state can share the same buffers
+		void RenderRange(size_t first, size_t count) const;
+		//baseInstance offsets where the instanced attributes start reading, so several draws can share one instance buffer
+		void RenderInstanced(size_t numOfObjects, size_t numOfVerts = 0, size_t baseInstance = 0) const;
+		//Renders the VAO using a draw command stored in a buffer (a DrawArraysIndirectCommand, or DrawElementsIndirectCommand if
+		//it has an IBO) at the given offset in bytes, so the gpu can decide how much gets drawn
+		void RenderIndirect(const TTN_IBuffer& commandBuffer, size_t offset = 0) const;
 
 	private:
+		//points the attributes of any streaming VBOs at the region they were last written to, called before drawing
+		void BindStreamingRegions() const;
+		//marks the regions of any streaming VBOs that were just drawn as in use by the gpu, called after drawing
+		void MarkStreamingRegionsDrawn() const;
+
 		//structure to store a VBO and it's attributes
 		struct VertexBufferBinding
 		{
@@ -116,6 +128,9 @@ namespace Titan {
 		//the number of vertices
 		GLsizei _vertexCount;
 
+		//wheter or not any of the VBOs are streaming buffers
+		bool _hasStreamingVbos;
+
 		//the openGL handle that the class is wrapping around
 		GLuint _handle;
 	};
@@ -20,19 +20,75 @@ namespace Titan {
 			return std::make_shared<TTN_VertexBuffer>(usage);
 		}
 
+		//creates and returns a shared(smart) pointer to a streaming vertex buffer, a persistently mapped ring of numOfRegions
+		//regions that can each hold maxElements elements of elementSize bytes
+		static inline svbptr CreateStreaming(size_t elementSize, size_t maxElements, size_t numOfRegions = 3) {
+			return std::make_shared<TTN_VertexBuffer>(elementSize, maxElements, numOfRegions);
+		}
+
 	public:
 		//constructor, creates a new vertex buffer with the given usage, data will be still need be loaded before it can be used though
-		TTN_VertexBuffer(GLenum usage = GL_STATIC_DRAW) : TTN_IBuffer(GL_ARRAY_BUFFER, usage)
+		TTN_VertexBuffer(GLenum usage = GL_STATIC_DRAW) : TTN_IBuffer(GL_ARRAY_BUFFER, usage),
+			m_streaming(false), m_mappedData(nullptr), m_maxElements(0), m_numOfRegions(0), m_currentRegion(0),
+			m_currentRegionDrawn(false)
 			{ }
 
+		//constructor, creates a new streaming vertex buffer, allocating immutable storage for all the regions and mapping it
+		TTN_VertexBuffer(size_t elementSize, size_t maxElements, size_t numOfRegions);
+
+		//destructor, unmaps the buffer and deletes any fences if it is streaming
+		~TTN_VertexBuffer();
+
+		//loads data into the buffer, streaming buffers copy it into the next region of the ring rather than reallocating the buffer
+		void LoadData(const void* data, size_t elementSize, size_t elementCount) override;
+		using TTN_IBuffer::LoadData;
+
+		//moves a streaming buffer onto the next region of the ring, waiting until the gpu is done with it, and returns a pointer to
+		//the mapped memory so the data can be written straight into it
+		void* BeginWrite();
+		template <typename T>
+		T* BeginWrite() { return static_cast<T*>(BeginWrite()); }
+		//finishes writing to the current region, saving how many elements were written
+		void EndWrite(size_t elementCount);
+
+		//notes that a draw call read from the current region, so it gets fenced once the buffer moves on from it and won't be
+		//written again until the gpu has read it (the VAO does this automatically for any streaming buffers it renders)
+		void MarkCurrentRegionDrawn() { m_currentRegionDrawn = true; }
+
+		//gets wheter or not this is a streaming buffer
+		bool IsStreaming() const { return m_streaming; }
+		//gets the maximum number of elements a region of a streaming buffer can hold
+		size_t GetMaxElementCount() const { return m_maxElements; }
+		//gets the offset in bytes from the start of the buffer to the current region
+		size_t GetCurrentOffset() const { return m_currentRegion * m_maxElements * _elementSize; }
+
 		//unbinds the current vertex buffer
 		static void UnBind() {
 			TTN_IBuffer::UnBind(GL_ARRAY_BUFFER);
 		}
 
+	private:
+		//fences the current region if it was drawn, called as the buffer moves on from it so every draw using it is covered
+		void RetireCurrentRegion();
+		//blocks until the fence on the given region has been passed by the gpu
+		void WaitForRegion(size_t region);
+
+		//wheter or not this is a streaming buffer
+		bool m_streaming;
+		//pointer to the persistently mapped storage
+		uint8_t* m_mappedData;
+		//the number of elements each region can hold
+		size_t m_maxElements;
+		//the number of regions in the ring
+		size_t m_numOfRegions;
+		//the region that was last written to (and is the one that will be drawn)
+		size_t m_currentRegion;
+		//wheter or not the current region has been drawn since it was written
+		bool m_currentRegionDrawn;
+		//fences for each region, null when the region isn't waiting on the gpu
+		std::vector<GLsync> m_fences;
 	}; 
 
-	//this class is a lot shorter than the index buffer as the exact type of data the vertices are stored in isn't that important 
-	// so we can just use the LoadData from IBuffer and the overloads to ensure the types were compabatile with the index buffer 
-	//took a lot of code, in reality, niether class is missing any required functionality 
+	//the exact type of data the vertices are stored in isn't that important so regular vertex buffers just use the LoadData from
+	//IBuffer, streaming buffers override it to write into their mapped ring instead
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include <memory>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <cfloat>
 #include <stdexcept>
 #include <iostream>
 #include <stdio.h>
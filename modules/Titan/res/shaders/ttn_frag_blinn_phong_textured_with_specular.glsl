@@ -1,4 +1,4 @@
-#version 410
+#version 420
 
 //mesh data from vert shader
 layout(location = 0) in vec3 inPos;
@@ -6,28 +6,37 @@ layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
 layout(location = 3) in vec3 inColor;
 
-//material data
-uniform sampler2D s_Diffuse;
-uniform sampler2D s_Specular;
-uniform float u_Shininess;
-
-//scene ambient lighting
-uniform vec3  u_AmbientCol;
-uniform float u_AmbientStrength;
-
-//Specfic light stuff
-uniform vec3  u_LightPos[16];
-uniform vec3  u_LightCol[16];
-uniform float u_AmbientLightStrength[16];
-uniform float u_SpecularLightStrength[16];
-uniform float u_LightAttenuationConstant[16];
-uniform float u_LightAttenuationLinear[16];
-uniform float u_LightAttenuationQuadratic[16];
-
-uniform int u_NumOfLights;
-
-//camera data
-uniform vec3  u_CamPos;
+//material textures
+layout(binding = 0) uniform sampler2D s_Diffuse;
+layout(binding = 1) uniform sampler2D s_Specular;
+
+//per material data
+layout(std140, binding = 1) uniform TTN_MaterialData {
+	float u_Shininess;
+	float u_HeightInfluence;
+};
+
+//per frame data, shared by all of titan's default shaders
+struct TTN_LightData {
+	//xyz position, w ambient strength
+	vec4 position;
+	//rgb color, w specular strength
+	vec4 color;
+	//x constant, y linear, z quadratic attenuation
+	vec4 attenuation;
+};
+layout(std140, binding = 0) uniform TTN_FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_VP;
+	//xyz camera position
+	vec4 u_CamPos;
+	//rgb scene ambient color, a scene ambient strength
+	vec4 u_Ambient;
+	//x number of lights
+	ivec4 u_NumOfLights;
+	TTN_LightData u_Lights[16];
+};
 
 //result
 out vec4 frag_color;
@@ -39,7 +48,7 @@ vec3 CalcLight(vec3 pos, vec3 col, float ambStr, float specStr, float attenConst
 void main() {
 	//calcualte the vectors needed for lighting
 	vec3 N = normalize(inNormal);
-	vec3 viewDir  = normalize(u_CamPos - inPos);
+	vec3 viewDir  = normalize(u_CamPos.xyz - inPos);
 	//sample the textures
 	float texSpec = texture(s_Specular, inUV).x;
 	vec4 textureColor = texture(s_Diffuse, inUV);
@@ -48,12 +57,12 @@ void main() {
 		discard;
 
 	//combine everything
-	vec3 result = u_AmbientCol * u_AmbientStrength; // global ambient light
+	vec3 result = u_Ambient.rgb * u_Ambient.a; // global ambient light
 
 	//add the results from all the lights
-	for(int i = 0; i < u_NumOfLights; i++) {
-		result = result + CalcLight(u_LightPos[i], u_LightCol[i], u_AmbientLightStrength[i], u_SpecularLightStrength[i], 
-					u_LightAttenuationConstant[i], u_LightAttenuationLinear[i], u_LightAttenuationQuadratic[i], 
+	for(int i = 0; i < u_NumOfLights.x; i++) {
+		result = result + CalcLight(u_Lights[i].position.xyz, u_Lights[i].color.rgb, u_Lights[i].position.w, u_Lights[i].color.w, 
+					u_Lights[i].attenuation.x, u_Lights[i].attenuation.y, u_Lights[i].attenuation.z, 
 					N, viewDir, texSpec);
 	}
 
@@ -1,8 +1,8 @@
-#version 410
+#version 420
 
 layout(location = 0) in vec3 inNormal;
 
-uniform samplerCube s_Environment;
+layout(binding = 0) uniform samplerCube s_Environment;
 
 out vec4 frag_color;
 
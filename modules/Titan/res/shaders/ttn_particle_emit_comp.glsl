@@ -0,0 +1,139 @@
+#version 430
+
+//emits new particles for the gpu particle backend, one thread per new particle
+layout(local_size_x = 64) in;
+
+//a single particle, must match the layout in the update and vertex shaders
+struct Particle {
+	vec4 position; //xyz is the position, w is how long it's been alive
+	vec4 startVelocity; //xyz is the start velocity, w is the lifetime
+	vec4 endVelocity; //xyz is the end velocity
+	vec4 startColor;
+	vec4 endColor;
+	vec4 color; //the interpolated color used for rendering
+	vec4 scale; //x is the start scale, y is the end scale, z is the interpolated scale used for rendering
+};
+
+//buffers
+layout(std430, binding = 0) buffer ParticleBuffer { Particle particles[]; };
+layout(std430, binding = 1) buffer AliveListIn { uint aliveIn[]; };
+layout(std430, binding = 3) buffer DeadList { uint deadList[]; };
+layout(std430, binding = 4) buffer Counters {
+	//the first four are a DrawArraysIndirectCommand, instanceCount doubles as the number of particles that survived the update
+	uint vertexCount;
+	uint instanceCount;
+	uint firstVertex;
+	uint baseInstance;
+	//the number of particles in the alive list being updated this frame
+	uint aliveCount;
+	//the number of free particles on the dead list
+	int deadCount;
+};
+
+//emission data from c++
+uniform int u_emitCount;
+uniform int u_seed;
+uniform int u_emitterShape; //0 cone, 1 sphere, 2 circle, 3 cube
+uniform float u_emitterAngle;
+uniform vec3 u_emitterScale;
+uniform mat3 u_emitterRotation;
+
+//particle template data from c++
+uniform vec4 u_startColor;
+uniform vec4 u_startColor2;
+uniform vec4 u_endColor;
+uniform vec4 u_endColor2;
+uniform vec2 u_startSize;
+uniform vec2 u_endSize;
+uniform vec2 u_startSpeed;
+uniform vec2 u_endSpeed;
+uniform vec2 u_lifeTime;
+
+//random number generation (pcg hash)
+uint rngState;
+uint PcgHash(uint value) {
+	uint state = value * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+float RandomFloat(float minimum, float maximum) {
+	rngState = PcgHash(rngState);
+	return mix(minimum, maximum, float(rngState) / 4294967295.0);
+}
+
+//rotation matrix for an euler angle with no y rotation, matching glm::toMat4(glm::quat(vec3(x, 0, z)))
+mat3 RotationXZ(float x, float z) {
+	float cx = cos(x), sx = sin(x);
+	float cz = cos(z), sz = sin(z);
+	mat3 rotX = mat3(1.0, 0.0, 0.0, 0.0, cx, sx, 0.0, -sx, cx);
+	mat3 rotZ = mat3(cz, sz, 0.0, -sz, cz, 0.0, 0.0, 0.0, 1.0);
+	return rotZ * rotX;
+}
+
+void main() {
+	if (gl_GlobalInvocationID.x >= uint(u_emitCount))
+		return;
+
+	//take a free particle off the dead list, if there aren't any left the particle just isn't emitted
+	int freeCount = atomicAdd(deadCount, -1);
+	if (freeCount <= 0) {
+		atomicAdd(deadCount, 1);
+		return;
+	}
+	uint index = deadList[freeCount - 1];
+
+	rngState = PcgHash(uint(u_seed) ^ PcgHash(gl_GlobalInvocationID.x));
+
+	Particle p;
+
+	//position
+	p.position = vec4(0.0);
+	if (u_emitterShape == 3) {
+		p.position.xyz = vec3(RandomFloat(-u_emitterScale.x / 2.0, u_emitterScale.x / 2.0),
+			RandomFloat(-u_emitterScale.y / 2.0, u_emitterScale.y / 2.0),
+			RandomFloat(-u_emitterScale.z / 2.0, u_emitterScale.z / 2.0));
+	}
+
+	//colors
+	p.startColor = vec4(RandomFloat(u_startColor.r, u_startColor2.r), RandomFloat(u_startColor.g, u_startColor2.g),
+		RandomFloat(u_startColor.b, u_startColor2.b), RandomFloat(u_startColor.a, u_startColor2.a));
+	p.endColor = vec4(RandomFloat(u_endColor.r, u_endColor2.r), RandomFloat(u_endColor.g, u_endColor2.g),
+		RandomFloat(u_endColor.b, u_endColor2.b), RandomFloat(u_endColor.a, u_endColor2.a));
+	p.color = p.startColor;
+
+	//direction
+	vec3 dir = vec3(0.0, 1.0, 0.0);
+	//sphere emitter
+	if (u_emitterShape == 1) {
+		dir = normalize(vec3(RandomFloat(-1.0, 1.0), RandomFloat(-1.0, 1.0), RandomFloat(-1.0, 1.0)));
+	}
+	//circle emitter
+	else if (u_emitterShape == 2) {
+		dir = u_emitterRotation * normalize(vec3(RandomFloat(-1.0, 1.0), RandomFloat(-1.0, 1.0), 0.0));
+	}
+	//cone emitter
+	else if (u_emitterShape == 0) {
+		float x = radians(RandomFloat(-u_emitterAngle, u_emitterAngle));
+		float z = radians(RandomFloat(-u_emitterAngle, u_emitterAngle));
+		dir = u_emitterRotation * (RotationXZ(x, z) * dir);
+	}
+	//cube emitter
+	else {
+		dir = u_emitterRotation * dir;
+	}
+
+	//velocities and lifetime
+	p.startVelocity = vec4(dir * RandomFloat(u_startSpeed.x, u_startSpeed.y), RandomFloat(u_lifeTime.x, u_lifeTime.y));
+	p.endVelocity = vec4(dir * RandomFloat(u_endSpeed.x, u_endSpeed.y), 0.0);
+
+	//scales
+	p.scale.x = RandomFloat(u_startSize.x, u_startSize.y);
+	p.scale.y = RandomFloat(u_endSize.x, u_endSize.y);
+	p.scale.z = p.scale.x;
+	p.scale.w = 0.0;
+
+	particles[index] = p;
+
+	//add it to the alive list so it gets updated this frame
+	aliveIn[atomicAdd(aliveCount, 1u)] = index;
+}
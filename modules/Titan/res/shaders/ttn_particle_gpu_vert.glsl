@@ -0,0 +1,48 @@
+#version 430
+
+//data from c++
+//regular vbos
+layout(location = 0) in vec3 inVertPos;
+layout(location = 1) in vec3 inVertNorm;
+layout(location = 2) in vec2 inVertUV;
+
+//a single particle, must match the layout in the emit and update shaders
+struct Particle {
+	vec4 position; //xyz is the position, w is how long it's been alive
+	vec4 startVelocity; //xyz is the start velocity, w is the lifetime
+	vec4 endVelocity; //xyz is the end velocity
+	vec4 startColor;
+	vec4 endColor;
+	vec4 color; //the interpolated color used for rendering
+	vec4 scale; //x is the start scale, y is the end scale, z is the interpolated scale used for rendering
+};
+
+//the particles and the list of the ones that survived the update, each instance is one entry on that list
+layout(std430, binding = 0) readonly buffer ParticleBuffer { Particle particles[]; };
+layout(std430, binding = 2) readonly buffer AliveList { uint aliveIndices[]; };
+
+//mesh data to pass to the frag shader
+layout(location = 0) out vec3 outPos;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec2 outUV;
+layout(location = 3) out vec4 outColor;
+
+uniform mat4 u_model;
+uniform mat4 u_mvp;
+uniform mat3 u_normalMat;
+
+void main() {
+	Particle p = particles[aliveIndices[gl_InstanceID]];
+
+	//calculate the position
+	vec3 ParticlePos = inVertPos * p.scale.z + p.position.xyz;
+
+	//pass data onto the frag shader
+	outPos = (u_model * vec4(ParticlePos, 1.0)).xyz;
+	outNormal = u_normalMat * inVertNorm;
+	outUV = inVertUV;
+	outColor = p.color;
+
+	//set the position of the vertex
+	gl_Position = u_mvp * vec4(ParticlePos, 1.0);
+}
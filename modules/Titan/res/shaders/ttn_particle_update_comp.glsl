@@ -0,0 +1,77 @@
+#version 430
+
+//updates the living particles for the gpu particle backend, one thread per particle
+layout(local_size_x = 64) in;
+
+//a single particle, must match the layout in the emit and vertex shaders
+struct Particle {
+	vec4 position; //xyz is the position, w is how long it's been alive
+	vec4 startVelocity; //xyz is the start velocity, w is the lifetime
+	vec4 endVelocity; //xyz is the end velocity
+	vec4 startColor;
+	vec4 endColor;
+	vec4 color; //the interpolated color used for rendering
+	vec4 scale; //x is the start scale, y is the end scale, z is the interpolated scale used for rendering
+};
+
+//buffers
+layout(std430, binding = 0) buffer ParticleBuffer { Particle particles[]; };
+layout(std430, binding = 1) readonly buffer AliveListIn { uint aliveIn[]; };
+layout(std430, binding = 2) writeonly buffer AliveListOut { uint aliveOut[]; };
+layout(std430, binding = 3) buffer DeadList { uint deadList[]; };
+layout(std430, binding = 4) buffer Counters {
+	//the first four are a DrawArraysIndirectCommand, instanceCount doubles as the number of particles that survived the update
+	uint vertexCount;
+	uint instanceCount;
+	uint firstVertex;
+	uint baseInstance;
+	//the number of particles in the alive list being updated this frame
+	uint aliveCount;
+	//the number of free particles on the dead list
+	int deadCount;
+};
+//the baked velocity, color, and scale readgraphs, one after another
+layout(std430, binding = 5) readonly buffer ReadGraphs { float readGraphs[]; };
+
+//data from c++
+uniform float u_deltaTime;
+uniform int u_readGraphSamples;
+
+//reads a value from a baked readgraph, linearly interpolating between the two nearest samples
+float SampleReadGraph(uint graph, float t) {
+	uint samples = uint(u_readGraphSamples);
+	float sampleIndex = t * float(samples - 1u);
+	uint index = min(uint(sampleIndex), samples - 2u);
+	uint base = graph * samples;
+	return mix(readGraphs[base + index], readGraphs[base + index + 1u], sampleIndex - float(index));
+}
+
+void main() {
+	if (gl_GlobalInvocationID.x >= aliveCount)
+		return;
+
+	uint index = aliveIn[gl_GlobalInvocationID.x];
+	Particle p = particles[index];
+
+	//update how long the particle has been alive, if it's gone through it's lifetime put it back on the dead list
+	p.position.w += u_deltaTime;
+	if (p.position.w >= p.startVelocity.w) {
+		deadList[atomicAdd(deadCount, 1)] = index;
+		return;
+	}
+
+	//get a t value for interpolation
+	float t = clamp(p.position.w / p.startVelocity.w, 0.0, 1.0);
+
+	//update the position based on the interpolation of the velocities
+	p.position.xyz += mix(p.startVelocity.xyz, p.endVelocity.xyz, SampleReadGraph(0u, t)) * u_deltaTime;
+
+	//interpolate the color and scale for rendering
+	p.color = mix(p.startColor, p.endColor, SampleReadGraph(1u, t));
+	p.scale.z = mix(p.scale.x, p.scale.y, SampleReadGraph(2u, t));
+
+	particles[index] = p;
+
+	//add it to the alive list that gets drawn
+	aliveOut[atomicAdd(instanceCount, 1u)] = index;
+}
@@ -1,17 +1,20 @@
 #version 410
-//mesh data from c++ program
+//mesh data from c++ program, the quads are already in world space
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec2 inUv;
+layout(location = 2) in vec4 inColor;
 
 //mesh data to pass to the frag shader
 layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
 
-//model view projection matrix
-uniform mat4 MVP;
+//view projection matrix
+uniform mat4 u_VP;
 
 void main() {
-	//send the uvs onto the frag shader 
+	//send the uvs and color onto the frag shader 
 	outUV = inUv;
+	outColor = inColor;
 	//set the vertex position
-	gl_Position = MVP * vec4(inPos, 1.0);
+	gl_Position = u_VP * vec4(inPos, 1.0);
 }
\ No newline at end of file
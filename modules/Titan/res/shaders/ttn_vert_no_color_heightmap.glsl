@@ -1,8 +1,11 @@
-#version 410
+#version 420
 //mesh data from c++ program
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
+//per instance data, used when the mesh is drawn instanced
+layout(location = 6) in mat4 inInstanceModel;
+layout(location = 10) in mat3 inInstanceNormalMat;
 
 //mesh data to pass to the frag shader
 layout(location = 0) out vec3 outPos;
@@ -10,11 +13,36 @@ layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outUV;
 layout(location = 3) out vec3 outColor;
 
-//texture
-uniform sampler2D Texture;
+//height map
+layout(binding = 2) uniform sampler2D s_HeightMap;
 
-//influnce the displacement map should have 
-uniform float u_influence;
+//per material data
+layout(std140, binding = 1) uniform TTN_MaterialData {
+	float u_Shininess;
+	float u_HeightInfluence;
+};
+
+//per frame data, shared by all of titan's default shaders
+struct TTN_LightData {
+	//xyz position, w ambient strength
+	vec4 position;
+	//rgb color, w specular strength
+	vec4 color;
+	//x constant, y linear, z quadratic attenuation
+	vec4 attenuation;
+};
+layout(std140, binding = 0) uniform TTN_FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_VP;
+	//xyz camera position
+	vec4 u_CamPos;
+	//rgb scene ambient color, a scene ambient strength
+	vec4 u_Ambient;
+	//x number of lights
+	ivec4 u_NumOfLights;
+	TTN_LightData u_Lights[16];
+};
 
 //model, view, projection matrix
 uniform mat4 MVP;
@@ -22,19 +50,25 @@ uniform mat4 MVP;
 uniform mat4 Model; 
 //normal matrix
 uniform mat3 NormalMat;
+//wheter the model and normal matrices should come from the per instance data instead of the uniforms above
+uniform bool u_Instanced;
 
 void main() {
+	//get the matrices for this instance
+	mat4 model = u_Instanced ? inInstanceModel : Model;
+	mat3 normalMat = u_Instanced ? inInstanceNormalMat : NormalMat;
+	mat4 mvp = u_Instanced ? u_VP * inInstanceModel : MVP;
 
 	//pass data onto the frag shader
-	outPos = (Model * vec4(inPos, 1.0)).xyz;
-	outNormal = NormalMat * inNormal;
+	outPos = (model * vec4(inPos, 1.0)).xyz;
+	outNormal = normalMat * inNormal;
 	outUV = inUV;
 	outColor = vec3(1.0, 1.0, 1.0);
 
 	vec3 vert = inPos;
-	vert = vert + texture(Texture, inUV).r * u_influence * outNormal;
-	//vert.y = texture (Texture, inUV).r; 
+	vert = vert + texture(s_HeightMap, inUV).r * u_HeightInfluence * outNormal;
+	//vert.y = texture (s_HeightMap, inUV).r; 
 		
-	vec4 newPos = MVP * vec4(vert, 1.0);
+	vec4 newPos = mvp * vec4(vert, 1.0);
 	gl_Position = newPos;
 }
\ No newline at end of file
@@ -1,11 +1,12 @@
-#version 410
+#version 430
 
 //mesh data from c++ program
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
-layout(location = 4) in vec3 inPosNextFrame;
-layout(location = 5) in vec3 inNormalNextFrame;
+//per instance data, used when the mesh is drawn instanced
+layout(location = 6) in mat4 inInstanceModel;
+layout(location = 10) in mat3 inInstanceNormalMat;
+//x current morph frame, y next morph frame, z interpolation parameter
+layout(location = 13) in vec3 inInstanceMorph;
 
 //mesh data to pass to the frag shader
 layout(location = 0) out vec3 outPos;
@@ -13,27 +14,71 @@ layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outUV;
 layout(location = 3) out vec3 outColor;
 
+//per frame data, shared by all of titan's default shaders
+struct TTN_LightData {
+	//xyz position, w ambient strength
+	vec4 position;
+	//rgb color, w specular strength
+	vec4 color;
+	//x constant, y linear, z quadratic attenuation
+	vec4 attenuation;
+};
+layout(std140, binding = 0) uniform TTN_FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_VP;
+	//xyz camera position
+	vec4 u_CamPos;
+	//rgb scene ambient color, a scene ambient strength
+	vec4 u_Ambient;
+	//x number of lights
+	ivec4 u_NumOfLights;
+	TTN_LightData u_Lights[16];
+};
+
 //model, view, projection matrix
 uniform mat4 MVP;
 //model matrix only
 uniform mat4 Model; 
 //normal matrix
 uniform mat3 NormalMat;
+//wheter the model and normal matrices should come from the per instance data instead of the uniforms above
+uniform bool u_Instanced;
 
-//uniform with the value of the interpolation 
-uniform float t; 
+//every morph frame of the mesh, frame after frame, with a position and normal for each vertex
+struct TTN_MorphVertex {
+	vec4 position;
+	vec4 normal;
+};
+layout(std430, binding = 6) readonly buffer TTN_MorphFrames {
+	TTN_MorphVertex u_MorphVertices[];
+};
+//the number of vertices in each frame
+uniform int u_MorphVertexCount;
+//the morph state used when the mesh isn't drawn instanced, x current frame, y next frame, z interpolation parameter
+uniform vec3 u_Morph;
 
 void main() {
+	//get the matrices for this instance
+	mat4 model = u_Instanced ? inInstanceModel : Model;
+	mat3 normalMat = u_Instanced ? inInstanceNormalMat : NormalMat;
+	mat4 mvp = u_Instanced ? u_VP * inInstanceModel : MVP;
+
+	//find this vertex in the current and next frames
+	vec3 morph = u_Instanced ? inInstanceMorph : u_Morph;
+	int current = int(morph.x) * u_MorphVertexCount + gl_VertexID;
+	int next = int(morph.y) * u_MorphVertexCount + gl_VertexID;
+
 	//lerp the positions and normals 
-	vec3 pos = mix(inPos, inPosNextFrame, t);
-	vec3 normal = normalize(mix(inNormal, inNormalNextFrame, t));
+	vec3 pos = mix(u_MorphVertices[current].position.xyz, u_MorphVertices[next].position.xyz, morph.z);
+	vec3 normal = normalize(mix(u_MorphVertices[current].normal.xyz, u_MorphVertices[next].normal.xyz, morph.z));
 
 	//apply the mvp matrix to the position
-	vec4 newPos = MVP * vec4(pos, 1.0);
+	vec4 newPos = mvp * vec4(pos, 1.0);
 
 	//pass data onto the frag shader
-	outPos = (Model * vec4(pos, 1.0)).xyz;
-	outNormal = NormalMat * normal;
+	outPos = (model * vec4(pos, 1.0)).xyz;
+	outNormal = normalMat * normal;
 	outUV = inUV;
 	outColor = vec3(1.0f, 1.0f, 1.0f);
 
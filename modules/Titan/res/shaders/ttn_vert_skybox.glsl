@@ -1,14 +1,36 @@
-#version 410
+#version 420
 
 layout(location = 0) in vec3 inPosition;
 
 layout(location = 0) out vec3 outNormal;
 
-uniform mat4 u_SkyboxMatrix;
+//per frame data, shared by all of titan's default shaders
+struct TTN_LightData {
+	//xyz position, w ambient strength
+	vec4 position;
+	//rgb color, w specular strength
+	vec4 color;
+	//x constant, y linear, z quadratic attenuation
+	vec4 attenuation;
+};
+layout(std140, binding = 0) uniform TTN_FrameData {
+	mat4 u_View;
+	mat4 u_Projection;
+	mat4 u_VP;
+	//xyz camera position
+	vec4 u_CamPos;
+	//rgb scene ambient color, a scene ambient strength
+	vec4 u_Ambient;
+	//x number of lights
+	ivec4 u_NumOfLights;
+	TTN_LightData u_Lights[16];
+};
+
 uniform mat3 u_EnvironmentRotation;
 
 void main() {
- vec4 pos = u_SkyboxMatrix * vec4(inPosition, 1.0);
+ //drop the translation from the view matrix so the skybox stays centered on the camera
+ vec4 pos = u_Projection * mat4(mat3(u_View)) * vec4(inPosition, 1.0);
 
  gl_Position = pos.xyww;
 
@@ -73,6 +73,15 @@ namespace Titan {
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+		//set up the profiler (this needs to happen before the worker threads start so the main thread is the first one in the timeline)
+		TTN_Profiler::Init();
+
+		//start the worker threads
+		TTN_JobSystem::Init();
+
+		//set up the instance buffer for the mesh renderers
+		TTN_Renderer::InitRenderer();
+
 		//set up the shader program for the particle system
 		TTN_ParticleSystem::InitParticleShader();
 
@@ -96,6 +105,8 @@ namespace Titan {
 	//function that cleans things up when the window closes so there are no memory leaks and everything goes cleanly 
 	void TTN_Application::Closing()
 	{
+		//clean up the profiler's gpu queries while we still have a gl context
+		TTN_Profiler::Shutdown();
 		//have glfw destroy the window 
 		glfwDestroyWindow(m_window);
 		//close glfw
@@ -103,6 +114,8 @@ namespace Titan {
 		//delete scene pointers
 		for (auto x : scenes)
 			delete x;
+		//stop the worker threads
+		TTN_JobSystem::Shutdown();
 	}
 
 	void TTN_Application::NewFrameStart()
@@ -134,34 +147,57 @@ namespace Titan {
 	//function to run each frame 
 	void TTN_Application::Update()
 	{
-		//start a new frame 
-		TTN_Application::NewFrameStart();
+		//start recording the frame in the profiler
+		TTN_Profiler::BeginFrame();
+
+		{
+			TTN_PROFILE_SCOPE("Frame Start");
+			//start a new frame 
+			TTN_Application::NewFrameStart();
 
-		//start ImGui
-		StartImgui();
+			//start ImGui
+			StartImgui();
 
-		//check for events from glfw 
-		glfwPollEvents();
+			//check for events from glfw 
+			glfwPollEvents();
+		}
 
-		//update the asset system
-		TTN_AssetSystem::Update();
+		{
+			TTN_PROFILE_SCOPE("Asset System Update");
+			//update the asset system
+			TTN_AssetSystem::Update();
+		}
 
 		//go through each scene 
 		for (int i = 0; i < TTN_Application::scenes.size(); i++) {
 			//and check if they should be rendered
 			if (TTN_Application::scenes[i]->GetShouldRender()) {
 				//if they should, then check input, update, and render them 
-				TTN_Application::scenes[i]->KeyDownChecks();
-				TTN_Application::scenes[i]->KeyChecks();
-				TTN_Application::scenes[i]->KeyUpChecks();
-
-				TTN_Application::scenes[i]->MouseButtonDownChecks();
-				TTN_Application::scenes[i]->MouseButtonChecks();
-				TTN_Application::scenes[i]->MouseButtonUpChecks();
-
-				TTN_Application::scenes[i]->Update(m_dt);
-				TTN_Application::scenes[i]->Render();
-				TTN_Application::scenes[i]->PostRender();
+				{
+					TTN_PROFILE_SCOPE("Scene Input");
+					TTN_Application::scenes[i]->KeyDownChecks();
+					TTN_Application::scenes[i]->KeyChecks();
+					TTN_Application::scenes[i]->KeyUpChecks();
+
+					TTN_Application::scenes[i]->MouseButtonDownChecks();
+					TTN_Application::scenes[i]->MouseButtonChecks();
+					TTN_Application::scenes[i]->MouseButtonUpChecks();
+				}
+
+				{
+					TTN_PROFILE_SCOPE("Scene Update");
+					TTN_Application::scenes[i]->Update(m_dt);
+				}
+				{
+					TTN_PROFILE_SCOPE("Scene Render");
+					TTN_PROFILE_GPU_SCOPE("Scene Render");
+					TTN_Application::scenes[i]->Render();
+				}
+				{
+					TTN_PROFILE_SCOPE("Scene Post Render");
+					TTN_PROFILE_GPU_SCOPE("Scene Post Render");
+					TTN_Application::scenes[i]->PostRender();
+				}
 			}
 		}
 
@@ -173,11 +209,24 @@ namespace Titan {
 		//now all the scenes that should be rendered (current gameplay scene, ui, etc.) will be rendered
 		//while anything that doesn't need to be rendered (such as a prefabs scene) will not 
 		
-		//end Imgui
-		EndImgui();
+		{
+			TTN_PROFILE_SCOPE("ImGui");
+			TTN_PROFILE_GPU_SCOPE("ImGui");
+			//draw the profiler window (if it's open)
+			TTN_Profiler::DrawImGui();
+
+			//end Imgui
+			EndImgui();
+		}
+
+		{
+			TTN_PROFILE_SCOPE("Swap Buffers");
+			//swap the buffers so all the drawings that the scenes just did are acutally visible 
+			glfwSwapBuffers(m_window);
+		}
 
-		//swap the buffers so all the drawings that the scenes just did are acutally visible 
-		glfwSwapBuffers(m_window);
+		//and finish recording the frame
+		TTN_Profiler::EndFrame();
 	}
 
 	//quits the application
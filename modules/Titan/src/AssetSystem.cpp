@@ -161,263 +161,370 @@ namespace Titan {
 
 	//loads an entire set of assets at the time of the function call
 	void TTN_AssetSystem::LoadSetNow(int set) {
-		//confirm there are textures in the set 
-		if (s_2DTexturesToLoad.size() > set) {
-			//iterate through all the 2D textures in the set first
-			for (auto it : s_2DTexturesToLoad[set]) {
-				//load the texture into the unordered map
-				s_texture2DMap[it.m_AccessName] = TTN_Texture2D::LoadFromFile(it.m_FileName);
+		//queue the set ahead of everything else
+		LoadSetInBackground(set, INT_MAX);
+
+		//and keep loading until it's done, using every worker and without any upload budget
+		const size_t maxInFlight = std::max((size_t)TTN_JobSystem::GetWorkerCount(), (size_t)1) * 2;
+		while (s_setStates[set].m_loading) {
+			DispatchRequests(maxInFlight);
+
+			//wait for the workers to finish something if there's nothing to upload
+			if (s_uploadQueue.empty()) {
+				std::unique_lock<std::mutex> lock(s_completedMutex);
+				s_completedSignal.wait(lock, []() { return !s_completedRequests.empty(); });
 			}
-		}
 
-		//confirm there are cubemaps in the set 
-		if (s_CubemapsToLoad.size() > set) {
-			//iterate through all the cubemap textures in the set next
-			for (auto it : s_CubemapsToLoad[set]) {
-				//load the cubemap into the unordered map
-				s_cubemapMap[it.m_AccessName] = TTN_TextureCubeMap::LoadFromImages(it.m_FileName);
-			}
+			UploadCompletedRequests(FLT_MAX);
 		}
+	}
 
-		//confirm there are non animated meshes in the set 
-		if (s_NonAnimatedMeshesToLoad.size() > set) {
-			//iterate through all the non-animated meshes in the set 
-			for (auto it : s_NonAnimatedMeshesToLoad[set]) {
-				//load the mesh into the unordered map
-				s_meshMap[it.m_AccessName] = TTN_ObjLoader::LoadFromFile(it.m_FileName);
-				s_meshMap[it.m_AccessName]->SetUpVao();
-			}
+	//load a set of assets in the background, reading and decoding them on the worker threads and uploading them a few at a time
+	void TTN_AssetSystem::LoadSetInBackground(int set, int priority) {
+		//if it's already loading, just change the priority
+		if (s_setStates[set].m_loading) {
+			SetSetPriority(set, priority);
+			return;
 		}
 
-		//confirm there are animated meshes in the set 
-		if (s_AnimatedMeshesToLoad.size() > set) {
-			//iterate through all the animated meshes in the set 
-			for (auto it : s_AnimatedMeshesToLoad[set]) {
-				//load the animated mesh into the unordered map
-				s_meshMap[it.m_AccessName] = TTN_ObjLoader::LoadAnimatedMeshFromFiles(it.m_FileName, it.m_number);
-				s_meshMap[it.m_AccessName]->SetUpVao();
-			}
-		}
+		s_setStates[set].m_priority = priority;
+		QueueSet(set);
+	}
 
-		//confirm there are non default shaders in the set
-		if (s_ShadersToLoad.size() > set) {
-			//iterate through all the non default shaders in the set
-			for (auto it : s_ShadersToLoad[set]) {
-				//create and load the shader
-				TTN_Shader::sshptr temp = TTN_Shader::Create();
-				temp->LoadShaderStageFromFile(it.m_vertShader.c_str(), GL_VERTEX_SHADER);
-				temp->LoadShaderStageFromFile(it.m_fragShader.c_str(), GL_FRAGMENT_SHADER);
-				temp->Link();
-				//and store it in the unordered map
-				s_shaderMap[it.m_AccessName] = temp;
-			}
-		}
+	//stops loading a set
+	void TTN_AssetSystem::CancelSet(int set) {
+		SetLoadState& state = s_setStates[set];
+		if (!state.m_loading)
+			return;
 
-		//confirm there are default shaders in the set
-		if (s_DefaultShadersToLoad.size() > set) {
-			//iterate through all the non default shaders in the set
-			for (auto it : s_DefaultShadersToLoad[set]) {
-				//create and load the shader
-				TTN_Shader::sshptr temp = TTN_Shader::Create();
-				temp->LoadDefaultShader(it.m_vertShader);
-				temp->LoadDefaultShader(it.m_fragShader);
-				temp->Link();
-				//and store it in the unordered map
-				s_shaderMap[it.m_AccessName] = temp;
-			}
-		}
+		//move the set onto a new generation so anything already being loaded gets thrown away when it's finished
+		state.m_generation++;
+		state.m_loading = false;
 
-		s_setsLoaded[set] = true;
+		//remove the requests that haven't been sent to the workers yet
+		s_pendingRequests.erase(std::remove_if(s_pendingRequests.begin(), s_pendingRequests.end(),
+			[set](const slrptr& request) { return request->m_set == set; }), s_pendingRequests.end());
+
+		//and remove it from the load queue
+		s_loadQueue.erase(std::remove(s_loadQueue.begin(), s_loadQueue.end(), set), s_loadQueue.end());
 	}
 
-	//load a set of assets in the background, loading 1 asset per frame as the program does other things
-	void TTN_AssetSystem::LoadSetInBackground(int set) {
-		//add the set to be loaded to the load queue
-		s_loadQueue.push_back(set);
+	//changes the priority of a set
+	void TTN_AssetSystem::SetSetPriority(int set, int priority) {
+		s_setStates[set].m_priority = priority;
+
+		//the pending requests and the load queue need to be sorted again
+		s_pendingDirty = true;
+		std::stable_sort(s_loadQueue.begin(), s_loadQueue.end(), [](int a, int b) {
+			return s_setStates[a].m_priority > s_setStates[b].m_priority;
+		});
 	}
 
 	//the update function, run every frame, acutally does the background loading
 	void TTN_AssetSystem::Update() {
-		//check if a set has finished
-		if (s_FinishedLoadingSet) {
-			//remove the first element in the queue
-			s_loadQueue.erase(s_loadQueue.begin());
-			//and remove the finished flag
-			s_FinishedLoadingSet = false;
-		}
+		//the sets that finished last frame are no longer the current set
+		s_finishedSets.clear();
 
-		//check there's a set in the queue
-		if (s_loadQueue.size() > 0) {
-			//if there is, we can load an asset
-
-			//increment the current asset index
-			s_CurrentAssetIndex++;
-
-			//if we're currently loading 2D textures
-			if (s_CurrentAssetType == 0) {
-				//first confirm there are textures in the set
-				if (s_2DTexturesToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_2DTexturesToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						s_texture2DMap[s_2DTexturesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] =
-							TTN_Texture2D::LoadFromFile(s_2DTexturesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_FileName);
-					}
-					//if it is, then move onto cubemaps
-					else {
-						s_CurrentAssetType = 1;
-						s_CurrentAssetIndex = -1;
-					}
-				}
-				//if there aren't, move onto cubemaps
-				else {
-					s_CurrentAssetType = 1;
-					s_CurrentAssetIndex = -1;
-				}
-			}
+		//keep the workers busy
+		DispatchRequests(s_maxInFlight);
 
-			//if we're currently loading cubemaps
-			else if (s_CurrentAssetType == 1) {
-				//first confirm there are cubemaps in the set
-				if (s_CubemapsToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_CubemapsToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						s_cubemapMap[s_CubemapsToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] =
-							TTN_TextureCubeMap::LoadFromImages(s_CubemapsToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_FileName);
-					}
-					//if it is, then move onto non animated meshes
-					else {
-						s_CurrentAssetType = 2;
-						s_CurrentAssetIndex = -1;
-					}
-				}
-				//if there aren't, move onto non animated meshes
-				else {
-					s_CurrentAssetType = 2;
-					s_CurrentAssetIndex = -1;
-				}
-			}
+		//upload whatever they've finished
+		UploadCompletedRequests(s_uploadBudget);
 
-			//if we're currently loading non animated meshes
-			else if (s_CurrentAssetType == 2) {
-				//first confirm there are meshes in the set
-				if (s_NonAnimatedMeshesToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_NonAnimatedMeshesToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						s_meshMap[s_NonAnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] =
-							TTN_ObjLoader::LoadFromFile(s_NonAnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_FileName);
-
-						s_meshMap[s_NonAnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName]->SetUpVao();
-					}
-					//if it is, then move onto animated meshes
-					else {
-						s_CurrentAssetType = 3;
-						s_CurrentAssetIndex = -1;
-					}
-				}
-				//if there aren't, move onto animated meshes
-				else {
-					s_CurrentAssetType = 3;
-					s_CurrentAssetIndex = -1;
-				}
-			}
+		//uploading frees up slots, so give the workers more to do right away rather than waiting for the next frame
+		DispatchRequests(s_maxInFlight);
+	}
 
-			//if we're currently loading animated meshes
-			else if (s_CurrentAssetType == 3) {
-				//first confirm there are meshes in the set
-				if (s_AnimatedMeshesToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_AnimatedMeshesToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						s_meshMap[s_AnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] =
-							TTN_ObjLoader::LoadAnimatedMeshFromFiles(s_AnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_FileName,
-								s_AnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_number);
-
-						s_meshMap[s_AnimatedMeshesToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName]->SetUpVao();
-					}
-					//if it is, then move onto non-default shaders
-					else {
-						s_CurrentAssetType = 4;
-						s_CurrentAssetIndex = -1;
-					}
-				}
-				//if there aren't, move onto non-default shaders
-				else {
-					s_CurrentAssetType = 4;
-					s_CurrentAssetIndex = -1;
-				}
-			}
+	//gets the number for the current set being loaded, or the set that has finished loading on the frame it was called, returns -1 if no set is being loaded
+	int TTN_AssetSystem::GetCurrentSet() {
+		//if a set finished this frame, return it's number
+		if (s_finishedSets.size() > 0)
+			return s_finishedSets[0];
 
-			//if we're currently loading non-default shaders
-			else if (s_CurrentAssetType == 4) {
-				//first confirm there are shaders in the set
-				if (s_ShadersToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_ShadersToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						TTN_Shader::sshptr temp = TTN_Shader::Create();
-						temp->LoadShaderStageFromFile(s_ShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_vertShader.c_str(), GL_VERTEX_SHADER);
-						temp->LoadShaderStageFromFile(s_ShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_fragShader.c_str(), GL_FRAGMENT_SHADER);
-						temp->Link();
-						//and store it in the unordered map
-						s_shaderMap[s_ShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] = temp;
-					}
-					//if it is, then move onto non-default shaders
-					else {
-						s_CurrentAssetType = 5;
-						s_CurrentAssetIndex = -1;
-					}
-				}
-				//if there aren't, move onto non-default shaders
-				else {
-					s_CurrentAssetType = 5;
-					s_CurrentAssetIndex = -1;
-				}
+		//if there's a set being loaded, return it's number
+		if (s_loadQueue.size() > 0)
+			return s_loadQueue[0];
+
+		//otherwise return -1
+		return -1;
+	}
+
+	//gets wheter or not a set is loading
+	bool TTN_AssetSystem::GetSetLoading(int set) {
+		auto it = s_setStates.find(set);
+		return it != s_setStates.end() && it->second.m_loading;
+	}
+
+	//gets how much of a set has loaded
+	float TTN_AssetSystem::GetSetProgress(int set) {
+		auto it = s_setStates.find(set);
+		if (it != s_setStates.end() && it->second.m_loading)
+			return (float)it->second.m_finished / (float)it->second.m_total;
+
+		return s_setsLoaded[set] ? 1.0f : 0.0f;
+	}
+
+	//makes the requests for every asset in a set
+	void TTN_AssetSystem::QueueSet(int set) {
+		SetLoadState& state = s_setStates[set];
+
+		//makes a request and adds it to the pending list
+		auto makeRequest = [&](AssetType type, const std::string& accessName) {
+			slrptr request = std::make_shared<LoadRequest>();
+			request->m_set = set;
+			request->m_generation = state.m_generation;
+			request->m_order = s_requestCounter++;
+			request->m_type = type;
+			request->m_AccessName = accessName;
+			request->m_number = 0;
+			request->m_vertDefault = TTN_DefaultShaders::NOT_DEFAULT;
+			request->m_fragDefault = TTN_DefaultShaders::NOT_DEFAULT;
+			s_pendingRequests.push_back(request);
+			return request;
+		};
+
+		size_t numOfRequests = s_pendingRequests.size();
+		if (s_2DTexturesToLoad.count(set)) {
+			for (auto& it : s_2DTexturesToLoad[set])
+				makeRequest(AssetType::TEXTURE_2D, it.m_AccessName)->m_FileName = it.m_FileName;
+		}
+		if (s_CubemapsToLoad.count(set)) {
+			for (auto& it : s_CubemapsToLoad[set])
+				makeRequest(AssetType::CUBEMAP, it.m_AccessName)->m_FileName = it.m_FileName;
+		}
+		if (s_NonAnimatedMeshesToLoad.count(set)) {
+			for (auto& it : s_NonAnimatedMeshesToLoad[set])
+				makeRequest(AssetType::MESH, it.m_AccessName)->m_FileName = it.m_FileName;
+		}
+		if (s_AnimatedMeshesToLoad.count(set)) {
+			for (auto& it : s_AnimatedMeshesToLoad[set]) {
+				slrptr request = makeRequest(AssetType::ANIMATED_MESH, it.m_AccessName);
+				request->m_FileName = it.m_FileName;
+				request->m_number = it.m_number;
+			}
+		}
+		if (s_ShadersToLoad.count(set)) {
+			for (auto& it : s_ShadersToLoad[set]) {
+				slrptr request = makeRequest(AssetType::SHADER, it.m_AccessName);
+				request->m_FileName = it.m_vertShader;
+				request->m_SecondFileName = it.m_fragShader;
 			}
+		}
+		if (s_DefaultShadersToLoad.count(set)) {
+			for (auto& it : s_DefaultShadersToLoad[set]) {
+				slrptr request = makeRequest(AssetType::DEFAULT_SHADER, it.m_AccessName);
+				request->m_vertDefault = it.m_vertShader;
+				request->m_fragDefault = it.m_fragShader;
+			}
+		}
+		numOfRequests = s_pendingRequests.size() - numOfRequests;
 
-			//if we're currently loading default shaders
-			else if (s_CurrentAssetType == 5) {
-				//first confirm there are shader in the set
-				if (s_DefaultShadersToLoad.size() > s_loadQueue[0]) {
-					//check the index is not out of bounds
-					if (s_CurrentAssetIndex < s_DefaultShadersToLoad[s_loadQueue[0]].size()) {
-						//load the asset
-						TTN_Shader::sshptr temp = TTN_Shader::Create();
-						temp->LoadDefaultShader(s_DefaultShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_vertShader);
-						temp->LoadDefaultShader(s_DefaultShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_fragShader);
-						temp->Link();
-						//and store it in the unordered map
-						s_shaderMap[s_DefaultShadersToLoad[s_loadQueue[0]][s_CurrentAssetIndex].m_AccessName] = temp;
-					}
-					//if it is, then move onto non-default shaders
-					else {
-						s_CurrentAssetType = 0;
-						s_CurrentAssetIndex = -1;
-						s_FinishedLoadingSet = true;
-						s_setsLoaded[s_loadQueue[0]] = true;
-					}
-				}
-				//if there aren't, move onto non-default shaders
-				else {
-					s_CurrentAssetType = 0;
-					s_CurrentAssetIndex = -1;
-					s_FinishedLoadingSet = true;
-					s_setsLoaded[s_loadQueue[0]] = true;
+		//save the state of the set
+		state.m_total = numOfRequests;
+		state.m_finished = 0;
+		state.m_loading = true;
+		s_setsLoaded[set] = false;
+		s_loadQueue.push_back(set);
+		SetSetPriority(set, state.m_priority);
+
+		//a set without anything in it is finished straight away
+		if (numOfRequests == 0) {
+			state.m_loading = false;
+			s_setsLoaded[set] = true;
+			s_finishedSets.push_back(set);
+			s_loadQueue.erase(std::remove(s_loadQueue.begin(), s_loadQueue.end(), set), s_loadQueue.end());
+		}
+	}
+
+	//marks a request as finished
+	void TTN_AssetSystem::FinishRequest(int set) {
+		SetLoadState& state = s_setStates[set];
+		state.m_finished++;
+
+		//if that was the last one the set is done
+		if (state.m_finished >= state.m_total) {
+			state.m_loading = false;
+			s_setsLoaded[set] = true;
+			s_finishedSets.push_back(set);
+			s_loadQueue.erase(std::remove(s_loadQueue.begin(), s_loadQueue.end(), set), s_loadQueue.end());
+		}
+	}
+
+	//sorts the pending requests
+	void TTN_AssetSystem::SortPendingRequests() {
+		if (!s_pendingDirty)
+			return;
+
+		//higher priority sets first, then in the order they were added
+		std::sort(s_pendingRequests.begin(), s_pendingRequests.end(), [](const slrptr& a, const slrptr& b) {
+			int priorityA = s_setStates[a->m_set].m_priority;
+			int priorityB = s_setStates[b->m_set].m_priority;
+			if (priorityA != priorityB)
+				return priorityA > priorityB;
+			return a->m_order < b->m_order;
+		});
+		s_pendingDirty = false;
+	}
+
+	//sends pending requests to the workers
+	void TTN_AssetSystem::DispatchRequests(size_t maxInFlight) {
+		//by default use half the workers, so there's always some free for the jobs the frame itself needs
+		if (maxInFlight == 0)
+			maxInFlight = std::max((size_t)TTN_JobSystem::GetWorkerCount() / 2, (size_t)1);
+
+		SortPendingRequests();
+		while (s_inFlight < maxInFlight && !s_pendingRequests.empty()) {
+			slrptr request = s_pendingRequests.front();
+			s_pendingRequests.pop_front();
+			s_inFlight++;
+
+			TTN_JobSystem::SubmitBackground([request]() {
+				LoadRequestData(*request);
+
+				//hand it back to the main thread
+				{
+					std::lock_guard<std::mutex> lock(s_completedMutex);
+					s_completedRequests.push_back(request);
 				}
+				s_completedSignal.notify_all();
+			});
+		}
+	}
+
+	//reads and decodes the files for a request
+	void TTN_AssetSystem::LoadRequestData(LoadRequest& request) {
+		//reads a whole text file into a string
+		auto readTextFile = [](const std::string& fileName, std::string& out) {
+			std::ifstream file(fileName);
+			if (!file.is_open())
+				throw std::runtime_error("File not found: " + fileName);
+			std::stringstream stream;
+			stream << file.rdbuf();
+			out = stream.str();
+		};
+
+		//exceptions can't leave a worker thread, so they get saved and reported when the request is uploaded
+		try {
+			switch (request.m_type) {
+			case AssetType::TEXTURE_2D:
+				request.m_textureData = TTN_Texture2DData::LoadFromFile(request.m_FileName);
+				request.m_failed = request.m_textureData == nullptr;
+				break;
+			case AssetType::CUBEMAP:
+				request.m_cubemapData = TTN_TextureCubeMapData::LoadFromImages(request.m_FileName);
+				request.m_failed = request.m_cubemapData == nullptr;
+				break;
+			case AssetType::MESH:
+				TTN_ObjLoader::LoadDataFromFile(request.m_FileName, request.m_meshData);
+				break;
+			case AssetType::ANIMATED_MESH:
+				TTN_ObjLoader::LoadAnimatedDataFromFiles(request.m_FileName, request.m_number, request.m_meshData);
+				break;
+			case AssetType::SHADER:
+				readTextFile(request.m_FileName, request.m_vertSource);
+				readTextFile(request.m_SecondFileName, request.m_fragSource);
+				break;
+			case AssetType::DEFAULT_SHADER:
+				//default shaders are built in, there's nothing to read
+				break;
 			}
+		}
+		catch (const std::exception& e) {
+			request.m_failed = true;
+			request.m_error = e.what();
+		}
+	}
+
+	//uploads completed requests
+	void TTN_AssetSystem::UploadCompletedRequests(float budget) {
+		//take everything the workers have finished
+		{
+			std::lock_guard<std::mutex> lock(s_completedMutex);
+			for (slrptr& request : s_completedRequests)
+				s_uploadQueue.push_back(request);
+			s_completedRequests.clear();
+		}
 
+		//upload the highest priority ones first
+		std::stable_sort(s_uploadQueue.begin(), s_uploadQueue.end(), [](const slrptr& a, const slrptr& b) {
+			return s_setStates[a->m_set].m_priority > s_setStates[b->m_set].m_priority;
+		});
+
+		auto start = std::chrono::high_resolution_clock::now();
+		bool uploadedAny = false;
+		while (!s_uploadQueue.empty()) {
+			//stop once the budget has been used, but always do atleast one so loading can't stall
+			float elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (uploadedAny && elapsed >= budget)
+				break;
+
+			slrptr request = s_uploadQueue.front();
+			s_uploadQueue.pop_front();
+			s_inFlight--;
+
+			//if the set was cancelled while it was loading, just throw it away
+			if (request->m_generation != s_setStates[request->m_set].m_generation)
+				continue;
+
+			UploadRequest(*request);
+			FinishRequest(request->m_set);
+			uploadedAny = true;
 		}
 	}
 
-	//gets the number for the current set being loaded, or the set that has finished loading on the frame it was called, returns -1 if no set is being loaded
-	int TTN_AssetSystem::GetCurrentSet() {
-		//if there's a set being loaded, return it's number
-		if (s_loadQueue.size() > 0)
-			return s_loadQueue[0];
+	//creates the asset from a completed request
+	void TTN_AssetSystem::UploadRequest(LoadRequest& request) {
+		//if it failed to load there's nothing to upload, the set still finishes but the asset won't be in the system
+		if (request.m_failed) {
+			LOG_ERROR("Failed to load asset \"{}\" from \"{}\": {}", request.m_AccessName, request.m_FileName, request.m_error);
+			return;
+		}
 
-		//otherwise return -1
-		return -1;
+		//the staging buffer needs opengl so it's made the first time something gets uploaded
+		if (s_stagingBuffer == nullptr)
+			s_stagingBuffer = TTN_PixelUnpackBuffer::Create();
+
+		switch (request.m_type) {
+		case AssetType::TEXTURE_2D: {
+			TTN_Texture2D::st2dptr texture = TTN_Texture2D::Create();
+			texture->LoadData(request.m_textureData, s_stagingBuffer.get());
+			s_texture2DMap[request.m_AccessName] = texture;
+			break;
+		}
+		case AssetType::CUBEMAP: {
+			TTN_TextureCubeMap::stcmptr cubemap = TTN_TextureCubeMap::Create();
+			cubemap->LoadData(request.m_cubemapData, s_stagingBuffer.get());
+			s_cubemapMap[request.m_AccessName] = cubemap;
+			break;
+		}
+		case AssetType::MESH:
+		case AssetType::ANIMATED_MESH: {
+			TTN_Mesh::smptr mesh = TTN_ObjLoader::CreateMesh(request.m_meshData);
+			mesh->SetUpVao();
+			s_meshMap[request.m_AccessName] = mesh;
+			break;
+		}
+		case AssetType::SHADER: {
+			TTN_Shader::sshptr shader = TTN_Shader::Create();
+			shader->LoadShaderStage(request.m_vertSource.c_str(), GL_VERTEX_SHADER);
+			shader->LoadShaderStage(request.m_fragSource.c_str(), GL_FRAGMENT_SHADER);
+			shader->Link();
+			s_shaderMap[request.m_AccessName] = shader;
+			break;
+		}
+		case AssetType::DEFAULT_SHADER: {
+			TTN_Shader::sshptr shader = TTN_Shader::Create();
+			shader->LoadDefaultShader(request.m_vertDefault);
+			shader->LoadDefaultShader(request.m_fragDefault);
+			shader->Link();
+			s_shaderMap[request.m_AccessName] = shader;
+			break;
+		}
+		}
+
+		//the cpu copy of the data isn't needed anymore
+		request.m_textureData = nullptr;
+		request.m_cubemapData = nullptr;
+		request.m_meshData = TTN_ObjMeshData();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,376 @@
+//Titan Engine, by Atlas X Games
+
+//precompile header, this file uses vector, algorithm, and GLM/glm.hpp
+#include "Titan/ttn_pch.h"
+// BVH.cpp - source file for the dynamic bounding volume hierarchy used to quickly find which objects are inside a volume
+#include "Titan/BVH.h"
+
+namespace Titan {
+#pragma region AABB_and_Frustum
+	//transforms a box by transforming it's center and projecting it's extents onto the new axes
+	TTN_AABB TTN_AABB::Transform(const TTN_AABB& box, const glm::mat4& matrix)
+	{
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(box.GetCenter(), 1.0f));
+		glm::vec3 extents = box.GetExtents();
+
+		glm::mat3 absMatrix = glm::mat3(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+		glm::vec3 newExtents = absMatrix * extents;
+
+		return { center - newExtents, center + newExtents };
+	}
+
+	//extracts the planes from a view projection matrix (Gribb and Hartmann)
+	TTN_Frustum TTN_Frustum::FromMatrix(const glm::mat4& viewProjection)
+	{
+		TTN_Frustum frustum;
+		//glm is column major, so get the rows of the matrix
+		glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		//left, right, bottom, top, near, far
+		frustum.planes[0] = row3 + row0;
+		frustum.planes[1] = row3 - row0;
+		frustum.planes[2] = row3 + row1;
+		frustum.planes[3] = row3 - row1;
+		frustum.planes[4] = row3 + row2;
+		frustum.planes[5] = row3 - row2;
+
+		//normalize them so the distances are in world units
+		for (int i = 0; i < 6; i++)
+			frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+
+		return frustum;
+	}
+
+	//tests a box against the frustum
+	TTN_Frustum::TestResult TTN_Frustum::Test(const TTN_AABB& box) const
+	{
+		glm::vec3 center = box.GetCenter();
+		glm::vec3 extents = box.GetExtents();
+
+		TestResult result = TestResult::INSIDE;
+		for (int i = 0; i < 6; i++) {
+			glm::vec3 normal = glm::vec3(planes[i]);
+			//distance from the center to the plane, and how far the box reaches along the normal
+			float distance = glm::dot(normal, center) + planes[i].w;
+			float radius = glm::dot(glm::abs(normal), extents);
+
+			//if it's entirely behind any plane it's outside
+			if (distance < -radius)
+				return TestResult::OUTSIDE;
+			//if it crosses a plane it's only partly inside
+			if (distance < radius)
+				result = TestResult::INTERSECTING;
+		}
+
+		return result;
+	}
+#pragma endregion AABB_and_Frustum
+
+	//constructor
+	TTN_BVH::TTN_BVH(float margin)
+		: m_root(-1), m_freeList(-1), m_proxyCount(0), m_margin(margin)
+	{ }
+
+	//adds an object to the tree
+	int TTN_BVH::CreateProxy(const TTN_AABB& box, uint32_t userData)
+	{
+		int proxy = AllocateNode();
+
+		//make the leaf a little bigger than the object so it can move a bit without changing the tree
+		glm::vec3 margin = glm::vec3(m_margin);
+		m_nodes[proxy].box = { box.min - margin, box.max + margin };
+		m_nodes[proxy].userData = userData;
+		m_nodes[proxy].height = 0;
+
+		InsertLeaf(proxy);
+		m_proxyCount++;
+
+		return proxy;
+	}
+
+	//removes an object from the tree
+	void TTN_BVH::DestroyProxy(int proxy)
+	{
+		LOG_ASSERT(proxy >= 0 && proxy < (int)m_nodes.size() && m_nodes[proxy].IsLeaf(), "Invalid BVH proxy");
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		m_proxyCount--;
+	}
+
+	//moves an object
+	bool TTN_BVH::MoveProxy(int proxy, const TTN_AABB& box)
+	{
+		LOG_ASSERT(proxy >= 0 && proxy < (int)m_nodes.size() && m_nodes[proxy].IsLeaf(), "Invalid BVH proxy");
+
+		//if it's still inside it's enlarged box, nothing needs to change
+		if (m_nodes[proxy].box.Contains(box))
+			return false;
+
+		//otherwise take it out and put it back in with a new box
+		RemoveLeaf(proxy);
+		glm::vec3 margin = glm::vec3(m_margin);
+		m_nodes[proxy].box = { box.min - margin, box.max + margin };
+		InsertLeaf(proxy);
+
+		return true;
+	}
+
+	//finds every object touching the frustum
+	size_t TTN_BVH::QueryFrustum(const TTN_Frustum& frustum, std::vector<uint32_t>& results) const
+	{
+		if (m_root == -1)
+			return 0;
+
+		size_t tested = 0;
+		//walk the tree with a stack rather than recursion
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+
+		while (!stack.empty()) {
+			int nodeIndex = stack.back();
+			stack.pop_back();
+			const Node& node = m_nodes[nodeIndex];
+
+			tested++;
+			TTN_Frustum::TestResult result = frustum.Test(node.box);
+
+			//skip the whole branch if it's outside
+			if (result == TTN_Frustum::TestResult::OUTSIDE)
+				continue;
+
+			//if it's entirely inside, so is everything under it, so there's no need to test any further
+			if (result == TTN_Frustum::TestResult::INSIDE || node.IsLeaf()) {
+				CollectLeaves(nodeIndex, results);
+				continue;
+			}
+
+			//otherwise test the children
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+
+		return tested;
+	}
+
+	//adds the user data of every leaf under a node
+	void TTN_BVH::CollectLeaves(int node, std::vector<uint32_t>& results) const
+	{
+		if (m_nodes[node].IsLeaf()) {
+			results.push_back(m_nodes[node].userData);
+			return;
+		}
+
+		CollectLeaves(m_nodes[node].child1, results);
+		CollectLeaves(m_nodes[node].child2, results);
+	}
+
+	//gets a node from the free list
+	int TTN_BVH::AllocateNode()
+	{
+		//if there aren't any free nodes, add one to the pool
+		if (m_freeList == -1) {
+			m_nodes.push_back(Node());
+			m_freeList = (int)m_nodes.size() - 1;
+			m_nodes[m_freeList].parent = -1;
+			m_nodes[m_freeList].height = -1;
+		}
+
+		//take the node off the front of the free list
+		int node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+		m_nodes[node].parent = -1;
+		m_nodes[node].child1 = -1;
+		m_nodes[node].child2 = -1;
+		m_nodes[node].height = 0;
+		m_nodes[node].userData = 0;
+
+		return node;
+	}
+
+	//returns a node to the free list
+	void TTN_BVH::FreeNode(int node)
+	{
+		m_nodes[node].parent = m_freeList;
+		m_nodes[node].height = -1;
+		m_freeList = node;
+	}
+
+	//inserts a leaf into the tree
+	void TTN_BVH::InsertLeaf(int leaf)
+	{
+		//if the tree is empty the leaf becomes the root
+		if (m_root == -1) {
+			m_root = leaf;
+			m_nodes[m_root].parent = -1;
+			return;
+		}
+
+		//walk down the tree to find the best sibling, at each step comparing the cost of pairing with the current node against
+		//the lowest possible cost of going further down either child
+		TTN_AABB leafBox = m_nodes[leaf].box;
+		int index = m_root;
+		while (!m_nodes[index].IsLeaf()) {
+			int child1 = m_nodes[index].child1;
+			int child2 = m_nodes[index].child2;
+
+			float area = m_nodes[index].box.GetSurfaceArea();
+			float combinedArea = TTN_AABB::Union(m_nodes[index].box, leafBox).GetSurfaceArea();
+
+			//cost of making a new parent for this node and the leaf
+			float cost = 2.0f * combinedArea;
+			//minimum cost of pushing the leaf further down, every ancestor grows by this much
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			//cost of descending into each child
+			auto descendCost = [&](int child) {
+				float newArea = TTN_AABB::Union(leafBox, m_nodes[child].box).GetSurfaceArea();
+				if (m_nodes[child].IsLeaf())
+					return newArea + inheritanceCost;
+				return (newArea - m_nodes[child].box.GetSurfaceArea()) + inheritanceCost;
+			};
+			float cost1 = descendCost(child1);
+			float cost2 = descendCost(child2);
+
+			//stop if pairing here is cheapest
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = (cost1 < cost2) ? child1 : child2;
+		}
+		int sibling = index;
+
+		//make a new parent for the sibling and the leaf
+		int oldParent = m_nodes[sibling].parent;
+		int newParent = AllocateNode();
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].box = TTN_AABB::Union(leafBox, m_nodes[sibling].box);
+		m_nodes[newParent].height = m_nodes[sibling].height + 1;
+		m_nodes[newParent].child1 = sibling;
+		m_nodes[newParent].child2 = leaf;
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		//hook the new parent into the tree
+		if (oldParent != -1) {
+			if (m_nodes[oldParent].child1 == sibling)
+				m_nodes[oldParent].child1 = newParent;
+			else
+				m_nodes[oldParent].child2 = newParent;
+		}
+		else
+			m_root = newParent;
+
+		//walk back up fixing the boxes and heights
+		Refit(m_nodes[leaf].parent);
+	}
+
+	//removes a leaf from the tree
+	void TTN_BVH::RemoveLeaf(int leaf)
+	{
+		if (leaf == m_root) {
+			m_root = -1;
+			return;
+		}
+
+		//the leaf's sibling takes the parent's place
+		int parent = m_nodes[leaf].parent;
+		int grandParent = m_nodes[parent].parent;
+		int sibling = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+		if (grandParent != -1) {
+			if (m_nodes[grandParent].child1 == parent)
+				m_nodes[grandParent].child1 = sibling;
+			else
+				m_nodes[grandParent].child2 = sibling;
+			m_nodes[sibling].parent = grandParent;
+			FreeNode(parent);
+
+			//walk back up fixing the boxes and heights
+			Refit(grandParent);
+		}
+		else {
+			m_root = sibling;
+			m_nodes[sibling].parent = -1;
+			FreeNode(parent);
+		}
+
+		m_nodes[leaf].parent = -1;
+	}
+
+	//walks up the tree from a node, balancing it and refitting the boxes and heights
+	void TTN_BVH::Refit(int node)
+	{
+		int index = node;
+		while (index != -1) {
+			index = Balance(index);
+
+			int child1 = m_nodes[index].child1;
+			int child2 = m_nodes[index].child2;
+			m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+			m_nodes[index].box = TTN_AABB::Union(m_nodes[child1].box, m_nodes[child2].box);
+
+			index = m_nodes[index].parent;
+		}
+	}
+
+	//rotates the tree around a node if one side is more than one level taller than the other
+	int TTN_BVH::Balance(int a)
+	{
+		if (m_nodes[a].IsLeaf() || m_nodes[a].height < 2)
+			return a;
+
+		int b = m_nodes[a].child1;
+		int c = m_nodes[a].child2;
+		int balance = m_nodes[c].height - m_nodes[b].height;
+
+		//rotates the taller child (up) above a, keeping the other side as a's child
+		auto rotate = [&](int up, int other) {
+			int f = m_nodes[up].child1;
+			int g = m_nodes[up].child2;
+
+			//swap a and up
+			m_nodes[up].child1 = a;
+			m_nodes[up].parent = m_nodes[a].parent;
+			m_nodes[a].parent = up;
+
+			//a's old parent should point to up
+			if (m_nodes[up].parent != -1) {
+				if (m_nodes[m_nodes[up].parent].child1 == a)
+					m_nodes[m_nodes[up].parent].child1 = up;
+				else
+					m_nodes[m_nodes[up].parent].child2 = up;
+			}
+			else
+				m_root = up;
+
+			//keep the taller of up's children above a
+			int keep = (m_nodes[f].height > m_nodes[g].height) ? f : g;
+			int move = (keep == f) ? g : f;
+			m_nodes[up].child2 = keep;
+			if (m_nodes[a].child1 == up) m_nodes[a].child1 = move;
+			else m_nodes[a].child2 = move;
+			m_nodes[move].parent = a;
+
+			m_nodes[a].box = TTN_AABB::Union(m_nodes[other].box, m_nodes[move].box);
+			m_nodes[a].height = 1 + std::max(m_nodes[other].height, m_nodes[move].height);
+			m_nodes[up].box = TTN_AABB::Union(m_nodes[a].box, m_nodes[keep].box);
+			m_nodes[up].height = 1 + std::max(m_nodes[a].height, m_nodes[keep].height);
+
+			return up;
+		};
+
+		//rotate c up
+		if (balance > 1)
+			return rotate(c, b);
+		//rotate b up
+		if (balance < -1)
+			return rotate(b, c);
+
+		return a;
+	}
+}
@@ -0,0 +1,144 @@
+//Titan Engine, by Atlas X Games
+// ContactSystem.cpp - source file for the class that tracks which physics bodies are touching and when they start and stop touching
+
+//precompile header, this file uses entt.hpp, vector, and algorithm
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/ContactSystem.h"
+
+namespace Titan {
+	//gets the entity stored in a bullet object's user pointer
+	static inline entt::entity EntityFromObject(const btCollisionObject* object)
+	{
+		return static_cast<entt::entity>(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(object->getUserPointer())));
+	}
+
+	//converts a bullet vector to a glm one
+	static inline glm::vec3 ToGlm(const btVector3& vector)
+	{
+		return glm::vec3((float)vector.getX(), (float)vector.getY(), (float)vector.getZ());
+	}
+
+	//makes the key for a pair of entities
+	uint64_t TTN_ContactSystem::MakePairKey(entt::entity a, entt::entity b)
+	{
+		uint32_t first = static_cast<uint32_t>(a);
+		uint32_t second = static_cast<uint32_t>(b);
+		if (first > second)
+			std::swap(first, second);
+
+		return (static_cast<uint64_t>(first) << 32) | static_cast<uint64_t>(second);
+	}
+
+	//rebuilds the contact pairs and points from the manifolds
+	void TTN_ContactSystem::Update(btDispatcher* dispatcher)
+	{
+		//the pairs touching last update become the previous pairs, and everything else starts over, keeping it's memory
+		std::swap(m_previousKeys, m_touchingKeys);
+		m_touchingKeys.clear();
+		m_manifolds.clear();
+		m_pairs.clear();
+		m_points.clear();
+
+		//find every manifold with at least one point where the bodies are actually touching
+		int numOfManifolds = dispatcher->getNumManifolds();
+		for (int i = 0; i < numOfManifolds; i++) {
+			const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+
+			bool touching = false;
+			for (int j = 0; j < manifold->getNumContacts(); j++) {
+				if (manifold->getContactPoint(j).getDistance() < 0.0f) {
+					touching = true;
+					break;
+				}
+			}
+			if (!touching)
+				continue;
+
+			entt::entity entity0 = EntityFromObject(manifold->getBody0());
+			entt::entity entity1 = EntityFromObject(manifold->getBody1());
+			m_manifolds.push_back({ MakePairKey(entity0, entity1), i, static_cast<uint32_t>(entity0) > static_cast<uint32_t>(entity1) });
+		}
+
+		//sort them so all the manifolds between the same bodies (which compound shapes can have several of) end up next to each other,
+		//ties are broken by the manifold index to keep the order of the points stable
+		std::sort(m_manifolds.begin(), m_manifolds.end(), [](const ManifoldEntry& a, const ManifoldEntry& b) {
+			return (a.key != b.key) ? a.key < b.key : a.index < b.index;
+		});
+
+		//walk through the groups, merging them against the previous pairs (which are also sorted) to work out the events
+		size_t previous = 0;
+		size_t entry = 0;
+		while (entry < m_manifolds.size()) {
+			uint64_t key = m_manifolds[entry].key;
+
+			//any previous pairs that sort before this one aren't touching anymore
+			while (previous < m_previousKeys.size() && m_previousKeys[previous] < key) {
+				AddPair(m_previousKeys[previous], TTN_ContactEvent::END, static_cast<uint32_t>(m_points.size()), 0);
+				previous++;
+			}
+
+			//if this pair was touching last update too then it's stayed in contact, otherwise it's just begun
+			TTN_ContactEvent event = TTN_ContactEvent::BEGIN;
+			if (previous < m_previousKeys.size() && m_previousKeys[previous] == key) {
+				event = TTN_ContactEvent::STAY;
+				previous++;
+			}
+
+			//copy the touching points of every manifold in the group
+			uint32_t firstPoint = static_cast<uint32_t>(m_points.size());
+			for (; entry < m_manifolds.size() && m_manifolds[entry].key == key; entry++) {
+				const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(m_manifolds[entry].index);
+				bool swapped = m_manifolds[entry].swapped;
+
+				for (int j = 0; j < manifold->getNumContacts(); j++) {
+					const btManifoldPoint& point = manifold->getContactPoint(j);
+					if (point.getDistance() >= 0.0f)
+						continue;
+
+					//bullet's normal points from body 1 of the manifold to body 0, so if the bodies are the other way around in the
+					//pair the positions swap and the normal flips
+					TTN_ContactPoint contact;
+					glm::vec3 positionOnA = ToGlm(point.getPositionWorldOnA());
+					glm::vec3 positionOnB = ToGlm(point.getPositionWorldOnB());
+					glm::vec3 normal = ToGlm(point.m_normalWorldOnB);
+					contact.positionOnBody1 = swapped ? positionOnB : positionOnA;
+					contact.positionOnBody2 = swapped ? positionOnA : positionOnB;
+					contact.normal = swapped ? -normal : normal;
+					contact.distance = (float)point.getDistance();
+					contact.impulse = (float)point.getAppliedImpulse();
+					m_points.push_back(contact);
+				}
+			}
+
+			AddPair(key, event, firstPoint, static_cast<uint32_t>(m_points.size()) - firstPoint);
+			m_touchingKeys.push_back(key);
+		}
+
+		//any previous pairs left over aren't touching anymore either
+		for (; previous < m_previousKeys.size(); previous++)
+			AddPair(m_previousKeys[previous], TTN_ContactEvent::END, static_cast<uint32_t>(m_points.size()), 0);
+	}
+
+	//forgets all the pairs
+	void TTN_ContactSystem::Clear()
+	{
+		m_manifolds.clear();
+		m_touchingKeys.clear();
+		m_previousKeys.clear();
+		m_pairs.clear();
+		m_points.clear();
+	}
+
+	//appends a pair to the output
+	void TTN_ContactSystem::AddPair(uint64_t key, TTN_ContactEvent event, uint32_t firstPoint, uint32_t numOfPoints)
+	{
+		TTN_ContactPair pair;
+		pair.body1 = static_cast<entt::entity>(static_cast<uint32_t>(key >> 32));
+		pair.body2 = static_cast<entt::entity>(static_cast<uint32_t>(key & 0xFFFFFFFFu));
+		pair.event = event;
+		pair.firstPoint = firstPoint;
+		pair.numOfPoints = numOfPoints;
+		m_pairs.push_back(pair);
+	}
+}
@@ -0,0 +1,180 @@
+//Titan Engine, by Atlas X Games
+
+//precompile header, this file uses entt.hpp, vector, and algorithm
+#include "Titan/ttn_pch.h"
+// CullingSystem.cpp - source file for the class that keeps the renderers of a scene in a bvh and finds which ones the camera can see
+#include "Titan/CullingSystem.h"
+
+namespace Titan {
+	//constructor, hooks the system into the registry
+	TTN_CullingSystem::TTN_CullingSystem(entt::registry* registry)
+		: m_registry(registry), m_rendererChanges(TTN_Renderer::GetChangeCount()), m_materialChanges(TTN_Material::GetBoundsChangeCount())
+	{
+		//any proxies already in the registry belong to a different tree, so clear them out to be recreated in this one
+		m_registry->clear<TTN_CullProxy>();
+
+		m_registry->on_destroy<TTN_CullProxy>().connect<&TTN_CullingSystem::OnProxyDestroyed>(*this);
+		m_registry->on_update<TTN_Renderer>().connect<&TTN_CullingSystem::OnRendererReplaced>(*this);
+	}
+
+	//destructor, unhooks the system from the registry
+	TTN_CullingSystem::~TTN_CullingSystem()
+	{
+		m_registry->on_destroy<TTN_CullProxy>().disconnect(*this);
+		m_registry->on_update<TTN_Renderer>().disconnect(*this);
+	}
+
+	//brings the bvh up to date
+	void TTN_CullingSystem::Update(const std::vector<entt::entity>& movedEntities)
+	{
+		//remove the proxies of entities that no longer have a renderer
+		auto staleView = m_registry->view<TTN_CullProxy>(entt::exclude<TTN_Renderer>);
+		if (staleView.begin() != staleView.end()) {
+			std::vector<entt::entity> stale(staleView.begin(), staleView.end());
+			//removing the component removes it from the tree through the callback
+			m_registry->remove<TTN_CullProxy>(stale.begin(), stale.end());
+		}
+
+		//add proxies for any new renderers
+		auto newView = m_registry->view<TTN_Transform, TTN_Renderer>(entt::exclude<TTN_CullProxy>);
+		if (newView.begin() != newView.end()) {
+			std::vector<entt::entity> added(newView.begin(), newView.end());
+			for (entt::entity entity : added) {
+				TTN_CullProxy& proxy = m_registry->emplace<TTN_CullProxy>(entity);
+				InsertProxy(entity, proxy, m_registry->get<TTN_Transform>(entity), m_registry->get<TTN_Renderer>(entity));
+			}
+		}
+
+		//if a renderer has a new mesh, shader, or material, it's bounds (or wheter it's always visible) might have changed, the
+		//setters count every change so the proxies only need checking on frames where something was actually set
+		if (m_rendererChanges != TTN_Renderer::GetChangeCount() || m_materialChanges != TTN_Material::GetBoundsChangeCount()) {
+			m_rendererChanges = TTN_Renderer::GetChangeCount();
+			m_materialChanges = TTN_Material::GetBoundsChangeCount();
+
+			auto proxyView = m_registry->view<TTN_Transform, TTN_Renderer, TTN_CullProxy>();
+			for (entt::entity entity : proxyView)
+				RefreshProxy(entity, proxyView.get<TTN_CullProxy>(entity), proxyView.get<TTN_Transform>(entity), proxyView.get<TTN_Renderer>(entity));
+		}
+		//replaced renderers don't go through the setters, so entt tells us about those
+		else {
+			for (entt::entity entity : m_replacedRenderers) {
+				if (m_registry->valid(entity) && m_registry->has<TTN_Transform, TTN_Renderer, TTN_CullProxy>(entity))
+					RefreshProxy(entity, m_registry->get<TTN_CullProxy>(entity), m_registry->get<TTN_Transform>(entity),
+						m_registry->get<TTN_Renderer>(entity));
+			}
+		}
+		m_replacedRenderers.clear();
+
+		//refit anything that moved
+		for (entt::entity entity : movedEntities) {
+			if (!m_registry->valid(entity))
+				continue;
+			TTN_CullProxy* proxy = m_registry->try_get<TTN_CullProxy>(entity);
+			if (proxy == nullptr || proxy->proxy == -1)
+				continue;
+
+			m_bvh.MoveProxy(proxy->proxy, CalculateBounds(m_registry->get<TTN_Transform>(entity), m_registry->get<TTN_Renderer>(entity)));
+		}
+	}
+
+	//finds every renderer that can be seen
+	void TTN_CullingSystem::Cull(const glm::mat4& viewProjection, std::vector<entt::entity>& visible)
+	{
+		visible.clear();
+
+		//query the tree
+		m_queryResults.clear();
+		m_stats.nodesTested = m_bvh.QueryFrustum(TTN_Frustum::FromMatrix(viewProjection), m_queryResults);
+
+		visible.reserve(m_queryResults.size() + m_alwaysVisible.size());
+		for (uint32_t entity : m_queryResults)
+			visible.push_back(static_cast<entt::entity>(entity));
+		//and add everything that's always drawn
+		visible.insert(visible.end(), m_alwaysVisible.begin(), m_alwaysVisible.end());
+
+		//update the counters
+		m_stats.objects = m_bvh.GetProxyCount() + m_alwaysVisible.size();
+		m_stats.visible = visible.size();
+		m_stats.culled = m_stats.objects - m_stats.visible;
+	}
+
+	//calculates the world space bounds of a renderer
+	TTN_AABB TTN_CullingSystem::CalculateBounds(TTN_Transform& transform, TTN_Renderer& renderer)
+	{
+		TTN_AABB local = { renderer.GetMesh()->GetBoundsMin(), renderer.GetMesh()->GetBoundsMax() };
+
+		//height maps push the vertices out along their normals by up to the influence, so grow the box to fit
+		TTN_Shader::sshptr shader = renderer.GetShader();
+		if (shader != nullptr && renderer.GetMat() != nullptr
+			&& (shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_COLOR_HEIGHTMAP
+				|| shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_NO_COLOR_HEIGHTMAP)) {
+			glm::vec3 influence = glm::vec3(glm::abs(renderer.GetMat()->GetHeightInfluence()));
+			local.min -= influence;
+			local.max += influence;
+		}
+
+		return TTN_AABB::Transform(local, transform.GetGlobal());
+	}
+
+	//adds a proxy to the tree
+	void TTN_CullingSystem::InsertProxy(entt::entity entity, TTN_CullProxy& proxy, TTN_Transform& transform, TTN_Renderer& renderer)
+	{
+		proxy.mesh = renderer.GetMesh().get();
+		proxy.shader = renderer.GetShader().get();
+		proxy.material = renderer.GetMat().get();
+		proxy.materialVersion = (renderer.GetMat() != nullptr) ? renderer.GetMat()->GetBoundsVersion() : 0;
+
+		//the skybox is drawn around the camera no matter where it's transform is, and a renderer without a mesh has no bounds,
+		//so those skip the tree
+		proxy.alwaysVisible = (proxy.mesh == nullptr)
+			|| (renderer.GetShader() != nullptr && renderer.GetShader()->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_SKYBOX);
+
+		if (proxy.alwaysVisible) {
+			proxy.proxy = -1;
+			m_alwaysVisible.push_back(entity);
+		}
+		else
+			proxy.proxy = m_bvh.CreateProxy(CalculateBounds(transform, renderer), static_cast<uint32_t>(entity));
+	}
+
+	//removes a proxy from the tree
+	void TTN_CullingSystem::RemoveProxy(entt::entity entity, TTN_CullProxy& proxy)
+	{
+		if (proxy.proxy != -1) {
+			m_bvh.DestroyProxy(proxy.proxy);
+			proxy.proxy = -1;
+		}
+		else if (proxy.alwaysVisible) {
+			auto it = std::find(m_alwaysVisible.begin(), m_alwaysVisible.end(), entity);
+			if (it != m_alwaysVisible.end()) {
+				*it = m_alwaysVisible.back();
+				m_alwaysVisible.pop_back();
+			}
+		}
+		proxy.alwaysVisible = false;
+	}
+
+	//recalculates the bounds of a proxy if what they were calculated from has changed
+	void TTN_CullingSystem::RefreshProxy(entt::entity entity, TTN_CullProxy& proxy, TTN_Transform& transform, TTN_Renderer& renderer)
+	{
+		const uint32_t materialVersion = (renderer.GetMat() != nullptr) ? renderer.GetMat()->GetBoundsVersion() : 0;
+		if (proxy.mesh == renderer.GetMesh().get() && proxy.shader == renderer.GetShader().get()
+			&& proxy.material == renderer.GetMat().get() && proxy.materialVersion == materialVersion)
+			return;
+
+		RemoveProxy(entity, proxy);
+		InsertProxy(entity, proxy, transform, renderer);
+	}
+
+	//called by entt whenever a proxy component is removed, including when it's entity is deleted
+	void TTN_CullingSystem::OnProxyDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		RemoveProxy(entity, registry.get<TTN_CullProxy>(entity));
+	}
+
+	//called by entt whenever a renderer is replaced with a new one
+	void TTN_CullingSystem::OnRendererReplaced(entt::registry&, entt::entity entity)
+	{
+		m_replacedRenderers.push_back(entity);
+	}
+}
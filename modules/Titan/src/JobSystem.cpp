@@ -0,0 +1,187 @@
+//Titan Engine, by Atlas X Games
+// JobSystem.cpp - source file for the class that manages the worker threads used to split work across the cpu cores
+
+//precompile header, this file uses vector and algorithm
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/JobSystem.h"
+//include the profiler so jobs show up in the timeline
+#include "Titan/Profiler.h"
+
+namespace Titan {
+	//starts the worker threads
+	void TTN_JobSystem::Init(unsigned numOfWorkers)
+	{
+		//if it's already running there's nothing to do
+		if (!s_workers.empty())
+			return;
+
+		//if no number was given, use every hardware thread other than the one the main thread is on
+		if (numOfWorkers == 0) {
+			unsigned hardwareThreads = std::thread::hardware_concurrency();
+			numOfWorkers = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+		}
+
+		s_stopping = false;
+		s_workers.reserve(numOfWorkers);
+		for (unsigned i = 0; i < numOfWorkers; i++)
+			s_workers.emplace_back(&TTN_JobSystem::WorkerLoop);
+	}
+
+	//joins the worker threads
+	void TTN_JobSystem::Shutdown()
+	{
+		//tell the workers to stop once the queue is empty, background jobs that haven't started yet are dropped as nothing is waiting on them
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_backgroundJobs.clear();
+			s_stopping = true;
+		}
+		s_wake.notify_all();
+
+		//and wait for them to finish
+		for (auto& worker : s_workers) {
+			if (worker.joinable())
+				worker.join();
+		}
+		s_workers.clear();
+	}
+
+	//pushes a job onto the queue
+	void TTN_JobSystem::Submit(std::function<void()> job)
+	{
+		//make sure there are workers to run it
+		if (s_workers.empty())
+			Init();
+
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_jobs.push_back(std::move(job));
+		}
+		s_wake.notify_one();
+	}
+
+	//pushes a job onto the background queue
+	void TTN_JobSystem::SubmitBackground(std::function<void()> job)
+	{
+		//make sure there are workers to run it
+		if (s_workers.empty())
+			Init();
+
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_backgroundJobs.push_back(std::move(job));
+		}
+		s_wake.notify_one();
+	}
+
+	//splits a range into chunks and runs them across the workers
+	void TTN_JobSystem::ParallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t)>& function)
+	{
+		if (count == 0)
+			return;
+
+		//make sure there are workers to run it
+		if (s_workers.empty())
+			Init();
+
+		//work out how big each chunk should be, aiming for a few chunks per thread so uneven chunks balance out
+		minChunkSize = std::max(minChunkSize, (size_t)1);
+		const size_t numOfThreads = (size_t)s_workers.size() + 1;
+		size_t chunkSize = std::max(minChunkSize, (count + numOfThreads * 4 - 1) / (numOfThreads * 4));
+		const size_t numOfChunks = (count + chunkSize - 1) / chunkSize;
+
+		//if it all fits in one chunk there's no point paying for the queue, just run it here
+		if (numOfChunks == 1) {
+			function(0, count);
+			return;
+		}
+
+		//counter of chunks that haven't finished yet
+		std::atomic<size_t> remaining(numOfChunks - 1);
+
+		//push every chunk but the first onto the queue
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			for (size_t chunk = 1; chunk < numOfChunks; chunk++) {
+				size_t begin = chunk * chunkSize;
+				size_t end = std::min(begin + chunkSize, count);
+				s_jobs.push_back([&function, &remaining, begin, end]() {
+					function(begin, end);
+					remaining.fetch_sub(1, std::memory_order_release);
+				});
+			}
+		}
+		s_wake.notify_all();
+
+		//run the first chunk on this thread
+		function(0, std::min(chunkSize, count));
+
+		//then help with whatever's left until every chunk is done, this also means calling it from inside a job can't deadlock
+		while (remaining.load(std::memory_order_acquire) > 0) {
+			if (!RunPendingJob())
+				std::this_thread::yield();
+		}
+	}
+
+	//the loop each worker runs
+	void TTN_JobSystem::WorkerLoop()
+	{
+		//name the thread so its jobs are easy to find in the profiler
+		static std::atomic<unsigned> workerCount(0);
+		TTN_Profiler::SetThreadName("Worker " + std::to_string(workerCount++));
+
+		while (true) {
+			bool background = false;
+			std::function<void()> job;
+
+			//wait until there is a job or the system is stopping
+			{
+				std::unique_lock<std::mutex> lock(s_mutex);
+				s_wake.wait(lock, []() { return s_stopping || !s_jobs.empty() || !s_backgroundJobs.empty(); });
+
+				//regular jobs go first, the main thread is usually waiting on them
+				if (!s_jobs.empty()) {
+					job = std::move(s_jobs.front());
+					s_jobs.pop_front();
+				}
+				else if (!s_backgroundJobs.empty()) {
+					job = std::move(s_backgroundJobs.front());
+					s_backgroundJobs.pop_front();
+					background = true;
+				}
+				else
+					return;
+			}
+
+			//and run it
+			if (background) {
+				TTN_PROFILE_SCOPE("Background Job");
+				job();
+			}
+			else {
+				TTN_PROFILE_SCOPE("Job");
+				job();
+			}
+		}
+	}
+
+	//runs a job from the queue on the calling thread
+	bool TTN_JobSystem::RunPendingJob()
+	{
+		std::function<void()> job;
+
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			if (s_jobs.empty())
+				return false;
+
+			job = std::move(s_jobs.front());
+			s_jobs.pop_front();
+		}
+
+		TTN_PROFILE_SCOPE("Job");
+		job();
+		return true;
+	}
+}
@@ -25,6 +25,11 @@ namespace Titan {
 		//set the height map to an all black texture by default 
 		m_HeightMap = TTN_Texture2D::Create();
 		m_HeightMap->Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+		//create the uniform buffer and fill it with the default values
+		m_Ubo = TTN_UniformBuffer::Create();
+		MaterialData data = { m_Shininess, m_HeightInfluence, { 0.0f, 0.0f } };
+		m_Ubo->LoadData(&data, 1);
 	}
 
 	//default desctructor
@@ -41,6 +46,7 @@ namespace Titan {
 	void TTN_Material::SetShininess(float shininess)
 	{
 		m_Shininess = shininess;
+		UpdateUniforms();
 	}
 
 	//sets the specular map texture
@@ -64,6 +70,39 @@ namespace Titan {
 	//sets a multipliers for how how influence the height map should have
 	void TTN_Material::SetHeightInfluence(float influence)
 	{
+		//the height map pushes the vertices out by the influence, so the bounds of everything using the material change with it
+		if (influence != m_HeightInfluence) {
+			m_BoundsVersion++;
+			s_BoundsChangeCount++;
+		}
+
 		m_HeightInfluence = influence;
+		UpdateUniforms();
+	}
+
+	//binds the uniform buffer
+	void TTN_Material::BindUniforms()
+	{
+		m_Ubo->BindBase(TTN_UniformBinding::MATERIAL);
+	}
+
+	//binds the uniform buffer for objects without a material
+	void TTN_Material::BindDefaultUniforms()
+	{
+		//create it the first time it's needed, objects without a material get a shininess of 128 and no height influence
+		if (s_DefaultUbo == nullptr) {
+			s_DefaultUbo = TTN_UniformBuffer::Create(GL_STATIC_DRAW);
+			MaterialData data = { 128.0f, 0.0f, { 0.0f, 0.0f } };
+			s_DefaultUbo->LoadData(&data, 1);
+		}
+
+		s_DefaultUbo->BindBase(TTN_UniformBinding::MATERIAL);
+	}
+
+	//sends the material data to the uniform buffer
+	void TTN_Material::UpdateUniforms()
+	{
+		MaterialData data = { m_Shininess, m_HeightInfluence, { 0.0f, 0.0f } };
+		m_Ubo->UpdateData(&data, 0, sizeof(MaterialData));
 	}
 }
\ No newline at end of file
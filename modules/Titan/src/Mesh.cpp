@@ -15,6 +15,19 @@ namespace Titan {
 
 		//set the mesh to not having vertex colors
 		m_HasVertColors = false;
+
+		//the bounds start empty
+		m_boundsMin = glm::vec3(FLT_MAX);
+		m_boundsMax = glm::vec3(-FLT_MAX);
+
+		//the vao hasn't been set up yet
+		m_vaoCurrentFrame = -1;
+		m_vaoNextFrame = -1;
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
+
+		//there aren't any frames to pack yet
+		m_morphDirty = true;
 	}
 
 	//destructor
@@ -25,6 +38,10 @@ namespace Titan {
 	//sets up the VAO for the mesh so it can acutally be rendered, needs to be called by the user in case they change the mesh
 	void TTN_Mesh::SetUpVao(int currentFrame, int nextFrame)
 	{
+		//if the vao is already set up with these frames, there's nothing to do
+		if (m_vao != nullptr && !m_vaoDirty && currentFrame == m_vaoCurrentFrame && nextFrame == m_vaoNextFrame)
+			return;
+
 		//if we don't have a vao, creates a new vao
 		if (m_vao == nullptr)
 			m_vao = TTN_VertexArrayObject::Create();
@@ -32,13 +49,66 @@ namespace Titan {
 		else
 			m_vao->ClearVertexBuffers();
 
+		//load the mesh into it
+		FillVao(m_vao, currentFrame, nextFrame);
+
+		//save the frames so it doesn't get set up again until they change
+		m_vaoCurrentFrame = currentFrame;
+		m_vaoNextFrame = nextFrame;
+		m_vaoDirty = false;
+	}
+
+	//gets a vao set up with the given current and next frames, kept apart from the mesh's main vao so entities on different frames
+	//don't keep setting up the same vao again every draw
+	const TTN_VertexArrayObject::svaptr& TTN_Mesh::GetMorphVao(int currentFrame, int nextFrame)
+	{
+		//if the mesh has changed, every cached vao is out of date
+		if (m_morphVaosDirty) {
+			m_morphVaos.clear();
+			m_morphVaosDirty = false;
+		}
+
+		//look for a vao that's already set up with these frames
+		uint64_t key = ((uint64_t)(uint32_t)currentFrame << 32) | (uint32_t)nextFrame;
+		auto it = m_morphVaos.find(key);
+		if (it != m_morphVaos.end())
+			return it->second;
+
+		//if there isn't one, make it
+		TTN_VertexArrayObject::svaptr vao = TTN_VertexArrayObject::Create();
+		FillVao(vao, currentFrame, nextFrame);
+		return m_morphVaos.emplace(key, vao).first->second;
+	}
+
+	//loads the mesh's buffers into a vao, with the given frames as the current and next frame
+	void TTN_Mesh::FillVao(const TTN_VertexArrayObject::svaptr& vao, int currentFrame, int nextFrame)
+	{
+		//make sure both frames have vbos
+		CreateFrameVbos(currentFrame);
+		CreateFrameVbos(nextFrame);
+
 		//load the vbos from the mesh into the vao 
-		m_vao->AddVertexBuffer(m_vertVbos[currentFrame], { BufferAttribute(0, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Position) });
-		m_vao->AddVertexBuffer(m_normVbos[currentFrame], { BufferAttribute(1, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Normal) });
-		m_vao->AddVertexBuffer(m_UVsVbo, { BufferAttribute(2, 2, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Texture) });
-		if (m_HasVertColors) m_vao->AddVertexBuffer(m_ColVbo, { BufferAttribute(3, 3, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Color) });
-		m_vao->AddVertexBuffer(m_vertVbos[nextFrame], {BufferAttribute(4, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Position) });
-		m_vao->AddVertexBuffer(m_normVbos[nextFrame], { BufferAttribute(5, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Normal) });
+		vao->AddVertexBuffer(m_vertVbos[currentFrame], { BufferAttribute(0, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Position) });
+		vao->AddVertexBuffer(m_normVbos[currentFrame], { BufferAttribute(1, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Normal) });
+		vao->AddVertexBuffer(m_UVsVbo, { BufferAttribute(2, 2, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Texture) });
+		if (m_HasVertColors) vao->AddVertexBuffer(m_ColVbo, { BufferAttribute(3, 3, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Color) });
+		vao->AddVertexBuffer(m_vertVbos[nextFrame], {BufferAttribute(4, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Position) });
+		vao->AddVertexBuffer(m_normVbos[nextFrame], { BufferAttribute(5, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Normal) });
+		//and the instance buffer if it has one
+		if (m_instanceVbo != nullptr) vao->AddVertexBuffer(m_instanceVbo, m_instanceAttributes);
+		//set the index buffer (or clear it if the mesh isn't indexed)
+		vao->SetIndexBuffer(m_ibo);
+	}
+
+	//sets the instance buffer added to the vao
+	void TTN_Mesh::SetInstanceBuffer(const TTN_VertexBuffer::svbptr& instanceBuffer, const std::vector<BufferAttribute>& attributes)
+	{
+		m_instanceVbo = instanceBuffer;
+		m_instanceAttributes = attributes;
+
+		//the vao needs to be set up again to include it
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
 	}
 
 	void TTN_Mesh::SetUVs(std::vector<glm::vec2>& uvs)
@@ -48,6 +118,9 @@ namespace Titan {
 
 		//copy the list of uvs
 		m_Uvs = uvs;
+		//the vao will need to be set up again with the new data
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
 
 		//add the uvs to the vbo
 		if (uvs.size() != 0) {
@@ -65,6 +138,9 @@ namespace Titan {
 
 			//copy the colors
 			m_Colors = colors;
+			//the vao will need to be set up again with the new data
+			m_vaoDirty = true;
+			m_morphVaosDirty = true;
 			//set the mesh to have vertex colors (note, they still won't render if the shader is not set to render them)
 			m_HasVertColors = true;
 			//send them to a vbo
@@ -87,6 +163,15 @@ namespace Titan {
 
 		//copy the list of verts
 		m_Vertices.push_back(verts);
+		//grow the bounds to fit them
+		for (const glm::vec3& vert : verts) {
+			m_boundsMin = glm::min(m_boundsMin, vert);
+			m_boundsMax = glm::max(m_boundsMax, vert);
+		}
+		//the vao will need to be set up again with the new data, and the frames packed again
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
+		m_morphDirty = true;
 
 		//add those verts to the new vbo
 		if (verts.size() != 0) {
@@ -105,6 +190,10 @@ namespace Titan {
 
 		//copy the list of normals
 		m_Normals.push_back(norms);
+		//the vao will need to be set up again with the new data, and the frames packed again
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
+		m_morphDirty = true;
 
 		//add those normals to the new vbo
 		if (norms.size() != 0) {
@@ -115,6 +204,115 @@ namespace Titan {
 		m_normVbos.push_back(newNormVbo);
 	}
 
+	//sets the triangle indices of the mesh
+	void TTN_Mesh::SetIndices(std::vector<uint32_t>& indices)
+	{
+		//copy the list of indices
+		m_Indices = indices;
+		//the vao will need to be set up again with the new data
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
+
+		//an empty list means the mesh is drawn as a triangle list without an ibo
+		if (indices.size() == 0) {
+			m_ibo = nullptr;
+			return;
+		}
+
+		//create a new ibo and add the indices to it
+		m_ibo = TTN_IndexBuffer::Create();
+		m_ibo->LoadData(indices.data(), indices.size());
+	}
+
+	//sets every morph frame of the mesh at once
+	void TTN_Mesh::SetMorphFrames(std::vector<std::vector<glm::vec3>>& positions, std::vector<std::vector<glm::vec3>>& normals)
+	{
+		//copy the frames
+		m_Vertices = positions;
+		m_Normals = normals;
+		m_Normals.resize(m_Vertices.size());
+
+		//fit the bounds around every frame
+		m_boundsMin = glm::vec3(FLT_MAX);
+		m_boundsMax = glm::vec3(-FLT_MAX);
+		for (const std::vector<glm::vec3>& frame : m_Vertices) {
+			for (const glm::vec3& vert : frame) {
+				m_boundsMin = glm::min(m_boundsMin, vert);
+				m_boundsMax = glm::max(m_boundsMax, vert);
+			}
+		}
+
+		//clear out the old vbos, only the first frame gets new ones straight away as it's the only one drawn without the morph buffer
+		m_vertVbos.assign(m_Vertices.size(), nullptr);
+		m_normVbos.assign(m_Vertices.size(), nullptr);
+		if (!m_Vertices.empty())
+			CreateFrameVbos(0);
+
+		//the vao will need to be set up again with the new data
+		m_vaoDirty = true;
+		m_morphVaosDirty = true;
+
+		//and pack animated meshes' frames into the morph buffer straight away, meshes with a single frame only get packed if they're
+		//ever drawn with a morph shader
+		m_morphDirty = true;
+		if (m_Vertices.size() > 1)
+			PackMorphFrames();
+	}
+
+	//gets the packed morph frames
+	const TTN_ShaderStorageBuffer::sssbptr& TTN_Mesh::GetMorphBuffer()
+	{
+		if (m_morphDirty)
+			PackMorphFrames();
+
+		return m_morphBuffer;
+	}
+
+	//creates the vbos for a frame if it doesn't have them yet
+	void TTN_Mesh::CreateFrameVbos(int frame)
+	{
+		if (m_vertVbos[frame] == nullptr) {
+			m_vertVbos[frame] = TTN_VertexBuffer::Create();
+			if (m_Vertices[frame].size() != 0)
+				m_vertVbos[frame]->LoadData(m_Vertices[frame].data(), m_Vertices[frame].size());
+		}
+
+		if (m_normVbos[frame] == nullptr) {
+			m_normVbos[frame] = TTN_VertexBuffer::Create();
+			if (m_Normals[frame].size() != 0)
+				m_normVbos[frame]->LoadData(m_Normals[frame].data(), m_Normals[frame].size());
+		}
+	}
+
+	//packs the morph frames into the morph buffer
+	void TTN_Mesh::PackMorphFrames()
+	{
+		m_morphDirty = false;
+		if (m_Vertices.empty() || m_Vertices[0].empty()) {
+			m_morphBuffer = nullptr;
+			return;
+		}
+
+		//lay the frames out one after another, each vertex of each frame gets it's position and normal as vec4s (std430 pads vec3
+		//arrays out to 16 bytes anyways), frames missing normals get zeros
+		const size_t numOfVerts = m_Vertices[0].size();
+		std::vector<glm::vec4> packed(m_Vertices.size() * numOfVerts * 2, glm::vec4(0.0f));
+		for (size_t frame = 0; frame < m_Vertices.size(); frame++) {
+			glm::vec4* dst = packed.data() + frame * numOfVerts * 2;
+			const std::vector<glm::vec3>& positions = m_Vertices[frame];
+			const std::vector<glm::vec3>* normals = (frame < m_Normals.size()) ? &m_Normals[frame] : nullptr;
+			for (size_t vert = 0; vert < numOfVerts && vert < positions.size(); vert++) {
+				dst[vert * 2] = glm::vec4(positions[vert], 1.0f);
+				if (normals != nullptr && vert < normals->size())
+					dst[vert * 2 + 1] = glm::vec4((*normals)[vert], 0.0f);
+			}
+		}
+
+		if (m_morphBuffer == nullptr)
+			m_morphBuffer = TTN_ShaderStorageBuffer::Create(GL_STATIC_DRAW);
+		m_morphBuffer->LoadData(packed.data(), packed.size());
+	}
+
 	//gets the pointer to the meshes vao 
 	TTN_VertexArrayObject::svaptr TTN_Mesh::GetVAOPointer()
 	{
@@ -1,285 +1,687 @@
 //Titan Engine, by Atlas X Games
-//ObjLoader.cpp - source file for the class that parses OBJ files into TTN_Models 
+//ObjLoader.cpp - source file for the class that parses OBJ files into TTN_Models
 
-//precompile header, this file uses string, sstream, fstream, iostream, algorithm, and Logging.h
+//precompile header, this file uses string, fstream, vector, cstring, filesystem, and Logging.h
 #include "Titan/ttn_pch.h"
 //include the header
 #include "Titan/ObjLoader.h"
+//include the threading headers for naming the temporary cache files
+#include <atomic>
+#include <thread>
+
+//include the os headers for memory mapping files
+#ifdef WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace Titan {
 
-	// Taken from https://stackoverflow.com/questions/216823/whats-the-best-way-to-trim-stdstring
-#pragma region String Trimming
+#pragma region Memory Mapped Files
+
+	//read only view of a whole file, mapped into memory so it can be parsed in place without copying it into a buffer first
+	class TTN_MappedFile {
+	public:
+		TTN_MappedFile(const std::string& fileName) : m_data(nullptr), m_size(0), m_open(false)
+		{
+#ifdef WINDOWS
+			m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			m_mapping = nullptr;
+			if (m_file == INVALID_HANDLE_VALUE)
+				return;
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size))
+				return;
+			m_size = (size_t)size.QuadPart;
+			m_open = true;
+
+			//empty files can't be mapped, but they're still open (just with nothing in them)
+			if (m_size == 0)
+				return;
+
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping != nullptr)
+				m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			m_open = m_data != nullptr;
+#else
+			m_file = open(fileName.c_str(), O_RDONLY);
+			if (m_file < 0)
+				return;
+
+			struct stat info;
+			if (fstat(m_file, &info) != 0)
+				return;
+			m_size = (size_t)info.st_size;
+			m_open = true;
+
+			//empty files can't be mapped, but they're still open (just with nothing in them)
+			if (m_size == 0)
+				return;
+
+			void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (mapped != MAP_FAILED) {
+				m_data = static_cast<const char*>(mapped);
+				//the whole file gets read front to back
+				madvise(mapped, m_size, MADV_SEQUENTIAL);
+			}
+			m_open = m_data != nullptr;
+#endif
+		}
+
+		~TTN_MappedFile()
+		{
+#ifdef WINDOWS
+			if (m_data != nullptr) UnmapViewOfFile(m_data);
+			if (m_mapping != nullptr) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+			if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+			if (m_file >= 0) close(m_file);
+#endif
+		}
 
-// trim from start (in place)
-	static inline void ltrim(std::string& s) {
-		s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
-			return !std::isspace(ch);
-		}));
+		//ensuring moving and copying is not allowed so the mapping only gets released once
+		TTN_MappedFile(const TTN_MappedFile& other) = delete;
+		TTN_MappedFile& operator=(const TTN_MappedFile& other) = delete;
+
+		//gets wheter or not the file was opened and mapped
+		bool IsOpen() const { return m_open; }
+		//gets the start and end of the file's contents
+		const char* Begin() const { return m_data; }
+		const char* End() const { return m_data + m_size; }
+		//gets the size of the file in bytes
+		size_t GetSize() const { return m_size; }
+
+	private:
+#ifdef WINDOWS
+		HANDLE m_file;
+		HANDLE m_mapping;
+#else
+		int m_file;
+#endif
+		const char* m_data;
+		size_t m_size;
+		bool m_open;
+	};
+
+#pragma endregion
+
+#pragma region Number Parsing
+
+	//powers of ten that can be represented exactly as doubles
+	static const double s_powersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	//gets if a character is a digit
+	static inline bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
 	}
 
-	// trim from end (in place)
-	static inline void rtrim(std::string& s) {
-		s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
-			return !std::isspace(ch);
-		}).base(), s.end());
+	//gets if a character is a space or tab
+	static inline bool IsBlank(char c) {
+		return c == ' ' || c == '\t';
 	}
 
-	// trim from both ends (in place)
-	static inline void trim(std::string& s) {
-		ltrim(s);
-		rtrim(s);
+	//skips over the spaces and tabs at p
+	static inline const char* SkipBlanks(const char* p, const char* end) {
+		while (p < end && IsBlank(*p)) p++;
+		return p;
 	}
 
-#pragma endregion 
+	//skips to the start of the next line
+	static inline const char* SkipLine(const char* p, const char* end) {
+		const char* newLine = static_cast<const char*>(memchr(p, '\n', end - p));
+		return (newLine != nullptr) ? newLine + 1 : end;
+	}
 
-	TTN_Mesh::smptr TTN_ObjLoader::LoadFromFile(const std::string& fileName)
-	{
-		//Vectors for storing data parsed in 
-		std::vector<glm::vec3> vertexPos;
-		std::vector<glm::vec2> vertexUV; 
-		std::vector<glm::vec3> vertexNorms; 
+	//parses a float at p (after any blanks), returning where it stopped reading
+	//the digits are collected into a 64 bit integer and scaled once at the end, so there's no locale lookups or allocations like strtof
+	//or streams have
+	static const char* ParseFloat(const char* p, const char* end, float& out) {
+		p = SkipBlanks(p, end);
 
-		std::vector<GLint> vertexPosIndices; 
-		std::vector<GLint> vertexUvsIndices;
-		std::vector<GLint> vertexNormIndices;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
 
-		//Open the file
-		std::ifstream file;
-		file.open(fileName, std::ios::binary);
+		//read the digits, anything past what a 64 bit integer can hold just moves the exponent
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		while (p < end && IsDigit(*p)) {
+			if (mantissa < 100000000000000000ULL) mantissa = mantissa * 10 + (*p - '0');
+			else exponent++;
+			p++;
+		}
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && IsDigit(*p)) {
+				if (mantissa < 100000000000000000ULL) {
+					mantissa = mantissa * 10 + (*p - '0');
+					exponent--;
+				}
+				p++;
+			}
+		}
 
-		//if it fails to open, throw an error
-		if (!file) {
-			LOG_ERROR("Obj Loader failed to open file.");
-			throw std::runtime_error("Obj Loader failed to open file.");
+		//read the exponent if it has one
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negativeExponent = *p == '-';
+				p++;
+			}
+			int fileExponent = 0;
+			while (p < end && IsDigit(*p)) {
+				if (fileExponent < 1000) fileExponent = fileExponent * 10 + (*p - '0');
+				p++;
+			}
+			exponent += negativeExponent ? -fileExponent : fileExponent;
 		}
 
-		//get a string to represent each line of the file
-		std::string line;
+		//scale the digits by the exponent
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value /= (exponent >= -22) ? s_powersOf10[-exponent] : std::pow(10.0, -exponent);
+		else if (exponent > 0)
+			value *= (exponent <= 22) ? s_powersOf10[exponent] : std::pow(10.0, exponent);
 
-		//parse each line of the file
-		while (std::getline(file, line)) {
-			//trim the line so there isn't any white space
-			trim(line);
+		out = (float)(negative ? -value : value);
+		return p;
+	}
+
+	//parses an int at p, returning where it stopped reading, sets read to false if there weren't any digits
+	static inline const char* ParseInt(const char* p, const char* end, int32_t& out, bool& read) {
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		int32_t value = 0;
+		read = false;
+		while (p < end && IsDigit(*p)) {
+			value = value * 10 + (*p - '0');
+			read = true;
+			p++;
+		}
+
+		out = negative ? -value : value;
+		return p;
+	}
+
+#pragma endregion
+
+#pragma region Obj Parsing
 
-			//check if the line is a comment
-			if (line.substr(0, 1) == "#") {
-				//if it is, there is no need to do anything with it
+	//the position, uv, and normal indices of a face corner (zero based, -1 if the corner doesn't have one)
+	struct TTN_ObjCorner {
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+
+		bool operator==(const TTN_ObjCorner& other) const {
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	//everything read out of a single obj file
+	struct TTN_ObjFileData {
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		//the corners of every triangle, polygons are split into fans of triangles
+		std::vector<TTN_ObjCorner> corners;
+	};
+
+	//turns an obj index into a zero based one, obj indices start at 1 and negative indices count back from the latest element
+	static inline int32_t ResolveIndex(int32_t index, size_t count) {
+		if (index > 0) return index - 1;
+		if (index < 0) return (int32_t)count + index;
+
+		LOG_ERROR("Obj Loader found an index of 0.");
+		throw std::runtime_error("Obj Loader found an index of 0.");
+	}
+
+	//parses the face corner at p, returning where it stopped reading
+	static inline const char* ParseCorner(const char* p, const char* end, const TTN_ObjFileData& file, TTN_ObjCorner& corner) {
+		int32_t index;
+		bool read;
+
+		//the position is always there
+		p = ParseInt(p, end, index, read);
+		corner.position = ResolveIndex(index, file.positions.size());
+		corner.uv = -1;
+		corner.normal = -1;
+
+		//the uv and normal are both optional (v, v/vt, v//vn, and v/vt/vn are all valid)
+		if (p < end && *p == '/') {
+			p = ParseInt(p + 1, end, index, read);
+			if (read) corner.uv = ResolveIndex(index, file.uvs.size());
+
+			if (p < end && *p == '/') {
+				p = ParseInt(p + 1, end, index, read);
+				if (read) corner.normal = ResolveIndex(index, file.normals.size());
 			}
-			//if it's not a a comment, check if it is an object
-			else if (line.substr(0, 1) == "o") {
+		}
+
+		//skip over anything else left in the token
+		while (p < end && !IsBlank(*p) && *p != '\r' && *p != '\n') p++;
+		return p;
+	}
 
+	//parses a whole obj file that has been loaded into memory
+	static void ParseObj(const char* begin, const char* end, TTN_ObjFileData& file) {
+		//count the elements first so every vector can be allocated once, this is much cheaper than the parsing itself
+		size_t numOfPositions = 0, numOfUvs = 0, numOfNormals = 0, numOfFaces = 0;
+		for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+			p = SkipBlanks(p, end);
+			if (end - p < 2) continue;
+			if (p[0] == 'v') {
+				if (IsBlank(p[1])) numOfPositions++;
+				else if (p[1] == 't') numOfUvs++;
+				else if (p[1] == 'n') numOfNormals++;
 			}
-			//if not, then check if it's a vertex
-			else if (line.substr(0, 2) == "v ") {
-				//grab the line passed the v
-				std::istringstream ss = std::istringstream(line.substr(2));
-				//add a new vertex position to the vector
-				vertexPos.push_back(glm::vec3(1.0f));
-				//copy the line into it 
-				ss >> vertexPos[vertexPos.size() - 1].x >> vertexPos[vertexPos.size() - 1].y >> vertexPos[vertexPos.size() - 1].z;
+			else if (p[0] == 'f' && IsBlank(p[1])) numOfFaces++;
+		}
+		file.positions.reserve(numOfPositions);
+		file.uvs.reserve(numOfUvs);
+		file.normals.reserve(numOfNormals);
+		//most faces are triangles or quads, so guess two triangles per face
+		file.corners.reserve(numOfFaces * 6);
+
+		//the corners of the face currently being parsed, kept outside the loop so the memory gets reused
+		std::vector<TTN_ObjCorner> faceCorners;
+		faceCorners.reserve(16);
+
+		//parse each line of the file
+		for (const char* p = begin; p < end; p = SkipLine(p, end)) {
+			p = SkipBlanks(p, end);
+			if (end - p < 2) continue;
+
+			//check if it's a vertex
+			if (p[0] == 'v' && IsBlank(p[1])) {
+				glm::vec3 position;
+				p = ParseFloat(p + 2, end, position.x);
+				p = ParseFloat(p, end, position.y);
+				p = ParseFloat(p, end, position.z);
+				file.positions.push_back(position);
 			}
 			//if not then check if it's a uv
-			else if (line.substr(0, 2) == "vt") {
-				//grab the line past the vt
-				std::istringstream ss = std::istringstream(line.substr(2));
-				//add a new vertex uv to the vector 
-				vertexUV.push_back(glm::vec3(1.0f));
-				//copy the line into it
-				ss >> vertexUV[vertexUV.size() - 1].x >> vertexUV[vertexUV.size() - 1].y;
+			else if (p[0] == 'v' && p[1] == 't') {
+				glm::vec2 uv;
+				p = ParseFloat(p + 2, end, uv.x);
+				p = ParseFloat(p, end, uv.y);
+				file.uvs.push_back(uv);
 			}
 			//if not then check if it's a normal
-			else if (line.substr(0, 2) == "vn") {
-				//grab the line passed the vn
-				std::istringstream ss = std::istringstream(line.substr(2));
-				//add a new vertex normal to the vector
-				vertexNorms.push_back(glm::vec3(1.0f));
-				//copy the line into it 
-				ss >> vertexNorms[vertexNorms.size() - 1].x >> vertexNorms[vertexNorms.size() - 1].y >> vertexNorms[vertexNorms.size() - 1].z;
+			else if (p[0] == 'v' && p[1] == 'n') {
+				glm::vec3 normal;
+				p = ParseFloat(p + 2, end, normal.x);
+				p = ParseFloat(p, end, normal.y);
+				p = ParseFloat(p, end, normal.z);
+				file.normals.push_back(normal);
 			}
-			//if not then check if it's a face index detail
-			else if (line.substr(0, 1) == "f") {
-				int counter = 0; //used to check which detail we're on (0=vertex index, 1=uv index, 2=normal index)
-				GLint temp; //used to temporarily store the index before pushing it into one of the vectors
-				std::istringstream ss = std::istringstream(line.substr(1));
-				//go through the line
-				while (ss >> temp) {
-					if (counter == 0) vertexPosIndices.push_back(temp);
-					else if (counter == 1) vertexUvsIndices.push_back(temp);
-					else if (counter == 2) vertexNormIndices.push_back(temp);
-
-					//check if the next character is a forward slash
-					if (ss.peek() == '/') {
-						//if it is, move to the next character, skipping over the slash
-						counter++;
-						ss.ignore(1, '/');
-					}
-					//if it's not, check if it's a space
-					else if (ss.peek() == ' ') {
-						//if it is, move to the next character, skipping over the space
-						counter++;
-						ss.ignore(1, ' ');
-					}
-
-					//if the counter goes above 2, reset it to zero so it takes another vertex position
-					if (counter > 2)
-						counter = 0;
+			//if not then check if it's a face
+			else if (p[0] == 'f' && IsBlank(p[1])) {
+				//read every corner on the line
+				faceCorners.clear();
+				p = SkipBlanks(p + 2, end);
+				while (p < end && (IsDigit(*p) || *p == '-')) {
+					TTN_ObjCorner corner;
+					p = ParseCorner(p, end, file, corner);
+					faceCorners.push_back(corner);
+					p = SkipBlanks(p, end);
+				}
+
+				//split it into a fan of triangles
+				for (size_t i = 2; i < faceCorners.size(); i++) {
+					file.corners.push_back(faceCorners[0]);
+					file.corners.push_back(faceCorners[i - 1]);
+					file.corners.push_back(faceCorners[i]);
 				}
-					
 			}
-			//if it's anything else we can just ignore it for now
+			//if it's anything else (comments, objects, groups, materials, etc.) we can just ignore it
 		}
+	}
+
+	//opens and parses an obj file
+	static void ParseObjFile(const std::string& fileName, TTN_ObjFileData& file) {
+		TTN_MappedFile mappedFile(fileName);
 
-		//now we have loaded in all the data, we can use it to construct a mesh 
-		//create a new vectors with all the positions, uvs, and normals (this is the lenght of the indices, as these are all the vertices needed to construct the faces, some of which
-		//may have the same values twice) 
-		std::vector <glm::vec3> meshVertPos; 
-		std::vector <glm::vec2> meshVertUvs;
-		std::vector <glm::vec3> meshVertNorms;
-		//make that those vector the lenght of the their indices vector equilavents
-		meshVertPos.resize(vertexPosIndices.size(), glm::vec3());
-		meshVertUvs.resize(vertexUvsIndices.size(), glm::vec2());
-		meshVertNorms.resize(vertexNormIndices.size(), glm::vec3());
-		
-		//copy the data from the first set of vectors into the new vectors based on the indices so that they can used by the mesh
-		for (int i = 0; i < meshVertPos.size(); i++) {
-			//copy the positions
-			meshVertPos[i] = vertexPos[vertexPosIndices[i] - 1]; 
+		//if it fails to open, throw an error
+		if (!mappedFile.IsOpen()) {
+			LOG_ERROR("Obj Loader failed to open file {}.", fileName);
+			throw std::runtime_error("Obj Loader failed to open file.");
 		}
-		for (int i = 0; i < meshVertUvs.size(); i++) {
-			//copy the uvs
-			meshVertUvs[i] = vertexUV[vertexUvsIndices[i] - 1];
+
+		ParseObj(mappedFile.Begin(), mappedFile.End(), file);
+	}
+
+	//hashes a face corner for the vertex deduplication table
+	static inline uint32_t HashCorner(const TTN_ObjCorner& corner) {
+		uint32_t hash = (uint32_t)corner.position * 0x9E3779B1u;
+		hash ^= (uint32_t)corner.uv * 0x85EBCA77u + (hash << 6) + (hash >> 2);
+		hash ^= (uint32_t)corner.normal * 0xC2B2AE3Du + (hash << 6) + (hash >> 2);
+		hash ^= hash >> 15;
+		return hash;
+	}
+
+	//merges the corners with the same position, uv, and normal into single vertices, writing the unique corners into vertices and
+	//the index of the vertex each corner uses into indices
+	static void DeduplicateCorners(const std::vector<TTN_ObjCorner>& corners, std::vector<TTN_ObjCorner>& vertices, std::vector<uint32_t>& indices) {
+		//open addressing table of vertex indices, at least twice the number of corners so it never gets more than half full
+		size_t tableSize = 16;
+		while (tableSize < corners.size() * 2) tableSize *= 2;
+		const uint32_t mask = (uint32_t)tableSize - 1;
+		const uint32_t empty = UINT32_MAX;
+		std::vector<uint32_t> table(tableSize, empty);
+
+		vertices.clear();
+		indices.clear();
+		indices.reserve(corners.size());
+
+		for (const TTN_ObjCorner& corner : corners) {
+			//probe until we find either the same vertex or an empty slot
+			uint32_t slot = HashCorner(corner) & mask;
+			while (table[slot] != empty && !(vertices[table[slot]] == corner))
+				slot = (slot + 1) & mask;
+
+			//if it's a new vertex add it
+			if (table[slot] == empty) {
+				table[slot] = (uint32_t)vertices.size();
+				vertices.push_back(corner);
+			}
+
+			indices.push_back(table[slot]);
 		}
-		for (int i = 0; i < meshVertNorms.size(); i++) {
-			//copy the normals
-			meshVertNorms[i] = vertexNorms[vertexNormIndices[i] - 1];
+	}
+
+	//throws an error if a corner refers to data the file doesn't have
+	static inline void ValidateCorner(const TTN_ObjCorner& corner, const TTN_ObjFileData& file) {
+		//uvs and normals can be -1 for a corner that doesn't have one, but nothing lower
+		if (corner.position < 0 || corner.position >= (int32_t)file.positions.size() ||
+			corner.uv < -1 || corner.uv >= (int32_t)file.uvs.size() ||
+			corner.normal < -1 || corner.normal >= (int32_t)file.normals.size()) {
+			LOG_ERROR("Obj Loader found a face index out of range.");
+			throw std::runtime_error("Obj Loader found a face index out of range.");
 		}
+	}
 
-		//create and return the mesh from that data
-		TTN_Mesh::smptr newMesh = TTN_Mesh::Create();
-		newMesh->AddVertices(meshVertPos);
-		newMesh->AddNormals(meshVertNorms);
-		newMesh->SetUVs(meshVertUvs);
+#pragma endregion
+
+#pragma region Binary Cache
+
+	//the start of a cache file, followed by a source for every obj file it was built from, the uvs, the indices, and then the positions
+	//and normals for each frame
+	struct TTN_MeshCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numOfSources;
+		uint32_t numOfFrames;
+		uint32_t numOfVertices;
+		uint32_t numOfIndices;
+	};
+
+	//the size and last write time of an obj file a cache was built from, if either changes the cache is out of date
+	struct TTN_MeshCacheSource {
+		uint64_t size;
+		int64_t writeTime;
+	};
+
+	//the characters TTNM, marking the file as a titan mesh cache
+	static const uint32_t s_cacheMagic = 0x4D4E5454;
+
+	//gets the cache file for a list of obj files
+	static std::string GetCacheFileName(const std::string& fileName) {
+		return std::filesystem::path(fileName).replace_extension(".ttnmesh").string();
+	}
 
-		return newMesh;
+	//gets the size and write time of the obj files, returns false if any of them don't exist
+	static bool GetCacheSources(const std::vector<std::string>& fileNames, std::vector<TTN_MeshCacheSource>& sources) {
+		sources.resize(fileNames.size());
+		for (size_t i = 0; i < fileNames.size(); i++) {
+			std::error_code error;
+			sources[i].size = (uint64_t)std::filesystem::file_size(fileNames[i], error);
+			if (error) return false;
+			sources[i].writeTime = (int64_t)std::filesystem::last_write_time(fileNames[i], error).time_since_epoch().count();
+			if (error) return false;
+		}
+
+		return true;
 	}
 
-	//loads a series of meshes for morph target animations, assumes the files are named with the convention: fileName_1, fileName_2, etc.
-	TTN_Mesh::smptr TTN_ObjLoader::LoadAnimatedMeshFromFiles(const std::string& fileName, int numOfFiles)
-	{
-		//start by loading the first mesh, this will handle the first set of vertices and normals along with the uvs
-		TTN_Mesh::smptr newMesh = LoadFromFile(fileName + "_1.obj");
-
-		//from there loop through the next couple of files, loading in vertices and normals and adding them to newMesh
-		for (int i = 2; i <= numOfFiles; i++) {
-			//Vectors for storing data parsed in 
-			std::vector<glm::vec3> vertexPos;
-			std::vector<glm::vec3> vertexNorms;
-			std::vector<GLint> vertexPosIndices;
-			std::vector<GLint> vertexNormIndices;
-
-			//Open the file
-			std::ifstream file;
-			file.open(fileName + "_" + std::to_string(i) + ".obj", std::ios::binary);
-
-			//if it fails to open, throw an error
+	//copies count elements out of the cache, advancing the read pointer
+	template <typename T>
+	static inline void ReadCacheArray(const char*& p, std::vector<T>& out, size_t count) {
+		out.resize(count);
+		if (count > 0) memcpy(out.data(), p, sizeof(T) * count);
+		p += sizeof(T) * count;
+	}
+
+	//loads a cache file if it exists and was built from the current version of the obj files, returns false if it couldn't be used
+	static bool ReadCache(const std::string& cacheFileName, const std::vector<TTN_MeshCacheSource>& sources, TTN_ObjMeshData& data) {
+		TTN_MappedFile mappedFile(cacheFileName);
+		if (!mappedFile.IsOpen() || mappedFile.GetSize() < sizeof(TTN_MeshCacheHeader))
+			return false;
+
+		//check the header matches what we're expecting
+		TTN_MeshCacheHeader header;
+		memcpy(&header, mappedFile.Begin(), sizeof(TTN_MeshCacheHeader));
+		if (header.magic != s_cacheMagic || header.version != TTN_ObjLoader::s_cacheVersion || header.numOfSources != sources.size())
+			return false;
+
+		//check the file is the size the header says it is, so a partly written cache doesn't get read
+		size_t expectedSize = sizeof(TTN_MeshCacheHeader) + sizeof(TTN_MeshCacheSource) * header.numOfSources
+			+ sizeof(glm::vec2) * header.numOfVertices + sizeof(uint32_t) * header.numOfIndices
+			+ sizeof(glm::vec3) * 2 * (size_t)header.numOfVertices * header.numOfFrames;
+		if (mappedFile.GetSize() != expectedSize)
+			return false;
+
+		//check none of the obj files have changed since the cache was built
+		const char* p = mappedFile.Begin() + sizeof(TTN_MeshCacheHeader);
+		for (const TTN_MeshCacheSource& source : sources) {
+			TTN_MeshCacheSource cachedSource;
+			memcpy(&cachedSource, p, sizeof(TTN_MeshCacheSource));
+			p += sizeof(TTN_MeshCacheSource);
+			if (cachedSource.size != source.size || cachedSource.writeTime != source.writeTime)
+				return false;
+		}
+
+		//copy the data out
+		ReadCacheArray(p, data.uvs, header.numOfVertices);
+		ReadCacheArray(p, data.indices, header.numOfIndices);
+		data.positions.resize(header.numOfFrames);
+		data.normals.resize(header.numOfFrames);
+		for (uint32_t i = 0; i < header.numOfFrames; i++) {
+			ReadCacheArray(p, data.positions[i], header.numOfVertices);
+			ReadCacheArray(p, data.normals[i], header.numOfVertices);
+		}
+
+		return true;
+	}
+
+	//saves loaded data to a cache file, failing to write it isn't an error as the obj files can always be parsed again
+	static void WriteCache(const std::string& cacheFileName, const std::vector<TTN_MeshCacheSource>& sources, const TTN_ObjMeshData& data) {
+		//write to a temporary file first and move it over the cache at the end, so a crash midway never leaves a broken cache behind,
+		//meshes can be loaded on several threads at once so each write gets it's own temporary file, otherwise two loads of the same
+		//mesh could write into the same one and move a mix of both into place
+		static std::atomic<uint32_t> s_tempFileCounter{ 0 };
+		std::string tempFileName = cacheFileName + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+			+ "." + std::to_string(s_tempFileCounter.fetch_add(1)) + ".tmp";
+		{
+			std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
 			if (!file) {
-				LOG_ERROR("Obj Loader failed to open file.");
-				throw std::runtime_error("Obj Loader failed to open file.");
+				LOG_WARN("Obj Loader couldn't write the mesh cache {}.", cacheFileName);
+				return;
 			}
 
-			//get a string to represent each line of the file
-			std::string line;
+			TTN_MeshCacheHeader header;
+			header.magic = s_cacheMagic;
+			header.version = TTN_ObjLoader::s_cacheVersion;
+			header.numOfSources = (uint32_t)sources.size();
+			header.numOfFrames = (uint32_t)data.positions.size();
+			header.numOfVertices = (uint32_t)data.uvs.size();
+			header.numOfIndices = (uint32_t)data.indices.size();
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(TTN_MeshCacheHeader));
+			file.write(reinterpret_cast<const char*>(sources.data()), sizeof(TTN_MeshCacheSource) * sources.size());
+			file.write(reinterpret_cast<const char*>(data.uvs.data()), sizeof(glm::vec2) * data.uvs.size());
+			file.write(reinterpret_cast<const char*>(data.indices.data()), sizeof(uint32_t) * data.indices.size());
+			for (size_t i = 0; i < data.positions.size(); i++) {
+				file.write(reinterpret_cast<const char*>(data.positions[i].data()), sizeof(glm::vec3) * data.positions[i].size());
+				file.write(reinterpret_cast<const char*>(data.normals[i].data()), sizeof(glm::vec3) * data.normals[i].size());
+			}
 
-			//parse each line of the file
-			while (std::getline(file, line)) {
-				//trim the line so there isn't any white space
-				trim(line);
+			if (!file) {
+				LOG_WARN("Obj Loader couldn't write the mesh cache {}.", cacheFileName);
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(tempFileName, error);
+				return;
+			}
+		}
 
-				//check if the line is a comment
-				if (line.substr(0, 1) == "#") {
-					//if it is, there is no need to do anything with it
-				}
-				//if it's not a a comment, check if it is an object
-				else if (line.substr(0, 1) == "o") {
+		std::error_code error;
+		std::filesystem::rename(tempFileName, cacheFileName, error);
+		if (error) {
+			LOG_WARN("Obj Loader couldn't write the mesh cache {}.", cacheFileName);
+			std::filesystem::remove(tempFileName, error);
+		}
+	}
 
-				}
-				//if not, then check if it's a vertex
-				else if (line.substr(0, 2) == "v ") {
-					//grab the line passed the v
-					std::istringstream ss = std::istringstream(line.substr(2));
-					//add a new vertex position to the vector
-					vertexPos.push_back(glm::vec3(1.0f));
-					//copy the line into it 
-					ss >> vertexPos[vertexPos.size() - 1].x >> vertexPos[vertexPos.size() - 1].y >> vertexPos[vertexPos.size() - 1].z;
-				}
-				//if not then check if it's a normal
-				else if (line.substr(0, 2) == "vn") {
-					//grab the line passed the vn
-					std::istringstream ss = std::istringstream(line.substr(2));
-					//add a new vertex normal to the vector
-					vertexNorms.push_back(glm::vec3(1.0f));
-					//copy the line into it 
-					ss >> vertexNorms[vertexNorms.size() - 1].x >> vertexNorms[vertexNorms.size() - 1].y >> vertexNorms[vertexNorms.size() - 1].z;
-				}
-				//if not then check if it's a face index detail
-				else if (line.substr(0, 1) == "f") {
-					int counter = 0; //used to check which detail we're on (0=vertex index, 1=uv index, 2=normal index)
-					GLint temp; //used to temporarily store the index before pushing it into one of the vectors
-					std::istringstream ss = std::istringstream(line.substr(1));
-					//go through the line
-					while (ss >> temp) {
-						if (counter == 0) vertexPosIndices.push_back(temp);
-						else if (counter == 2) vertexNormIndices.push_back(temp);
-
-						//check if the next character is a forward slash
-						if (ss.peek() == '/') {
-							//if it is, move to the next character, skipping over the slash
-							counter++;
-							ss.ignore(1, '/');
-						}
-						//if it's not, check if it's a space
-						else if (ss.peek() == ' ') {
-							//if it is, move to the next character, skipping over the space
-							counter++;
-							ss.ignore(1, ' ');
-						}
-
-						//if the counter goes above 2, reset it to zero so it takes another vertex position
-						if (counter > 2)
-							counter = 0;
-					}
+#pragma endregion
 
-				}
-				//if it's anything else we can just ignore it for now
+	//loads a mesh from an obj file
+	TTN_Mesh::smptr TTN_ObjLoader::LoadFromFile(const std::string& fileName, bool useCache)
+	{
+		TTN_ObjMeshData data;
+		LoadDataFromFile(fileName, data, useCache);
+		return CreateMesh(data);
+	}
 
-			}
+	//loads a series of meshes for morph target animations, assumes the files are named with the convention: fileName_1, fileName_2, etc.
+	TTN_Mesh::smptr TTN_ObjLoader::LoadAnimatedMeshFromFiles(const std::string& fileName, int numOfFiles, bool useCache)
+	{
+		TTN_ObjMeshData data;
+		LoadAnimatedDataFromFiles(fileName, numOfFiles, data, useCache);
+		return CreateMesh(data);
+	}
 
-			//now we have loaded in all the data, we can use it to construct a mesh 
-			//create a new vectors with all the positions, uvs, and normals (this is the lenght of the indices, as these are all the vertices needed to construct the faces, some of which
-			//may have the same values twice) 
-			std::vector <glm::vec3> meshVertPos;
-			std::vector <glm::vec3> meshVertNorms;
-			//make that those vector the lenght of the their indices vector equilavents
-			meshVertPos.resize(vertexPosIndices.size(), glm::vec3());
-			meshVertNorms.resize(vertexNormIndices.size(), glm::vec3());
-
-			//copy the data from the first set of vectors into the new vectors based on the indices so that they can used by the mesh
-			for (int i = 0; i < meshVertPos.size(); i++) {
-				//copy the positions
-				meshVertPos[i] = vertexPos[vertexPosIndices[i] - 1];
-			}
-			for (int i = 0; i < meshVertNorms.size(); i++) {
-				//copy the normals
-				meshVertNorms[i] = vertexNorms[vertexNormIndices[i] - 1];
+	//loads the data for a mesh from an obj file
+	void TTN_ObjLoader::LoadDataFromFile(const std::string& fileName, TTN_ObjMeshData& data, bool useCache)
+	{
+		//a single file is just an animation with one frame
+		std::vector<std::string> fileNames = { fileName };
+		std::vector<TTN_MeshCacheSource> sources;
+		std::string cacheFileName = GetCacheFileName(fileName);
+
+		//if the cache is up to date there's no need to parse anything
+		bool haveSources = useCache && GetCacheSources(fileNames, sources);
+		if (haveSources && ReadCache(cacheFileName, sources, data))
+			return;
+
+		//parse the file
+		TTN_ObjFileData file;
+		ParseObjFile(fileName, file);
+
+		//merge the corners into indexed vertices
+		std::vector<TTN_ObjCorner> vertices;
+		DeduplicateCorners(file.corners, vertices, data.indices);
+
+		//and copy the data for each vertex, corners without a uv or normal get zeros
+		data.positions.assign(1, std::vector<glm::vec3>(vertices.size()));
+		data.normals.assign(1, std::vector<glm::vec3>(vertices.size(), glm::vec3(0.0f)));
+		data.uvs.assign(vertices.size(), glm::vec2(0.0f));
+		for (size_t i = 0; i < vertices.size(); i++) {
+			ValidateCorner(vertices[i], file);
+			data.positions[0][i] = file.positions[vertices[i].position];
+			if (vertices[i].normal >= 0) data.normals[0][i] = file.normals[vertices[i].normal];
+			if (vertices[i].uv >= 0) data.uvs[i] = file.uvs[vertices[i].uv];
+		}
+
+		//save the cache for next time
+		if (haveSources)
+			WriteCache(cacheFileName, sources, data);
+	}
+
+	//loads the data for a morph target animated mesh from a series of obj files
+	void TTN_ObjLoader::LoadAnimatedDataFromFiles(const std::string& fileName, int numOfFiles, TTN_ObjMeshData& data, bool useCache)
+	{
+		//there has to be at least one frame to load, otherwise the mesh is just left empty
+		if (numOfFiles <= 0) {
+			LOG_ERROR("Obj Loader was asked to load {} frames of {}.", numOfFiles, fileName);
+			return;
+		}
+
+		std::vector<std::string> fileNames;
+		for (int i = 1; i <= numOfFiles; i++)
+			fileNames.push_back(fileName + "_" + std::to_string(i) + ".obj");
+
+		//the whole animation goes into one cache
+		std::vector<TTN_MeshCacheSource> sources;
+		std::string cacheFileName = GetCacheFileName(fileName + "_frames");
+
+		//if the cache is up to date there's no need to parse anything
+		bool haveSources = useCache && GetCacheSources(fileNames, sources);
+		if (haveSources && ReadCache(cacheFileName, sources, data))
+			return;
+
+		//start by loading the first frame, this handles the first set of vertices and normals along with the uvs and indices
+		LoadDataFromFile(fileNames[0], data, false);
+		data.positions.resize(numOfFiles);
+		data.normals.resize(numOfFiles);
+
+		//every frame has the same faces, so each corner of the later frames goes into the vertex the same corner of the first
+		//frame was merged into
+		TTN_ObjFileData file;
+		for (int i = 1; i < numOfFiles; i++) {
+			file.positions.clear();
+			file.uvs.clear();
+			file.normals.clear();
+			file.corners.clear();
+			ParseObjFile(fileNames[i], file);
+
+			if (file.corners.size() != data.indices.size()) {
+				LOG_ERROR("Obj Loader found {} doesn't have the same faces as the first frame.", fileNames[i]);
+				throw std::runtime_error("Obj Loader found a morph target frame with different faces.");
 			}
 
-			//with the data all loaded in it need only be added to the mesh object
-			newMesh->AddVertices(meshVertPos);
-			newMesh->AddNormals(meshVertNorms);
+			data.positions[i].assign(data.uvs.size(), glm::vec3(0.0f));
+			data.normals[i].assign(data.uvs.size(), glm::vec3(0.0f));
+			for (size_t j = 0; j < file.corners.size(); j++) {
+				const TTN_ObjCorner& corner = file.corners[j];
+				ValidateCorner(corner, file);
+				data.positions[i][data.indices[j]] = file.positions[corner.position];
+				if (corner.normal >= 0) data.normals[i][data.indices[j]] = file.normals[corner.normal];
+			}
 		}
 
-		//at the end of the for loop all the animation files will be loaded into a single mesh object, so you can just return that mesh
+		//save the cache for next time
+		if (haveSources)
+			WriteCache(cacheFileName, sources, data);
+	}
+
+	//creates a mesh from loaded data
+	TTN_Mesh::smptr TTN_ObjLoader::CreateMesh(TTN_ObjMeshData& data)
+	{
+		TTN_Mesh::smptr newMesh = TTN_Mesh::Create();
+		//the frames go straight into the mesh's packed morph buffer
+		newMesh->SetMorphFrames(data.positions, data.normals);
+		newMesh->SetUVs(data.uvs);
+		newMesh->SetIndices(data.indices);
+
 		return newMesh;
 	}
-}
\ No newline at end of file
+}
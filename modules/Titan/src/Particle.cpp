@@ -5,10 +5,19 @@
 #include "Titan/ttn_pch.h"
 //include the header
 #include "Titan/Particle.h"
+//include the job system for multithreading the update
+#include "Titan/JobSystem.h"
 
 //code refernce: https://www.youtube.com/watch?v=GK0jHlv3e3w&t=515s
 
 namespace Titan {
+	//uniform ids used by this file, interned once so setting them doesn't need to look up the names
+	static const TTN_UniformId s_uniformModel("u_model");
+	static const TTN_UniformId s_uniformMVP("u_mvp");
+	static const TTN_UniformId s_uniformNormalMat("u_normalMat");
+	static const TTN_UniformId s_uniformDeltaTime("u_deltaTime");
+	static const TTN_UniformId s_uniformReadGraphSamples("u_readGraphSamples");
+
 	//default constructor
 	TTN_ParticleSystem::TTN_ParticleSystem()
 	{
@@ -22,34 +31,29 @@ namespace Titan {
 		m_loop = true;
 		m_paused = false;
 		m_emissionTimer = 0.0f;
+		m_backend = TTN_ParticleBackend::CPU;
+		m_gpuAliveList = 0;
+		m_gpuPendingEmits = 0;
+		m_gpuReadGraphsDirty = true;
+		m_gpuCountReadback = 0;
+		m_gpuCountData = nullptr;
+		for (GLsync& fence : m_gpuCountFences)
+			fence = nullptr;
+		m_gpuCountSlot = 0;
+		m_gpuActiveCount = 0;
 
 		m_maxParticlesCount = 1000;
 		m_durationRemaining = m_duration;
-		m_activeParticleIndex = m_maxParticlesCount - 1;
 		m_vao = TTN_VertexArrayObject::Create();
 
 		//reverse memory space for all the particle data
-		Positions = new glm::vec3[m_maxParticlesCount];
-		StartColors = new glm::vec4[m_maxParticlesCount];
-		EndColors = new glm::vec4[m_maxParticlesCount];
-		StartVelocities = new glm::vec3[m_maxParticlesCount];
-		EndVelocities = new glm::vec3[m_maxParticlesCount];
-		StartScales = new float[m_maxParticlesCount];
-		EndScales = new float[m_maxParticlesCount];
-		timeAlive = new float[m_maxParticlesCount];
-		lifeTimes = new float[m_maxParticlesCount];
-		Active = new bool[m_maxParticlesCount];
-
-		particle_pos = new glm::vec3[m_maxParticlesCount];
-		particle_col = new glm::vec4[m_maxParticlesCount];
-		particle_scale = new float[m_maxParticlesCount];
-
+		SetUpParticleData();
 
 		//set up function pointers
-		readGraphVelo = &defaultReadGraph;
-		readGraphColor = &defaultReadGraph;
-		readGraphRotation = &defaultReadGraph;
-		readGraphScale = &defaultReadGraph;
+		VelocityReadGraphCallback(&defaultReadGraph);
+		ColorReadGraphCallback(&defaultReadGraph);
+		RotationReadGraphCallback(&defaultReadGraph);
+		ScaleReadGraphCallback(&defaultReadGraph);
 
 		SetUpRenderingStuff();
 	}
@@ -63,60 +67,48 @@ namespace Titan {
 		m_paused = false;
 
 		//reverse memory space for all the particle data
-		Positions = new glm::vec3[m_maxParticlesCount];
-		StartColors = new glm::vec4[m_maxParticlesCount];
-		EndColors = new glm::vec4[m_maxParticlesCount];
-		StartVelocities = new glm::vec3[m_maxParticlesCount];
-		EndVelocities = new glm::vec3[m_maxParticlesCount];
-		StartScales = new float[m_maxParticlesCount];
-		EndScales = new float[m_maxParticlesCount];
-		timeAlive = new float[m_maxParticlesCount];
-		lifeTimes = new float[m_maxParticlesCount];
-		Active = new bool[m_maxParticlesCount];
-
-		particle_pos = new glm::vec3[m_maxParticlesCount];
-		particle_col = new glm::vec4[m_maxParticlesCount];
-		particle_scale = new float[m_maxParticlesCount];
+		SetUpParticleData();
 
 		//setup the rest of the data
 		m_durationRemaining = 0.0f;
-		m_activeParticleIndex = m_maxParticlesCount - 1;
 		m_vao = TTN_VertexArrayObject::Create();
 		m_rotation = glm::vec3(0.0f);
 		m_emitterShape = TTN_ParticleEmitterShape::SPHERE;
 		m_EmitterAngle = 15.0f;
 		m_EmitterScale = glm::vec3(0.0f);
 		m_emissionTimer = 0.0f;
+		m_backend = TTN_ParticleBackend::CPU;
+		m_gpuAliveList = 0;
+		m_gpuPendingEmits = 0;
+		m_gpuReadGraphsDirty = true;
+		m_gpuCountReadback = 0;
+		m_gpuCountData = nullptr;
+		for (GLsync& fence : m_gpuCountFences)
+			fence = nullptr;
+		m_gpuCountSlot = 0;
+		m_gpuActiveCount = 0;
 
 		//set up function pointers
-		readGraphVelo = &defaultReadGraph;
-		readGraphColor = &defaultReadGraph;
-		readGraphRotation = &defaultReadGraph;
-		readGraphScale = &defaultReadGraph;
+		VelocityReadGraphCallback(&defaultReadGraph);
+		ColorReadGraphCallback(&defaultReadGraph);
+		RotationReadGraphCallback(&defaultReadGraph);
+		ScaleReadGraphCallback(&defaultReadGraph);
 
 		SetUpRenderingStuff();
 		
-		VertexPosVBO->LoadData(m_particle._mesh->GetVertexPositions().data(), m_particle._mesh->GetVertexPositions().size());
-		VertexNormVBO->LoadData(m_particle._mesh->GetVertexNormals().data(), m_particle._mesh->GetVertexNormals().size());
-		VertexUVVBO->LoadData(m_particle._mesh->GetVertexUvs().data(), m_particle._mesh->GetVertexUvs().size());
+		LoadParticleMesh();
 	}
 
+	//destructor, all the particle data is in vectors so it cleans itself up, just the gpu alive count readback needs deleting
 	TTN_ParticleSystem::~TTN_ParticleSystem()
 	{
-		delete[] Positions;
-		delete[] StartColors;
-		delete[] EndColors;
-		delete[] StartVelocities;
-		delete[] EndVelocities;
-		delete[] StartScales;
-		delete[] EndScales;
-		delete[] timeAlive;
-		delete[] lifeTimes;
-		delete[] Active;
-
-		delete[] particle_col;
-		delete[] particle_pos;
-		delete[] particle_scale;
+		ClearGPUCountReadbacks();
+		if (m_gpuCountReadback != 0) {
+			glUnmapNamedBuffer(m_gpuCountReadback);
+			glDeleteBuffers(1, &m_gpuCountReadback);
+			m_gpuCountReadback = 0;
+			m_gpuCountData = nullptr;
+		}
 	}
 
 	//set up the shaders for the particle system
@@ -129,6 +121,33 @@ namespace Titan {
 
 		//init the default particle texture too
 		s_defaultWhiteTexture = TTN_Texture2D::LoadFromFile("textures/ttn_particle_default.png");
+
+		//and if compute shaders are available, the shaders for the gpu backend
+		if (GLAD_GL_VERSION_4_3) {
+			s_particleEmitProgram = TTN_Shader::Create();
+			s_particleEmitProgram->LoadShaderStageFromFile("shaders/ttn_particle_emit_comp.glsl", GL_COMPUTE_SHADER);
+			s_particleEmitProgram->Link();
+			s_emitUniforms = TTN_UniformSet::Create(s_particleEmitProgram, {
+				TTN_UniformId("u_emitCount"), TTN_UniformId("u_seed"), TTN_UniformId("u_emitterShape"), TTN_UniformId("u_emitterAngle"),
+				TTN_UniformId("u_emitterScale"), TTN_UniformId("u_emitterRotation"), TTN_UniformId("u_startColor"), TTN_UniformId("u_startColor2"),
+				TTN_UniformId("u_endColor"), TTN_UniformId("u_endColor2"), TTN_UniformId("u_startSize"), TTN_UniformId("u_endSize"),
+				TTN_UniformId("u_startSpeed"), TTN_UniformId("u_endSpeed"), TTN_UniformId("u_lifeTime") });
+
+			s_particleUpdateProgram = TTN_Shader::Create();
+			s_particleUpdateProgram->LoadShaderStageFromFile("shaders/ttn_particle_update_comp.glsl", GL_COMPUTE_SHADER);
+			s_particleUpdateProgram->Link();
+
+			s_particleGPUShaderProgram = TTN_Shader::Create();
+			s_particleGPUShaderProgram->LoadShaderStageFromFile("shaders/ttn_particle_gpu_vert.glsl", GL_VERTEX_SHADER);
+			s_particleGPUShaderProgram->LoadShaderStageFromFile("shaders/ttn_particle_frag.glsl", GL_FRAGMENT_SHADER);
+			s_particleGPUShaderProgram->Link();
+		}
+	}
+
+	//gets if the gpu backend can be used
+	bool TTN_ParticleSystem::GetGPUBackendSupported()
+	{
+		return GLAD_GL_VERSION_4_3 && s_particleEmitProgram != nullptr && s_particleUpdateProgram != nullptr;
 	}
 
 	//sets up the particle system as a cone
@@ -189,9 +208,13 @@ namespace Titan {
 	{
 		m_particle = particleTemplate;
 
-		VertexPosVBO->LoadData(m_particle._mesh->GetVertexPositions().data(), m_particle._mesh->GetVertexPositions().size());
-		VertexNormVBO->LoadData(m_particle._mesh->GetVertexNormals().data(), m_particle._mesh->GetVertexNormals().size());
-		VertexUVVBO->LoadData(m_particle._mesh->GetVertexUvs().data(), m_particle._mesh->GetVertexUvs().size());
+		LoadParticleMesh();
+
+		//the gpu backend's draw command needs to know the new number of vertices
+		if (m_gpuCounters != nullptr) {
+			GLuint vertexCount = (GLuint)m_meshVertexCount;
+			m_gpuCounters->UpdateData(&vertexCount, offsetof(GPUCounters, vertexCount), sizeof(GLuint));
+		}
 	}
 
 	//set the rate at which particles are emitted (particles/second)
@@ -212,16 +235,55 @@ namespace Titan {
 		m_paused = paused;
 	}
 
+	//sets where the particles are simulated
+	void TTN_ParticleSystem::SetBackend(TTN_ParticleBackend backend)
+	{
+		//if the gpu backend isn't available, stay on the cpu
+		if (backend == TTN_ParticleBackend::GPU && !GetGPUBackendSupported()) {
+			LOG_WARN("GPU particle backend requires OpenGL 4.3 compute shaders, using the CPU backend instead");
+			backend = TTN_ParticleBackend::CPU;
+		}
+
+		if (backend == m_backend)
+			return;
+
+		m_backend = backend;
+
+		//the particles don't carry over between backends, so start both off empty
+		m_aliveCount = 0;
+		InstanceBuffer->EndWrite(0);
+		if (m_backend == TTN_ParticleBackend::GPU) {
+			if (m_gpuParticles == nullptr)
+				SetUpGPUBackend();
+			ResetGPUParticles();
+		}
+	}
+
+	//gets the number of living particles
+	size_t TTN_ParticleSystem::GetActiveParticleCount()
+	{
+		if (m_backend == TTN_ParticleBackend::GPU) {
+			ReadBackGPUCount();
+			return m_gpuActiveCount;
+		}
+
+		return m_aliveCount;
+	}
+
 	//sets the function pointer for the readgraph used in lerping velocity
 	void TTN_ParticleSystem::VelocityReadGraphCallback(float(*function)(float))
 	{
 		readGraphVelo = function;
+		BakeReadGraph(m_veloGraph, readGraphVelo);
+		m_gpuReadGraphsDirty = true;
 	}
 
 	//sets the function pointer for the readgraph used in lerping color
 	void TTN_ParticleSystem::ColorReadGraphCallback(float(*function)(float))
 	{
 		readGraphColor = function;
+		BakeReadGraph(m_colorGraph, readGraphColor);
+		m_gpuReadGraphsDirty = true;
 	}
 
 	//sets the function pointer for the readgraph used in lerping color
@@ -230,9 +292,12 @@ namespace Titan {
 		readGraphRotation = function;
 	}
 
+	//sets the function pointer for the readgraph used in lerping scale
 	void TTN_ParticleSystem::ScaleReadGraphCallback(float(*function)(float))
 	{
 		readGraphScale = function;
+		BakeReadGraph(m_scaleGraph, readGraphScale);
+		m_gpuReadGraphsDirty = true;
 	}
 
 	//updates the particle system
@@ -263,39 +328,46 @@ namespace Titan {
 				m_durationRemaining = m_duration;
 			}
 
-			//iterate over all the particles
-			for (size_t i = 0; i < m_maxParticlesCount; i++) {
-				//if it's not alive just skip it
-				if (!Active[i])
-					continue;
-				//if it's gone through it's lifetime, deactive it and skip to the next one
-				if (timeAlive[i] >= lifeTimes[i]) {
-					Active[i] = false;
-					continue;
-				}
-
-				//update how long the particle has been alive
-				timeAlive[i] += deltaTime;
+			//if it's simulated on the gpu, hand everything over to the compute shaders
+			if (m_backend == TTN_ParticleBackend::GPU) {
+				UpdateGPU(deltaTime);
+				return;
+			}
 
-				//get a t value for interpolation 
-				float t = std::clamp(timeAlive[i] / lifeTimes[i], 0.0f, 1.0f);
-				//update the position of the particlce based on the interpolation of the velocities
-				Positions[i] += glm::mix(StartVelocities[i], EndVelocities[i], readGraphVelo(t)) * deltaTime;
+			//age the living particles, split into chunks across the worker threads
+			TTN_JobSystem::ParallelFor(m_aliveCount, s_updateChunkSize, [this, deltaTime](size_t begin, size_t end) {
+				AgeParticles(begin, end, deltaTime);
+			});
+
+			//remove any particles that died this frame, swapping the last living particle into their place to keep the arrays compacted
+			for (size_t i = 0; i < m_aliveCount;) {
+				if (Dead[i])
+					KillParticle(i);
+				else
+					i++;
 			}
+
+			//then move the particles that are left, writing their render data straight into the next region of the instance buffer
+			ParticleInstance* instances = InstanceBuffer->BeginWrite<ParticleInstance>();
+			TTN_JobSystem::ParallelFor(m_aliveCount, s_updateChunkSize, [this, deltaTime, instances](size_t begin, size_t end) {
+				UpdateParticles(begin, end, deltaTime, instances);
+			});
+			InstanceBuffer->EndWrite(m_aliveCount);
 		}
 	}
 
 	//renders all the active particles
 	void TTN_ParticleSystem::Render(glm::vec3 ParentGlobalPos, glm::mat4 view, glm::mat4 projection)
 	{
-		//bind the shader
-		s_particleShaderProgram->Bind();
+		//bind the shader, the gpu backend reads the instance data straight out of the particle buffer so it uses a different one
+		TTN_Shader::sshptr shader = (m_backend == TTN_ParticleBackend::GPU) ? s_particleGPUShaderProgram : s_particleShaderProgram;
+		shader->Bind();
 
 		//set uniforms
 		glm::mat4 temp_model = glm::translate(glm::mat4(1.0f), ParentGlobalPos);
-		s_particleShaderProgram->SetUniformMatrix("u_model", temp_model);
-		s_particleShaderProgram->SetUniformMatrix("u_mvp", projection * view * temp_model);
-		s_particleShaderProgram->SetUniformMatrix("u_normalMat", glm::mat3(glm::transpose(glm::inverse(temp_model))));
+		shader->SetUniformMatrix(s_uniformModel, temp_model);
+		shader->SetUniformMatrix(s_uniformMVP, projection * view * temp_model);
+		shader->SetUniformMatrix(s_uniformNormalMat, glm::mat3(glm::transpose(glm::inverse(temp_model))));
 
 		//bind the albedo texture from the mat
 		if (m_particle._mat->GetAlbedo() != nullptr) {
@@ -306,49 +378,38 @@ namespace Titan {
 			s_defaultWhiteTexture->Bind(0);
 		}
 
-		size_t numOfActiveParticles = 0;
-		//go through all the particles and set up their data for rendering
-		for (size_t i = 0; i < m_maxParticlesCount; i++) {
-			//if the particle isn't active, just skip to the next one
-			if (!Active[i])
-				continue;
-
-			//get a t value for interpolation 
-			float t = std::clamp(timeAlive[i] / lifeTimes[i], 0.0f, 1.0f);
-
-			//interpolate the color
-			glm::vec4 temp_col = glm::mix(StartColors[i], EndColors[i], readGraphColor(t));
-			//interpolate the scale
-			float temp_scale = glm::mix(StartScales[i], EndScales[i], readGraphScale(t));
-			//get the global position of the particle
-			glm::vec3 temp_pos = ParentGlobalPos + Positions[i];
-
-			
-			//save the color
-			particle_col[numOfActiveParticles] = temp_col;
-			particle_pos[numOfActiveParticles] = temp_pos;
-			particle_scale[numOfActiveParticles] = temp_scale;
-
-
-			numOfActiveParticles++;
+		//the gpu backend draws however many particles survived it's last update, without the cpu ever needing to know how many
+		if (m_backend == TTN_ParticleBackend::GPU) {
+			m_gpuParticles->BindBase(0);
+			m_gpuAliveLists[m_gpuAliveList]->BindBase(2);
+			m_gpuVao->RenderIndirect(*m_gpuCounters, offsetof(GPUCounters, vertexCount));
+			return;
 		}
-		//if there are particles to acutally be rendered, render them, if not just exit the function
-		if (numOfActiveParticles > 0) {
-			//manually set up the buffers and vao since titan doesn't currently have the infastructure to render instanced stuff automatically
-
-			ColorInstanceBuffer->LoadData(particle_col, numOfActiveParticles);
-
-			PositionInstanceBuffer->LoadData(particle_pos, numOfActiveParticles);
 
-			ScaleInstanceBuffer->LoadData(particle_scale, numOfActiveParticles);
-
-			m_vao->RenderInstanced(numOfActiveParticles, m_particle._mesh->GetVertexPositions().size());
+		//if there are particles to acutally be rendered, render them, if not just exit the function
+		//the render data was already written into the instance buffer by the update so it can just be drawn
+		size_t numOfParticles = InstanceBuffer->GetElementCount();
+		if (numOfParticles > 0) {
+			m_vao->RenderInstanced(numOfParticles, m_meshVertexCount);
 		}
 	}
 
 	//emits a single particle
 	void TTN_ParticleSystem::Emit()
 	{
+		//the gpu backend emits in batches during the update
+		if (m_backend == TTN_ParticleBackend::GPU) {
+			m_gpuPendingEmits = std::min(m_gpuPendingEmits + 1, m_maxParticlesCount);
+			return;
+		}
+
+		//if every particle is already alive there's no room for a new one
+		if (m_aliveCount >= m_maxParticlesCount)
+			return;
+
+		//new particles go on the end of the living particles
+		const size_t index = m_aliveCount;
+
 		//setup the new particle's data
 		//position
 		{
@@ -357,10 +418,10 @@ namespace Titan {
 				float y = TTN_Random::RandomFloat(-(m_EmitterScale.y / 2), m_EmitterScale.y / 2);
 				float z = TTN_Random::RandomFloat(-(m_EmitterScale.z / 2), m_EmitterScale.z / 2);
 
-				Positions[m_activeParticleIndex] = glm::vec3(x, y, z);
+				Positions[index] = glm::vec3(x, y, z);
 			}
 			else {
-				Positions[m_activeParticleIndex] = glm::vec3(0.0f);
+				Positions[index] = glm::vec3(0.0f);
 			}
 		}
 
@@ -382,8 +443,8 @@ namespace Titan {
 			a = TTN_Random::RandomFloat(m_particle._EndColor.a, m_particle._EndColor2.a);
 			EndColor = glm::vec4(r, g, b, a);
 
-			StartColors[m_activeParticleIndex] = Startcolor;
-			EndColors[m_activeParticleIndex] = EndColor;
+			StartColors[index] = Startcolor;
+			EndColors[index] = EndColor;
 		}
 
 		//velocities
@@ -444,25 +505,23 @@ namespace Titan {
 			}
 
 
-			StartVelocities[m_activeParticleIndex] = Dir * TTN_Random::RandomFloat(m_particle._startSpeed, m_particle._startSpeed2);
-			EndVelocities[m_activeParticleIndex] = Dir * TTN_Random::RandomFloat(m_particle._endSpeed, m_particle._endSpeed2);
+			StartVelocities[index] = Dir * TTN_Random::RandomFloat(m_particle._startSpeed, m_particle._startSpeed2);
+			EndVelocities[index] = Dir * TTN_Random::RandomFloat(m_particle._endSpeed, m_particle._endSpeed2);
 		}
 
 		//scales
 		{
-			StartScales[m_activeParticleIndex] = TTN_Random::RandomFloat(m_particle._StartSize, m_particle._StartSize2);
-			EndScales[m_activeParticleIndex] = TTN_Random::RandomFloat(m_particle._EndSize, m_particle._EndSize2);
+			StartScales[index] = TTN_Random::RandomFloat(m_particle._StartSize, m_particle._StartSize2);
+			EndScales[index] = TTN_Random::RandomFloat(m_particle._EndSize, m_particle._EndSize2);
 		}
 
 		//how long the particle has been alive and how long it should live (used to caculate t values)
-		timeAlive[m_activeParticleIndex] = 0.0f;
-		lifeTimes[m_activeParticleIndex] = TTN_Random::RandomFloat(m_particle._lifeTime, m_particle._lifeTime2);
+		timeAlive[index] = 0.0f;
+		lifeTimes[index] = TTN_Random::RandomFloat(m_particle._lifeTime, m_particle._lifeTime2);
 
 		//set the particle to be alive
-		Active[m_activeParticleIndex] = true;
-
-		//and move the index back so the next emit will use the next index
-		m_activeParticleIndex = (m_activeParticleIndex - 1) % m_maxParticlesCount;
+		Dead[index] = 0;
+		m_aliveCount++;
 	}
 
 	//emits a bunch of particles all at once
@@ -473,6 +532,35 @@ namespace Titan {
 		}
 	}
 
+	//loads the particle mesh into the vbos
+	void TTN_ParticleSystem::LoadParticleMesh()
+	{
+		std::vector<glm::vec3> positions = m_particle._mesh->GetVertexPositions();
+		std::vector<glm::vec3> normals = m_particle._mesh->GetVertexNormals();
+		std::vector<glm::vec2> uvs = m_particle._mesh->GetVertexUvs();
+
+		//indexed meshes get expanded back out into a triangle list, particle meshes are small so this is cheap
+		if (m_particle._mesh->GetIsIndexed()) {
+			const std::vector<uint32_t>& indices = m_particle._mesh->GetIndices();
+			std::vector<glm::vec3> expandedPositions(indices.size());
+			std::vector<glm::vec3> expandedNormals(indices.size());
+			std::vector<glm::vec2> expandedUvs(indices.size());
+			for (size_t i = 0; i < indices.size(); i++) {
+				expandedPositions[i] = positions[indices[i]];
+				if (indices[i] < normals.size()) expandedNormals[i] = normals[indices[i]];
+				if (indices[i] < uvs.size()) expandedUvs[i] = uvs[indices[i]];
+			}
+			positions.swap(expandedPositions);
+			normals.swap(expandedNormals);
+			uvs.swap(expandedUvs);
+		}
+
+		VertexPosVBO->LoadData(positions.data(), positions.size());
+		VertexNormVBO->LoadData(normals.data(), normals.size());
+		VertexUVVBO->LoadData(uvs.data(), uvs.size());
+		m_meshVertexCount = positions.size();
+	}
+
 	//sets up vao and vbos
 	void TTN_ParticleSystem::SetUpRenderingStuff()
 	{
@@ -480,9 +568,8 @@ namespace Titan {
 		VertexPosVBO = TTN_VertexBuffer::Create();
 		VertexNormVBO = TTN_VertexBuffer::Create();
 		VertexUVVBO = TTN_VertexBuffer::Create();
-		ColorInstanceBuffer = TTN_VertexBuffer::Create();
-		PositionInstanceBuffer = TTN_VertexBuffer::Create();
-		ScaleInstanceBuffer = TTN_VertexBuffer::Create();
+		//the instance data changes every frame so it goes into a streaming buffer the update can write straight into
+		InstanceBuffer = TTN_VertexBuffer::CreateStreaming(sizeof(ParticleInstance), m_maxParticlesCount);
 		//create the vao
 		m_vao = TTN_VertexArrayObject::Create();
 
@@ -492,8 +579,269 @@ namespace Titan {
 		m_vao->AddVertexBuffer(VertexUVVBO, { BufferAttribute(2, 2, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Texture) });
 
 		//load the instanced vertex buffers
-		m_vao->AddVertexBuffer(ColorInstanceBuffer, { BufferAttribute(3, 4, GL_FLOAT, false, sizeof(float) * 4, 0, AttribUsage::Color, 1) });
-		m_vao->AddVertexBuffer(PositionInstanceBuffer, { BufferAttribute(4, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::User0, 1) });
-		m_vao->AddVertexBuffer(ScaleInstanceBuffer, { BufferAttribute(5, 1, GL_FLOAT, false, sizeof(float), 0, AttribUsage::User1, 1) });
+		m_vao->AddVertexBuffer(InstanceBuffer, {
+			BufferAttribute(3, 4, GL_FLOAT, false, sizeof(ParticleInstance), offsetof(ParticleInstance, color), AttribUsage::Color, 1),
+			BufferAttribute(4, 3, GL_FLOAT, false, sizeof(ParticleInstance), offsetof(ParticleInstance, position), AttribUsage::User0, 1),
+			BufferAttribute(5, 1, GL_FLOAT, false, sizeof(ParticleInstance), offsetof(ParticleInstance, scale), AttribUsage::User1, 1)
+		});
+	}
+
+	//reserves the memory for all the particle data
+	void TTN_ParticleSystem::SetUpParticleData()
+	{
+		Positions.resize(m_maxParticlesCount);
+		StartColors.resize(m_maxParticlesCount);
+		EndColors.resize(m_maxParticlesCount);
+		StartVelocities.resize(m_maxParticlesCount);
+		EndVelocities.resize(m_maxParticlesCount);
+		StartScales.resize(m_maxParticlesCount);
+		EndScales.resize(m_maxParticlesCount);
+		timeAlive.resize(m_maxParticlesCount);
+		lifeTimes.resize(m_maxParticlesCount);
+		Dead.resize(m_maxParticlesCount);
+
+		m_aliveCount = 0;
+	}
+
+	//samples a readgraph function into a lookup table
+	void TTN_ParticleSystem::BakeReadGraph(std::vector<float>& graph, float(*function)(float))
+	{
+		graph.resize(s_readGraphSamples);
+		for (size_t i = 0; i < s_readGraphSamples; i++)
+			graph[i] = function((float)i / (float)(s_readGraphSamples - 1));
+	}
+
+	//reads a value from a baked readgraph, linearly interpolating between the two nearest samples
+	static inline float SampleReadGraph(const float* graph, size_t samples, float t)
+	{
+		float sample = t * (float)(samples - 1);
+		size_t index = std::min((size_t)sample, samples - 2);
+		return glm::mix(graph[index], graph[index + 1], sample - (float)index);
+	}
+
+	//ages the particles in the range [begin, end), run on the worker threads so it only touches the data for those particles
+	void TTN_ParticleSystem::AgeParticles(size_t begin, size_t end, float deltaTime)
+	{
+		for (size_t i = begin; i < end; i++) {
+			//update how long the particle has been alive, if it's gone through it's lifetime flag it to be removed
+			timeAlive[i] += deltaTime;
+			Dead[i] = (timeAlive[i] >= lifeTimes[i]);
+		}
+	}
+
+	//updates the particles in the range [begin, end), run on the worker threads so it only touches the data for those particles
+	void TTN_ParticleSystem::UpdateParticles(size_t begin, size_t end, float deltaTime, ParticleInstance* instances)
+	{
+		const float* veloGraph = m_veloGraph.data();
+		const float* colorGraph = m_colorGraph.data();
+		const float* scaleGraph = m_scaleGraph.data();
+
+		for (size_t i = begin; i < end; i++) {
+			//get a t value for interpolation 
+			float t = std::clamp(timeAlive[i] / lifeTimes[i], 0.0f, 1.0f);
+
+			//update the position of the particlce based on the interpolation of the velocities
+			Positions[i] += glm::mix(StartVelocities[i], EndVelocities[i], SampleReadGraph(veloGraph, s_readGraphSamples, t)) * deltaTime;
+
+			//interpolate the color and scale and write them out for rendering, the instance buffer is write only so the whole
+			//instance is built up and written in one go
+			ParticleInstance instance;
+			instance.color = glm::mix(StartColors[i], EndColors[i], SampleReadGraph(colorGraph, s_readGraphSamples, t));
+			instance.position = Positions[i];
+			instance.scale = glm::mix(StartScales[i], EndScales[i], SampleReadGraph(scaleGraph, s_readGraphSamples, t));
+			instances[i] = instance;
+		}
+	}
+
+	//removes a particle by moving the last living particle into it's slot
+	void TTN_ParticleSystem::KillParticle(size_t index)
+	{
+		m_aliveCount--;
+		const size_t last = m_aliveCount;
+		if (index == last)
+			return;
+
+		Positions[index] = Positions[last];
+		StartColors[index] = StartColors[last];
+		EndColors[index] = EndColors[last];
+		StartVelocities[index] = StartVelocities[last];
+		EndVelocities[index] = EndVelocities[last];
+		StartScales[index] = StartScales[last];
+		EndScales[index] = EndScales[last];
+		timeAlive[index] = timeAlive[last];
+		lifeTimes[index] = lifeTimes[last];
+		Dead[index] = Dead[last];
+	}
+
+	//creates the buffers for the gpu backend
+	void TTN_ParticleSystem::SetUpGPUBackend()
+	{
+		//particle data
+		m_gpuParticles = TTN_ShaderStorageBuffer::Create();
+		m_gpuParticles->LoadData(nullptr, s_gpuParticleSize, m_maxParticlesCount);
+
+		//index lists
+		m_gpuAliveLists[0] = TTN_ShaderStorageBuffer::Create();
+		m_gpuAliveLists[0]->LoadData(nullptr, sizeof(GLuint), m_maxParticlesCount);
+		m_gpuAliveLists[1] = TTN_ShaderStorageBuffer::Create();
+		m_gpuAliveLists[1]->LoadData(nullptr, sizeof(GLuint), m_maxParticlesCount);
+		m_gpuDeadList = TTN_ShaderStorageBuffer::Create();
+		m_gpuDeadList->LoadData(nullptr, sizeof(GLuint), m_maxParticlesCount);
+
+		//counters
+		m_gpuCounters = TTN_ShaderStorageBuffer::Create();
+		m_gpuCounters->LoadData(nullptr, sizeof(GPUCounters), 1);
+
+		//readgraphs
+		m_gpuReadGraphs = TTN_ShaderStorageBuffer::Create();
+		m_gpuReadGraphs->LoadData(nullptr, sizeof(float), s_readGraphSamples * 3);
+		m_gpuReadGraphsDirty = true;
+
+		//alive count readback, mapped for the whole lifetime of the system so reading it never has to wait on a map
+		const GLbitfield readbackFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_gpuCountReadback);
+		glNamedBufferStorage(m_gpuCountReadback, sizeof(GLuint) * s_gpuCountReadbacks, nullptr, readbackFlags);
+		m_gpuCountData = static_cast<GLuint*>(glMapNamedBufferRange(m_gpuCountReadback, 0, sizeof(GLuint) * s_gpuCountReadbacks, readbackFlags));
+		if (m_gpuCountData == nullptr)
+			LOG_ERROR("Failed to persistently map the gpu particle count readback buffer");
+
+		//vao with just the mesh
+		m_gpuVao = TTN_VertexArrayObject::Create();
+		m_gpuVao->AddVertexBuffer(VertexPosVBO, { BufferAttribute(0, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Position) });
+		m_gpuVao->AddVertexBuffer(VertexNormVBO, { BufferAttribute(1, 3, GL_FLOAT, false, sizeof(float) * 3, 0, AttribUsage::Normal) });
+		m_gpuVao->AddVertexBuffer(VertexUVVBO, { BufferAttribute(2, 2, GL_FLOAT, false, sizeof(float) * 2, 0, AttribUsage::Texture) });
+	}
+
+	//resets the gpu buffers so every particle is dead
+	void TTN_ParticleSystem::ResetGPUParticles()
+	{
+		//every particle starts on the dead list
+		std::vector<GLuint> deadIndices(m_maxParticlesCount);
+		for (size_t i = 0; i < m_maxParticlesCount; i++)
+			deadIndices[i] = (GLuint)i;
+		m_gpuDeadList->UpdateData(deadIndices.data(), 0, deadIndices.size() * sizeof(GLuint));
+
+		//and nothing is alive
+		GPUCounters counters;
+		counters.vertexCount = (GLuint)m_meshVertexCount;
+		counters.instanceCount = 0;
+		counters.firstVertex = 0;
+		counters.baseInstance = 0;
+		counters.aliveCount = 0;
+		counters.deadCount = (GLint)m_maxParticlesCount;
+		m_gpuCounters->UpdateData(&counters, 0, sizeof(GPUCounters));
+
+		m_gpuAliveList = 0;
+		m_gpuPendingEmits = 0;
+
+		//any counts still on their way back are from before the reset
+		ClearGPUCountReadbacks();
+		m_gpuActiveCount = 0;
+	}
+
+	//emits and updates the particles on the gpu
+	void TTN_ParticleSystem::UpdateGPU(float deltaTime)
+	{
+		//upload the readgraphs if they've changed
+		if (m_gpuReadGraphsDirty) {
+			m_gpuReadGraphs->UpdateData(m_veloGraph.data(), 0, s_readGraphSamples * sizeof(float));
+			m_gpuReadGraphs->UpdateData(m_colorGraph.data(), s_readGraphSamples * sizeof(float), s_readGraphSamples * sizeof(float));
+			m_gpuReadGraphs->UpdateData(m_scaleGraph.data(), s_readGraphSamples * sizeof(float) * 2, s_readGraphSamples * sizeof(float));
+			m_gpuReadGraphsDirty = false;
+		}
+
+		//the list that survived the last update is the one that gets updated now, and the other one gets refilled
+		const int inList = m_gpuAliveList;
+		m_gpuAliveList = 1 - m_gpuAliveList;
+
+		//move the number of survivors into the alive count and reset the survivor count, all on the gpu so nothing has to be read back
+		const GLuint zero = 0;
+		glCopyNamedBufferSubData(m_gpuCounters->GetHandle(), m_gpuCounters->GetHandle(),
+			offsetof(GPUCounters, instanceCount), offsetof(GPUCounters, aliveCount), sizeof(GLuint));
+		glClearNamedBufferSubData(m_gpuCounters->GetHandle(), GL_R32UI, offsetof(GPUCounters, instanceCount), sizeof(GLuint),
+			GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+		//bind the buffers
+		m_gpuParticles->BindBase(0);
+		m_gpuAliveLists[inList]->BindBase(1);
+		m_gpuAliveLists[m_gpuAliveList]->BindBase(2);
+		m_gpuDeadList->BindBase(3);
+		m_gpuCounters->BindBase(4);
+		m_gpuReadGraphs->BindBase(5);
+
+		//emit any new particles onto the list that's about to be updated
+		if (m_gpuPendingEmits > 0) {
+			s_emitUniforms->Set(EMIT_COUNT, (int)m_gpuPendingEmits);
+			s_emitUniforms->Set(EMIT_SEED, (int)(TTN_Random::RandomFloat(0.0f, 1.0f) * 16777215.0f));
+			s_emitUniforms->Set(EMIT_SHAPE, (int)m_emitterShape);
+			s_emitUniforms->Set(EMIT_ANGLE, m_EmitterAngle);
+			s_emitUniforms->Set(EMIT_SCALE, m_EmitterScale);
+			s_emitUniforms->Set(EMIT_ROTATION, glm::toMat3(glm::quat(m_rotation)));
+			s_emitUniforms->Set(EMIT_START_COLOR, m_particle._StartColor);
+			s_emitUniforms->Set(EMIT_START_COLOR2, m_particle._StartColor2);
+			s_emitUniforms->Set(EMIT_END_COLOR, m_particle._EndColor);
+			s_emitUniforms->Set(EMIT_END_COLOR2, m_particle._EndColor2);
+			s_emitUniforms->Set(EMIT_START_SIZE, glm::vec2(m_particle._StartSize, m_particle._StartSize2));
+			s_emitUniforms->Set(EMIT_END_SIZE, glm::vec2(m_particle._EndSize, m_particle._EndSize2));
+			s_emitUniforms->Set(EMIT_START_SPEED, glm::vec2(m_particle._startSpeed, m_particle._startSpeed2));
+			s_emitUniforms->Set(EMIT_END_SPEED, glm::vec2(m_particle._endSpeed, m_particle._endSpeed2));
+			s_emitUniforms->Set(EMIT_LIFETIME, glm::vec2(m_particle._lifeTime, m_particle._lifeTime2));
+			s_emitUniforms->Apply();
+
+			s_particleEmitProgram->Dispatch(((GLuint)m_gpuPendingEmits + s_gpuWorkGroupSize - 1) / s_gpuWorkGroupSize);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			m_gpuPendingEmits = 0;
+		}
+
+		//update the living particles, the cpu doesn't know how many there are so it dispatches enough for all of them and the
+		//extra threads exit straight away
+		s_particleUpdateProgram->SetUniform(s_uniformDeltaTime, deltaTime);
+		s_particleUpdateProgram->SetUniform(s_uniformReadGraphSamples, (int)s_readGraphSamples);
+		s_particleUpdateProgram->Dispatch(((GLuint)m_maxParticlesCount + s_gpuWorkGroupSize - 1) / s_gpuWorkGroupSize);
+
+		//make sure the results are visible to the draw, the indirect command, and next frame's counter copy
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		TTN_Shader::UnBind();
+
+		//copy the number of survivors into the readback buffer and fence it so it can be read once the gpu gets there, if the
+		//slot is still waiting the gpu is more than a few frames behind so just skip this frame's count rather than stall
+		ReadBackGPUCount();
+		if (m_gpuCountData != nullptr && m_gpuCountFences[m_gpuCountSlot] == nullptr) {
+			glCopyNamedBufferSubData(m_gpuCounters->GetHandle(), m_gpuCountReadback,
+				offsetof(GPUCounters, instanceCount), m_gpuCountSlot * sizeof(GLuint), sizeof(GLuint));
+			m_gpuCountFences[m_gpuCountSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			m_gpuCountSlot = (m_gpuCountSlot + 1) % s_gpuCountReadbacks;
+		}
+	}
+
+	//reads back any alive counts the gpu has finished copying
+	void TTN_ParticleSystem::ReadBackGPUCount()
+	{
+		//go from the oldest slot to the newest, stopping at the first one the gpu hasn't reached so the counts stay in order
+		for (size_t i = 0; i < s_gpuCountReadbacks; i++) {
+			const size_t slot = (m_gpuCountSlot + i) % s_gpuCountReadbacks;
+			GLsync& fence = m_gpuCountFences[slot];
+			if (fence == nullptr)
+				continue;
+
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				break;
+
+			m_gpuActiveCount = (size_t)m_gpuCountData[slot];
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	//deletes the fences on any alive counts still waiting to be read back
+	void TTN_ParticleSystem::ClearGPUCountReadbacks()
+	{
+		for (GLsync& fence : m_gpuCountFences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
 	}
 }
\ No newline at end of file
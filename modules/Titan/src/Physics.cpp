@@ -18,13 +18,14 @@ namespace Titan {
 		m_trans.SetScale(glm::vec3(1.0f));
 
 		//set up bullet collision shape
-		m_colShape = new btBoxShape(btVector3(m_trans.GetScale().x / 2.0f, m_trans.GetScale().y / 2.0f, m_trans.GetScale().z / 2.0f));
+		m_shape = TTN_ShapeCache::GetBox(m_trans.GetScale() / 2.0f);
+		m_colShape = m_shape.get();
 		//set up bullet transform
 		m_bulletTrans.setIdentity();
 		m_bulletTrans.setOrigin(btVector3(m_trans.GetPos().x, m_trans.GetPos().y, m_trans.GetPos().z));
 		m_bulletTrans.setRotation(btQuaternion(m_trans.GetRotQuat().x, m_trans.GetRotQuat().y, m_trans.GetRotQuat().z, m_trans.GetRotQuat().w));
 		//setup up bullet motion state
-		m_MotionState = new btDefaultMotionState(m_bulletTrans);
+		m_MotionState = new TTN_MotionState(m_bulletTrans);
 
 		//setup mass, static v dynmaic status, and local internia
 		btVector3 localIntertia(0, 0, 0);
@@ -36,21 +37,32 @@ namespace Titan {
 		btRigidBody::btRigidBodyConstructionInfo rbInfo(m_Mass, m_MotionState, m_colShape, localIntertia);
 		m_body = new btRigidBody(rbInfo);
 
-		m_body->setActivationState(DISABLE_DEACTIVATION);
-
 		m_hasGravity = true;
 
 		m_InWorld = false;
 
 		m_entity = static_cast<entt::entity>(-1);
+		m_MotionState->SetEntity(m_entity);
 
 		m_body->setUserPointer(reinterpret_cast<void*>(static_cast<uint32_t>(m_entity)));
 	
 	}
 
-	//constructor that makes a physics body out of a position, rotation, and scale
+	//constructor that makes a physics body out of a position, rotation, and scale, with a box collider the size of the scale
 	TTN_Physics::TTN_Physics(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, entt::entity entityNum, TTN_PhysicsBodyType bodyType, float mass)
+		: TTN_Physics(position, rotation, scale, entityNum, TTN_ShapeCache::GetBox(scale / 2.0f), bodyType, mass)
+	{}
+
+	//constructor that makes a physics body out of a position, rotation, scale, and a collider from the shape cache
+	TTN_Physics::TTN_Physics(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, entt::entity entityNum, TTN_ShapeCache::sshapeptr shape,
+		TTN_PhysicsBodyType bodyType, float mass)
 	{
+		//bullet can't simulate triangle meshes as dynamic bodies, only static or kinematic ones
+		if (shape->isConcave() && bodyType == TTN_PhysicsBodyType::DYNAMIC) {
+			LOG_ERROR("Triangle mesh colliders can only be used by static or kinematic physics bodies");
+			throw std::runtime_error("Triangle mesh colliders can only be used by static or kinematic physics bodies");
+		}
+
 		//set up titan transform
 		m_trans = TTN_Transform();
 		m_trans.SetPos(position);
@@ -58,13 +70,14 @@ namespace Titan {
 		m_trans.SetScale(scale);
 
 		//set up bullet collision shape
-		m_colShape = new btBoxShape(btVector3(m_trans.GetScale().x / 2.0f, m_trans.GetScale().y / 2.0f, m_trans.GetScale().z / 2.0f));
+		m_shape = shape;
+		m_colShape = m_shape.get();
 		m_bulletTrans.setIdentity();
 		//set up bullet transform
 		m_bulletTrans.setOrigin(btVector3(m_trans.GetPos().x, m_trans.GetPos().y, m_trans.GetPos().z));
 		m_bulletTrans.setRotation(btQuaternion(m_trans.GetRotQuat().x, m_trans.GetRotQuat().y, m_trans.GetRotQuat().z, m_trans.GetRotQuat().w));
 		//setup up bullet motion state
-		m_MotionState = new btDefaultMotionState(m_bulletTrans);
+		m_MotionState = new TTN_MotionState(m_bulletTrans);
 
 		//setup mass, static v dynmaic status, and local internia
 		btVector3 localIntertia(0, 0, 0);
@@ -89,13 +102,17 @@ namespace Titan {
 			m_body->setCollisionFlags(m_body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
 		}
 
-		m_body->setActivationState(DISABLE_DEACTIVATION);
+		//kinematic bodies are moved by the game rather than bullet, so bullet has to keep reading them instead of letting them sleep,
+		//dynamic bodies are left to go to sleep when they come to rest
+		if (m_bodyType == TTN_PhysicsBodyType::KINEMATIC)
+			m_body->setActivationState(DISABLE_DEACTIVATION);
 
 		m_hasGravity = true;
 
 		m_InWorld = false;
 
 		m_entity = entityNum;
+		m_MotionState->SetEntity(m_entity);
 
 		m_body->setUserPointer(reinterpret_cast<void*>(static_cast<uint32_t>(m_entity)));
 	}
@@ -116,12 +133,10 @@ namespace Titan {
 			m_bulletTrans = m_body->getWorldTransform();
 		}
 
-		//copy the position of the bullet transfrom into the titan transform
-		m_trans.SetPos(glm::vec3((float)m_bulletTrans.getOrigin().getX(), (float)m_bulletTrans.getOrigin().getY(), (float)m_bulletTrans.getOrigin().getZ()));
-
-		//copy the rotation
+		//copy the position and rotation of the bullet transfrom into the titan transform
 		btQuaternion rot = m_bulletTrans.getRotation();
-		m_trans.SetRotationQuat(glm::quat(rot.getW(), rot.getX(), rot.getY(), rot.getZ()));
+		m_trans.SetPosAndRotation(glm::vec3((float)m_bulletTrans.getOrigin().getX(), (float)m_bulletTrans.getOrigin().getY(), (float)m_bulletTrans.getOrigin().getZ()),
+			glm::quat((float)rot.getW(), (float)rot.getX(), (float)rot.getY(), (float)rot.getZ()));
 	}
 
 	
@@ -177,11 +192,14 @@ namespace Titan {
 
 	void TTN_Physics::SetLinearVelocity(glm::vec3 velocity)
 	{
+		//wake the body up in case it's sleeping, otherwise bullet would ignore the change
+		m_body->activate();
 		m_body->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 	}
 
 	void TTN_Physics::SetAngularVelocity(glm::vec3 velocity)
 	{
+		m_body->activate();
 		m_body->setAngularVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 	}
 
@@ -191,6 +209,12 @@ namespace Titan {
 		btTransform Trans;
 		m_body->getMotionState()->getWorldTransform(Trans);
 		Trans.setOrigin(newPos);
+		//bullet only reads the motion state of kinematic bodies, so the body itself needs to be moved too
+		if (m_bodyType != TTN_PhysicsBodyType::KINEMATIC) {
+			m_body->setWorldTransform(Trans);
+			m_body->setInterpolationWorldTransform(Trans);
+		}
+		m_body->activate();
 		m_body->getMotionState()->setWorldTransform(Trans);
 		m_trans.SetPos(position);
 	}
@@ -202,11 +226,13 @@ namespace Titan {
 
 	void TTN_Physics::AddForce(glm::vec3 force)
 	{
+		m_body->activate();
 		m_body->applyCentralForce(btVector3(force.x, force.y, force.z));
 	}
 
 	void TTN_Physics::AddImpulse(glm::vec3 impulseForce)
 	{
+		m_body->activate();
 		m_body->applyCentralImpulse(btVector3(impulseForce.x, impulseForce.y, impulseForce.z));
 	}
 
@@ -220,21 +246,7 @@ namespace Titan {
 		m_entity = entity;
 		//save the entity in bullet
 		m_body->setUserPointer(reinterpret_cast<void*>(static_cast<uint32_t>(m_entity)));
-	}
-
-	TTN_Collision::TTN_Collision()
-	{
-		b1 = entt::null;
-		b2 = entt::null;
-	}
-
-	void TTN_Collision::SetBody1(const entt::entity body)
-	{
-		b1 = body;
-	}
-
-	void TTN_Collision::SetBody2(const entt::entity body)
-	{
-		b2 = body;
+		//and in the motion state
+		m_MotionState->SetEntity(m_entity);
 	}
 }
\ No newline at end of file
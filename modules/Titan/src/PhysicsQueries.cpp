@@ -0,0 +1,320 @@
+//Titan Engine, by Atlas X Games
+// PhysicsQueries.cpp - source file for the class that runs batches of raycasts, sweeps, and overlap tests against a physics world
+
+//precompile header, this file uses vector and Logging.h
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/PhysicsQueries.h"
+//include the job system to split the queries across threads
+#include "Titan/JobSystem.h"
+//bullet's narrowphase, used directly for the overlap tests
+#include <BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h>
+#include <BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h>
+#include <BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h>
+#include <BulletCollision/NarrowPhaseCollision/btPointCollector.h>
+#include <BulletCollision/CollisionShapes/btTriangleShape.h>
+
+namespace Titan {
+	//gets the entity stored in a bullet object's user pointer
+	static inline entt::entity EntityFromObject(const btCollisionObject* object)
+	{
+		return static_cast<entt::entity>(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(object->getUserPointer())));
+	}
+
+	//gets the broadphase proxy a broadphase tree leaf is for
+	static inline btBroadphaseProxy* ProxyFromLeaf(const btDbvtNode* leaf)
+	{
+		return static_cast<btBroadphaseProxy*>(leaf->data);
+	}
+
+	//gets the bullet object a broadphase tree leaf is for
+	static inline btCollisionObject* ObjectFromLeaf(const btDbvtNode* leaf)
+	{
+		return static_cast<btCollisionObject*>(ProxyFromLeaf(leaf)->m_clientObject);
+	}
+
+	//conversions between bullet and glm
+	static inline btVector3 ToBullet(const glm::vec3& vector) { return btVector3(vector.x, vector.y, vector.z); }
+	static inline btQuaternion ToBullet(const glm::quat& quat) { return btQuaternion(quat.x, quat.y, quat.z, quat.w); }
+	static inline glm::vec3 ToGlm(const btVector3& vector) { return glm::vec3((float)vector.getX(), (float)vector.getY(), (float)vector.getZ()); }
+
+	//checks a shape can be used in a sweep or overlap query
+	static const btConvexShape* GetQueryShape(const TTN_ShapeCache::sshapeptr& shape)
+	{
+		if (shape == nullptr || !shape->isConvex()) {
+			LOG_ERROR("Physics sweeps and overlap queries need a convex shape");
+			throw std::runtime_error("Physics sweeps and overlap queries need a convex shape");
+		}
+
+		return static_cast<const btConvexShape*>(shape.get());
+	}
+
+	//checks an output array is big enough for a batch
+	static void CheckResultSize(size_t resultSize, size_t requiredSize)
+	{
+		if (resultSize < requiredSize) {
+			LOG_ERROR("Physics query result array is too small, it has {} elements but needs {}", resultSize, requiredSize);
+			throw std::runtime_error("Physics query result array is too small");
+		}
+	}
+
+	//copies a bullet hit into a titan one
+	static inline void WriteHit(TTN_QueryHit& hit, const btCollisionObject* object, const btVector3& point, const btVector3& normal, btScalar fraction)
+	{
+		hit.hit = (object != nullptr);
+		if (!hit.hit)
+			return;
+
+		hit.entity = EntityFromObject(object);
+		hit.point = ToGlm(point);
+		hit.normal = ToGlm(normal.normalized());
+		hit.fraction = (float)fraction;
+	}
+
+#pragma region Overlap Tests
+
+	//checks if two convex shapes are overlapping using gjk (falling back to epa if they're penetrating)
+	static bool ConvexShapesOverlap(const btConvexShape* a, const btTransform& transformA, const btConvexShape* b, const btTransform& transformB)
+	{
+		btVoronoiSimplexSolver simplexSolver;
+		btGjkEpaPenetrationDepthSolver penetrationSolver;
+		btGjkPairDetector detector(a, b, &simplexSolver, &penetrationSolver);
+
+		btGjkPairDetector::ClosestPointInput input;
+		input.m_transformA = transformA;
+		input.m_transformB = transformB;
+		btPointCollector output;
+		detector.getClosestPoints(input, output, nullptr);
+
+		return output.m_hasResult && output.m_distance <= btScalar(0.0);
+	}
+
+	//triangle callback that checks a convex shape against every triangle of a mesh it's given until one overlaps
+	struct TTN_TriangleOverlapCallback : public btTriangleCallback {
+		const btConvexShape* shape;
+		btTransform shapeTransform;
+		btTransform meshTransform;
+		bool overlapping = false;
+
+		void processTriangle(btVector3* triangle, int /*partId*/, int /*triangleIndex*/) override {
+			if (overlapping)
+				return;
+
+			btTriangleShape triangleShape(triangle[0], triangle[1], triangle[2]);
+			overlapping = ConvexShapesOverlap(shape, shapeTransform, &triangleShape, meshTransform);
+		}
+	};
+
+	//checks if a convex shape overlaps any kind of shape
+	static bool ShapesOverlap(const btConvexShape* shape, const btTransform& shapeTransform, const btCollisionShape* other, const btTransform& otherTransform)
+	{
+		//convex shapes can be tested directly
+		if (other->isConvex())
+			return ConvexShapesOverlap(shape, shapeTransform, static_cast<const btConvexShape*>(other), otherTransform);
+
+		//compounds are tested child by child
+		if (other->isCompound()) {
+			const btCompoundShape* compound = static_cast<const btCompoundShape*>(other);
+			for (int i = 0; i < compound->getNumChildShapes(); i++) {
+				if (ShapesOverlap(shape, shapeTransform, compound->getChildShape(i), otherTransform * compound->getChildTransform(i)))
+					return true;
+			}
+			return false;
+		}
+
+		//triangle meshes are tested against the triangles around the shape
+		if (other->isConcave()) {
+			TTN_TriangleOverlapCallback callback;
+			callback.shape = shape;
+			callback.shapeTransform = shapeTransform;
+			callback.meshTransform = otherTransform;
+
+			btVector3 aabbMin, aabbMax;
+			shape->getAabb(otherTransform.inverse() * shapeTransform, aabbMin, aabbMax);
+			static_cast<const btConcaveShape*>(other)->processAllTriangles(&callback, aabbMin, aabbMax);
+			return callback.overlapping;
+		}
+
+		return false;
+	}
+
+#pragma endregion
+
+#pragma region Broadphase Collectors
+
+	//passes every body whose bounds the ray crosses to bullet's single object ray test, filtered the same way btCollisionWorld::rayTest
+	//filters them, so bodies outside the callback's group and mask are skipped and triggers (bodies without contact response) are hit
+	struct TTN_RayCollector : public btDbvt::ICollide {
+		using btDbvt::ICollide::Process;
+
+		btTransform from;
+		btTransform to;
+		entt::entity ignore;
+		btCollisionWorld::ClosestRayResultCallback* callback;
+
+		void Process(const btDbvtNode* leaf) override {
+			if (!callback->needsCollision(ProxyFromLeaf(leaf)))
+				return;
+
+			btCollisionObject* object = ObjectFromLeaf(leaf);
+			if (EntityFromObject(object) == ignore)
+				return;
+
+			btCollisionWorld::rayTestSingle(from, to, object, object->getCollisionShape(), object->getWorldTransform(), *callback);
+		}
+	};
+
+	//passes every body whose bounds the sweep crosses to bullet's single object sweep test, filtered the same way as the rays
+	struct TTN_SweepCollector : public btDbvt::ICollide {
+		using btDbvt::ICollide::Process;
+
+		const btConvexShape* shape;
+		btTransform from;
+		btTransform to;
+		entt::entity ignore;
+		btCollisionWorld::ClosestConvexResultCallback* callback;
+
+		void Process(const btDbvtNode* leaf) override {
+			if (!callback->needsCollision(ProxyFromLeaf(leaf)))
+				return;
+
+			btCollisionObject* object = ObjectFromLeaf(leaf);
+			if (EntityFromObject(object) == ignore)
+				return;
+
+			btCollisionWorld::objectQuerySingle(shape, from, to, object, object->getCollisionShape(), object->getWorldTransform(), *callback, 0.0f);
+		}
+	};
+
+	//tests every body whose bounds the shape overlaps against the shape itself, recording the ones it actually overlaps
+	struct TTN_OverlapCollector : public btDbvt::ICollide {
+		using btDbvt::ICollide::Process;
+
+		const btConvexShape* shape;
+		btTransform transform;
+		entt::entity ignore;
+		entt::entity* results;
+		uint32_t maxResults;
+		uint32_t numOfResults = 0;
+
+		void Process(const btDbvtNode* leaf) override {
+			if (numOfResults >= maxResults)
+				return;
+
+			btCollisionObject* object = ObjectFromLeaf(leaf);
+			entt::entity entity = EntityFromObject(object);
+			if (entity == ignore)
+				return;
+
+			if (ShapesOverlap(shape, transform, object->getCollisionShape(), object->getWorldTransform()))
+				results[numOfResults++] = entity;
+		}
+	};
+
+#pragma endregion
+
+	//casts every ray
+	void TTN_PhysicsQueries::Raycast(btDbvtBroadphase* broadphase, TTN_Span<const TTN_RaycastQuery> queries, TTN_Span<TTN_QueryHit> hits)
+	{
+		CheckResultSize(hits.size(), queries.size());
+
+		TTN_JobSystem::ParallelFor(queries.size(), s_minQueriesPerJob, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const TTN_RaycastQuery& query = queries[i];
+				btVector3 from = ToBullet(query.from);
+				btVector3 to = ToBullet(query.to);
+				btCollisionWorld::ClosestRayResultCallback callback(from, to);
+				callback.m_collisionFilterGroup = query.group;
+				callback.m_collisionFilterMask = query.mask;
+
+				TTN_RayCollector collector;
+				collector.from.setIdentity();
+				collector.from.setOrigin(from);
+				collector.to.setIdentity();
+				collector.to.setOrigin(to);
+				collector.ignore = query.ignore;
+				collector.callback = &callback;
+
+				//walk both the dynamic and static trees
+				for (int set = 0; set < 2; set++)
+					btDbvt::rayTest(broadphase->m_sets[set].m_root, from, to, collector);
+
+				hits[i] = TTN_QueryHit();
+				WriteHit(hits[i], callback.m_collisionObject, callback.m_hitPointWorld, callback.m_hitNormalWorld, callback.m_closestHitFraction);
+			}
+		});
+	}
+
+	//sweeps every shape
+	void TTN_PhysicsQueries::Sweep(btDbvtBroadphase* broadphase, TTN_Span<const TTN_SweepQuery> queries, TTN_Span<TTN_QueryHit> hits)
+	{
+		CheckResultSize(hits.size(), queries.size());
+		//check the shapes up front so the error isn't thrown on a worker
+		for (const TTN_SweepQuery& query : queries)
+			GetQueryShape(query.shape);
+
+		TTN_JobSystem::ParallelFor(queries.size(), s_minQueriesPerJob, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const TTN_SweepQuery& query = queries[i];
+				btVector3 from = ToBullet(query.from);
+				btVector3 to = ToBullet(query.to);
+				btCollisionWorld::ClosestConvexResultCallback callback(from, to);
+				callback.m_collisionFilterGroup = query.group;
+				callback.m_collisionFilterMask = query.mask;
+
+				TTN_SweepCollector collector;
+				collector.shape = static_cast<const btConvexShape*>(query.shape.get());
+				collector.from = btTransform(ToBullet(query.rotation), from);
+				collector.to = btTransform(ToBullet(query.rotation), to);
+				collector.ignore = query.ignore;
+				collector.callback = &callback;
+
+				//the bodies the shape could hit are the ones inside the bounds of the whole sweep
+				btVector3 fromMin, fromMax, toMin, toMax;
+				collector.shape->getAabb(collector.from, fromMin, fromMax);
+				collector.shape->getAabb(collector.to, toMin, toMax);
+				fromMin.setMin(toMin);
+				fromMax.setMax(toMax);
+				btDbvtVolume bounds = btDbvtVolume::FromMM(fromMin, fromMax);
+
+				for (int set = 0; set < 2; set++)
+					broadphase->m_sets[set].collideTV(broadphase->m_sets[set].m_root, bounds, collector);
+
+				hits[i] = TTN_QueryHit();
+				WriteHit(hits[i], callback.m_hitCollisionObject, callback.m_hitPointWorld, callback.m_hitNormalWorld, callback.m_closestHitFraction);
+			}
+		});
+	}
+
+	//finds the entities each shape overlaps
+	void TTN_PhysicsQueries::Overlap(btDbvtBroadphase* broadphase, TTN_Span<const TTN_OverlapQuery> queries, TTN_Span<entt::entity> results,
+		size_t maxResultsPerQuery, TTN_Span<uint32_t> resultCounts)
+	{
+		CheckResultSize(resultCounts.size(), queries.size());
+		CheckResultSize(results.size(), queries.size() * maxResultsPerQuery);
+		for (const TTN_OverlapQuery& query : queries)
+			GetQueryShape(query.shape);
+
+		TTN_JobSystem::ParallelFor(queries.size(), s_minQueriesPerJob, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				const TTN_OverlapQuery& query = queries[i];
+
+				TTN_OverlapCollector collector;
+				collector.shape = static_cast<const btConvexShape*>(query.shape.get());
+				collector.transform = btTransform(ToBullet(query.rotation), ToBullet(query.position));
+				collector.ignore = query.ignore;
+				collector.results = results.data() + i * maxResultsPerQuery;
+				collector.maxResults = (uint32_t)maxResultsPerQuery;
+
+				btVector3 aabbMin, aabbMax;
+				collector.shape->getAabb(collector.transform, aabbMin, aabbMax);
+				btDbvtVolume bounds = btDbvtVolume::FromMM(aabbMin, aabbMax);
+
+				for (int set = 0; set < 2; set++)
+					broadphase->m_sets[set].collideTV(broadphase->m_sets[set].m_root, bounds, collector);
+
+				resultCounts[i] = collector.numOfResults;
+			}
+		});
+	}
+}
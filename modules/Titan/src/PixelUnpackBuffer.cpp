@@ -0,0 +1,85 @@
+//Titan Engine, by Atlas X Games
+// PixelUnpackBuffer.cpp - source file for the class that stages texture data in a buffer so it can be uploaded to textures asynchronously
+
+//precompile header, this file uses cstring, algorithm, and Logging.h
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/PixelUnpackBuffer.h"
+
+namespace Titan {
+	//constructor, creates the staging ring
+	TTN_PixelUnpackBuffer::TTN_PixelUnpackBuffer(size_t regionSize, size_t numOfRegions)
+		: TTN_IBuffer(GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW), m_mappedData(nullptr), m_regionSize(regionSize),
+		m_numOfRegions(std::max(numOfRegions, (size_t)1)), m_currentRegion(0)
+	{
+		_elementSize = 1;
+		_elementCount = m_regionSize * m_numOfRegions;
+		m_fences.resize(m_numOfRegions, nullptr);
+
+		//allocate immutable storage for every region and map it for the whole lifetime of the buffer
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr totalSize = std::max((GLsizeiptr)_elementCount, (GLsizeiptr)1);
+		glNamedBufferStorage(_handle, totalSize, nullptr, flags);
+		m_mappedData = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, totalSize, flags));
+
+		//if it couldn't be mapped, throw an error
+		if (m_mappedData == nullptr) {
+			LOG_ERROR("Failed to persistently map pixel unpack buffer");
+			throw std::runtime_error("Failed to persistently map pixel unpack buffer");
+		}
+	}
+
+	//destructor, unmaps the buffer and deletes the fences (the base class deletes the buffer itself)
+	TTN_PixelUnpackBuffer::~TTN_PixelUnpackBuffer()
+	{
+		for (GLsync& fence : m_fences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		if (m_mappedData != nullptr && _handle != 0) {
+			glUnmapNamedBuffer(_handle);
+			m_mappedData = nullptr;
+		}
+	}
+
+	//copies data into the next region
+	bool TTN_PixelUnpackBuffer::Stage(const void* data, size_t size, size_t& offset)
+	{
+		if (size > m_regionSize)
+			return false;
+
+		//check the gpu is done with the next region, without waiting on it if it isn't
+		size_t nextRegion = (m_currentRegion + 1) % m_numOfRegions;
+		GLsync& fence = m_fences[nextRegion];
+		if (fence != nullptr) {
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				return false;
+
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		//copy the data in and bind the buffer so the upload reads from it
+		m_currentRegion = nextRegion;
+		offset = m_currentRegion * m_regionSize;
+		memcpy(m_mappedData + offset, data, size);
+		Bind();
+
+		return true;
+	}
+
+	//fences the last staged region and unbinds the buffer
+	void TTN_PixelUnpackBuffer::FinishUpload()
+	{
+		GLsync& fence = m_fences[m_currentRegion];
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		UnBind();
+	}
+}
@@ -0,0 +1,491 @@
+//Titan Engine, by Atlas X Games
+// Profiler.cpp - source file for the frame profiler, which times scopes on the cpu (on any thread) and passes on the gpu
+
+//precompile header, this file uses vector, string, fstream, and algorithm
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/Profiler.h"
+//include imgui for the profiler window
+#include "imgui.h"
+//include json for the chrome trace export
+#include <json.hpp>
+#include <chrono>
+#include <string_view>
+
+namespace Titan {
+	//every profiler time is measured from when the program started
+	static const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+	//set the base values for the member variables that can't be set up in the header
+	std::vector<std::unique_ptr<TTN_Profiler::ThreadBuffer>> TTN_Profiler::s_threads;
+	TTN_Profiler::GPUFrame TTN_Profiler::s_gpuFrames[TTN_Profiler::GPUFramesInFlight];
+
+	//sets up the profiler
+	void TTN_Profiler::Init()
+	{
+		if (s_initialized)
+			return;
+
+		//name the main thread so it shows up first in the timeline
+		SetThreadName("Main");
+
+		//make an initial set of queries for each frame in flight, more are made if a frame needs them
+		for (auto& gpuFrame : s_gpuFrames) {
+			gpuFrame.queries.resize(64);
+			glGenQueries((GLsizei)gpuFrame.queries.size(), gpuFrame.queries.data());
+		}
+
+		s_initialized = true;
+	}
+
+	//cleans up the profiler
+	void TTN_Profiler::Shutdown()
+	{
+		if (!s_initialized)
+			return;
+
+		SetEnabled(false);
+		s_inFrame = false;
+
+		for (auto& gpuFrame : s_gpuFrames) {
+			glDeleteQueries((GLsizei)gpuFrame.queries.size(), gpuFrame.queries.data());
+			gpuFrame = GPUFrame();
+		}
+
+		//the thread buffers are left alone, threads that are still running might write to them
+		s_history.clear();
+		s_initialized = false;
+	}
+
+	//gets the current time
+	int64_t TTN_Profiler::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+	}
+
+	//starts recording a new frame
+	void TTN_Profiler::BeginFrame()
+	{
+		if (!s_initialized || !GetEnabled())
+			return;
+
+		s_frameIndex++;
+		s_frameStart = Now();
+		s_inFrame = true;
+
+		//reuse the queries from a few frames ago, reading their results first if we haven't yet
+		GPUFrame& gpuFrame = s_gpuFrames[s_frameIndex % GPUFramesInFlight];
+		if (gpuFrame.pending)
+			ResolveGPUFrame(gpuFrame);
+
+		gpuFrame.frameIndex = s_frameIndex;
+		gpuFrame.usedQueries = 0;
+		gpuFrame.scopes.clear();
+		s_gpuDepth = 0;
+
+		//timer queries use the gpu's clock, so work out how far it is from ours
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuFrame.gpuToCpuOffset = Now() - gpuNow;
+	}
+
+	//finishes recording the current frame
+	void TTN_Profiler::EndFrame()
+	{
+		if (!s_inFrame)
+			return;
+		s_inFrame = false;
+
+		GPUFrame& gpuFrame = s_gpuFrames[s_frameIndex % GPUFramesInFlight];
+		gpuFrame.pending = !gpuFrame.scopes.empty();
+
+		//if we're paused we still empty the thread buffers so they don't fill up, we just throw the events away
+		if (s_paused) {
+			CollectCPUEvents(nullptr);
+			return;
+		}
+
+		TTN_ProfileFrame frame;
+		frame.index = s_frameIndex;
+		frame.start = s_frameStart;
+		frame.end = Now();
+		CollectCPUEvents(&frame);
+
+		s_history.push_back(std::move(frame));
+		while (s_history.size() > HistorySize)
+			s_history.pop_front();
+	}
+
+	//names the calling thread
+	void TTN_Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(s_threadMutex);
+		buffer.name = name;
+	}
+
+	//gets the calling thread's buffer
+	TTN_Profiler::ThreadBuffer& TTN_Profiler::GetThreadBuffer()
+	{
+		static thread_local ThreadBuffer* t_buffer = nullptr;
+
+		if (t_buffer == nullptr) {
+			std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+			buffer->events = std::make_unique<TTN_ProfileEvent[]>(ThreadBufferSize);
+
+			std::lock_guard<std::mutex> lock(s_threadMutex);
+			buffer->name = "Thread " + std::to_string(s_threads.size());
+			t_buffer = buffer.get();
+			s_threads.push_back(std::move(buffer));
+		}
+
+		return *t_buffer;
+	}
+
+	//opens a cpu scope on the calling thread
+	void TTN_Profiler::BeginScope()
+	{
+		GetThreadBuffer().depth++;
+	}
+
+	//closes a cpu scope on the calling thread and records it
+	void TTN_Profiler::EndScope(const char* name, int64_t start)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+		if (buffer.depth > 0)
+			buffer.depth--;
+
+		//write the event first, then publish it by moving the write index past it, so the main thread never reads a half written event
+		uint64_t index = buffer.write.load(std::memory_order_relaxed);
+		buffer.events[index % ThreadBufferSize] = { name, start, Now(), buffer.depth };
+		buffer.write.store(index + 1, std::memory_order_release);
+	}
+
+	//moves the events recorded since the last frame into a frame
+	void TTN_Profiler::CollectCPUEvents(TTN_ProfileFrame* frame)
+	{
+		std::lock_guard<std::mutex> lock(s_threadMutex);
+
+		if (frame != nullptr)
+			frame->cpuEvents.resize(s_threads.size());
+
+		for (size_t i = 0; i < s_threads.size(); i++) {
+			ThreadBuffer& buffer = *s_threads[i];
+
+			uint64_t write = buffer.write.load(std::memory_order_acquire);
+			uint64_t begin = buffer.read;
+
+			//if the thread recorded more than the buffer holds, the oldest events have already been written over
+			if (write - begin > ThreadBufferSize) {
+				s_droppedEvents += write - begin - ThreadBufferSize;
+				begin = write - ThreadBufferSize;
+			}
+
+			if (frame != nullptr) {
+				std::vector<TTN_ProfileEvent>& events = frame->cpuEvents[i];
+				for (uint64_t j = begin; j < write; j++)
+					events.push_back(buffer.events[j % ThreadBufferSize]);
+
+				//the thread kept going while we copied, so anything it could have written over in that time can't be trusted
+				uint64_t after = buffer.write.load(std::memory_order_acquire);
+				if (after >= ThreadBufferSize && begin + ThreadBufferSize <= after) {
+					size_t overwritten = (size_t)std::min<uint64_t>(after - ThreadBufferSize + 1 - begin, events.size());
+					events.erase(events.begin(), events.begin() + overwritten);
+					s_droppedEvents += overwritten;
+				}
+			}
+
+			buffer.read = write;
+		}
+	}
+
+	//opens a gpu scope
+	int TTN_Profiler::BeginGPUScope(const char* name)
+	{
+		if (!s_inFrame)
+			return -1;
+
+		GPUFrame& gpuFrame = s_gpuFrames[s_frameIndex % GPUFramesInFlight];
+
+		//grow the pool if this frame has used all of its queries
+		if (gpuFrame.usedQueries + 2 > gpuFrame.queries.size()) {
+			size_t oldSize = gpuFrame.queries.size();
+			gpuFrame.queries.resize(oldSize * 2);
+			glGenQueries((GLsizei)oldSize, gpuFrame.queries.data() + oldSize);
+		}
+
+		GPUScope scope;
+		scope.name = name;
+		scope.startQuery = gpuFrame.queries[gpuFrame.usedQueries++];
+		scope.endQuery = gpuFrame.queries[gpuFrame.usedQueries++];
+		scope.depth = s_gpuDepth++;
+
+		//timestamps rather than elapsed time queries, as only one elapsed time query can run at once and our passes nest
+		glQueryCounter(scope.startQuery, GL_TIMESTAMP);
+		gpuFrame.scopes.push_back(scope);
+
+		return (int)gpuFrame.scopes.size() - 1;
+	}
+
+	//closes a gpu scope
+	void TTN_Profiler::EndGPUScope(int query)
+	{
+		GPUFrame& gpuFrame = s_gpuFrames[s_frameIndex % GPUFramesInFlight];
+		if (!s_inFrame || query >= (int)gpuFrame.scopes.size())
+			return;
+
+		glQueryCounter(gpuFrame.scopes[query].endQuery, GL_TIMESTAMP);
+		if (s_gpuDepth > 0)
+			s_gpuDepth--;
+	}
+
+	//reads back a frame's gpu queries
+	void TTN_Profiler::ResolveGPUFrame(GPUFrame& gpuFrame)
+	{
+		gpuFrame.pending = false;
+
+		//if the gpu still hasn't gotten to them after a few frames we drop them rather than wait
+		for (const GPUScope& scope : gpuFrame.scopes) {
+			GLint available = 0;
+			glGetQueryObjectiv(scope.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return;
+		}
+
+		TTN_ProfileFrame* frame = FindFrame(gpuFrame.frameIndex);
+		if (frame == nullptr)
+			return;
+
+		frame->gpuEvents.reserve(gpuFrame.scopes.size());
+		for (const GPUScope& scope : gpuFrame.scopes) {
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(scope.startQuery, GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+			frame->gpuEvents.push_back({ scope.name, (int64_t)start + gpuFrame.gpuToCpuOffset, (int64_t)end + gpuFrame.gpuToCpuOffset, scope.depth });
+		}
+		frame->gpuResolved = true;
+	}
+
+	//finds a frame in the history
+	TTN_ProfileFrame* TTN_Profiler::FindFrame(uint64_t index)
+	{
+		//the history is in order with no gaps unless we were paused, so search back from the newest
+		for (auto it = s_history.rbegin(); it != s_history.rend(); it++) {
+			if (it->index == index)
+				return &(*it);
+			if (it->index < index)
+				break;
+		}
+		return nullptr;
+	}
+
+	//writes the history as a chrome trace
+	bool TTN_Profiler::SaveChromeTrace(const std::string& fileName)
+	{
+		std::vector<std::string> threadNames;
+		{
+			std::lock_guard<std::mutex> lock(s_threadMutex);
+			for (const auto& buffer : s_threads)
+				threadNames.push_back(buffer->name);
+		}
+
+		nlohmann::json trace;
+		nlohmann::json& events = trace["traceEvents"];
+		events = nlohmann::json::array();
+
+		//the cpu and gpu show up as two processes, with each cpu thread as a thread of the first
+		events.push_back({ {"name", "process_name"}, {"ph", "M"}, {"pid", 0}, {"args", {{"name", "CPU"}}} });
+		events.push_back({ {"name", "process_name"}, {"ph", "M"}, {"pid", 1}, {"args", {{"name", "GPU"}}} });
+		events.push_back({ {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", 0}, {"args", {{"name", "GPU"}}} });
+		for (size_t i = 0; i < threadNames.size(); i++)
+			events.push_back({ {"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", i}, {"args", {{"name", threadNames[i]}}} });
+
+		//chrome wants times in microseconds
+		auto addEvent = [&events](const char* name, const char* category, int64_t start, int64_t end, int pid, size_t tid) {
+			events.push_back({ {"name", name}, {"cat", category}, {"ph", "X"}, {"ts", start / 1000.0}, {"dur", (end - start) / 1000.0},
+				{"pid", pid}, {"tid", tid} });
+		};
+
+		for (const TTN_ProfileFrame& frame : s_history) {
+			//the frame itself goes on the main thread, so everything it did is nested under it
+			addEvent("Frame", "frame", frame.start, frame.end, 0, 0);
+
+			for (size_t i = 0; i < frame.cpuEvents.size(); i++) {
+				for (const TTN_ProfileEvent& e : frame.cpuEvents[i])
+					addEvent(e.name, "cpu", e.start, e.end, 0, i);
+			}
+			for (const TTN_ProfileEvent& e : frame.gpuEvents)
+				addEvent(e.name, "gpu", e.start, e.end, 1, 0);
+		}
+
+		std::ofstream file(fileName);
+		if (!file.is_open()) {
+			LOG_ERROR("Failed to open {} to save the profiler trace", fileName);
+			return false;
+		}
+		file << trace.dump();
+		return file.good();
+	}
+
+	//draws the profiler window
+	void TTN_Profiler::DrawImGui()
+	{
+		if (!s_windowOpen)
+			return;
+
+		if (!ImGui::Begin("Profiler", &s_windowOpen)) {
+			ImGui::End();
+			return;
+		}
+
+		bool enabled = GetEnabled();
+		if (ImGui::Checkbox("Enabled", &enabled))
+			SetEnabled(enabled);
+		ImGui::SameLine();
+		ImGui::Checkbox("Paused", &s_paused);
+		ImGui::SameLine();
+		static std::string saveResult;
+		if (ImGui::Button("Save Chrome Trace"))
+			saveResult = SaveChromeTrace("profile.json") ? "Saved to profile.json" : "Failed to save profile.json";
+		if (!saveResult.empty()) {
+			ImGui::SameLine();
+			ImGui::TextUnformatted(saveResult.c_str());
+		}
+		if (s_droppedEvents > 0)
+			ImGui::Text("Dropped events: %llu (a thread recorded more than %llu scopes in one frame)",
+				(unsigned long long)s_droppedEvents, (unsigned long long)ThreadBufferSize);
+
+		if (s_history.empty()) {
+			ImGui::TextUnformatted("No frames recorded yet, enable the profiler to start recording");
+			ImGui::End();
+			return;
+		}
+
+		//frame time graph, clicking on a frame selects it (and pauses so it stays put)
+		static std::vector<float> frameTimes;
+		frameTimes.clear();
+		float maxFrameTime = 0.0f;
+		for (const TTN_ProfileFrame& frame : s_history) {
+			frameTimes.push_back((frame.end - frame.start) / 1000000.0f);
+			maxFrameTime = std::max(maxFrameTime, frameTimes.back());
+		}
+		ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), (int)frameTimes.size(), 0, "Frame time (ms)", 0.0f, maxFrameTime,
+			ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+		if (ImGui::IsItemHovered() && ImGui::IsMouseClicked(0)) {
+			ImVec2 graphMin = ImGui::GetItemRectMin();
+			ImVec2 graphMax = ImGui::GetItemRectMax();
+			float t = (ImGui::GetIO().MousePos.x - graphMin.x) / std::max(graphMax.x - graphMin.x, 1.0f);
+			int clicked = std::clamp((int)(t * frameTimes.size()), 0, (int)frameTimes.size() - 1);
+			s_selectedFrame = (int)frameTimes.size() - 1 - clicked;
+			s_paused = true;
+		}
+		ImGui::SliderInt("Frames Ago", &s_selectedFrame, 0, (int)s_history.size() - 1);
+		s_selectedFrame = std::clamp(s_selectedFrame, 0, (int)s_history.size() - 1);
+
+		const TTN_ProfileFrame& frame = s_history[s_history.size() - 1 - s_selectedFrame];
+		ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)frame.index, (frame.end - frame.start) / 1000000.0f);
+
+		std::vector<std::string> threadNames;
+		{
+			std::lock_guard<std::mutex> lock(s_threadMutex);
+			for (const auto& buffer : s_threads)
+				threadNames.push_back(buffer->name);
+		}
+
+		//the timeline covers the frame, and any gpu work that finished after it
+		int64_t rangeStart = frame.start;
+		int64_t rangeEnd = frame.end;
+		for (const TTN_ProfileEvent& e : frame.gpuEvents)
+			rangeEnd = std::max(rangeEnd, e.end);
+		const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		const float labelWidth = 100.0f;
+
+		if (ImGui::CollapsingHeader("Timeline", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::BeginChild("##Timeline", ImVec2(0.0f, 250.0f), true, ImGuiWindowFlags_HorizontalScrollbar);
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 100.0f);
+			float scale = width / (float)std::max<int64_t>(rangeEnd - rangeStart, 1);
+			float y = origin.y;
+
+			//draws a track (a thread or the gpu) with its scopes stacked by depth, like a flame graph
+			auto drawTrack = [&](const char* label, const std::vector<TTN_ProfileEvent>& events) {
+				if (events.empty())
+					return;
+
+				uint32_t maxDepth = 0;
+				for (const TTN_ProfileEvent& e : events)
+					maxDepth = std::max(maxDepth, e.depth);
+
+				drawList->AddText(ImVec2(origin.x, y), ImGui::GetColorU32(ImGuiCol_Text), label);
+				for (const TTN_ProfileEvent& e : events) {
+					ImVec2 min(origin.x + labelWidth + (e.start - rangeStart) * scale, y + e.depth * rowHeight);
+					ImVec2 max(std::max(origin.x + labelWidth + (e.end - rangeStart) * scale, min.x + 1.0f), min.y + rowHeight - 1.0f);
+
+					//colour each scope by its name so the same scope looks the same in every frame
+					float hue = (std::hash<std::string_view>()(e.name) % 360) / 360.0f;
+					drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.7f));
+					if (max.x - min.x > 20.0f) {
+						drawList->PushClipRect(min, max, true);
+						drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, e.name);
+						drawList->PopClipRect();
+					}
+
+					if (ImGui::IsMouseHoveringRect(min, max))
+						ImGui::SetTooltip("%s\n%.3f ms", e.name, (e.end - e.start) / 1000000.0f);
+				}
+
+				y += (maxDepth + 1) * rowHeight + 4.0f;
+			};
+
+			if (frame.gpuResolved)
+				drawTrack("GPU", frame.gpuEvents);
+			for (size_t i = 0; i < frame.cpuEvents.size(); i++)
+				drawTrack(i < threadNames.size() ? threadNames[i].c_str() : "Thread", frame.cpuEvents[i]);
+
+			ImGui::Dummy(ImVec2(labelWidth + width, y - origin.y));
+			ImGui::EndChild();
+		}
+
+		//the total time and number of calls of each scope in the frame, most expensive first
+		if (ImGui::CollapsingHeader("Scope Totals", ImGuiTreeNodeFlags_DefaultOpen)) {
+			struct ScopeTotal {
+				std::string name;
+				int64_t time = 0;
+				int calls = 0;
+			};
+			std::vector<ScopeTotal> totals;
+			std::unordered_map<std::string, size_t> lookup;
+			auto addTotal = [&](const std::string& name, const TTN_ProfileEvent& e) {
+				auto it = lookup.find(name);
+				if (it == lookup.end()) {
+					it = lookup.emplace(name, totals.size()).first;
+					totals.push_back({ name });
+				}
+				totals[it->second].time += e.end - e.start;
+				totals[it->second].calls++;
+			};
+			for (const auto& events : frame.cpuEvents) {
+				for (const TTN_ProfileEvent& e : events)
+					addTotal(e.name, e);
+			}
+			for (const TTN_ProfileEvent& e : frame.gpuEvents)
+				addTotal(std::string("[GPU] ") + e.name, e);
+			std::sort(totals.begin(), totals.end(), [](const ScopeTotal& a, const ScopeTotal& b) { return a.time > b.time; });
+
+			ImGui::Columns(3, "##ScopeTotals");
+			ImGui::TextUnformatted("Scope"); ImGui::NextColumn();
+			ImGui::TextUnformatted("Total (ms)"); ImGui::NextColumn();
+			ImGui::TextUnformatted("Calls"); ImGui::NextColumn();
+			ImGui::Separator();
+			for (const ScopeTotal& total : totals) {
+				ImGui::TextUnformatted(total.name.c_str()); ImGui::NextColumn();
+				ImGui::Text("%.3f", total.time / 1000000.0f); ImGui::NextColumn();
+				ImGui::Text("%d", total.calls); ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+		}
+
+		ImGui::End();
+	}
+}
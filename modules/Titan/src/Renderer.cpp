@@ -7,6 +7,12 @@
 #include "Titan/Renderer.h"
 
 namespace Titan {
+	//uniform ids used by this file, interned once so setting them doesn't need to look up the names
+	static const TTN_UniformId s_uniformInstanced("u_Instanced");
+	static const TTN_UniformId s_uniformMVP("MVP");
+	static const TTN_UniformId s_uniformModel("Model");
+	static const TTN_UniformId s_uniformNormalMat("NormalMat");
+
 	//constructor, creates a renderer object from a mesh
 	TTN_Renderer::TTN_Renderer(TTN_Mesh::smptr mesh)
 	{
@@ -50,18 +56,21 @@ namespace Titan {
 	void TTN_Renderer::SetMesh(TTN_Mesh::smptr mesh)
 	{
 		m_mesh = mesh;
+		s_changeCount++;
 	}
 
 	//sets a shader
 	void TTN_Renderer::SetShader(TTN_Shader::sshptr shader)
 	{
 		m_Shader = shader;
+		s_changeCount++;
 	}
 
 	//sets a material
 	void TTN_Renderer::SetMat(TTN_Material::smatptr mat)
 	{
 		m_Mat = mat;
+		s_changeCount++;
 	}
 
 	//sets the renderlayer
@@ -71,10 +80,13 @@ namespace Titan {
 	}
 
 	//function that will send the uniforms with how to draw the object arounding to the camera to openGL
-	void TTN_Renderer::Render(glm::mat4 model, glm::mat4 VP)
+	void TTN_Renderer::Render(glm::mat4 model, glm::mat4 VP, const TTN_VertexArrayObject::svaptr& vao)
 	{
+		//draw the mesh's own vao unless a different one was given
+		const TTN_VertexArrayObject::svaptr& drawVao = (vao != nullptr) ? vao : m_mesh->GetVAOPointer();
+
 		//make sure the vao is acutally set up before continuing
-		if (m_mesh->GetVAOPointer() == nullptr)
+		if (drawVao == nullptr)
 			//if it isn't, then stop then return so the later code doesn't break the entire program
 			return;
 
@@ -83,13 +95,45 @@ namespace Titan {
 		//send the uniforms to openGL 
 		if (m_Shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::VERT_SKYBOX && 
 			m_Shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT) {
-			m_Shader->SetUniformMatrix("MVP", VP * model);
-			m_Shader->SetUniformMatrix("Model", model);
-			m_Shader->SetUniformMatrix("NormalMat", glm::mat3(glm::transpose(glm::inverse(model))));
+			m_Shader->SetUniform(s_uniformInstanced, 0);
+			m_Shader->SetUniformMatrix(s_uniformMVP, VP * model);
+			m_Shader->SetUniformMatrix(s_uniformModel, model);
+			m_Shader->SetUniformMatrix(s_uniformNormalMat, glm::mat3(glm::transpose(glm::inverse(model))));
 		}
 		//render the VAO
-		m_mesh->GetVAOPointer()->Render();
+		drawVao->Render();
 		//unbind the shader
 		m_Shader->UnBind();
 	}
+
+	//sets up the buffer used for instanced draws
+	void TTN_Renderer::InitRenderer(size_t maxInstancesPerFrame)
+	{
+		//the instance data is rewritten every frame so it goes in a streaming buffer
+		s_instanceBuffer = TTN_VertexBuffer::CreateStreaming(sizeof(InstanceData), maxInstancesPerFrame);
+
+		//the model matrix takes up slots 6-9 and the normal matrix slots 10-12, one column per slot, and the morph state slot 13
+		const GLsizei stride = sizeof(InstanceData);
+		const size_t modelOffset = offsetof(InstanceData, model);
+		const size_t normalOffset = offsetof(InstanceData, normalMat);
+		const size_t morphOffset = offsetof(InstanceData, morph);
+		s_instanceAttributes = {
+			BufferAttribute(6, 4, GL_FLOAT, false, stride, modelOffset, AttribUsage::User0, 1),
+			BufferAttribute(7, 4, GL_FLOAT, false, stride, modelOffset + sizeof(glm::vec4), AttribUsage::User0, 1),
+			BufferAttribute(8, 4, GL_FLOAT, false, stride, modelOffset + sizeof(glm::vec4) * 2, AttribUsage::User0, 1),
+			BufferAttribute(9, 4, GL_FLOAT, false, stride, modelOffset + sizeof(glm::vec4) * 3, AttribUsage::User0, 1),
+			BufferAttribute(10, 3, GL_FLOAT, false, stride, normalOffset, AttribUsage::User1, 1),
+			BufferAttribute(11, 3, GL_FLOAT, false, stride, normalOffset + sizeof(glm::vec3), AttribUsage::User1, 1),
+			BufferAttribute(12, 3, GL_FLOAT, false, stride, normalOffset + sizeof(glm::vec3) * 2, AttribUsage::User1, 1),
+			BufferAttribute(13, 3, GL_FLOAT, false, stride, morphOffset, AttribUsage::User2, 1)
+		};
+	}
+
+	//gets if a shader can be drawn instanced
+	bool TTN_Renderer::GetShaderSupportsInstancing(const TTN_Shader::sshptr& shader)
+	{
+		return s_instanceBuffer != nullptr
+			&& shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT
+			&& shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::VERT_SKYBOX;
+	}
 }
\ No newline at end of file
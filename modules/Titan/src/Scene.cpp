@@ -4,8 +4,16 @@
 #include "Titan/ttn_pch.h"
 // Scene.cpp - source file for the class that handles ECS, render calls, etc.
 #include "Titan/Scene.h"
+//include the profiler to time the heavier parts of the update and render
+#include "Titan/Profiler.h"
 
 namespace Titan {
+	//uniform ids used by this file, interned once so setting them doesn't need to look up the names
+	static const TTN_UniformId s_uniformInstanced("u_Instanced");
+	static const TTN_UniformId s_uniformMorph("u_Morph");
+	static const TTN_UniformId s_uniformMorphVertexCount("u_MorphVertexCount");
+	static const TTN_UniformId s_uniformEnvironmentRotation("u_EnvironmentRotation");
+
 	//default constructor
  
 	TTN_Scene::TTN_Scene() {
@@ -13,6 +21,8 @@ namespace Titan {
 		m_ShouldRender = true;
 		m_Registry = new entt::registry();
 		m_RenderGroup = std::make_unique<RenderGroupType>(m_Registry->group<TTN_Transform, TTN_Renderer>());
+		m_TransformSystem = std::make_unique<TTN_TransformSystem>(m_Registry);
+		m_CullingSystem = std::make_unique<TTN_CullingSystem>(m_Registry);
 		m_AmbientColor = glm::vec3(1.0f);
 		m_AmbientStrength = 1.0f;
 
@@ -24,6 +34,7 @@ namespace Titan {
 
 		//create the physics world
 		m_physicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfig);
+		m_ContactSystem = std::make_unique<TTN_ContactSystem>();
 
 		//set gravity to default none
 		m_physicsWorld->setGravity(btVector3(0.0f, 0.0f, 0.0f));
@@ -39,6 +50,8 @@ namespace Titan {
 		m_ShouldRender = true;
 		m_Registry = new entt::registry();
 		m_RenderGroup = std::make_unique<RenderGroupType>(m_Registry->group<TTN_Transform, TTN_Renderer>());
+		m_TransformSystem = std::make_unique<TTN_TransformSystem>(m_Registry);
+		m_CullingSystem = std::make_unique<TTN_CullingSystem>(m_Registry);
 
 		//setting up physics world
 		collisionConfig = new btDefaultCollisionConfiguration(); //default collision config
@@ -48,6 +61,7 @@ namespace Titan {
 
 		//create the physics world
 		m_physicsWorld = new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfig);
+		m_ContactSystem = std::make_unique<TTN_ContactSystem>();
 
 		//set gravity to default none
 		m_physicsWorld->setGravity(btVector3(0.0f, 0.0f, 0.0f));
@@ -67,9 +81,6 @@ namespace Titan {
 		//create the entity
 		auto entity = m_Registry->create();
 
-		//reconstruct scenegraph as entt was shuffled
-		ReconstructScenegraph();
-
 		//return the entity id
 		return entity;
 	}
@@ -80,23 +91,25 @@ namespace Titan {
 		//if the entity has a bullet physics body, delete it from bullet
 		if (m_Registry->has<TTN_Physics>(entity)) {
 			btRigidBody* body = Get<TTN_Physics>(entity).GetRigidBody();
+			//the collision shape is shared through the shape cache, so it's deleted with the last component using it
 			delete body->getMotionState();
-			delete body->getCollisionShape();
 			m_physicsWorld->removeRigidBody(body);
 			delete body;
 		}
 
 		//delete the entity from the registry
 		m_Registry->destroy(entity);
-
-		//reconstruct the scenegraph as entt was shuffled
-		ReconstructScenegraph();
 	}
 
 	//sets the underlying entt registry of the scene
 	void TTN_Scene::SetScene(entt::registry* reg)
 	{
+		//detach the transform and culling systems from the old registry before switching
+		m_CullingSystem.reset();
+		m_TransformSystem.reset();
 		m_Registry = reg;
+		m_TransformSystem = std::make_unique<TTN_TransformSystem>(m_Registry);
+		m_CullingSystem = std::make_unique<TTN_CullingSystem>(m_Registry);
 	}
 
 	//unloads the scene, deleting the registry and physics world
@@ -124,6 +137,12 @@ namespace Titan {
 		delete overlappingPairCache;
 		delete dispatcher;
 		delete collisionConfig;
+		//and forget the contacts between the bodies that were in it
+		m_ContactSystem->Clear();
+
+		//delete the culling and transform systems before the registry they're hooked into
+		m_CullingSystem.reset();
+		m_TransformSystem.reset();
 
 		//delete registry
 		if (m_Registry != nullptr) {
@@ -132,19 +151,16 @@ namespace Titan {
 		}
 	}
 
-	//reconstructs the scenegraph, should be done every time entt shuffles
-	void TTN_Scene::ReconstructScenegraph()
+	//sets the parent of an entity's transform, the child's global matrix will be resolved before the next render
+	void TTN_Scene::SetParent(entt::entity child, entt::entity parent)
 	{
-		//reconstruct any scenegraph relationships
-		auto transView = m_Registry->view<TTN_Transform>();
-		for (auto entity : transView) {
-			//if it should have a parent
-			if (Get<TTN_Transform>(entity).GetParentEntity() != nullptr) {
-				//then reatach that parent
-				Get<TTN_Transform>(entity).SetParent(&Get<TTN_Transform>(*Get<TTN_Transform>(entity).GetParentEntity()),
-					Get<TTN_Transform>(entity).GetParentEntity());
-			}
-		}
+		Get<TTN_Transform>(child).SetParent(parent);
+	}
+
+	//resolves the global matrices of every transform in the scene in a single pass
+	void TTN_Scene::ResolveTransforms()
+	{
+		m_TransformSystem->Resolve();
 	}
 
 	//update the scene, running physics simulation, animations, and particle systems
@@ -152,37 +168,44 @@ namespace Titan {
 	{
 		//only run the updates if the scene is not paused
 		if (!m_Paused) {
-			//call the step simulation for bullet
-			m_physicsWorld->stepSimulation(deltaTime);
-
-			//run through all of the physicsbody in the scene
+			//add any physics bodies that aren't in the world yet
 			auto physicsBodyView = m_Registry->view<TTN_Physics>();
 			for (auto entity : physicsBodyView) {
-				//if the physics body isn't in the world, add it
-				if (!Get<TTN_Physics>(entity).GetIsInWorld()) {
-					Get<TTN_Physics>(entity).SetEntity(entity);
-					m_physicsWorld->addRigidBody(Get<TTN_Physics>(entity).GetRigidBody());
-					Get<TTN_Physics>(entity).SetIsInWorld(true);
+				TTN_Physics& physics = Get<TTN_Physics>(entity);
+				if (!physics.GetIsInWorld()) {
+					physics.SetEntity(entity);
+					//have the body's motion state report to this scene when bullet moves it
+					physics.GetMotionState()->SetMovedList(&m_MovedBodies);
+					m_physicsWorld->addRigidBody(physics.GetRigidBody());
+					physics.SetIsInWorld(true);
 				}
+			}
 
-				//make sure the physics body are active on every frame
-				Get<TTN_Physics>(entity).GetRigidBody()->setActivationState(true);
-
-				//call the physics body's update
-				Get<TTN_Physics>(entity).Update(deltaTime);
+			//step the simulation, bullet advances it in fixed steps (up to the cap) and writes transforms interpolated between the last two
+			//steps into the motion states of the active bodies, sleeping bodies are left alone
+			{
+				TTN_PROFILE_SCOPE("Physics Step");
+				m_physicsWorld->stepSimulation(deltaTime, m_PhysicsMaxSubSteps, m_PhysicsTimeStep);
 			}
 
-			//construct the collisions for the frame
-			ConstructCollisions();
+			//read the contacts out of the step
+			m_ContactSystem->Update(dispatcher);
 
-			//run through all of the entities with both a physics body and a transform in the scene
-			auto transAndPhysicsView = m_Registry->view<TTN_Transform, TTN_Physics>();
-			for (auto entity : transAndPhysicsView) {
-				if (!Get<TTN_Physics>(entity).GetIsStatic()) {
-					//copy the position of the physics body into the position of the transform
-					Get<TTN_Transform>(entity).SetPos(Get<TTN_Physics>(entity).GetTrans().GetPos());
-				}
+			//copy the transforms of only the bodies bullet moved back into the titan transforms
+			for (auto entity : m_MovedBodies) {
+				//skip anything that was deleted since
+				if (!m_Registry->valid(entity) || !m_Registry->has<TTN_Physics>(entity))
+					continue;
+
+				//read the interpolated transform out of bullet
+				TTN_Physics& physics = Get<TTN_Physics>(entity);
+				physics.Update(deltaTime);
+
+				//and copy the position and rotation into the transform
+				if (!physics.GetIsStatic() && m_Registry->has<TTN_Transform>(entity))
+					Get<TTN_Transform>(entity).SetPosAndRotation(physics.GetTrans().GetPos(), physics.GetTrans().GetRotQuat());
 			}
+			m_MovedBodies.clear();
 
 			//run through all the of entities with an animator and renderer in the scene and run it's update
 			auto manimatorRendererView = m_Registry->view<TTN_MorphAnimator>();
@@ -218,6 +241,9 @@ namespace Titan {
 	//renders all the messes in our game
 	void TTN_Scene::Render()
 	{
+		//resolve the transform hierarchy so every global matrix is up to date for this frame
+		ResolveTransforms();
+
 		//get the view and projection martix
 		glm::mat4 vp;
 		//update the camera for the scene
@@ -228,237 +254,252 @@ namespace Titan {
 		glm::mat4 viewMat = glm::inverse(Get<TTN_Transform>(m_Cam).GetGlobal());
 		vp *= viewMat;
 
-		//sort our render group
-		m_RenderGroup->sort<TTN_Renderer>([](const TTN_Renderer& l, const TTN_Renderer& r) {
-			//sort by render layer first, higher render layers get drawn later
-			if (l.GetRenderLayer() < r.GetRenderLayer()) return true;
-			if (l.GetRenderLayer() > r.GetRenderLayer()) return false;
-
-			//sort by shader pointer to minimize state changes on active shader
-			if (l.GetShader() < r.GetShader()) return true;
-			if (l.GetShader() > r.GetShader()) return false;
-
-			//sort by material pointer to  minimize state changes on textures and stuff
-			if (l.GetMat() < r.GetMat()) return true;
-			if (l.GetMat() > r.GetMat()) return false;
-		});
-
-		ReconstructScenegraph();
-
-		//go through every entity with a transform and a mesh renderer and render the mesh
-		m_RenderGroup->each([&](entt::entity entity, TTN_Transform& transform, TTN_Renderer& renderer) {
-			//get the shader pointer
-			TTN_Shader::sshptr shader = renderer.GetShader();
-
-			//bind the shader
-			shader->Bind();
-
-			//sets some uniforms
-			if (shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT) {
-				//scene level ambient lighting
-				shader->SetUniform("u_AmbientCol", m_AmbientColor);
-				shader->SetUniform("u_AmbientStrength", m_AmbientStrength);
-
-				//stuff from the light
-				glm::vec3 lightPositions[16];
-				glm::vec3 lightColor[16];
-				float lightAmbientStr[16];
-				float lightSpecStr[16];
-				float lightAttenConst[16];
-				float lightAttenLinear[16];
-				float lightAttenQuadartic[16];
-
-				for (int i = 0; i < 16 && i < m_Lights.size(); i++) {
-					auto& light = Get<TTN_Light>(m_Lights[i]);
-					auto& lightTrans = Get<TTN_Transform>(m_Lights[i]);
-					lightPositions[i] = lightTrans.GetPos();
-					lightColor[i] = light.GetColor();
-					lightAmbientStr[i] = light.GetAmbientStrength();
-					lightSpecStr[i] = light.GetSpecularStrength();
-					lightAttenConst[i] = light.GetConstantAttenuation();
-					lightAttenLinear[i] = light.GetConstantAttenuation();
-					lightAttenQuadartic[i] = light.GetQuadraticAttenuation();
-				}
+		//build the render queue from every entity with a transform and a mesh renderer that the camera can see
+		m_RenderQueue.clear();
+		//bring the bvh up to date with anything that moved (even if culling is off, so it's ready if it gets turned back on)
+		{
+			TTN_PROFILE_SCOPE("BVH Update");
+			m_CullingSystem->Update(m_TransformSystem->GetMovedEntities());
+			m_TransformSystem->ClearMovedEntities();
+		}
+		if (m_FrustumCulling) {
+			//find the visible set
+			{
+				TTN_PROFILE_SCOPE("Frustum Culling");
+				m_CullingSystem->Cull(vp, m_VisibleEntities);
+			}
 
-				//send all the data about the lights to glsl
-				shader->SetUniform("u_LightPos", lightPositions[0], 16);
-				shader->SetUniform("u_LightCol", lightColor[0], 16);
-				shader->SetUniform("u_AmbientLightStrength", lightAmbientStr[0], 16);
-				shader->SetUniform("u_SpecularLightStrength", lightSpecStr[0], 16);
-				shader->SetUniform("u_LightAttenuationConstant", lightAttenConst[0], 16);
-				shader->SetUniform("u_LightAttenuationLinear", lightAttenLinear[0], 16);
-				shader->SetUniform("u_LightAttenuationQuadratic", lightAttenQuadartic[0], 16);
+			for (entt::entity entity : m_VisibleEntities) {
+				TTN_Transform& transform = Get<TTN_Transform>(entity);
+				TTN_Renderer& renderer = Get<TTN_Renderer>(entity);
+				m_RenderQueue.push_back({ renderer.GetRenderLayer(), renderer.GetShader().get(), renderer.GetMat().get(), renderer.GetMesh().get(),
+					entity, &transform, &renderer, GetMorphState(entity) });
+			}
+		}
+		else {
+			m_RenderGroup->each([&](entt::entity entity, TTN_Transform& transform, TTN_Renderer& renderer) {
+				m_RenderQueue.push_back({ renderer.GetRenderLayer(), renderer.GetShader().get(), renderer.GetMat().get(), renderer.GetMesh().get(),
+					entity, &transform, &renderer, GetMorphState(entity) });
+			});
+		}
 
-				//and tell it how many lights there actually are
-				shader->SetUniform("u_NumOfLights", (int)m_Lights.size());
+		//sort it by render layer first (higher render layers get drawn later), then by shader, material, and mesh to minimize state
+		//changes and put entities that can be drawn together next to each other
+		std::sort(m_RenderQueue.begin(), m_RenderQueue.end());
+
+		//send the camera and light data to the frame uniform block once for the whole frame
+		UpdateFrameUniforms(viewMat, Get<TTN_Camera>(m_Cam).GetProj());
+
+		//the instance data for the frame is written into the renderer's streaming buffer as the batches get drawn
+		TTN_VertexBuffer::svbptr instanceBuffer = TTN_Renderer::GetInstanceBuffer();
+		TTN_Renderer::InstanceData* instances = nullptr;
+		size_t instanceCapacity = (instanceBuffer != nullptr) ? instanceBuffer->GetMaxElementCount() : 0;
+		size_t instanceCursor = 0;
+
+		//the shader and material the last material uniforms were sent for, and the currently bound shader
+		TTN_Shader* lastShader = nullptr;
+		TTN_Material* lastMat = nullptr;
+		TTN_Shader* boundShader = nullptr;
+
+		//go through the queue, drawing runs of entities that share the same state together
+		size_t i = 0;
+		while (i < m_RenderQueue.size()) {
+			const RenderQueueItem& first = m_RenderQueue[i];
+			TTN_Shader* shader = first.shader;
+
+			//find the end of the batch, morph animated entities batch with everything else as their frames go in the instance data
+			size_t batchEnd = i + 1;
+			bool instanced = TTN_Renderer::GetShaderSupportsInstancing(first.renderer->GetShader());
+			if (instanced) {
+				while (batchEnd < m_RenderQueue.size() && m_RenderQueue[batchEnd].layer == first.layer && m_RenderQueue[batchEnd].shader == shader
+					&& m_RenderQueue[batchEnd].material == first.material && m_RenderQueue[batchEnd].mesh == first.mesh)
+					batchEnd++;
+			}
 
-				//stuff from the camera
-				shader->SetUniform("u_CamPos", Get<TTN_Transform>(m_Cam).GetPos());
+			//send the material uniforms whenever the shader and material change
+			if (shader != lastShader || first.material != lastMat) {
+				ApplyMaterialUniforms(shader, first.material);
+				lastShader = shader;
+				lastMat = first.material;
 			}
 
-			//if it's not the skybox shader, set some uniforms for lighting
-			if (shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::FRAG_SKYBOX
-				&& shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT) {
-				//sets some uniforms
-				//scene level ambient lighting
-				shader->SetUniform("u_AmbientCol", m_AmbientColor);
-				shader->SetUniform("u_AmbientStrength", m_AmbientStrength);
-
-				//stuff from the light
-				glm::vec3 lightPositions[16];
-				glm::vec3 lightColor[16];
-				float lightAmbientStr[16];
-				float lightSpecStr[16];
-				float lightAttenConst[16];
-				float lightAttenLinear[16];
-				float lightAttenQuadartic[16];
-
-				for (int i = 0; i < 16 && i < m_Lights.size(); i++) {
-					auto& light = Get<TTN_Light>(m_Lights[i]);
-					auto& lightTrans = Get<TTN_Transform>(m_Lights[i]);
-					lightPositions[i] = lightTrans.GetGlobalPos();
-					lightColor[i] = light.GetColor();
-					lightAmbientStr[i] = light.GetAmbientStrength();
-					lightSpecStr[i] = light.GetSpecularStrength();
-					lightAttenConst[i] = light.GetConstantAttenuation();
-					lightAttenLinear[i] = light.GetConstantAttenuation();
-					lightAttenQuadartic[i] = light.GetQuadraticAttenuation();
+			//if the batch fits in what's left of the instance buffer, draw it in one instanced call
+			size_t batchSize = batchEnd - i;
+			if (instanced && instanceCursor + batchSize <= instanceCapacity) {
+				//start writing the instance data for the frame if this is the first instanced batch
+				if (instances == nullptr) instances = instanceBuffer->BeginWrite<TTN_Renderer::InstanceData>();
+
+				//write the per instance matrices
+				for (size_t j = i; j < batchEnd; j++) {
+					const glm::mat4& model = m_RenderQueue[j].transform->GetGlobal();
+					instances[instanceCursor + j - i].model = model;
+					instances[instanceCursor + j - i].normalMat = glm::mat3(glm::transpose(glm::inverse(model)));
+					instances[instanceCursor + j - i].morph = m_RenderQueue[j].morph;
 				}
 
-				//send all the data about the lights to glsl
-				shader->SetUniform("u_LightPos", lightPositions[0], 16);
-				shader->SetUniform("u_LightCol", lightColor[0], 16);
-				shader->SetUniform("u_AmbientLightStrength", lightAmbientStr[0], 16);
-				shader->SetUniform("u_SpecularLightStrength", lightSpecStr[0], 16);
-				shader->SetUniform("u_LightAttenuationConstant", lightAttenConst[0], 16);
-				shader->SetUniform("u_LightAttenuationLinear", lightAttenLinear[0], 16);
-				shader->SetUniform("u_LightAttenuationQuadratic", lightAttenQuadartic[0], 16);
-
-				//and tell it how many lights there actually are
-				shader->SetUniform("u_NumOfLights", (int)m_Lights.size());
-
-				//stuff from the camera
-				shader->SetUniform("u_CamPos", Get<TTN_Transform>(m_Cam).GetPos());
-			}
-
-			//if the mesh has a material send data from that
-			if (renderer.GetMat() != nullptr)
-			{
+				//make sure the mesh's vao reads from the instance buffer
+				if (first.mesh->GetInstanceBuffer() != instanceBuffer)
+					first.mesh->SetInstanceBuffer(instanceBuffer, TTN_Renderer::GetInstanceAttributes());
+				first.mesh->SetUpVao();
 
-				//give openGL the shinniess
-				if (shader->GetFragShaderDefaultStatus() != 8) shader->SetUniform("u_Shininess", renderer.GetMat()->GetShininess());
-				//if they're using a texture
-				if (shader->GetFragShaderDefaultStatus() == 4 || shader->GetFragShaderDefaultStatus() == 5)
-
-					//give openGL the shinniess if it's not a skybox being renderered
-					if (shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::FRAG_SKYBOX
-						&& shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT)
-						shader->SetUniform("u_Shininess", renderer.GetMat()->GetShininess());
-
-				//texture slot to dynamically send textures across different types of shaders
-				int textureSlot = 0;
-
-				//if they're using a displacement map 
-				if (shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_COLOR_HEIGHTMAP
-					|| shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_NO_COLOR_HEIGHTMAP)
-				{
-					//bind it to the slot 
-					renderer.GetMat()->GetHeightMap()->Bind(textureSlot);
-					//update the texture slot for future textures to use
-					textureSlot++;
-					//and pass in the influence
-					shader->SetUniform("u_influence", renderer.GetMat()->GetHeightInfluence());
+				//bind the shader and draw the whole batch
+				if (first.mesh->GetVAOPointer() != nullptr) {
+					if (boundShader != shader) {
+						shader->Bind();
+						boundShader = shader;
+					}
+					shader->SetUniform(s_uniformInstanced, 1);
+					BindMorphFrames(shader, first.mesh);
+					first.mesh->GetVAOPointer()->RenderInstanced(batchSize, 0, instanceCursor);
 				}
-
-				//if they're using an animator 
-				if (shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_MORPH_ANIMATION_NO_COLOR
-					|| shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_MORPH_ANIMATION_COLOR) {
-					//try to get an animator component 
-					if (Has<TTN_MorphAnimator>(entity)) {
-						shader->SetUniform("t", Get<TTN_MorphAnimator>(entity).getActiveAnimRef().getInterpolationParameter());
+				instanceCursor += batchSize;
+			}
+			//otherwise draw each entity in it on it's own
+			else {
+				for (size_t j = i; j < batchEnd; j++) {
+					const RenderQueueItem& item = m_RenderQueue[j];
+
+					//make sure the mesh's vao is set up, and send the morph state if the shader is a morph shader
+					TTN_VertexArrayObject::svaptr morphVao = nullptr;
+					if (BindMorphFrames(shader, item.mesh)) {
+						item.mesh->SetUpVao();
+						shader->SetUniform(s_uniformMorph, item.morph);
 					}
+					//custom shaders on animated entities still read the current and next frames from the vertex attributes, so they
+					//get a vao set up with their frames (apart from the main one, so it isn't set up again for every entity)
+					else if (Has<TTN_MorphAnimator>(item.entity))
+						morphVao = item.mesh->GetMorphVao((int)item.morph.x, (int)item.morph.y);
 					else
-						shader->SetUniform("t", 0.0f);
+						item.mesh->SetUpVao();
+
+					//and finish by rendering the mesh (this unbinds the shader after)
+					item.renderer->Render(item.transform->GetGlobal(), vp, morphVao);
+					boundShader = nullptr;
 				}
+			}
 
-				//if they're using an albedo texture 
-				if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_ONLY
-					|| shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_AND_SPECULAR)
+			i = batchEnd;
+		}
 
-				{
-					//bind it so openGL can see it
-					renderer.GetMat()->GetAlbedo()->Bind(textureSlot);
-					//update the texture slot for future textures to use
-					textureSlot++;
-				}
+		//finish writing the instance data
+		if (instances != nullptr) instanceBuffer->EndWrite(instanceCursor);
+		if (boundShader != nullptr) boundShader->UnBind();
 
-				//if they're using a specular map
-				if (shader->GetFragShaderDefaultStatus() == 5)
+		//2D sprite rendering
+		//submit every entity with a 2d renderer and a transform to the batcher, it sorts them by their z positions and draws them
+		TTN_SpriteBatcher* spriteBatcher = TTN_Renderer2D::GetSpriteBatcher();
+		if (spriteBatcher != nullptr) {
+			spriteBatcher->Begin(vp);
+			auto render2DView = m_Registry->view<TTN_Transform, TTN_Renderer2D>();
+			for (entt::entity entity : render2DView) {
+				TTN_Renderer2D& sprite = render2DView.get<TTN_Renderer2D>(entity);
+				spriteBatcher->Submit(sprite.GetSprite(), render2DView.get<TTN_Transform>(entity).GetGlobal(), sprite.GetColor());
+			}
+			spriteBatcher->End();
+		}
+	}
 
+	//fills the frame uniform buffer and binds it
+	void TTN_Scene::UpdateFrameUniforms(const glm::mat4& view, const glm::mat4& projection)
+	{
+		//create the buffer the first time the scene is rendered
+		if (m_FrameUbo == nullptr) {
+			m_FrameUbo = TTN_UniformBuffer::Create();
+			m_FrameUbo->LoadData<FrameData>(nullptr, 1);
+		}
 
-					//if they're using a specular map 
-					if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_AND_SPECULAR)
+		FrameData data;
+		//camera data
+		data.view = view;
+		data.projection = projection;
+		data.viewProjection = projection * view;
+		data.camPos = glm::vec4(Get<TTN_Transform>(m_Cam).GetGlobalPos(), 1.0f);
+
+		//scene level ambient lighting
+		data.ambient = glm::vec4(m_AmbientColor, m_AmbientStrength);
+
+		//stuff from the lights
+		int numOfLights = (int)std::min(m_Lights.size(), (size_t)16);
+		data.numOfLights = glm::ivec4(numOfLights, 0, 0, 0);
+		for (int i = 0; i < numOfLights; i++) {
+			auto& light = Get<TTN_Light>(m_Lights[i]);
+			auto& lightTrans = Get<TTN_Transform>(m_Lights[i]);
+			data.lights[i].position = glm::vec4(lightTrans.GetGlobalPos(), light.GetAmbientStrength());
+			data.lights[i].color = glm::vec4(light.GetColor(), light.GetSpecularStrength());
+			data.lights[i].attenuation = glm::vec4(light.GetConstantAttenuation(), light.GetLinearAttenuation(), light.GetQuadraticAttenuation(), 0.0f);
+		}
 
-					{
-						//bind it so openGL can see it
-						renderer.GetMat()->GetSpecularMap()->Bind(textureSlot);
-						//update the texture slot for future textures to use
-						textureSlot++;
-					}
+		//only upload the lights that are actually used
+		size_t size = offsetof(FrameData, lights) + sizeof(FrameLightData) * numOfLights;
+		m_FrameUbo->UpdateData(&data, 0, size);
+		m_FrameUbo->BindBase(TTN_UniformBinding::FRAME);
+	}
 
-				//if they're using a skybox
-				if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_SKYBOX)
-				{
-					//bind the skybox texture
-					renderer.GetMat()->GetSkybox()->Bind(textureSlot);
-					//set the rotation uniform
-					shader->SetUniformMatrix("u_EnvironmentRotation", glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1, 0, 0))));
-					//set the skybox matrix uniform
-					shader->SetUniformMatrix("u_SkyboxMatrix", Get<TTN_Camera>(m_Cam).GetProj() * glm::mat4(glm::mat3(viewMat)));
-				}
+	//sends the material data to a shader and binds it's textures
+	void TTN_Scene::ApplyMaterialUniforms(TTN_Shader* shader, TTN_Material* material)
+	{
+		//the vertex and fragment sides are checked separately, as a default vertex shader can be paired with a custom fragment
+		//shader (and the other way around), the fragment side bindings below only match the default fragment shaders
 
-			}
-			//otherwise send a default shinnies value
-			else if (shader->GetFragShaderDefaultStatus() != (int)TTN_DefaultShaders::NOT_DEFAULT) {
-				shader->SetUniform("u_Shininess", 128.0f);
-			}
+		//if there's no material use the default material uniforms
+		if (material == nullptr) {
+			TTN_Material::BindDefaultUniforms();
+			return;
+		}
 
-			//if the entity has an animator
-			if (Has<TTN_MorphAnimator>(entity)) {
-				entt::entity tempA = entity;
-				//int tempNum = Get<TTN_MorphAnimator>(entity).getActiveAnimRef().getCurrentMeshIndex();
-				//int tempNum2 = Get<TTN_MorphAnimator>(entity).getActiveAnimRef().getNextMeshIndex();
-				TTN_MorphAnimation& tempAnim = Get<TTN_MorphAnimator>(entity).getActiveAnimRef();
+		//bind the material's uniform block with the shininess and height map influence
+		material->BindUniforms();
+
+		//the default shaders read each texture from a fixed slot, albedo (or the skybox) on 0, specular on 1, and the height map on 2
+		//if they're using a displacement map 
+		if (shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_COLOR_HEIGHTMAP
+			|| shader->GetVertexShaderDefaultStatus() == (int)TTN_DefaultShaders::VERT_NO_COLOR_HEIGHTMAP)
+			material->GetHeightMap()->Bind(2);
+
+		//if they're using an albedo texture 
+		if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_ONLY
+			|| shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_AND_SPECULAR)
+			material->GetAlbedo()->Bind(0);
+
+		//if they're using a specular map 
+		if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_BLINN_PHONG_ALBEDO_AND_SPECULAR)
+			material->GetSpecularMap()->Bind(1);
+
+		//if they're using a skybox
+		if (shader->GetFragShaderDefaultStatus() == (int)TTN_DefaultShaders::FRAG_SKYBOX)
+		{
+			//bind the skybox texture
+			material->GetSkybox()->Bind(0);
+			//set the rotation uniform (the skybox matrix comes from the frame uniforms)
+			shader->SetUniformMatrix(s_uniformEnvironmentRotation, glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1, 0, 0))));
+		}
+	}
 
-				//set up the vao on the mesh properly
-				renderer.GetMesh()->SetUpVao(Get<TTN_MorphAnimator>(entity).getActiveAnimRef().getCurrentMeshIndex(),
-					Get<TTN_MorphAnimator>(entity).getActiveAnimRef().getNextMeshIndex());
-			}
-			//if it doesn't
-			else {
-				//set up the vao with both mesh indices on zero
-				renderer.GetMesh()->SetUpVao();
-			}
+	//gets the morph animation state of an entity
+	glm::vec3 TTN_Scene::GetMorphState(entt::entity entity)
+	{
+		//entities without an animator just sit on the first frame
+		if (!Has<TTN_MorphAnimator>(entity))
+			return glm::vec3(0.0f);
 
-			//and finish by rendering the mesh
-			renderer.Render(transform.GetGlobal(), vp);
-		});
+		TTN_MorphAnimation& anim = Get<TTN_MorphAnimator>(entity).getActiveAnimRef();
+		return glm::vec3((float)anim.getCurrentMeshIndex(), (float)anim.getNextMeshIndex(), anim.getInterpolationParameter());
+	}
 
-		//2D sprite rendering
-		//make a vector to store all the entities to render
-		std::vector<entt::entity> tempSpriteEntitiesToRender = std::vector<entt::entity>();
-		//go through every entity with a 2d renderer and a transform, addding them to the list of entities to render
-		auto render2DView = m_Registry->view<TTN_Transform, TTN_Renderer2D>();
-		for (entt::entity entity : render2DView) {
-			tempSpriteEntitiesToRender.push_back(entity);
-		}
+	//binds a mesh's packed morph frames
+	bool TTN_Scene::BindMorphFrames(TTN_Shader* shader, TTN_Mesh* mesh)
+	{
+		if (shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::VERT_MORPH_ANIMATION_NO_COLOR
+			&& shader->GetVertexShaderDefaultStatus() != (int)TTN_DefaultShaders::VERT_MORPH_ANIMATION_COLOR)
+			return false;
 
-		//sort the entities by their z positions
-		mergeSortEntitiesZ(tempSpriteEntitiesToRender, 0, tempSpriteEntitiesToRender.size() - 1);
+		//the shader finds each vertex in the buffer from the frame and the number of vertices in each frame
+		const TTN_ShaderStorageBuffer::sssbptr& morphBuffer = mesh->GetMorphBuffer();
+		if (morphBuffer != nullptr)
+			morphBuffer->BindBase(TTN_Mesh::s_morphBufferBinding);
+		shader->SetUniform(s_uniformMorphVertexCount, mesh->GetVertCount());
 
-		//and loop through, rendering them in reverse order
-		for (int i = tempSpriteEntitiesToRender.size() - 1; i >= 0; i--) 
-			Get<TTN_Renderer2D>(tempSpriteEntitiesToRender[i]).Render(Get<TTN_Transform>(tempSpriteEntitiesToRender[i]).GetGlobal(), vp);
+		return true;
 	}
 
 	//sets wheter or not the scene should be rendered
@@ -511,51 +552,29 @@ namespace Titan {
 		return glm::vec3((float)grav.getX(), (float)grav.getY(), (float)grav.getZ());
 	}
 
-	//makes all the collision objects by going through all the overalapping manifolds in bullet
-	//based on code from https://andysomogyi.github.io/mechanica/bullet.html specfically the first block in the bullet callbacks and triggers section
-	void TTN_Scene::ConstructCollisions()
+	//casts a batch of rays against the physics world
+	void TTN_Scene::Raycast(TTN_Span<const TTN_RaycastQuery> queries, TTN_Span<TTN_QueryHit> hits)
 	{
-		//clear all the collisions from the previous frame
-		collisions.clear();
+		TTN_PhysicsQueries::Raycast(static_cast<btDbvtBroadphase*>(overlappingPairCache), queries, hits);
+	}
 
-		int numManifolds = m_physicsWorld->getDispatcher()->getNumManifolds();
-		//iterate through all the manifolds
-		for (int i = 0; i < numManifolds; i++) {
-			//get the contact manifolds and both objects
-			btPersistentManifold* contactManifold = m_physicsWorld->getDispatcher()->getManifoldByIndexInternal(i);
+	//casts a single ray against the physics world
+	TTN_QueryHit TTN_Scene::Raycast(const TTN_RaycastQuery& query)
+	{
+		TTN_QueryHit hit;
+		Raycast(TTN_Span<const TTN_RaycastQuery>(&query, 1), TTN_Span<TTN_QueryHit>(&hit, 1));
+		return hit;
+	}
 
-			const btCollisionObject* obj0 = contactManifold->getBody0();
-			const btCollisionObject* obj1 = contactManifold->getBody1();
+	//sweeps a batch of convex shapes through the physics world
+	void TTN_Scene::Sweep(TTN_Span<const TTN_SweepQuery> queries, TTN_Span<TTN_QueryHit> hits)
+	{
+		TTN_PhysicsQueries::Sweep(static_cast<btDbvtBroadphase*>(overlappingPairCache), queries, hits);
+	}
 
-			//iterate through all the contact points
-			int numOfContacts = contactManifold->getNumContacts();
-			for (int j = 0; j < numOfContacts; j++)
-			{
-				//get the contact point
-				btManifoldPoint& point = contactManifold->getContactPoint(j);
-				//if it's within the contact point distance
-				if (point.getDistance() < 0.f) {
-					//get the rigid bodies
-					const btRigidBody* b0 = btRigidBody::upcast(obj0);
-					const btRigidBody* b1 = btRigidBody::upcast(obj1);
-
-					//and make a collision object
-					TTN_Collision::scolptr newCollision = TTN_Collision::Create();
-					newCollision->SetBody1(static_cast<entt::entity>(reinterpret_cast<uint32_t>(b0->getUserPointer())));
-					newCollision->SetBody2(static_cast<entt::entity>(reinterpret_cast<uint32_t>(b1->getUserPointer())));
-
-					//compare it to all the previous collisions
-					bool shouldAdd = true;
-					for (int k = 0; k < collisions.size(); k++) {
-						if (TTN_Collision::same(newCollision, collisions[k])) {
-							shouldAdd = false;
-							break;
-						}
-					}
-					//if it's a new collision then add to the list of collisions
-					if (shouldAdd) collisions.push_back(newCollision);
-				}
-			}
-		}
+	//finds the entities a batch of convex shapes overlap
+	void TTN_Scene::Overlap(TTN_Span<const TTN_OverlapQuery> queries, TTN_Span<entt::entity> results, size_t maxResultsPerQuery, TTN_Span<uint32_t> resultCounts)
+	{
+		TTN_PhysicsQueries::Overlap(static_cast<btDbvtBroadphase*>(overlappingPairCache), queries, results, maxResultsPerQuery, resultCounts);
 	}
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 namespace Titan {
 	//default constructor, makes an empty shader program
 	TTN_Shader::TTN_Shader() :
-		_vs(0), _fs(0), _handle(0)
+		_vs(0), _fs(0), _cs(0), _handle(0)
 	{
 		_handle = glCreateProgram();
 		setDefault = false;
@@ -36,7 +36,7 @@ namespace Titan {
 			//if it's not, then mark the shader as custom
 			if (shaderType == GL_VERTEX_SHADER)
 				vertexShaderTTNIndentity = 0;
-			else
+			else if (shaderType == GL_FRAGMENT_SHADER)
 				fragShaderTTNIdentity = 0;
 		}
 
@@ -83,6 +83,9 @@ namespace Titan {
 		case GL_FRAGMENT_SHADER: //if it's a fragment shader, set the vertex shader variable
 			_fs = handle;
 			break;
+		case GL_COMPUTE_SHADER: //if it's a compute shader, set the compute shader variable
+			_cs = handle;
+			break;
 		default: //if it is anything else, log a warning that that type of shader has not been implemented with this shader program
 			LOG_WARN("Shader type not implemented");
 			break;
@@ -204,21 +207,36 @@ namespace Titan {
 
 	bool TTN_Shader::Link()
 	{
-		//if the program doesn't have both a vertex and a fragment shader log an error
-		LOG_ASSERT(_vs != 0 && _fs != 0, "Both a vertex and fragment shader need to be attached to the shader program.");
+		//if the program doesn't have both a vertex and a fragment shader, or a compute shader, log an error
+		LOG_ASSERT((_vs != 0 && _fs != 0) || _cs != 0, "Both a vertex and fragment shader, or a compute shader, need to be attached to the shader program.");
 
-		//Attach our shaders
-		glAttachShader(_handle, _vs);
-		glAttachShader(_handle, _fs);
+		//compute shaders are linked on their own
+		if (_cs != 0) {
+			//Attach our shader
+			glAttachShader(_handle, _cs);
 
-		//Perform linking
-		glLinkProgram(_handle);
+			//Perform linking
+			glLinkProgram(_handle);
 
-		//Remove shader stages to save memory (because the shader program has now been compiled we no longer need them seperatedly)
-		glDetachShader(_handle, _vs);
-		glDeleteShader(_vs);
-		glDetachShader(_handle, _fs);
-		glDeleteShader(_fs);
+			//Remove the shader stage to save memory
+			glDetachShader(_handle, _cs);
+			glDeleteShader(_cs);
+			_cs = 0;
+		}
+		else {
+			//Attach our shaders
+			glAttachShader(_handle, _vs);
+			glAttachShader(_handle, _fs);
+
+			//Perform linking
+			glLinkProgram(_handle);
+
+			//Remove shader stages to save memory (because the shader program has now been compiled we no longer need them seperatedly)
+			glDetachShader(_handle, _vs);
+			glDeleteShader(_vs);
+			glDetachShader(_handle, _fs);
+			glDeleteShader(_fs);
+		}
 
 		//Setup a check to make sure the shader program compiled and linked correclty
 		GLint status = 0;
@@ -247,6 +265,10 @@ namespace Titan {
 			}
 		}
 
+		//if it linked, find all the uniforms so they can be set by id
+		if (status != GL_FALSE)
+			__ReflectUniforms();
+
 		//return wheter or not the link was sucessful
 		return status != GL_FALSE;
 	}
@@ -263,6 +285,13 @@ namespace Titan {
 		glUseProgram(0);
 	}
 
+	//bind a compute program and dispatch it
+	void TTN_Shader::Dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ)
+	{
+		glUseProgram(_handle);
+		glDispatchCompute(groupsX, groupsY, groupsZ);
+	}
+
 #pragma region Uniform_Setters
 	//set a uniform for a 3x3 matrix so it can be recieved by the shaders
 	void TTN_Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed)
@@ -373,4 +402,145 @@ namespace Titan {
 		//return the result
 		return result;
 	}
+
+	//finds all the active uniforms in the program
+	void TTN_Shader::__ReflectUniforms()
+	{
+		_uniformsById.clear();
+
+		GLint numOfUniforms = 0;
+		glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numOfUniforms);
+
+		const GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+		std::string name;
+		for (GLint i = 0; i < numOfUniforms; i++) {
+			GLint values[4];
+			glGetProgramResourceiv(_handle, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+
+			//uniforms in blocks don't have locations, they're set through the uniform buffers
+			if (values[3] == -1)
+				continue;
+
+			//read the name, arrays are reported with [0] on the end which gets dropped so they can be found by their base name
+			name.resize(values[0]);
+			glGetProgramResourceName(_handle, GL_UNIFORM, i, values[0], nullptr, name.data());
+			name.resize(strlen(name.c_str()));
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+				name.resize(name.size() - 3);
+
+			//save the uniform under it's id
+			int id = TTN_UniformId::Intern(name);
+			if (id >= (int)_uniformsById.size())
+				_uniformsById.resize(id + 1);
+			_uniformsById[id].location = values[3];
+			_uniformsById[id].type = (GLenum)values[1];
+			_uniformsById[id].arraySize = values[2];
+
+			//also seed the name cache so the string setters don't have to ask openGL
+			_uniformLocations[name] = values[3];
+		}
+	}
+
+#pragma region Uniform_Ids
+	//the interned names, kept in function statics so ids can safely be created during static initialization
+	static std::unordered_map<std::string, int>& __UniformIdLookup() {
+		static std::unordered_map<std::string, int> lookup;
+		return lookup;
+	}
+	static std::vector<std::string>& __UniformIdNames() {
+		static std::vector<std::string> names;
+		return names;
+	}
+
+	//interns a uniform name
+	int TTN_UniformId::Intern(const std::string& name)
+	{
+		auto& lookup = __UniformIdLookup();
+		auto it = lookup.find(name);
+		if (it != lookup.end())
+			return it->second;
+
+		//new names get the next index
+		int index = (int)__UniformIdNames().size();
+		__UniformIdNames().push_back(name);
+		lookup[name] = index;
+		return index;
+	}
+
+	//gets the number of interned names
+	size_t TTN_UniformId::GetCount()
+	{
+		return __UniformIdNames().size();
+	}
+
+	//gets the name of an id
+	const std::string& TTN_UniformId::GetName() const
+	{
+		static const std::string invalid = "";
+		return (m_index >= 0) ? __UniformIdNames()[m_index] : invalid;
+	}
+#pragma endregion Uniform_Ids
+
+#pragma region Uniform_Sets
+	//gets the size in bytes of a single value of an openGL uniform type
+	static size_t __UniformTypeSize(GLenum type)
+	{
+		switch (type) {
+		case GL_FLOAT: case GL_INT: case GL_BOOL: return 4;
+		case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2: return 8;
+		case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3: return 12;
+		case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: return 16;
+		case GL_FLOAT_MAT3: return 36;
+		case GL_FLOAT_MAT4: return 64;
+		//samplers and images are set with a single int
+		default: return 4;
+		}
+	}
+
+	//builds the set
+	TTN_UniformSet::TTN_UniformSet(const TTN_Shader::sshptr& shader, const std::vector<TTN_UniformId>& uniforms)
+		: m_shader(shader)
+	{
+		size_t offset = 0;
+		m_entries.reserve(uniforms.size());
+		for (const TTN_UniformId& id : uniforms) {
+			Entry entry;
+			entry.location = shader->GetUniformLocation(id);
+			entry.type = shader->GetUniformType(id);
+			entry.count = std::max(shader->GetUniformArraySize(id), 1);
+			entry.size = (entry.location != -1) ? __UniformTypeSize(entry.type) * entry.count : 0;
+			entry.offset = offset;
+			entry.dirty = false;
+			offset += entry.size;
+			m_entries.push_back(entry);
+		}
+		m_values.resize(offset, 0);
+	}
+
+	//sends the changed values to the shader
+	void TTN_UniformSet::Apply()
+	{
+		const GLuint program = m_shader->GetHandle();
+		for (Entry& entry : m_entries) {
+			if (!entry.dirty)
+				continue;
+			entry.dirty = false;
+
+			const void* value = m_values.data() + entry.offset;
+			switch (entry.type) {
+			case GL_FLOAT: glProgramUniform1fv(program, entry.location, entry.count, (const float*)value); break;
+			case GL_FLOAT_VEC2: glProgramUniform2fv(program, entry.location, entry.count, (const float*)value); break;
+			case GL_FLOAT_VEC3: glProgramUniform3fv(program, entry.location, entry.count, (const float*)value); break;
+			case GL_FLOAT_VEC4: glProgramUniform4fv(program, entry.location, entry.count, (const float*)value); break;
+			case GL_INT_VEC2: case GL_BOOL_VEC2: glProgramUniform2iv(program, entry.location, entry.count, (const int*)value); break;
+			case GL_INT_VEC3: case GL_BOOL_VEC3: glProgramUniform3iv(program, entry.location, entry.count, (const int*)value); break;
+			case GL_INT_VEC4: case GL_BOOL_VEC4: glProgramUniform4iv(program, entry.location, entry.count, (const int*)value); break;
+			case GL_FLOAT_MAT3: glProgramUniformMatrix3fv(program, entry.location, entry.count, false, (const float*)value); break;
+			case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(program, entry.location, entry.count, false, (const float*)value); break;
+			//ints, bools, and samplers
+			default: glProgramUniform1iv(program, entry.location, entry.count, (const int*)value); break;
+			}
+		}
+	}
+#pragma endregion Uniform_Sets
 }
\ No newline at end of file
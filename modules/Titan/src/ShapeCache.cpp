@@ -0,0 +1,299 @@
+//Titan Engine, by Atlas X Games
+// ShapeCache.cpp - source file for the class that creates and shares the collision shapes used by physics bodies
+
+//precompile header, this file uses fstream, filesystem, cstring, and Logging.h
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/ShapeCache.h"
+//bullet's convex hull simplifier
+#include <BulletCollision/CollisionShapes/btShapeHull.h>
+
+namespace Titan {
+	//the triangle data a bvh triangle mesh reads from, bullet doesn't copy it so it has to live as long as the shape does
+	struct TTN_TriangleMeshData {
+		//the vertex positions and triangle indices
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		//bullet's view of them
+		std::unique_ptr<btTriangleIndexVertexArray> meshInterface;
+		//the buffer a bvh loaded from a cache lives in, null if the bvh was built
+		void* bvhBuffer = nullptr;
+
+		~TTN_TriangleMeshData() {
+			if (bvhBuffer != nullptr)
+				btAlignedFree(bvhBuffer);
+		}
+	};
+
+	//the start of a bvh cache file, followed by the serialized bvh
+	struct TTN_BvhCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numOfVertices;
+		uint32_t numOfIndices;
+		//hash of the vertex and index data the bvh was built from
+		uint64_t dataHash;
+		uint32_t bvhSize;
+		uint32_t padding;
+	};
+
+	//the characters TTNB, marking the file as a titan bvh cache
+	static const uint32_t s_bvhCacheMagic = 0x424E5454;
+
+	//64 bit fnv-1a hash of a block of memory
+	static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	//hashes a key
+	size_t TTN_ShapeCache::ShapeKeyHash::operator()(const ShapeKey& key) const
+	{
+		uint64_t hash = HashBytes(&key.type, sizeof(key.type));
+		//-0 and 0 compare equal but have different bits, adding 0 turns -0 into 0 so they hash the same too
+		glm::vec3 dimensions = key.dimensions + glm::vec3(0.0f);
+		hash = HashBytes(&dimensions, sizeof(dimensions), hash);
+		hash = HashBytes(&key.mesh, sizeof(key.mesh), hash);
+		return (size_t)hash;
+	}
+
+	//looks up a shape
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::Find(const ShapeKey& key, const TTN_Mesh::smptr& mesh)
+	{
+		auto it = s_shapes.find(key);
+		if (it == s_shapes.end())
+			return nullptr;
+
+		//if it was made from a mesh, make sure it's still the same mesh
+		if (mesh != nullptr && it->second.mesh.lock() != mesh)
+			return nullptr;
+
+		return it->second.shape.lock();
+	}
+
+	//gets a box
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::GetBox(glm::vec3 halfExtents)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		ShapeKey key = { ShapeType::BOX, halfExtents, nullptr };
+		sshapeptr shape = Find(key, nullptr);
+		if (shape == nullptr) {
+			shape = sshapeptr(new btBoxShape(btVector3(halfExtents.x, halfExtents.y, halfExtents.z)));
+			s_shapes[key] = { shape, std::weak_ptr<TTN_Mesh>() };
+		}
+
+		return shape;
+	}
+
+	//gets a sphere
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::GetSphere(float radius)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		ShapeKey key = { ShapeType::SPHERE, glm::vec3(radius, 0.0f, 0.0f), nullptr };
+		sshapeptr shape = Find(key, nullptr);
+		if (shape == nullptr) {
+			shape = sshapeptr(new btSphereShape(radius));
+			s_shapes[key] = { shape, std::weak_ptr<TTN_Mesh>() };
+		}
+
+		return shape;
+	}
+
+	//gets a capsule
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::GetCapsule(float radius, float height)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		ShapeKey key = { ShapeType::CAPSULE, glm::vec3(radius, height, 0.0f), nullptr };
+		sshapeptr shape = Find(key, nullptr);
+		if (shape == nullptr) {
+			shape = sshapeptr(new btCapsuleShape(radius, height));
+			s_shapes[key] = { shape, std::weak_ptr<TTN_Mesh>() };
+		}
+
+		return shape;
+	}
+
+	//gets the convex hull around a mesh
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::GetConvexHull(const TTN_Mesh::smptr& mesh, glm::vec3 scale)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		ShapeKey key = { ShapeType::CONVEX_HULL, scale, mesh.get() };
+		sshapeptr shape = Find(key, mesh);
+		if (shape == nullptr) {
+			//build a hull around every vertex, and then simplify it down to the ones on the surface of the hull
+			std::vector<glm::vec3> positions = mesh->GetVertexPositions();
+			btConvexHullShape fullHull(reinterpret_cast<const btScalar*>(positions.data()), (int)positions.size(), sizeof(glm::vec3));
+			btShapeHull simplifiedHull(&fullHull);
+			simplifiedHull.buildHull(fullHull.getMargin());
+
+			btConvexHullShape* hull = new btConvexHullShape(reinterpret_cast<const btScalar*>(simplifiedHull.getVertexPointer()),
+				simplifiedHull.numVertices(), sizeof(btVector3));
+			hull->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+			hull->optimizeConvexHull();
+
+			shape = sshapeptr(hull);
+			s_shapes[key] = { shape, mesh };
+		}
+
+		return shape;
+	}
+
+	//builds the unscaled bvh triangle mesh for a mesh
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::BuildTriangleMesh(const TTN_Mesh::smptr& mesh, const std::string& bvhCacheFile)
+	{
+		//copy the triangles out of the mesh
+		std::shared_ptr<TTN_TriangleMeshData> data = std::make_shared<TTN_TriangleMeshData>();
+		data->positions = mesh->GetVertexPositions();
+		if (mesh->GetIsIndexed())
+			data->indices = mesh->GetIndices();
+		else {
+			data->indices.resize(data->positions.size() - data->positions.size() % 3);
+			for (size_t i = 0; i < data->indices.size(); i++)
+				data->indices[i] = (uint32_t)i;
+		}
+
+		if (data->indices.size() < 3) {
+			LOG_ERROR("Can't create a triangle mesh collider from a mesh with no triangles");
+			throw std::runtime_error("Can't create a triangle mesh collider from a mesh with no triangles");
+		}
+
+		data->meshInterface = std::make_unique<btTriangleIndexVertexArray>((int)(data->indices.size() / 3),
+			reinterpret_cast<int*>(data->indices.data()), (int)(3 * sizeof(uint32_t)), (int)data->positions.size(),
+			reinterpret_cast<btScalar*>(data->positions.data()), (int)sizeof(glm::vec3));
+
+		//hash the data so a cache built from a different version of the mesh isn't used
+		uint64_t dataHash = HashBytes(data->positions.data(), sizeof(glm::vec3) * data->positions.size());
+		dataHash = HashBytes(data->indices.data(), sizeof(uint32_t) * data->indices.size(), dataHash);
+
+		//try to load the bvh from the cache
+		btOptimizedBvh* bvh = nullptr;
+		if (!bvhCacheFile.empty()) {
+			std::ifstream file(bvhCacheFile, std::ios::binary);
+			TTN_BvhCacheHeader header;
+			if (file && file.read(reinterpret_cast<char*>(&header), sizeof(TTN_BvhCacheHeader))
+				&& header.magic == s_bvhCacheMagic && header.version == s_bvhCacheVersion && header.dataHash == dataHash
+				&& header.numOfVertices == data->positions.size() && header.numOfIndices == data->indices.size()) {
+				//the bvh is deserialized in place, so it needs to be read into an aligned buffer that lives as long as the shape
+				data->bvhBuffer = btAlignedAlloc(header.bvhSize, 16);
+				if (file.read(static_cast<char*>(data->bvhBuffer), header.bvhSize))
+					bvh = btOptimizedBvh::deSerializeInPlace(data->bvhBuffer, header.bvhSize, false);
+
+				if (bvh == nullptr) {
+					btAlignedFree(data->bvhBuffer);
+					data->bvhBuffer = nullptr;
+				}
+			}
+		}
+
+		btBvhTriangleMeshShape* triangleMesh = nullptr;
+		if (bvh != nullptr) {
+			//if it loaded, give it to the shape instead of building a new one
+			triangleMesh = new btBvhTriangleMeshShape(data->meshInterface.get(), true, false);
+			triangleMesh->setOptimizedBvh(bvh);
+		}
+		else {
+			//otherwise build it
+			triangleMesh = new btBvhTriangleMeshShape(data->meshInterface.get(), true, true);
+
+			//and save it, failing to write it isn't an error as it can always be built again
+			if (!bvhCacheFile.empty()) {
+				btOptimizedBvh* builtBvh = triangleMesh->getOptimizedBvh();
+				unsigned bvhSize = builtBvh->calculateSerializeBufferSize();
+				void* buffer = btAlignedAlloc(bvhSize, 16);
+				bool written = builtBvh->serializeInPlace(buffer, bvhSize, false);
+
+				//write to a temporary file first and move it over the cache at the end, so a crash midway never leaves a broken cache behind
+				std::string tempFileName = bvhCacheFile + ".tmp";
+				if (written) {
+					std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+					TTN_BvhCacheHeader header = { s_bvhCacheMagic, s_bvhCacheVersion, (uint32_t)data->positions.size(),
+						(uint32_t)data->indices.size(), dataHash, bvhSize, 0 };
+					file.write(reinterpret_cast<const char*>(&header), sizeof(TTN_BvhCacheHeader));
+					file.write(static_cast<const char*>(buffer), bvhSize);
+					written = (bool)file;
+				}
+				btAlignedFree(buffer);
+
+				std::error_code error;
+				if (written)
+					std::filesystem::rename(tempFileName, bvhCacheFile, error);
+				if (!written || error) {
+					LOG_WARN("Couldn't write the bvh cache {}.", bvhCacheFile);
+					std::filesystem::remove(tempFileName, error);
+				}
+			}
+		}
+
+		//the shape keeps the triangle data alive until it's deleted
+		return sshapeptr(triangleMesh, [data](btCollisionShape* shape) { delete shape; });
+	}
+
+	//gets a triangle mesh collider for a mesh
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::GetTriangleMesh(const TTN_Mesh::smptr& mesh, glm::vec3 scale, const std::string& bvhCacheFile)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+
+		//get the unscaled mesh, building it if it isn't cached
+		ShapeKey key = { ShapeType::TRIANGLE_MESH, glm::vec3(1.0f), mesh.get() };
+		sshapeptr triangleMesh = Find(key, mesh);
+		if (triangleMesh == nullptr) {
+			triangleMesh = BuildTriangleMesh(mesh, bvhCacheFile);
+			s_shapes[key] = { triangleMesh, mesh };
+		}
+
+		if (scale == glm::vec3(1.0f))
+			return triangleMesh;
+
+		//if it's scaled, wrap it in a scaled shape that shares it's bvh
+		ShapeKey scaledKey = { ShapeType::SCALED_TRIANGLE_MESH, scale, mesh.get() };
+		sshapeptr scaledMesh = Find(scaledKey, mesh);
+		if (scaledMesh == nullptr) {
+			btScaledBvhTriangleMeshShape* scaled = new btScaledBvhTriangleMeshShape(static_cast<btBvhTriangleMeshShape*>(triangleMesh.get()),
+				btVector3(scale.x, scale.y, scale.z));
+			//the scaled shape keeps the unscaled one alive until it's deleted
+			scaledMesh = sshapeptr(scaled, [triangleMesh](btCollisionShape* shape) { delete shape; });
+			s_shapes[scaledKey] = { scaledMesh, mesh };
+		}
+
+		return scaledMesh;
+	}
+
+	//creates a compound collider
+	TTN_ShapeCache::sshapeptr TTN_ShapeCache::CreateCompound(const std::vector<TTN_CompoundChild>& children)
+	{
+		btCompoundShape* compound = new btCompoundShape(true, (int)children.size());
+		for (const TTN_CompoundChild& child : children) {
+			btTransform offset;
+			offset.setOrigin(btVector3(child.position.x, child.position.y, child.position.z));
+			offset.setRotation(btQuaternion(child.rotation.x, child.rotation.y, child.rotation.z, child.rotation.w));
+			compound->addChildShape(offset, child.shape.get());
+		}
+
+		//the compound keeps it's children alive until it's deleted
+		return sshapeptr(compound, [children](btCollisionShape* shape) { delete shape; });
+	}
+
+	//removes the entries for deleted shapes
+	void TTN_ShapeCache::ClearExpired()
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for (auto it = s_shapes.begin(); it != s_shapes.end();) {
+			if (it->second.shape.expired())
+				it = s_shapes.erase(it);
+			else
+				it++;
+		}
+	}
+
+	//gets the number of entries in the cache
+	size_t TTN_ShapeCache::GetNumOfEntries()
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		return s_shapes.size();
+	}
+}
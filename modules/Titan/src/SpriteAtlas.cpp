@@ -0,0 +1,257 @@
+//Titan Engine, by Atlas X Games
+// SpriteAtlas.cpp - source file for the class that packs sprite textures into larger atlas textures at runtime so sprites can be batched
+
+//precompile header, this file uses vector, unordered_map, cstring, algorithm, and glad/glad.h
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/SpriteAtlas.h"
+
+namespace Titan {
+	//constructor
+	TTN_SpriteAtlas::TTN_SpriteAtlas(uint32_t pageSize, uint32_t maxSpriteSize, size_t maxPages)
+		: m_pageSize(pageSize), m_maxSpriteSize(std::min(maxSpriteSize, pageSize - s_padding * 2)), m_maxPages(maxPages),
+		m_nextBatchId(0), m_outOfSpace(false), m_reclaims(0)
+	{}
+
+	//gets the region for a texture
+	const TTN_AtlasRegion& TTN_SpriteAtlas::GetRegion(const TTN_Texture2D::st2dptr& texture)
+	{
+		//if the texture has been seen before (and it's the same texture, not a new one that was given the same address) and it hasn't
+		//changed since it was copied in (or missed out on a page that has since had space given back), use that
+		auto it = m_entries.find(texture.get());
+		if (it != m_entries.end() && it->second.texture.lock() == texture && it->second.generation == texture->GetGeneration()
+			&& !(it->second.outOfSpace && it->second.reclaims != m_reclaims))
+			return it->second.region;
+
+		//otherwise give back whatever space it had and pack it again
+		Entry& entry = m_entries[texture.get()];
+		Release(entry);
+		entry.texture = texture;
+		entry.generation = texture->GetGeneration();
+		Pack(texture, entry);
+		return entry.region;
+	}
+
+	//deletes every page and forgets every texture
+	void TTN_SpriteAtlas::Clear()
+	{
+		m_pages.clear();
+		m_entries.clear();
+	}
+
+	//lets the space given back since the last call be reused
+	void TTN_SpriteAtlas::ReclaimReleased()
+	{
+		//deleted textures only need looking for once the pages have filled up
+		if (m_outOfSpace) {
+			ReleaseExpired();
+			m_outOfSpace = false;
+		}
+
+		bool reclaimed = false;
+		for (Page& page : m_pages) {
+			reclaimed = reclaimed || !page.releasedBlocks.empty();
+			page.freeBlocks.insert(page.freeBlocks.end(), page.releasedBlocks.begin(), page.releasedBlocks.end());
+			page.releasedBlocks.clear();
+		}
+
+		//let the textures that missed out try again
+		if (reclaimed)
+			m_reclaims++;
+	}
+
+	//works out where a texture should go and copies it in
+	void TTN_SpriteAtlas::Pack(const TTN_Texture2D::st2dptr& texture, Entry& entry)
+	{
+		entry.region = TTN_AtlasRegion();
+		entry.page = -1;
+		entry.outOfSpace = false;
+
+		//textures that haven't been loaded can't be drawn
+		const uint32_t width = texture->GetWidth();
+		const uint32_t height = texture->GetHeight();
+		if (width == 0 || height == 0)
+			return;
+
+		//the pages only have one level, so textures with mipmaps keep them by being drawn on their own
+		GLint levels = 1;
+		glGetTextureParameteriv(texture->GetHandle(), GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+
+		//find a page with the same filtering that it fits in, making a new one if there's room for it
+		Block block = { 0, 0, 0, 0 };
+		int target = -1;
+		if (levels <= 1 && width <= m_maxSpriteSize && height <= m_maxSpriteSize) {
+			const Texture_Min_Filter minFilter = texture->GetMinFilter();
+			const bool nearestMin = minFilter == Texture_Min_Filter::Min_Nearest || minFilter == Texture_Min_Filter::NearestMipNearest
+				|| minFilter == Texture_Min_Filter::NearestMipLinear;
+			const bool nearestMag = texture->GetMagFilter() == Texture_Mag_Filter::Mag_Nearest;
+			const uint32_t paddedWidth = width + s_padding * 2;
+			const uint32_t paddedHeight = height + s_padding * 2;
+
+			target = AllocateInPages(nearestMin, nearestMag, paddedWidth, paddedHeight, block);
+
+			//if the pages are full, it'll try again once the space from deleted textures has been taken back
+			if (target == -1) {
+				entry.outOfSpace = true;
+				entry.reclaims = m_reclaims;
+				m_outOfSpace = true;
+			}
+		}
+
+		//if it couldn't be packed, it gets drawn from it's own texture
+		if (target == -1) {
+			entry.region.texture = texture.get();
+			entry.region.batchId = m_nextBatchId++;
+			return;
+		}
+
+		//otherwise copy it in and point the region at it
+		Page& page = m_pages[target];
+		CopyIntoPage(*texture, page, block.x, block.y);
+		const float pageSize = (float)m_pageSize;
+		entry.page = target;
+		entry.block = block;
+		entry.region.texture = page.texture.get();
+		entry.region.uvRect = glm::vec4((float)(block.x + s_padding) / pageSize, (float)(block.y + s_padding) / pageSize,
+			(float)width / pageSize, (float)height / pageSize);
+		entry.region.batchId = page.batchId;
+	}
+
+	//finds space for a block in any page with the given filtering
+	int TTN_SpriteAtlas::AllocateInPages(bool nearestMin, bool nearestMag, uint32_t width, uint32_t height, Block& block)
+	{
+		for (size_t i = 0; i < m_pages.size(); i++) {
+			Page& page = m_pages[i];
+			if (page.nearestMin == nearestMin && page.nearestMag == nearestMag && Allocate(page, width, height, block))
+				return (int)i;
+		}
+
+		if (m_pages.size() < m_maxPages) {
+			Page& page = AddPage(nearestMin, nearestMag);
+			if (Allocate(page, width, height, block))
+				return (int)m_pages.size() - 1;
+		}
+
+		return -1;
+	}
+
+	//gives an entry's block back to it's page
+	void TTN_SpriteAtlas::Release(Entry& entry)
+	{
+		if (entry.page != -1 && entry.page < (int)m_pages.size())
+			m_pages[entry.page].releasedBlocks.push_back(entry.block);
+		entry.page = -1;
+	}
+
+	//forgets every texture that has been deleted
+	void TTN_SpriteAtlas::ReleaseExpired()
+	{
+		for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+			if (it->second.texture.expired()) {
+				Release(it->second);
+				it = m_entries.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	//finds space for a block in a page
+	bool TTN_SpriteAtlas::Allocate(Page& page, uint32_t width, uint32_t height, Block& block)
+	{
+		//reuse a freed block if one is big enough, taking the smallest so big blocks are kept for big sprites
+		auto freeBlock = page.freeBlocks.end();
+		for (auto it = page.freeBlocks.begin(); it != page.freeBlocks.end(); it++) {
+			if (it->width >= width && it->height >= height
+				&& (freeBlock == page.freeBlocks.end() || it->width * it->height < freeBlock->width * freeBlock->height))
+				freeBlock = it;
+		}
+		if (freeBlock != page.freeBlocks.end()) {
+			block = *freeBlock;
+			*freeBlock = page.freeBlocks.back();
+			page.freeBlocks.pop_back();
+			return true;
+		}
+
+		//otherwise use the shortest shelf it fits on, so short sprites don't waste the space on tall shelves
+		Shelf* best = nullptr;
+		for (Shelf& shelf : page.shelves) {
+			if (shelf.height >= height && shelf.cursorX + width <= m_pageSize && (best == nullptr || shelf.height < best->height))
+				best = &shelf;
+		}
+
+		//if there isn't one, start a new shelf on top of the others
+		if (best == nullptr) {
+			if (page.nextShelfY + height > m_pageSize || width > m_pageSize)
+				return false;
+
+			page.shelves.push_back({ page.nextShelfY, height, 0 });
+			page.nextShelfY += height;
+			best = &page.shelves.back();
+		}
+
+		//the block takes the full height of the shelf, so all of it can be reused once it's freed
+		block = { best->cursorX, best->y, width, best->height };
+		best->cursorX += width;
+		return true;
+	}
+
+	//creates a new page
+	TTN_SpriteAtlas::Page& TTN_SpriteAtlas::AddPage(bool nearestMin, bool nearestMag)
+	{
+		//the sprites are drawn at about their own size so the pages don't need mipmaps, and they're clamped as the sprites are
+		//extruded rather than wrapped
+		TTN_Texture2DDesc desc;
+		desc.width = m_pageSize;
+		desc.height = m_pageSize;
+		desc.format = Texture_Internal_Format::RGBA8;
+		desc.horiWrapMode = Texture_Wrap_Mode::ClampToEdge;
+		desc.vertWrapMode = Texture_Wrap_Mode::ClampToEdge;
+		desc.minificationFilter = nearestMin ? Texture_Min_Filter::Min_Nearest : Texture_Min_Filter::Min_Linear;
+		desc.magnificationFilter = nearestMag ? Texture_Mag_Filter::Mag_Nearest : Texture_Mag_Filter::Mag_Linear;
+		desc.GenerateMipMaps = false;
+
+		Page page;
+		page.texture = std::make_shared<TTN_Texture2D>(desc);
+		page.nearestMin = nearestMin;
+		page.nearestMag = nearestMag;
+		page.batchId = m_nextBatchId++;
+		page.nextShelfY = 0;
+		m_pages.push_back(std::move(page));
+
+		LOG_INFO("Created sprite atlas page {} ({}x{})", m_pages.size() - 1, m_pageSize, m_pageSize);
+		return m_pages.back();
+	}
+
+	//copies a texture's pixels into a page
+	void TTN_SpriteAtlas::CopyIntoPage(const TTN_Texture2D& texture, const Page& page, uint32_t x, uint32_t y)
+	{
+		const uint32_t width = texture.GetWidth();
+		const uint32_t height = texture.GetHeight();
+		const uint32_t paddedWidth = width + s_padding * 2;
+		const uint32_t paddedHeight = height + s_padding * 2;
+
+		//read the texture back as rgba, opengl converts it from whatever format it's stored in
+		m_pixels.resize((size_t)width * height * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glGetTextureImage(texture.GetHandle(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)m_pixels.size(), m_pixels.data());
+
+		//copy it into the middle of the padded block, repeating the edge pixels out into the padding
+		m_paddedPixels.resize((size_t)paddedWidth * paddedHeight * 4);
+		for (uint32_t row = 0; row < paddedHeight; row++) {
+			const uint32_t sourceRow = std::min(row - std::min(row, s_padding), height - 1);
+			const uint8_t* source = m_pixels.data() + (size_t)sourceRow * width * 4;
+			uint8_t* dest = m_paddedPixels.data() + (size_t)row * paddedWidth * 4;
+
+			for (uint32_t i = 0; i < s_padding; i++) {
+				memcpy(dest + i * 4, source, 4);
+				memcpy(dest + (s_padding + width + i) * 4, source + (width - 1) * 4, 4);
+			}
+			memcpy(dest + s_padding * 4, source, (size_t)width * 4);
+		}
+
+		//and upload it to the page
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTextureSubImage2D(page.texture->GetHandle(), 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, m_paddedPixels.data());
+	}
+}
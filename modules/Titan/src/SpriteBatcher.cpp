@@ -0,0 +1,208 @@
+//Titan Engine, by Atlas X Games
+// SpriteBatcher.cpp - source file for the class that sorts sprites and draws them in batches
+
+//precompile header, this file uses vector, cstring, algorithm, and glad/glad.h
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/SpriteBatcher.h"
+
+namespace Titan {
+	//uniform ids used by this file, interned once so setting them doesn't need to look up the names
+	static const TTN_UniformId s_uniformVP("u_VP");
+
+	//turns a float into an unsigned int that sorts in the same order
+	static inline uint32_t SortableFloat(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+		//negative numbers have all their bits flipped so bigger magnitudes come first, positive ones just have the sign bit set
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	//constructor
+	TTN_SpriteBatcher::TTN_SpriteBatcher(size_t maxQuadsPerBatch)
+		: m_VP(1.0f), m_maxQuads(std::max(maxQuadsPerBatch, (size_t)1)), m_numOfDrawCalls(0)
+	{
+		m_atlas = TTN_SpriteAtlas::Create();
+
+		//every quad uses the same pattern of indices, so the index buffer only needs to be made once
+		std::vector<uint32_t> indices = std::vector<uint32_t>(m_maxQuads * 6);
+		for (uint32_t i = 0; i < (uint32_t)m_maxQuads; i++) {
+			const uint32_t first = i * 4;
+			//top left, bottom right, bottom left, then top left, top right, bottom right, the same winding as the old unit quad
+			indices[i * 6 + 0] = first + 3;
+			indices[i * 6 + 1] = first + 1;
+			indices[i * 6 + 2] = first + 0;
+			indices[i * 6 + 3] = first + 3;
+			indices[i * 6 + 4] = first + 2;
+			indices[i * 6 + 5] = first + 1;
+		}
+		m_ibo = TTN_IndexBuffer::Create();
+		m_ibo->LoadData(indices.data(), indices.size());
+
+		//the vertices are rewritten every frame so they go in a streaming buffer
+		m_vbo = TTN_VertexBuffer::CreateStreaming(sizeof(SpriteVertex), m_maxQuads * 4);
+
+		const GLsizei stride = sizeof(SpriteVertex);
+		m_vao = TTN_VertexArrayObject::Create();
+		m_vao->SetIndexBuffer(m_ibo);
+		m_vao->AddVertexBuffer(m_vbo, {
+			BufferAttribute(0, 3, GL_FLOAT, false, stride, offsetof(SpriteVertex, position), AttribUsage::Position),
+			BufferAttribute(1, 2, GL_FLOAT, false, stride, offsetof(SpriteVertex, uv), AttribUsage::Texture),
+			BufferAttribute(2, 4, GL_FLOAT, false, stride, offsetof(SpriteVertex, color), AttribUsage::Color)
+		});
+
+		//create and load the shader program
+		m_shader = TTN_Shader::Create();
+		m_shader->LoadShaderStageFromFile("shaders/ttn_sprite_vert.glsl", GL_VERTEX_SHADER);
+		m_shader->LoadShaderStageFromFile("shaders/ttn_sprite_frag.glsl", GL_FRAGMENT_SHADER);
+		m_shader->Link();
+	}
+
+	//starts a new set of sprites
+	void TTN_SpriteBatcher::Begin(const glm::mat4& VP)
+	{
+		m_VP = VP;
+		m_sprites.clear();
+		m_keys.clear();
+		//last set's sprites have been drawn, so any atlas space they gave up can be reused now
+		m_atlas->ReclaimReleased();
+	}
+
+	//adds a sprite
+	void TTN_SpriteBatcher::Submit(const TTN_Texture2D::st2dptr& texture, const glm::mat4& model, const glm::vec4& color)
+	{
+		//make sure there's acutally a sprite to draw
+		if (texture == nullptr)
+			return;
+		const TTN_AtlasRegion& region = m_atlas->GetRegion(texture);
+		if (region.texture == nullptr)
+			return;
+
+		Sprite sprite;
+		sprite.origin = glm::vec3(model[3]);
+		sprite.right = glm::vec3(model[0]);
+		sprite.up = glm::vec3(model[1]);
+		sprite.color = color;
+		sprite.uvRect = region.uvRect;
+		sprite.texture = region.texture;
+		m_sprites.push_back(sprite);
+
+		//sprites are drawn from the largest z to the smallest, so the z is flipped to make the largest come first, and sprites at the
+		//same depth are grouped by the texture they're on so they can be drawn together
+		const uint64_t depth = ~SortableFloat(sprite.origin.z);
+		m_keys.push_back((depth << 32) | region.batchId);
+	}
+
+	//sorts the sprites with an lsd radix sort, a byte at a time
+	void TTN_SpriteBatcher::SortSprites()
+	{
+		const uint32_t count = (uint32_t)m_sprites.size();
+		m_order.resize(count);
+		m_orderScratch.resize(count);
+		m_keysScratch.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+			m_order[i] = i;
+
+		//count how many keys have each value of each byte in a single pass
+		uint32_t histograms[8][256];
+		memset(histograms, 0, sizeof(histograms));
+		for (uint64_t key : m_keys) {
+			for (int byte = 0; byte < 8; byte++)
+				histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+		}
+
+		uint64_t* keys = m_keys.data();
+		uint64_t* keysScratch = m_keysScratch.data();
+		uint32_t* order = m_order.data();
+		uint32_t* orderScratch = m_orderScratch.data();
+
+		for (int byte = 0; byte < 8; byte++) {
+			uint32_t* histogram = histograms[byte];
+			const int shift = byte * 8;
+
+			//if every key has the same value for this byte (like the high bytes of the batch ids usually do) the pass wouldn't change anything
+			if (histogram[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			//turn the counts into where each value starts
+			uint32_t offset = 0;
+			for (int i = 0; i < 256; i++) {
+				const uint32_t valueCount = histogram[i];
+				histogram[i] = offset;
+				offset += valueCount;
+			}
+
+			//and scatter the keys into place, keeping the order of equal keys
+			for (uint32_t i = 0; i < count; i++) {
+				const uint32_t dest = histogram[(keys[i] >> shift) & 0xFF]++;
+				keysScratch[dest] = keys[i];
+				orderScratch[dest] = order[i];
+			}
+
+			std::swap(keys, keysScratch);
+			std::swap(order, orderScratch);
+		}
+
+		//if the sorted order ended up in the scratch space swap it into place
+		if (order != m_order.data()) {
+			m_order.swap(m_orderScratch);
+			m_keys.swap(m_keysScratch);
+		}
+	}
+
+	//sorts and draws the sprites
+	void TTN_SpriteBatcher::End()
+	{
+		m_numOfDrawCalls = 0;
+		if (m_sprites.empty())
+			return;
+
+		SortSprites();
+
+		//bind the sprite shader and send the camera
+		m_shader->Bind();
+		m_shader->SetUniformMatrix(s_uniformVP, m_VP);
+
+		//stream the sprites through the vertex buffer as many quads at a time as it can hold
+		const size_t count = m_sprites.size();
+		for (size_t batchStart = 0; batchStart < count; batchStart += m_maxQuads) {
+			const size_t batchSize = std::min(count - batchStart, m_maxQuads);
+
+			//write the quads, transformed into world space so they can all be drawn with the same uniforms
+			SpriteVertex* vertices = m_vbo->BeginWrite<SpriteVertex>();
+			for (size_t i = 0; i < batchSize; i++) {
+				const Sprite& sprite = m_sprites[m_order[batchStart + i]];
+				const glm::vec3 halfRight = sprite.right * 0.5f;
+				const glm::vec3 halfUp = sprite.up * 0.5f;
+				const glm::vec2 uvMin = glm::vec2(sprite.uvRect.x, sprite.uvRect.y);
+				const glm::vec2 uvMax = uvMin + glm::vec2(sprite.uvRect.z, sprite.uvRect.w);
+
+				SpriteVertex* quad = vertices + i * 4;
+				//bottom left, bottom right, top right, top left
+				quad[0] = { sprite.origin - halfRight - halfUp, uvMin, sprite.color };
+				quad[1] = { sprite.origin + halfRight - halfUp, glm::vec2(uvMax.x, uvMin.y), sprite.color };
+				quad[2] = { sprite.origin + halfRight + halfUp, uvMax, sprite.color };
+				quad[3] = { sprite.origin - halfRight + halfUp, glm::vec2(uvMin.x, uvMax.y), sprite.color };
+			}
+			m_vbo->EndWrite(batchSize * 4);
+
+			//draw each run of sprites that shares a texture together
+			size_t runStart = 0;
+			for (size_t i = 1; i <= batchSize; i++) {
+				const TTN_Texture2D* texture = m_sprites[m_order[batchStart + runStart]].texture;
+				if (i < batchSize && m_sprites[m_order[batchStart + i]].texture == texture)
+					continue;
+
+				texture->Bind(0);
+				m_vao->RenderRange(runStart * 6, (i - runStart) * 6);
+				m_numOfDrawCalls++;
+				runStart = i;
+			}
+		}
+
+		m_shader->UnBind();
+		m_sprites.clear();
+		m_keys.clear();
+	}
+}
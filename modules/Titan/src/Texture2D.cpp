@@ -30,8 +30,7 @@ namespace Titan {
 		int width, height, numChannels;
 		const int targetChannels = forceRgba ? 4 : 0;
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(flipped);
+		// Use STBI to load the image, stb's flip setting is global (not per thread) so the image gets flipped after it's been loaded instead
 		uint8_t* data = stbi_load(file.c_str(), &width, &height, &numChannels, targetChannels);
 
 		// If we could not load any data, warn and return null
@@ -80,6 +79,8 @@ namespace Titan {
 		// Note that stbi will always give us an array of unsigned bytes (uint8_t)
 		TTN_Texture2DData::st2ddptr result = std::make_shared<TTN_Texture2DData>(width, height, image_format, Texture_Pixel_Data_Type::UByte, data, internal_format);
 		result->DebugName = std::filesystem::path(file).filename().string();
+		if (flipped)
+			result->FlipVertically();
 
 		// We now have a copy in our ptr, we can free STBI's copy of it
 		stbi_image_free(data);
@@ -87,6 +88,24 @@ namespace Titan {
 		return result;
 	}
 
+	//flips the rows of the image
+	void TTN_Texture2DData::FlipVertically()
+	{
+		const size_t rowSize = _dataSize / _height;
+		uint8_t* top = static_cast<uint8_t*>(_data);
+		uint8_t* bottom = top + rowSize * (_height - 1);
+		std::vector<uint8_t> temp(rowSize);
+
+		//swap the rows from the outside in
+		while (top < bottom) {
+			memcpy(temp.data(), top, rowSize);
+			memcpy(top, bottom, rowSize);
+			memcpy(bottom, temp.data(), rowSize);
+			top += rowSize;
+			bottom -= rowSize;
+		}
+	}
+
 	//default constructor
 	TTN_Texture2D::TTN_Texture2D()
 		: TTN_ITexture()
@@ -111,7 +130,7 @@ namespace Titan {
 		return result;
 	}
 
-	void TTN_Texture2D::LoadData(const TTN_Texture2DData::st2ddptr& data)
+	void TTN_Texture2D::LoadData(const TTN_Texture2DData::st2ddptr& data, TTN_PixelUnpackBuffer* stagingBuffer)
 	{
 		if (m_data.width != data->GetWidth() ||
 			m_data.height != data->GetHeight())
@@ -130,9 +149,17 @@ namespace Titan {
 		// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 		int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
 		glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+		// If it fits in the staging buffer, copy it there so the upload reads from the buffer (the pointer becomes an offset into it)
+		const void* pixels = data->GetDataPtr();
+		size_t stagingOffset = 0;
+		bool staged = stagingBuffer != nullptr && stagingBuffer->Stage(pixels, data->GetDataSize(), stagingOffset);
+		if (staged)
+			pixels = reinterpret_cast<const void*>(stagingOffset);
 		// Upload our data to our image
 		glTextureSubImage2D(_handle, 0, 0, 0, m_data.width, m_data.height, data->GetFormat(),
-			data->GetPixelType(), data->GetDataPtr());
+			data->GetPixelType(), pixels);
+		if (staged)
+			stagingBuffer->FinishUpload();
 
 		// We can get better error logs by attaching an object label!
 		if (!data->DebugName.empty()) {
@@ -143,12 +170,15 @@ namespace Titan {
 		if (m_data.GenerateMipMaps) {
 			glGenerateTextureMipmap(_handle);
 		}
+
+		m_generation++;
 	}
 
 	//sets the minification filter
 	void TTN_Texture2D::SetMinFilter(Texture_Min_Filter filter)
 	{
 		m_data.minificationFilter = filter;
+		m_generation++;
 		if (_handle != 0)
 			glTextureParameteri(_handle, GL_TEXTURE_MIN_FILTER, (GLenum)m_data.minificationFilter);
 	}
@@ -157,6 +187,7 @@ namespace Titan {
 	void TTN_Texture2D::SetMagFilter(Texture_Mag_Filter filter)
 	{
 		m_data.magnificationFilter = filter;
+		m_generation++;
 		if (_handle != 0)
 			glTextureParameteri(_handle, GL_TEXTURE_MAG_FILTER, (GLenum)m_data.magnificationFilter);
 	}
@@ -192,6 +223,8 @@ namespace Titan {
 	//recreates the texture in openGL
 	void TTN_Texture2D::RecreateTexture()
 	{
+		m_generation++;
+
 		if (_handle != 0) {
 			glDeleteTextures(1, &_handle);
 			_handle = 0;
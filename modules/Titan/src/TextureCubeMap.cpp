@@ -108,7 +108,7 @@ namespace Titan {
 	}
 
 	//loads from data
-	void TTN_TextureCubeMap::LoadData(const TTN_TextureCubeMapData::stcmdptr& data)
+	void TTN_TextureCubeMap::LoadData(const TTN_TextureCubeMapData::stcmdptr& data, TTN_PixelUnpackBuffer* stagingBuffer)
 	{
 		if (m_data.Size != data->GetSize()) {
 			m_data.Size = data->GetSize();
@@ -127,8 +127,16 @@ namespace Titan {
 		// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
 		int componentSize = (GLint)GetTexelComponentSize(data->GetPixelType());
 		glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+		// If it fits in the staging buffer, copy it there so the upload reads from the buffer (the pointer becomes an offset into it)
+		const void* pixels = data->GetDataPtr();
+		size_t stagingOffset = 0;
+		bool staged = stagingBuffer != nullptr && stagingBuffer->Stage(pixels, data->GetDataSize(), stagingOffset);
+		if (staged)
+			pixels = reinterpret_cast<const void*>(stagingOffset);
 		// Upload our data to our image
-		glTextureSubImage3D(_handle, 0, 0, 0, 0, m_data.Size, m_data.Size, 6, data->GetPixelFormat(), data->GetPixelType(), data->GetDataPtr());
+		glTextureSubImage3D(_handle, 0, 0, 0, 0, m_data.Size, m_data.Size, 6, data->GetPixelFormat(), data->GetPixelType(), pixels);
+		if (staged)
+			stagingBuffer->FinishUpload();
 
 		if (m_data.GenerateMipMaps) {
 			glGenerateTextureMipmap(_handle);
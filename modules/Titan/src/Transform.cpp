@@ -5,6 +5,8 @@
 
 // Transform.cpp - source file for the class that defines the transform component 
 #include "Titan/Transform.h"
+//include the transform system so changes can be passed onto it
+#include "Titan/TransformSystem.h"
 
 namespace Titan {
 	//default constructor, sets all of the variables to default values 
@@ -13,29 +15,53 @@ namespace Titan {
 		m_pos = glm::vec3(0.0f, 0.0f, 0.0f);
 		m_scale = glm::vec3(1.0f, 1.0f, 1.0f);
 		m_rotation = glm::quat(glm::radians(glm::vec3(0.0f, 0.0f, 0.0f)));
-		m_Parent = nullptr;
-		m_parentEntity = nullptr;
-		m_Children = std::vector<TTN_Transform*>();
+		m_parentEntity = entt::null;
+		m_system = nullptr;
+		m_slot = -1;
 		Recompute();
 	}
 
 	//constructor that takes all the data and makes a transform out of it
-	TTN_Transform::TTN_Transform(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale, TTN_Transform* parent, entt::entity* parentEntity)
+	TTN_Transform::TTN_Transform(glm::vec3 pos, glm::vec3 rotation, glm::vec3 scale, entt::entity parentEntity)
 	{
 		m_pos = pos;
 		m_rotation = glm::quat(glm::radians(rotation));
 		m_scale = scale;
 
-		m_Parent = parent;
 		m_parentEntity = parentEntity;
-		m_Children = std::vector<TTN_Transform*>();
+		m_system = nullptr;
+		m_slot = -1;
 
 		Recompute();
 	}
 
 	TTN_Transform::~TTN_Transform()
 	{
-		SetParent(nullptr, nullptr);
+	}
+
+	//copy constructor, copies all the data but not the place in the transform system (so the copy can't overwrite the original's slot)
+	TTN_Transform::TTN_Transform(const TTN_Transform& other)
+		: m_parentEntity(other.m_parentEntity), m_system(nullptr), m_slot(-1),
+		m_pos(other.m_pos), m_scale(other.m_scale), m_rotation(other.m_rotation),
+		m_transform(other.m_transform), m_global(other.m_global)
+	{
+	}
+
+	//copy assingment, copies all the data but keeps this transform's own place in the transform system
+	TTN_Transform& TTN_Transform::operator=(const TTN_Transform& other)
+	{
+		//if the parent changed the system needs to re-sort it's arrays
+		if (m_system != nullptr && m_parentEntity != other.m_parentEntity)
+			m_system->MarkHierarchyDirty();
+
+		m_parentEntity = other.m_parentEntity;
+		m_pos = other.m_pos;
+		m_scale = other.m_scale;
+		m_rotation = other.m_rotation;
+		m_global = other.m_global;
+		Recompute();
+
+		return *this;
 	}
 
 	//sets the position to the value passed in
@@ -64,25 +90,27 @@ namespace Titan {
 		Recompute();
 	}
 
-	//sets the transform that acts as this object's parent
-	void TTN_Transform::SetParent(TTN_Transform* parent, entt::entity* parentEntity)
+	//sets the position and rotation to the values passed in
+	void TTN_Transform::SetPosAndRotation(glm::vec3 pos, glm::quat rotationQuat)
 	{
-		//if this tranform already had a parent
-		if (m_Parent != nullptr) {
-			//remove this object from it's child list
-			m_Parent->RemoveChild(this);
-		}
+		//copy the position and rotation
+		m_pos = pos;
+		m_rotation = rotationQuat;
+		//recompute the matrix representing the overall transform
+		Recompute();
+	}
 
+	//sets the entity whose transform acts as this object's parent
+	void TTN_Transform::SetParent(entt::entity parentEntity)
+	{
 		//set the new parent
-		m_Parent = parent;
 		m_parentEntity = parentEntity;
 
-		if (m_Parent != nullptr) {
-			//add this object as a child of the new parent
-			m_Parent->AddChild(this);
-			Recompute();
-		}
+		//let the transform system know it needs to re-sort the hierarchy
+		if (m_system != nullptr)
+			m_system->MarkHierarchyDirty();
 
+		Recompute();
 	}
 
 	//returns the position value
@@ -119,12 +147,6 @@ namespace Titan {
 		return m_global;
 	}
 
-	//returns a pointer to this object's parent
-	TTN_Transform* TTN_Transform::GetParent()
-	{
-		return m_Parent;
-	}
-
 	void TTN_Transform::RotateRelative(glm::vec3 rotation)
 	{
 		m_rotation = m_rotation * glm::quat(glm::radians(rotation));
@@ -156,38 +178,15 @@ namespace Titan {
 			glm::toMat4(m_rotation) *
 			glm::scale(m_scale);
 
-		//check if the object has a parent
-		if (m_Parent != nullptr) {
-			//if it does then use it to caculate the global transformation matrix
-			m_global = m_Parent->GetGlobal() * m_transform;
-
-			//repeat on all the children (this is will do forward kinematics) 
-			for (int i = 0; i < m_Children.size(); i++) {
-				m_Children[i]->Recompute();
-			}
-		}
-		else {
-			//if it doesn't then the global and local transforms must be the same
+		//if the object doesn't have a parent then the global and local transforms must be the same
+		//if it does, the global transform gets calculated when the transform system resolves the hierarchy
+		if (m_parentEntity == entt::null) {
 			m_global = m_transform;
 		}
-	}
 
-	//adds a child to this object
-	void TTN_Transform::AddChild(TTN_Transform* child)
-	{
-		m_Children.push_back(child);
-	}
-
-	//removes a child from the object
-	void TTN_Transform::RemoveChild(TTN_Transform* child)
-	{
-		//go through all the children of the object
-		for (int i = 0; i < m_Children.size(); i++) {
-			//and check for the one that matches the given child
-			if (m_Children[i] == child) {
-				//when it's found erase it from the vector and break
-				m_Children.erase(m_Children.begin() + i);
-			}
+		//pass the new local matrix onto the transform system so it (and any children) get marked as dirty
+		if (m_system != nullptr && m_slot != -1) {
+			m_system->SetLocal(m_slot, m_transform);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+//Titan Engine, by Atlas X Games
+
+//precompile header, this file uses entt.hpp, vector, unordered_map, and algorithm
+#include "Titan/ttn_pch.h"
+// TransformSystem.cpp - source file for the class that resolves the transform hierarchy of a scene
+#include "Titan/TransformSystem.h"
+//include the transform component
+#include "Titan/Transform.h"
+
+namespace Titan {
+	//constructor, hooks the system into the registry's transform signals
+	TTN_TransformSystem::TTN_TransformSystem(entt::registry* registry)
+		: m_registry(registry), m_hierarchyDirty(true)
+	{
+		m_registry->on_construct<TTN_Transform>().connect<&TTN_TransformSystem::OnTransformConstructed>(*this);
+		m_registry->on_update<TTN_Transform>().connect<&TTN_TransformSystem::OnTransformConstructed>(*this);
+		m_registry->on_destroy<TTN_Transform>().connect<&TTN_TransformSystem::OnTransformDestroyed>(*this);
+
+		//pick up any transforms that were already in the registry
+		for (auto entity : m_registry->view<TTN_Transform>()) {
+			m_registry->get<TTN_Transform>(entity).m_system = this;
+			m_registry->get<TTN_Transform>(entity).m_slot = -1;
+		}
+	}
+
+	//destructor, unhooks the system from the registry and detaches all the transforms from it
+	TTN_TransformSystem::~TTN_TransformSystem()
+	{
+		m_registry->on_construct<TTN_Transform>().disconnect(*this);
+		m_registry->on_update<TTN_Transform>().disconnect(*this);
+		m_registry->on_destroy<TTN_Transform>().disconnect(*this);
+
+		for (auto entity : m_registry->view<TTN_Transform>()) {
+			m_registry->get<TTN_Transform>(entity).m_system = nullptr;
+			m_registry->get<TTN_Transform>(entity).m_slot = -1;
+		}
+	}
+
+	//copies a new local matrix into the arrays and marks the slot as dirty
+	void TTN_TransformSystem::SetLocal(int slot, const glm::mat4& local)
+	{
+		m_locals[slot] = local;
+		m_dirty[slot] = 1;
+	}
+
+	//resolves the global matrices of every dirty transform
+	void TTN_TransformSystem::Resolve()
+	{
+		//if the parenting has changed since the last resolve, re-sort the arrays first
+		if (m_hierarchyDirty)
+			Rebuild();
+
+		//parents always come before their children in the arrays, so by the time we reach any transform it's parent's global
+		//matrix is already final and one pass is enough to resolve the whole hierarchy
+		const size_t count = m_entities.size();
+		for (size_t i = 0; i < count; i++) {
+			const int parent = m_parents[i];
+
+			//if the parent moved then this transform moved too
+			if (parent != -1 && m_dirty[parent])
+				m_dirty[i] = 1;
+
+			//skip anything that hasn't changed
+			if (!m_dirty[i])
+				continue;
+
+			//calculate the global matrix
+			if (parent == -1)
+				m_globals[i] = m_locals[i];
+			else
+				m_globals[i] = m_globals[parent] * m_locals[i];
+
+			//and write it back into the component so GetGlobal returns it
+			m_registry->get<TTN_Transform>(m_entities[i]).m_global = m_globals[i];
+			m_moved.push_back(m_entities[i]);
+		}
+
+		//clear the dirty flags for the next frame
+		std::fill(m_dirty.begin(), m_dirty.end(), (uint8_t)0);
+	}
+
+	//rebuilds the depth sorted arrays from the registry
+	void TTN_TransformSystem::Rebuild()
+	{
+		auto transView = m_registry->view<TTN_Transform>();
+
+		//work out how deep every transform is in the hierarchy
+		std::unordered_map<entt::entity, int> depths;
+		depths.reserve(transView.size());
+		std::vector<std::pair<int, entt::entity>> order;
+		order.reserve(transView.size());
+		for (auto entity : transView) {
+			order.push_back(std::make_pair(CalculateDepth(entity, depths), entity));
+		}
+
+		//sort by depth so parents always come before their children
+		std::stable_sort(order.begin(), order.end(), [](const std::pair<int, entt::entity>& l, const std::pair<int, entt::entity>& r) {
+			return l.first < r.first;
+		});
+
+		//resize the arrays
+		const size_t count = order.size();
+		m_entities.resize(count);
+		m_parents.resize(count);
+		m_locals.resize(count);
+		m_globals.resize(count);
+		m_dirty.assign(count, (uint8_t)1);
+
+		//map of entities to their new slots, used to find the parent indices
+		std::unordered_map<entt::entity, int> slots;
+		slots.reserve(count);
+
+		//fill in the arrays
+		for (size_t i = 0; i < count; i++) {
+			entt::entity entity = order[i].second;
+			TTN_Transform& trans = m_registry->get<TTN_Transform>(entity);
+
+			m_entities[i] = entity;
+			m_locals[i] = trans.m_transform;
+			slots[entity] = (int)i;
+
+			//the parent is always already in the map because it has a lower depth
+			auto parentIt = slots.find(trans.m_parentEntity);
+			m_parents[i] = (trans.m_parentEntity != entt::null && parentIt != slots.end()) ? parentIt->second : -1;
+
+			//let the component know where it lives now
+			trans.m_system = this;
+			trans.m_slot = (int)i;
+		}
+
+		m_hierarchyDirty = false;
+	}
+
+	//gets how deep an entity is in the hierarchy, roots (and transforms whose parent no longer exists, or that are where a parenting
+	//loop gets broken) are at depth 0
+	int TTN_TransformSystem::CalculateDepth(entt::entity entity, std::unordered_map<entt::entity, int>& depths, int guard)
+	{
+		//check if we've already worked it out
+		auto it = depths.find(entity);
+		if (it != depths.end())
+			return it->second;
+
+		int depth = 0;
+		TTN_Transform& trans = m_registry->get<TTN_Transform>(entity);
+		entt::entity parent = trans.m_parentEntity;
+		//a parent that's been deleted (or lost it's transform) is never coming back, so the transform is made a root for good, which
+		//also means it's only warned about once
+		if (parent != entt::null && (!m_registry->valid(parent) || !m_registry->has<TTN_Transform>(parent))) {
+			LOG_WARN("Transform parent is not a valid entity with a transform, making it a root");
+			trans.m_parentEntity = entt::null;
+		}
+		//the guard stops a parenting loop from recursing forever, it's broken by treating the transform it reached as a root
+		else if (parent != entt::null && guard >= (int)m_registry->size<TTN_Transform>()) {
+			if (m_reportedLoops.insert(entity).second)
+				LOG_WARN("Transform parenting loop found, treating one of the transforms in it as a root");
+		}
+		//otherwise, this is one deeper than the parent
+		else if (parent != entt::null) {
+			depth = CalculateDepth(parent, depths, guard + 1) + 1;
+		}
+
+		depths[entity] = depth;
+		return depth;
+	}
+
+	//called by entt whenever a transform component is added or replaced
+	void TTN_TransformSystem::OnTransformConstructed(entt::registry& registry, entt::entity entity)
+	{
+		//attach the component to this system, it'll get a slot on the next rebuild
+		TTN_Transform& trans = registry.get<TTN_Transform>(entity);
+		trans.m_system = this;
+		trans.m_slot = -1;
+
+		m_hierarchyDirty = true;
+	}
+
+	//called by entt whenever a transform component is removed
+	void TTN_TransformSystem::OnTransformDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		//detach the component from the system so it doesn't write into a slot that's about to be reused
+		TTN_Transform& trans = registry.get<TTN_Transform>(entity);
+		trans.m_system = nullptr;
+		trans.m_slot = -1;
+		m_reportedLoops.erase(entity);
+
+		m_hierarchyDirty = true;
+	}
+}
@@ -9,7 +9,7 @@
 namespace Titan {
 	//default constructor, makes an empty VAO
 	TTN_VertexArrayObject::TTN_VertexArrayObject() :
-		_ibo(nullptr), _handle(0), _vertexCount(0)
+		_ibo(nullptr), _handle(0), _vertexCount(0), _hasStreamingVbos(false)
 	{
 		glCreateVertexArrays(1, &_handle);
 	}
@@ -68,6 +68,7 @@ namespace Titan {
 		binding.Attributes = attributes;
 		//add it to the vector of these structs stored in the VAO object
 		_vbos.push_back(binding);
+		_hasStreamingVbos = _hasStreamingVbos || vbo->IsStreaming();
 
 		//bind the VAO
 		Bind();
@@ -101,6 +102,7 @@ namespace Titan {
 		}
 		//get rid of the base vectors and the stored vbo pointers too
 		_vbos.clear();
+		_hasStreamingVbos = false;
 
 		//unbind the vao
 		UnBind();
@@ -123,6 +125,8 @@ namespace Titan {
 	{
 		//bind the VAO so we can use it
 		Bind();
+		//make sure any streaming buffers are reading from the right region
+		BindStreamingRegions();
 		//check if the VAO has an IBO bound to it 
 		if (_ibo != nullptr)
 			//if it does, then use the ibo to draw the triangles
@@ -130,24 +134,107 @@ namespace Titan {
 		else
 			//otherwise it must only have vbos, so use those vbos to draw the triangles
 			glDrawArrays(GL_TRIANGLES, 0, _vertexCount);
+		//mark the streaming regions as drawn so they get fenced before they're overwritten
+		MarkStreamingRegionsDrawn();
+		//unbind the VAO
+		UnBind();
+	}
+
+	//calls the openGL functions to acutally draw part of the triangles contained within the VAO
+	void TTN_VertexArrayObject::RenderRange(size_t first, size_t count) const
+	{
+		//bind the VAO so we can use it
+		Bind();
+		//make sure any streaming buffers are reading from the right region
+		BindStreamingRegions();
+		//check if the VAO has an IBO bound to it 
+		if (_ibo != nullptr) {
+			//if it does, then draw the range of indices, the offset into the ibo is in bytes
+			const size_t offset = first * _ibo->GetElementSize();
+			glDrawElements(GL_TRIANGLES, (GLsizei)count, _ibo->GetElementType(), reinterpret_cast<const void*>(offset));
+		}
+		else
+			//otherwise it must only have vbos, so draw the range of vertices
+			glDrawArrays(GL_TRIANGLES, (GLint)first, (GLsizei)count);
+		//mark the streaming regions as drawn so they get fenced before they're overwritten
+		MarkStreamingRegionsDrawn();
 		//unbind the VAO
 		UnBind();
 	}
 
 	//calls the openGL functions to acutally draw the triangles contained within the VAO, but does so with instancing
-	void TTN_VertexArrayObject::RenderInstanced(size_t numOfObjects, size_t numOfVerts) const
+	void TTN_VertexArrayObject::RenderInstanced(size_t numOfObjects, size_t numOfVerts, size_t baseInstance) const
 	{
 		//bind the VAO so we can use it
 		Bind();
+		//make sure any streaming buffers are reading from the right region
+		BindStreamingRegions();
 		//check if the VAO has an IBO bound to it 
 		if (_ibo != nullptr)
 			//if it does, then use the ibo to draw the triangles
-			glDrawElementsInstanced(GL_TRIANGLES, _ibo->GetElementCount(), _ibo->GetElementType(), nullptr, numOfObjects);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, _ibo->GetElementCount(), _ibo->GetElementType(), nullptr, numOfObjects, baseInstance);
 		else
 			//otherwise it must only have vbos, so use those vbos to draw the triangles
-			if(numOfVerts == 0) glDrawArraysInstanced(GL_TRIANGLES, 0, _vertexCount, numOfObjects);
-			else glDrawArraysInstanced(GL_TRIANGLES, 0, numOfVerts, numOfObjects);
+			if(numOfVerts == 0) glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, _vertexCount, numOfObjects, baseInstance);
+			else glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, numOfVerts, numOfObjects, baseInstance);
+		//mark the streaming regions as drawn so they get fenced before they're overwritten
+		MarkStreamingRegionsDrawn();
 		//unbind the VAO
 		UnBind();
 	}
+
+	//calls the openGL functions to acutally draw the triangles contained within the VAO, reading the draw parameters from a buffer
+	void TTN_VertexArrayObject::RenderIndirect(const TTN_IBuffer& commandBuffer, size_t offset) const
+	{
+		//bind the VAO so we can use it
+		Bind();
+		//make sure any streaming buffers are reading from the right region
+		BindStreamingRegions();
+		//bind the buffer with the draw command
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.GetHandle());
+		//check if the VAO has an IBO bound to it 
+		if (_ibo != nullptr)
+			//if it does, then use the ibo to draw the triangles
+			glDrawElementsIndirect(GL_TRIANGLES, _ibo->GetElementType(), (void*)offset);
+		else
+			//otherwise it must only have vbos, so use those vbos to draw the triangles
+			glDrawArraysIndirect(GL_TRIANGLES, (void*)offset);
+		//unbind the command buffer
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		//mark the streaming regions as drawn so they get fenced before they're overwritten
+		MarkStreamingRegionsDrawn();
+		//unbind the VAO
+		UnBind();
+	}
+
+	//points the attributes of the streaming vbos at their current regions, the VAO should already be bound
+	void TTN_VertexArrayObject::BindStreamingRegions() const
+	{
+		if (!_hasStreamingVbos)
+			return;
+
+		for (const VertexBufferBinding& binding : _vbos) {
+			if (!binding.vbo->IsStreaming())
+				continue;
+
+			//rather than reallocating the buffer each frame, the streaming buffers move between regions of the same buffer, so
+			//the attribute offsets just need to be moved to the region that was last written
+			binding.vbo->Bind();
+			for (const BufferAttribute& attrib : binding.Attributes)
+				glVertexAttribPointer(attrib.Slot, attrib.Size, attrib.Type, attrib.Normalized, attrib.Stride, (void*)(attrib.Offset + binding.vbo->GetCurrentOffset()));
+		}
+		TTN_VertexBuffer::UnBind();
+	}
+
+	//marks the current regions of the streaming vbos as drawn
+	void TTN_VertexArrayObject::MarkStreamingRegionsDrawn() const
+	{
+		if (!_hasStreamingVbos)
+			return;
+
+		for (const VertexBufferBinding& binding : _vbos) {
+			if (binding.vbo->IsStreaming())
+				binding.vbo->MarkCurrentRegionDrawn();
+		}
+	}
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+//Titan Engine, by Atlas X Games 
+// VertexBuffer.cpp - source file for the class that stores the buffer for vertices that we can render
+
+//precompile header, this file uses Logging.h and algorithm
+#include "Titan/ttn_pch.h"
+//include the header
+#include "Titan/VertexBuffer.h"
+//include memcpy
+#include <cstring>
+
+namespace Titan {
+	//constructor, creates a streaming vertex buffer
+	TTN_VertexBuffer::TTN_VertexBuffer(size_t elementSize, size_t maxElements, size_t numOfRegions)
+		: TTN_IBuffer(GL_ARRAY_BUFFER, GL_STREAM_DRAW), m_streaming(true), m_mappedData(nullptr),
+		m_maxElements(maxElements), m_numOfRegions(std::max(numOfRegions, (size_t)1)), m_currentRegion(0),
+		m_currentRegionDrawn(false)
+	{
+		_elementSize = elementSize;
+		_elementCount = 0;
+		m_fences.resize(m_numOfRegions, nullptr);
+
+		//allocate immutable storage for every region and map it for the whole lifetime of the buffer
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr totalSize = (GLsizeiptr)(m_numOfRegions * m_maxElements * _elementSize);
+		glNamedBufferStorage(_handle, std::max(totalSize, (GLsizeiptr)1), nullptr, flags);
+		m_mappedData = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, std::max(totalSize, (GLsizeiptr)1), flags));
+
+		//if it couldn't be mapped, throw an error
+		if (m_mappedData == nullptr) {
+			LOG_ERROR("Failed to persistently map streaming vertex buffer");
+			throw std::runtime_error("Failed to persistently map streaming vertex buffer");
+		}
+	}
+
+	//destructor, unmaps the buffer and deletes the fences (the base class deletes the buffer itself)
+	TTN_VertexBuffer::~TTN_VertexBuffer()
+	{
+		if (!m_streaming)
+			return;
+
+		for (GLsync& fence : m_fences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		if (m_mappedData != nullptr && _handle != 0) {
+			glUnmapNamedBuffer(_handle);
+			m_mappedData = nullptr;
+		}
+	}
+
+	//loads data into the buffer
+	void TTN_VertexBuffer::LoadData(const void* data, size_t elementSize, size_t elementCount)
+	{
+		//regular buffers just reallocate like any other buffer
+		if (!m_streaming) {
+			TTN_IBuffer::LoadData(data, elementSize, elementCount);
+			return;
+		}
+
+		//streaming buffers have a fixed element size and capacity
+		LOG_ASSERT(elementSize == _elementSize, "Element size does not match the size the streaming buffer was created with");
+		if (elementCount > m_maxElements) {
+			LOG_WARN("Streaming vertex buffer can only hold {} elements, {} were loaded, the rest will be dropped", m_maxElements, elementCount);
+			elementCount = m_maxElements;
+		}
+
+		//copy the data into the next region
+		void* region = BeginWrite();
+		memcpy(region, data, elementCount * _elementSize);
+		EndWrite(elementCount);
+	}
+
+	//moves onto the next region and returns a pointer to it
+	void* TTN_VertexBuffer::BeginWrite()
+	{
+		LOG_ASSERT(m_streaming, "BeginWrite can only be used on streaming vertex buffers");
+
+		//fence the region we're leaving, then move onto the next region and make sure the gpu isn't still reading from it
+		RetireCurrentRegion();
+		m_currentRegion = (m_currentRegion + 1) % m_numOfRegions;
+		WaitForRegion(m_currentRegion);
+
+		return m_mappedData + GetCurrentOffset();
+	}
+
+	//finishes writing to the current region
+	void TTN_VertexBuffer::EndWrite(size_t elementCount)
+	{
+		_elementCount = std::min(elementCount, m_maxElements);
+	}
+
+	//fences the current region as the buffer moves on from it
+	void TTN_VertexBuffer::RetireCurrentRegion()
+	{
+		//if nothing drew from the region the gpu has nothing to finish reading
+		if (!m_currentRegionDrawn)
+			return;
+
+		//every draw that reads the region was issued before this point, so one fence covers all of them
+		GLsync& fence = m_fences[m_currentRegion];
+		if (fence != nullptr)
+			glDeleteSync(fence);
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_currentRegionDrawn = false;
+	}
+
+	//waits for the gpu to be done with a region
+	void TTN_VertexBuffer::WaitForRegion(size_t region)
+	{
+		GLsync& fence = m_fences[region];
+		if (fence == nullptr)
+			return;
+
+		//wait in 1ms chunks, flushing on the first wait so the fence is guaranteed to eventually signal
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (true) {
+			GLenum result = glClientWaitSync(fence, waitFlags, 1000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+				break;
+			if (result == GL_WAIT_FAILED) {
+				LOG_ERROR("Waiting on a streaming vertex buffer fence failed");
+				break;
+			}
+			waitFlags = 0;
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
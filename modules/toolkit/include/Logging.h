@@ -3,6 +3,20 @@
 #include "spdlog/fmt/ostr.h"
 #include "spdlog/logger.h"
 
+// Log levels, these match spdlog's level enum
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF   6
+
+// Any log macro below this level is compiled out entirely (including its arguments), define
+// this before including Logging.h (or in the project settings) to strip the noisier levels
+#ifndef LOG_ACTIVE_LEVEL
+#define LOG_ACTIVE_LEVEL LOG_LEVEL_TRACE
+#endif
+
 class Logger {
 public:
 	struct LoggerSettings
@@ -10,8 +24,30 @@ public:
 		bool OutputToFile;
 		bool OutputToConsole;
 		std::string LogFileName;
+		/*
+			If true, messages are handed off to a queue and written by a background thread, so logging
+			never waits on the console or disk, and is safe from any thread
+		*/
+		bool Async;
+		// The number of messages the async queue can hold
+		size_t AsyncQueueSize;
+		/*
+			If true, logging blocks when the async queue is full. Otherwise the oldest queued messages
+			are dropped, so a burst of logging can never stall the caller
+		*/
+		bool BlockWhenFull;
+		/*
+			Identical messages logged back to back within this many seconds are collapsed into a
+			single "Skipped N duplicate messages" line. Set to 0 to log every message
+		*/
+		float DuplicateWindow;
+		// If true, messages are also written to a compact binary log (see Logging.cpp for the layout)
+		bool OutputToBinary;
+		std::string BinaryLogFileName;
 		LoggerSettings() :
-			OutputToFile(false), OutputToConsole(true), LogFileName("logs.txt") {}
+			OutputToFile(false), OutputToConsole(true), LogFileName("logs.txt"),
+			Async(true), AsyncQueueSize(8192), BlockWhenFull(false), DuplicateWindow(1.0f),
+			OutputToBinary(false), BinaryLogFileName("logs.bin") {}
 	};
 	/*
 		Initializes the logging subsystem, and sets up the color logger and debug trace utilities
@@ -23,6 +59,11 @@ public:
 	 */
 	static void Uninitialize();
 
+	/*
+		Blocks until every message logged so far has been written out
+	*/
+	static void Flush();
+
 	/*
 		Gets the logging instance
 	*/
@@ -35,13 +76,35 @@ public:
 private:
 	static std::shared_ptr<spdlog::logger> myLogger;
 	static bool isInitialized;
+	static bool isAsync;
 };
 
 // Client log macros
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_TRACE
 #define LOG_TRACE(...) ::Logger::GetLogger()->trace(__VA_ARGS__)
+#else
+#define LOG_TRACE(...) (void)0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_INFO
 #define LOG_INFO(...)  ::Logger::GetLogger()->info(__VA_ARGS__)
+#else
+#define LOG_INFO(...)  (void)0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_WARN
 #define LOG_WARN(...)  ::Logger::GetLogger()->warn(__VA_ARGS__)
-#define LOG_ERROR(...) { ::Logger::GetLogger()->error(__VA_ARGS__); ::Logger::GetLogger()->error("Location: \n{}", ::Logger::DumpStackTrace()); }
+#else
+#define LOG_WARN(...)  (void)0
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) { ::Logger::GetLogger()->error("{}\nLocation: \n{}", fmt::format(__VA_ARGS__), ::Logger::DumpStackTrace()); }
+#define LOG_ERROR(...) ::Logger::GetLogger()->error("{}\nLocation: \n{}", fmt::format(__VA_ARGS__), ::Logger::DumpStackTrace())
+#else
+#define LOG_ERROR(...) { }
+#endif
 
 // Allows us to assert if a value is true, and automagically debug break if it is false
-#define LOG_ASSERT(x, ...) { if (!(x)) { ::Logger::GetLogger()->error(__VA_ARGS__); __debugbreak(); } }
\ No newline at end of file
+// Asserts are never stripped, and flush the log so the message is out before we break
+#define LOG_ASSERT(x, ...) { if (!(x)) { ::Logger::GetLogger()->error(__VA_ARGS__); ::Logger::Flush(); __debugbreak(); } }
\ No newline at end of file
@@ -16,6 +16,9 @@
 #include "GLM/glm.hpp"
 #include "glad/glad.h"
 #include "stb_truetype.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace  TTK
 {
@@ -23,6 +26,7 @@ namespace  TTK
 		glm::vec2 Positions[4];
 		glm::vec2 UVs[4];
 		float OffsetX, OffsetY;
+		uint32_t Page;
 	};
 
 	/* TODO: Font alignment
@@ -45,32 +49,56 @@ namespace  TTK
 
 	class FontRenderer;
 	
+	/*
+	 * A TrueType font with a glyph atlas that fills in as text is drawn. Glyphs are rasterized the
+	 * first time they're used (any unicode code point the font has, not just ASCII), and when a page
+	 * of the atlas fills up, another page is added (the atlas is a 2D array texture, one layer per page)
+	 */
 	class TrueTypeTextureFont {
 	public:
 		TrueTypeTextureFont(const char* fileName, uint32_t size);
 		~TrueTypeTextureFont();
 		
-		GlyphInfo GetGlyph(int codePoint, float offsetX, float offsetY) const;
+		GlyphInfo GetGlyph(int codePoint, float offsetX, float offsetY);
 		float  GetKerning(int char1, int char2) const;
 		float  GetLineHeight() const;
 
 		virtual glm::vec2 MeausureString(const char* text, const float scale = 1.0f);
 
 		virtual GLint GetTexture() const { return myTexture; }
+		uint32_t GetPageCount() const { return myPageCount; }
 
 	protected:
 		friend class FontRenderer;
+
+		// Where a glyph sits in the atlas, and its quad relative to the pen position (in pixels)
+		struct PackedGlyph {
+			float X0, Y0, X1, Y1;
+			float S0, T0, S1, T1;
+			float Advance;
+			uint32_t Page;
+		};
+		const PackedGlyph& __GetPackedGlyph(uint32_t codePoint);
+		bool __AddPage();
+
 		GLuint   myTexture;
 		GLuint64 m_TexHandle;
 
 		const uint32_t ATLAS_WIDTH = 1024;
 		const uint32_t ATLAS_HEIGHT = 1024;
+		const uint32_t MAX_PAGES = 16;
+		const uint32_t GLYPH_PADDING = 1;
 		const uint32_t FONT_OVERSAMPLE_X = 2;
 		const uint32_t FONT_OVERSAMPLE_Y = 2;
 		const uint32_t FIRST_CHAR = ' ';
 		const uint32_t CHAR_COUNT = '~' - ' ';
 
-		stbtt_packedchar* myCharInfo;
+		std::unordered_map<uint32_t, PackedGlyph> myGlyphs;
+		uint32_t          myPageCount;
+		uint32_t          myShelfX,
+						  myShelfY,
+						  myShelfHeight;
+		unsigned char*    myFontData;
 		uint32_t          myFontSize;
 		stbtt_fontinfo    myFontInfo;
 		float             myPixelHeightScale;
@@ -80,6 +108,11 @@ namespace  TTK
 						  myLineGap;
 	};
 	
+	/*
+	 * Draws text for TTK. Each string is laid out once and cached (by its contents, font and scale),
+	 * so text that stays the same from frame to frame only needs its quads copied. All of the text
+	 * rendered in a frame is collected and drawn at Flush, with one draw call per font
+	 */
 	class FontRenderer {
 	public:
 		static FontRenderer& Instance() {
@@ -93,25 +126,73 @@ namespace  TTK
 		}
 
 	private:
+		friend class TrueTypeTextureFont;
 		static FontRenderer* m_Instance;
 
 		struct Vert {
 			glm::vec2 Position;
 			Col8      Color;
-			glm::vec2 UV;
+			glm::vec3 UV; // z is the atlas page
+		};
+
+		struct LayoutQuad {
+			glm::vec2 Positions[4];
+			glm::vec3 UVs[4];
+		};
+
+		struct CachedLayout {
+			std::string Text;
+			std::vector<LayoutQuad> Quads;
+			uint64_t LastUsed;
+		};
+
+		struct LayoutKey {
+			uint64_t Hash;
+			const TrueTypeTextureFont* Font;
+			float Scale;
+			bool operator==(const LayoutKey& other) const { return Hash == other.Hash && Font == other.Font && Scale == other.Scale; }
+		};
+
+		struct LayoutKeyHasher {
+			size_t operator()(const LayoutKey& key) const;
+		};
+
+		struct FontBatch {
+			TrueTypeTextureFont* Font;
+			std::vector<Vert> Verts;
 		};
 
 	public:
 		~FontRenderer();
 
-		void Render(const TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale = 1.0f);
+		void Render(TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale = 1.0f);
+
+		// Draws all of the text rendered since the last flush
+		void Flush();
 		
 	private:
 		FontRenderer();
+
+		const CachedLayout& __GetLayout(TrueTypeTextureFont& font, const char* text, size_t length, float scale);
+		void __EvictLayouts();
+		// Throws away the least recently used layouts, about count of them
+		void __EvictOldestLayouts(size_t count);
+		// Called when a font is destroyed, so we don't hold on to its layouts or batch
+		static void __ForgetFont(const TrueTypeTextureFont* font);
+
+		// How many flushes a layout can go unused before we throw it away
+		static const uint64_t LayoutLifetime = 120;
+		// How many layouts we keep at most, so text that changes every frame (timers, counters) can't grow the cache
+		// without bound between evictions
+		static const size_t MaxLayouts = 1024;
 				
 		GLuint   m_ShaderHandle;
 		GLuint   m_VAO, m_VBO, m_EBO;
-		Vert     m_MeshData[256 * 4];
-		GLuint   m_IndexData[256 * 6];
+		size_t   m_VertCapacity;
+		size_t   m_QuadCapacity;
+		uint64_t m_FrameIndex;
+
+		std::unordered_map<LayoutKey, CachedLayout, LayoutKeyHasher> m_Layouts;
+		std::vector<FontBatch> m_Batches;
 	};
 }
\ No newline at end of file
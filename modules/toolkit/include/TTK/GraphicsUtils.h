@@ -103,6 +103,13 @@ namespace TTK
 		 * @param colour The color of the line (rgba)
 		 */
 		static void DrawLine(float* p0, float* p1, float* colour = nullptr);
+		/*
+		 * Draws a batch of lines, much faster than calling DrawLine for each one
+		 * @param points Pairs of points, each pair is the start and end of a line
+		 * @param numPoints The number of points (twice the number of lines)
+		 * @param colour The color of the lines (rgba)
+		 */
+		static void DrawLines(const glm::vec3* points, size_t numPoints, const glm::vec4& colour = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
 		/*
 		 * Draws a vector, as a given point and direction
@@ -144,6 +151,14 @@ namespace TTK
 		// pointSize lets you specify the size of the point, in pixels (p0 is center of point)
 		static void DrawPoint(const glm::vec3& p0, float pointSize, const glm::vec4& colour = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 		static void DrawPoint(float *p0, float pointSize, float *colour = nullptr);
+		/*
+		 * Draws a batch of points, much faster than calling DrawPoint for each one
+		 * @param points The centers of the points
+		 * @param numPoints The number of points
+		 * @param pointSize The size of the points, in pixels
+		 * @param colour The color of the points (rgba)
+		 */
+		static void DrawPoints(const glm::vec3* points, size_t numPoints, float pointSize, const glm::vec4& colour = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 
 		// Description:
 		// Draws a cube at position p0 with the specified size
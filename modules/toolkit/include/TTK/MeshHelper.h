@@ -4,8 +4,8 @@
 // You may not use this header in your GDW games.
 //
 // This header contains a helper class for drawing the primitive types that
-// were originally supported by GLUT. This file was purposefully built to
-// be non-optimal
+// were originally supported by GLUT. Draw calls are recorded per mesh and
+// drawn as one instanced call per mesh when the context is flushed
 //
 // Based off of TTK by Michael Gharbharan 2017
 // Shawn Matthews 2019
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "TTKContext.h"
+#include <vector>
 
 namespace TTK {
 	namespace Impl {
@@ -21,20 +22,39 @@ namespace TTK {
 		public:
 			~MeshHelper();
 			MeshHelper();
-			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderSphere(const glm::mat4& transform, const glm::vec4& color) const;
-			void RenderCube(const glm::mat4& transform, const glm::vec4& color) const;
+			void RenderTeapot(const glm::mat4& transform, const glm::vec4& color);
+			void RenderSphere(const glm::mat4& transform, const glm::vec4& color);
+			void RenderCube(const glm::mat4& transform, const glm::vec4& color);
+
+			// Draws everything recorded since the last flush, one instanced draw per mesh
+			void Flush();
 			
 		private:
+			// What we store for each recorded draw, the view projection is baked in
+			// when we record it so that changing the camera mid-frame works as before
+			struct Instance {
+				glm::mat4 Transform;
+				glm::vec4 Color;
+			};
+			// Where a mesh lives in our shared vertex and index buffers
 			struct mesh {
-				GLuint VAO;
-				GLuint VBO;
+				GLint  BaseVertex;
+				size_t FirstIndex;
+				size_t IndexCount;
+				std::vector<Instance> Instances;
 			};
-			mesh __MakeMesh(const float* data, size_t size) const;
+			void __AddMesh(mesh& result, const float* data, size_t size, std::vector<glm::vec3>& verts, std::vector<uint32_t>& indices);
+			void __Record(mesh& target, const glm::mat4& transform, const glm::vec4& color);
 			
 			mesh m_Teapot;
 			mesh m_Sphere;
 			mesh m_Cube;
+			GLuint m_VAO;
+			GLuint m_VBO;
+			GLuint m_IBO;
+			GLuint m_InstanceBuffer;
+			size_t m_InstanceCapacity;
+			std::vector<Instance> m_Upload;
 			GLuint m_Shader;
 		};
 	}
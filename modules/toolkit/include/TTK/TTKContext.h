@@ -14,6 +14,8 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <deque>
+#include <initializer_list>
 #include "FontRenderer.h"
 
 namespace TTK
@@ -66,14 +68,22 @@ namespace TTK
 
 		void RenderText(const char* text, const glm::vec2& position, const glm::vec4& color, float scale = 1.0f);
 		
-		void DrawTeapot(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
-		void DrawSphere(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
-		void DrawCube(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f)) const;
+		// These are recorded and drawn instanced (one draw per mesh type) at the next Flush
+		void DrawTeapot(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f));
+		void DrawSphere(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f));
+		void DrawCube(const glm::mat4& mat, const glm::vec4& color = glm::vec4(1.0f));
 
 		void AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color = {0, 0, 0, 1});
 		void AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color = { 0, 0, 0, 1 });
 		void AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color = { 0, 0, 0, 1 });
 		void AddPoint(const glm::vec3& pos, float size, const glm::vec4& color = { 0, 0, 0, 1 });
+
+		// Batched versions of AddLine and AddPoint, these append a whole array in one go
+		// Lines take pairs of vertices (a trailing odd vertex is ignored)
+		void AddLines(const SimpleVert* verts, size_t vertCount);
+		void AddLines(const glm::vec3* points, size_t pointCount, const glm::vec4& color = { 0, 0, 0, 1 });
+		void AddPoints(const PointVert* verts, size_t vertCount);
+		void AddPoints(const glm::vec3* points, size_t pointCount, float size, const glm::vec4& color = { 0, 0, 0, 1 });
 		
 		void Flush();
 
@@ -87,29 +97,53 @@ namespace TTK
 
 		GLuint m_ShaderHandle;
 		GLuint m_PointShaderHandle;
+
+		// Marks a range of a stream buffer that the GPU may still be reading from
+		struct RangeFence {
+			GLsync Sync;
+			size_t Begin, End;
+		};
+
+		struct AttribDesc {
+			GLuint Index;
+			GLint  Size;
+			size_t Offset;
+		};
+
+		// A persistently mapped ring buffer that primitives are written straight into.
+		// Each flush draws [Head, Head + Count) and fences it, then the next batch starts
+		// where that one ended. When we reach the end we wrap back around to the start
+		// (waiting on the fences of whatever we're about to overwrite)
 		struct GLBuff {
 			GLuint VBO, VAO;
-			size_t Count;
-			size_t ElemSize;
 			GLenum Mode;
-			void*  Data;
 			GLuint Shader;
+			size_t ElemSize;
+			size_t Capacity;
+			uint8_t* Mapped;
+			size_t Head;
+			size_t Count;
+			std::deque<RangeFence> Fences;
 		};
 		GLBuff m_Tris, m_Lines, m_Points;
 
 		int m_WindowWidth, m_WindowHeight;
 		int m_viewportX, m_viewportY;
 
-		GLBuff __InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems);
+		void __InitBuff(GLBuff& buff, GLenum mode, GLuint shader, size_t elemSize, size_t initialElems, std::initializer_list<AttribDesc> attribs);
+		void __AllocStorage(GLBuff& buff, size_t elems);
+		void __FreeStorage(GLBuff& buff);
+		void __Grow(GLBuff& buff, size_t minElems);
+		bool __WaitForRange(GLBuff& buff, size_t begin, size_t end, bool block);
+		void* __Reserve(GLBuff& buff, size_t elems);
 		void __Flush(GLBuff& buff);
 		GLuint __CompileShader(const char* vsSource, const char* fsSource);
 
-		static const size_t MaxPointVerts = 512;
-		static const size_t MaxLineVerts = 512 * 2;
-		static const size_t MaxTriVerts = 512 * 3;
-
-		PointVert  m_PointVerts[MaxPointVerts];
-		SimpleVert m_LineVerts[MaxLineVerts];
-		SimpleVert m_TriVerts[MaxTriVerts];
+		// Starting sizes of the stream buffers, in vertices. They double whenever the GPU
+		// is still using the space we need, until we reach MaxStreamBytes
+		static const size_t InitialPointVerts = 16 * 1024;
+		static const size_t InitialLineVerts = 64 * 1024;
+		static const size_t InitialTriVerts = 48 * 1024;
+		static const size_t MaxStreamBytes = 64 * 1024 * 1024;
 	};
 }
@@ -1,42 +1,187 @@
 #include "Logging.h"
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <cstdlib>
+#include <algorithm>
 
 #include "spdlog/common.h"
+#include "spdlog/async.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include "spdlog/sinks/ansicolor_sink.h"
+#include "spdlog/sinks/dup_filter_sink.h"
+#include "spdlog/details/file_helper.h"
 
 #ifdef WINDOWS
 #include <Windows.h>
 #include <DbgHelp.h>
 #endif
 
+namespace {
+	/*
+		Writes messages to a compact binary file, which is much cheaper to write than formatted text
+		and easy to load back up in tools. The file starts with the 4 bytes "TTKL" and a uint32 version,
+		followed by one record per message:
+			int64  time (nanoseconds since the epoch)
+			uint64 thread ID
+			uint8  level (matches LOG_LEVEL_*)
+			uint8  padding[3]
+			uint32 logger name length
+			uint32 payload length
+			then the logger name and payload bytes (not null terminated)
+	*/
+	class BinaryFileSink : public spdlog::sinks::base_sink<std::mutex> {
+	public:
+		static constexpr uint32_t Version = 1;
+
+		struct RecordHeader {
+			int64_t  Time;
+			uint64_t ThreadId;
+			uint8_t  Level;
+			uint8_t  Padding[3];
+			uint32_t NameLength;
+			uint32_t PayloadLength;
+		};
+
+		explicit BinaryFileSink(const std::string& fileName) {
+			myFile.open(fileName, true);
+			spdlog::memory_buf_t header;
+			header.append("TTKL", "TTKL" + 4);
+			__Append(header, Version);
+			myFile.write(header);
+		}
+
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override {
+			RecordHeader record = RecordHeader();
+			record.Time = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+			record.ThreadId = msg.thread_id;
+			record.Level = static_cast<uint8_t>(msg.level);
+			record.NameLength = static_cast<uint32_t>(msg.logger_name.size());
+			record.PayloadLength = static_cast<uint32_t>(msg.payload.size());
+
+			myBuffer.clear();
+			__Append(myBuffer, record);
+			myBuffer.append(msg.logger_name.data(), msg.logger_name.data() + msg.logger_name.size());
+			myBuffer.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+			myFile.write(myBuffer);
+		}
+
+		void flush_() override {
+			myFile.flush();
+		}
+
+	private:
+		template <typename T>
+		static void __Append(spdlog::memory_buf_t& buffer, const T& value) {
+			const char* bytes = reinterpret_cast<const char*>(&value);
+			buffer.append(bytes, bytes + sizeof(T));
+		}
+
+		spdlog::details::file_helper myFile;
+		spdlog::memory_buf_t myBuffer;
+	};
+
+	/*
+		Lets Logger::Flush wait on the async writer thread. Each flush request is logged to this sink
+		(through its own logger on the same thread pool) with the request ID as the message, right after
+		the flush for our real sinks. The single writer thread handles the queue in order, so when it
+		reaches a request, everything queued before it has been written
+	*/
+	class FlushBarrierSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+	public:
+		uint64_t Request() {
+			return ++myRequested;
+		}
+
+		bool Wait(uint64_t request, std::chrono::milliseconds timeout) {
+			std::unique_lock<std::mutex> lock(myMutex);
+			return myCondition.wait_for(lock, timeout, [&]() { return myCompleted >= request; });
+		}
+
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override {
+			// Only complete up to the request we reached, later requests are still behind us in the queue
+			const std::string payload(msg.payload.data(), msg.payload.size());
+			const uint64_t request = std::strtoull(payload.c_str(), nullptr, 10);
+			{
+				std::lock_guard<std::mutex> lock(myMutex);
+				myCompleted = std::max(myCompleted, request);
+			}
+			myCondition.notify_all();
+		}
+
+		void flush_() override { }
+
+	private:
+		std::atomic<uint64_t> myRequested{ 0 };
+		uint64_t myCompleted = 0;
+		std::mutex myMutex;
+		std::condition_variable myCondition;
+	};
+
+	std::shared_ptr<FlushBarrierSink> flushBarrier;
+	// Carries flush requests to the barrier, kept separate so they never reach our real sinks
+	std::shared_ptr<spdlog::async_logger> flushBarrierLogger;
+}
+
 std::shared_ptr<spdlog::logger> Logger::myLogger;
 bool Logger::isInitialized = false;
+bool Logger::isAsync = false;
 
 void Logger::Init(const LoggerSettings& settings) {
 	if (!isInitialized) {
 		// Set our spd logging pattern
 		spdlog::set_pattern("%^[%l] %n: %v%$");
 
-		// Create a new color logger
+		std::vector<spdlog::sink_ptr> sinks;
+
+		// Create a new color sink
 		if (settings.OutputToConsole) {
-			myLogger = spdlog::stdout_color_mt("APP", spdlog::color_mode::automatic);
+			auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>(spdlog::color_mode::automatic);
+			// The default color for trace is the same as info, so we make trace cyan instead
+			console_sink->set_color(spdlog::level::trace, console_sink->CYAN);
+			sinks.push_back(console_sink);
 		}
 		if (settings.OutputToFile) {
-			myLogger->sinks().emplace(
-				myLogger->sinks().begin(),
-				std::make_shared<spdlog::sinks::basic_file_sink<spdlog::details::null_mutex>>(
-					settings.LogFileName.empty() ? "logs.txt" : settings.LogFileName)
-			);
+			sinks.insert(sinks.begin(), std::make_shared<spdlog::sinks::basic_file_sink_mt>(
+				settings.LogFileName.empty() ? "logs.txt" : settings.LogFileName));
+		}
+		if (settings.OutputToBinary) {
+			sinks.push_back(std::make_shared<BinaryFileSink>(
+				settings.BinaryLogFileName.empty() ? "logs.bin" : settings.BinaryLogFileName));
+		}
+
+		// Collapse repeated messages (ex: a warning every frame) before they reach any of our outputs
+		if (settings.DuplicateWindow > 0.0f) {
+			auto filter = std::make_shared<spdlog::sinks::dup_filter_sink_mt>(
+				std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<float>(settings.DuplicateWindow)));
+			filter->set_sinks(std::move(sinks));
+			sinks = { filter };
+		}
+
+		// In async mode, messages go into a bounded queue and a single writer thread drains it into our sinks
+		isAsync = settings.Async;
+		if (isAsync) {
+			spdlog::init_thread_pool(settings.AsyncQueueSize > 0 ? settings.AsyncQueueSize : 8192, 1);
+			const spdlog::async_overflow_policy policy = settings.BlockWhenFull ?
+				spdlog::async_overflow_policy::block : spdlog::async_overflow_policy::overrun_oldest;
+			myLogger = std::make_shared<spdlog::async_logger>("APP", sinks.begin(), sinks.end(), spdlog::thread_pool(), policy);
+
+			flushBarrier = std::make_shared<FlushBarrierSink>();
+			flushBarrierLogger = std::make_shared<spdlog::async_logger>("FLUSH", flushBarrier, spdlog::thread_pool(), policy);
+			flushBarrierLogger->set_level(spdlog::level::trace);
+		} else {
+			myLogger = std::make_shared<spdlog::logger>("APP", sinks.begin(), sinks.end());
 		}
+		spdlog::initialize_logger(myLogger);
 
 		// Our log level is set to trace (the highest) by default
 		myLogger->set_level(spdlog::level::trace);
-		// The default color for trace is the same as info, so we get our color output
-		auto console_sink = dynamic_cast<spdlog::sinks::stdout_color_sink_mt*>(myLogger->sinks().back().get());
-		// and make trace cyan instead
-		console_sink->set_color(spdlog::level::trace, console_sink->CYAN);
+		// Make sure errors make it out even if we crash shortly after
+		myLogger->flush_on(spdlog::level::err);
 
 		#ifdef WINDOWS 
 		// Get the process handle
@@ -58,8 +203,29 @@ void Logger::Uninitialize()
 		HANDLE process = GetCurrentProcess();
 		SymCleanup(process);
 		#endif
+		// Shutting down spdlog drains the async queue and joins the writer thread
 		myLogger = nullptr;
+		flushBarrierLogger = nullptr;
 		spdlog::shutdown();
+		flushBarrier = nullptr;
+		isInitialized = false;
+	}
+}
+
+void Logger::Flush()
+{
+	if (!isInitialized) {
+		return;
+	}
+
+	if (isAsync) {
+		// We don't wait forever, if the queue is dropping messages our flush request could be dropped too
+		uint64_t request = flushBarrier->Request();
+		myLogger->flush();
+		flushBarrierLogger->info("{}", request);
+		flushBarrier->Wait(request, std::chrono::milliseconds(500));
+	} else {
+		myLogger->flush();
 	}
 }
 
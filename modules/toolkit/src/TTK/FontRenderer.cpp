@@ -11,6 +11,8 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "TTK/FontRenderer.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include "Logging.h"
 #include <GLM/gtc/matrix_transform.hpp>
@@ -51,21 +53,64 @@ char* readFile(const char* filename) {
 	}
 }
 
+namespace {
+	// Reads the next code point from a UTF-8 string and moves text past it. Anything malformed
+	// comes out as the replacement character (U+FFFD), one byte at a time
+	uint32_t DecodeUtf8(const char*& text, const char* end) {
+		const uint8_t lead = static_cast<uint8_t>(*text++);
+		if (lead < 0x80) {
+			return lead;
+		}
+
+		int extra;
+		uint32_t codePoint;
+		if ((lead & 0xE0) == 0xC0) { extra = 1; codePoint = lead & 0x1F; }
+		else if ((lead & 0xF0) == 0xE0) { extra = 2; codePoint = lead & 0x0F; }
+		else if ((lead & 0xF8) == 0xF0) { extra = 3; codePoint = lead & 0x07; }
+		else { return 0xFFFD; }
+
+		if (end - text < extra) {
+			return 0xFFFD;
+		}
+		for (int ix = 0; ix < extra; ix++) {
+			const uint8_t next = static_cast<uint8_t>(text[ix]);
+			if ((next & 0xC0) != 0x80) {
+				return 0xFFFD;
+			}
+			codePoint = (codePoint << 6) | (next & 0x3F);
+		}
+		text += extra;
+		return codePoint > 0x10FFFF ? 0xFFFD : codePoint;
+	}
+
+	// FNV-1a, used to key our layout cache
+	uint64_t HashString(const char* text, size_t length) {
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t ix = 0; ix < length; ix++) {
+			hash ^= static_cast<uint8_t>(text[ix]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
 TTK::FontRenderer* TTK::FontRenderer::m_Instance = nullptr;
 
 TTK::TrueTypeTextureFont::TrueTypeTextureFont(const char* fileName, uint32_t size)
 {
 	myFontSize = size;
+	myTexture = 0;
+	m_TexHandle = 0;
+	myPageCount = 0;
+	myShelfX = myShelfY = myShelfHeight = 0;
 
-	unsigned char* fontData = (unsigned char*)readFile(fileName);
-	uint8_t* atlasData = new uint8_t[static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT];
+	// stb_truetype reads straight from the file data whenever we rasterize a glyph, so we hold on to it
+	myFontData = (unsigned char*)readFile(fileName);
 
-	myCharInfo = new stbtt_packedchar[CHAR_COUNT];
-
-	if (!stbtt_InitFont(&myFontInfo, fontData, 0)) {
+	if (myFontData == nullptr || !stbtt_InitFont(&myFontInfo, myFontData, 0)) {
 		LOG_ERROR("Failed to initialize font");
-		delete[] atlasData;
-		delete[] fontData;
+		delete[] myFontData;
+		myFontData = nullptr;
 		return;
 	}
 
@@ -75,77 +120,153 @@ TTK::TrueTypeTextureFont::TrueTypeTextureFont(const char* fileName, uint32_t siz
 	myPixelHeightScale = stbtt_ScaleForPixelHeight(&myFontInfo, static_cast<float>(size));
 	myEmToPixel = stbtt_ScaleForMappingEmToPixels(&myFontInfo, 1.0f);
 
-	stbtt_pack_context context;
-	if (!stbtt_PackBegin(&context, atlasData, ATLAS_WIDTH, ATLAS_HEIGHT, 0, 1, nullptr)) {
-		LOG_ERROR("Failed to pack font texture");
-		delete[] atlasData;
-		delete[] fontData;
+	if (!__AddPage()) {
 		return;
 	}
 
-	stbtt_PackSetOversampling(&context, FONT_OVERSAMPLE_X, FONT_OVERSAMPLE_Y);
-	if (!stbtt_PackFontRange(&context, fontData, 0, static_cast<float>(size), FIRST_CHAR, CHAR_COUNT, myCharInfo)) {
-		LOG_ERROR("Failed to pack font range");
-		delete[] atlasData;
-		delete[] fontData;
-		return;
+	// Rasterize the printable ASCII range up front, so the most common text never waits on it
+	for (uint32_t ix = FIRST_CHAR; ix <= FIRST_CHAR + CHAR_COUNT; ix++) {
+		__GetPackedGlyph(ix);
 	}
-	stbtt_PackEnd(&context);
+}
 
-	for (uint32_t ix = FIRST_CHAR; ix < FIRST_CHAR + CHAR_COUNT; ix++) {
-		// TODO: Grab glyph data
+TTK::TrueTypeTextureFont::~TrueTypeTextureFont()
+{
+	FontRenderer::__ForgetFont(this);
+	if (m_TexHandle != 0) {
+		glMakeTextureHandleNonResidentARB(m_TexHandle);
 	}
+	glDeleteTextures(1, &myTexture);
+	delete[] myFontData;
+}
 
-	// Create and upload the texture to store our font in
-	LOG_ASSERT(glGetError() == GL_NONE, "Some error has occured!");
-	glCreateTextures(GL_TEXTURE_2D, 1, &myTexture);
-	glTextureParameteri(myTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTextureParameteri(myTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTextureParameteri(myTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-	glTextureParameteri(myTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	LOG_ASSERT(glGetError() == GL_NONE, "Some error has occured!");
-	glTextureStorage2D(myTexture, 1, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT);
+bool TTK::TrueTypeTextureFont::__AddPage() {
+	if (myPageCount >= MAX_PAGES) {
+		LOG_WARN("Font atlas is full ({} pages), some glyphs will not be drawn", MAX_PAGES);
+		return false;
+	}
+
+	// Array textures can't be resized, so we make one with an extra layer and copy the old pages over.
+	// Glyphs keep the same page and UVs, so nothing that's already laid out needs to change
+	GLuint texture;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureStorage3D(texture, 1, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, myPageCount + 1);
 	LOG_ASSERT(glGetError() == GL_NONE, "Internal texture format not supported");
-	glTextureSubImage2D(myTexture, 0, 0, 0, ATLAS_WIDTH, ATLAS_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, atlasData);
-	LOG_ASSERT(glGetError() == GL_NONE, "Texture transfer format not supported");
+	glClearTexImage(texture, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+
+	if (myTexture != 0) {
+		glCopyImageSubData(myTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+			texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+			ATLAS_WIDTH, ATLAS_HEIGHT, myPageCount);
+		glMakeTextureHandleNonResidentARB(m_TexHandle);
+		glDeleteTextures(1, &myTexture);
+	}
+
+	myTexture = texture;
 	m_TexHandle = glGetTextureHandleARB(myTexture);
 	glMakeTextureHandleResidentARB(m_TexHandle);
 
-	delete[] atlasData;
-	delete[] fontData;
+	myPageCount++;
+	myShelfX = GLYPH_PADDING;
+	myShelfY = GLYPH_PADDING;
+	myShelfHeight = 0;
+	return true;
 }
 
-TTK::TrueTypeTextureFont::~TrueTypeTextureFont()
-{
-	delete[] myCharInfo;
-	glDeleteTextures(1, &myTexture);
+const TTK::TrueTypeTextureFont::PackedGlyph& TTK::TrueTypeTextureFont::__GetPackedGlyph(uint32_t codePoint) {
+	auto it = myGlyphs.find(codePoint);
+	if (it != myGlyphs.end()) {
+		return it->second;
+	}
+
+	PackedGlyph glyph = PackedGlyph();
+	if (myPageCount == 0) {
+		return myGlyphs.emplace(codePoint, glyph).first->second;
+	}
+
+	int advance, leftSideBearing;
+	stbtt_GetCodepointHMetrics(&myFontInfo, codePoint, &advance, &leftSideBearing);
+	glyph.Advance = advance * myPixelHeightScale;
+
+	// Same oversampling the stb packer used to give us, so glyphs look smooth at fractional positions
+	const float scaleX = myPixelHeightScale * FONT_OVERSAMPLE_X;
+	const float scaleY = myPixelHeightScale * FONT_OVERSAMPLE_Y;
+	int x0, y0, x1, y1;
+	stbtt_GetCodepointBitmapBoxSubpixel(&myFontInfo, codePoint, scaleX, scaleY, 0.0f, 0.0f, &x0, &y0, &x1, &y1);
+	const uint32_t width = static_cast<uint32_t>(x1 - x0) + FONT_OVERSAMPLE_X - 1;
+	const uint32_t height = static_cast<uint32_t>(y1 - y0) + FONT_OVERSAMPLE_Y - 1;
+
+	// Whitespace has nothing to draw
+	if (x1 > x0 && y1 > y0 && width + GLYPH_PADDING * 2 <= ATLAS_WIDTH && height + GLYPH_PADDING * 2 <= ATLAS_HEIGHT) {
+		// Shelf packing, glyphs go left to right in rows as tall as the tallest glyph in them
+		if (myShelfX + width + GLYPH_PADDING > ATLAS_WIDTH) {
+			myShelfX = GLYPH_PADDING;
+			myShelfY += myShelfHeight + GLYPH_PADDING;
+			myShelfHeight = 0;
+		}
+		if (myShelfY + height + GLYPH_PADDING > ATLAS_HEIGHT && !__AddPage()) {
+			return myGlyphs.emplace(codePoint, glyph).first->second;
+		}
+
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+		float subX, subY;
+		stbtt_MakeCodepointBitmapSubpixelPrefilter(&myFontInfo, pixels.data(), width, height, width, scaleX, scaleY, 0.0f, 0.0f,
+			FONT_OVERSAMPLE_X, FONT_OVERSAMPLE_Y, &subX, &subY, codePoint);
+
+		GLint unpackAlignment;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage3D(myTexture, 0, myShelfX, myShelfY, myPageCount - 1, width, height, 1, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+		glyph.X0 = x0 / static_cast<float>(FONT_OVERSAMPLE_X) + subX;
+		glyph.Y0 = y0 / static_cast<float>(FONT_OVERSAMPLE_Y) + subY;
+		glyph.X1 = (x0 + width) / static_cast<float>(FONT_OVERSAMPLE_X) + subX;
+		glyph.Y1 = (y0 + height) / static_cast<float>(FONT_OVERSAMPLE_Y) + subY;
+		glyph.S0 = myShelfX / static_cast<float>(ATLAS_WIDTH);
+		glyph.T0 = myShelfY / static_cast<float>(ATLAS_HEIGHT);
+		glyph.S1 = (myShelfX + width) / static_cast<float>(ATLAS_WIDTH);
+		glyph.T1 = (myShelfY + height) / static_cast<float>(ATLAS_HEIGHT);
+		glyph.Page = myPageCount - 1;
+
+		myShelfX += width + GLYPH_PADDING;
+		myShelfHeight = std::max(myShelfHeight, height);
+	}
+
+	return myGlyphs.emplace(codePoint, glyph).first->second;
 }
 
-TTK::GlyphInfo TTK::TrueTypeTextureFont::GetGlyph(int codePoint, float offsetX, float offsetY) const {
-	stbtt_aligned_quad quad;
+TTK::GlyphInfo TTK::TrueTypeTextureFont::GetGlyph(int codePoint, float offsetX, float offsetY) {
+	const PackedGlyph& packed = __GetPackedGlyph(static_cast<uint32_t>(codePoint));
 
-	stbtt_GetPackedQuad(myCharInfo, ATLAS_WIDTH, ATLAS_HEIGHT, codePoint - FIRST_CHAR, &offsetX, &offsetY, &quad, 1);
-	auto xmin = quad.x0;
-	auto xmax = quad.x1;
-	auto ymin = -quad.y1;
-	auto ymax = -quad.y0;
+	// Snap the quad to whole pixels, the same as stbtt_GetPackedQuad
+	auto xmin = std::floor(offsetX + packed.X0 + 0.5f);
+	auto ymin = std::floor(offsetY + packed.Y0 + 0.5f);
+	auto xmax = xmin + packed.X1 - packed.X0;
+	auto ymax = ymin + packed.Y1 - packed.Y0;
 
 	GlyphInfo info = GlyphInfo();
-	info.OffsetX = offsetX;
+	info.OffsetX = offsetX + packed.Advance;
 	info.OffsetY = offsetY;
-	info.Positions[0] = { xmax, -ymin };
-	info.Positions[1] = { xmax, -ymax };
-	info.Positions[2] = { xmin, -ymax };
-	info.Positions[3] = { xmin, -ymin };
-	info.UVs[0] = { quad.s1, quad.t1 };
-	info.UVs[1] = { quad.s1, quad.t0 };
-	info.UVs[2] = { quad.s0, quad.t0 };
-	info.UVs[3] = { quad.s0, quad.t1 };
+	info.Page = packed.Page;
+	info.Positions[0] = { xmax, ymax };
+	info.Positions[1] = { xmax, ymin };
+	info.Positions[2] = { xmin, ymin };
+	info.Positions[3] = { xmin, ymax };
+	info.UVs[0] = { packed.S1, packed.T1 };
+	info.UVs[1] = { packed.S1, packed.T0 };
+	info.UVs[2] = { packed.S0, packed.T0 };
+	info.UVs[3] = { packed.S0, packed.T1 };
 
 	return info;
 }
 
 float TTK::TrueTypeTextureFont::GetKerning(int char1, int char2) const {
+	if (myFontData == nullptr) return 0.0f;
 	return stbtt_GetCodepointKernAdvance(&myFontInfo, char1, char2) * myPixelHeightScale;
 }
 
@@ -156,38 +277,48 @@ float TTK::TrueTypeTextureFont::GetLineHeight() const {
 glm::vec2 TTK::TrueTypeTextureFont::MeausureString(const char* text, const float scale) {
 	float multiplier = scale;
 
-	glm::vec2 originPos = glm::vec2();
-
 	GlyphInfo glyph;
 
-	size_t length = strlen(text);
+	const char* cursor = text;
+	const char* end = text + strlen(text);
 	float xOff{ 0 }, yOff{ 0 };
 	float lineHeight = 0.0f;
 	float maxWidth = 0.0f;
 	float totalHeight = 0.0f;
+	uint32_t prevCodePoint = 0;
 
-	for (size_t i = 0; i < length; i++) {
-		glyph = GetGlyph(text[i], xOff, yOff);
-		xOff = glyph.OffsetX;
-		yOff = glyph.OffsetY;
-
-		lineHeight = glm::max(lineHeight, -glyph.Positions[1].y);
-		maxWidth = glm::max(maxWidth, xOff);
+	while (cursor < end) {
+		uint32_t codePoint = DecodeUtf8(cursor, end);
 
-		if (text[i] == '\n')
+		if (codePoint == '\n')
 		{
 			yOff += GetLineHeight() * multiplier;
 			totalHeight += lineHeight;
 			lineHeight = 0.0f;
 			xOff = 0;
+			prevCodePoint = 0;
 		}
-		else if (text[i] == '\r') {
+		else if (codePoint == '\r') {
 			xOff = 0;
+			prevCodePoint = 0;
 		}
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = GetGlyph(' ', xOffTemp, yOffTemp);
-			xOff += glyph.OffsetX * 4;
+		else if (codePoint == '\t') {
+			xOff += __GetPackedGlyph(' ').Advance * 4;
+			prevCodePoint = 0;
+		}
+		else {
+			// Kern the same way FontRenderer lays the text out, so the size matches what gets drawn
+			if (prevCodePoint != 0) {
+				xOff += GetKerning(prevCodePoint, codePoint);
+			}
+			prevCodePoint = codePoint;
+
+			glyph = GetGlyph(codePoint, xOff, yOff);
+			xOff = glyph.OffsetX;
+			yOff = glyph.OffsetY;
+
+			lineHeight = glm::max(lineHeight, -glyph.Positions[1].y);
+			maxWidth = glm::max(maxWidth, xOff);
 		}
 	}
 	GlyphInfo space = GetGlyph('|', xOff, yOff);
@@ -195,82 +326,177 @@ glm::vec2 TTK::TrueTypeTextureFont::MeausureString(const char* text, const float
 	return glm::vec2(xOff, yOff);
 }
 
+size_t TTK::FontRenderer::LayoutKeyHasher::operator()(const LayoutKey& key) const {
+	size_t hash = static_cast<size_t>(key.Hash);
+	hash ^= std::hash<const void*>()(key.Font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.Scale) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
 TTK::FontRenderer::~FontRenderer()
 {
-	glDeleteShader(m_ShaderHandle);
+	glDeleteProgram(m_ShaderHandle);
+	glDeleteBuffers(1, &m_VBO);
+	glDeleteBuffers(1, &m_EBO);
 	glDeleteVertexArrays(1, &m_VAO);
 }
 
-void TTK::FontRenderer::Render(const TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale)
-{
-	size_t length = strlen(text);
-	
-	float multiplier = scale;
-
-	// The number of quads ACTUALLY drawn Shit-For-Brains
-	int quads = 0;
+const TTK::FontRenderer::CachedLayout& TTK::FontRenderer::__GetLayout(TrueTypeTextureFont& font, const char* text, size_t length, float scale) {
+	LayoutKey key = { HashString(text, length), &font, scale };
+	auto it = m_Layouts.find(key);
+	if (it == m_Layouts.end()) {
+		// Make room before adding, so we're not holding on to a layout we're about to throw away
+		if (m_Layouts.size() >= MaxLayouts) {
+			__EvictOldestLayouts(MaxLayouts / 4);
+		}
+		it = m_Layouts.emplace(key, CachedLayout()).first;
+	}
+	CachedLayout& layout = it->second;
+	layout.LastUsed = m_FrameIndex;
 
-	glm::vec2 originPos = glm::vec2(pos.x, pos.y);
+	// We check the text as well as the hash, so a collision just costs us a re-layout
+	if (layout.Text.size() == length && memcmp(layout.Text.data(), text, length) == 0) {
+		return layout;
+	}
 
-	static GlyphInfo glyph;
-
-	Col8 gpuCol;
-	gpuCol.R = static_cast<char>(color.r * 255);
-	gpuCol.G = static_cast<char>(color.g * 255);
-	gpuCol.B = static_cast<char>(color.b * 255);
-	gpuCol.A = static_cast<char>(color.a * 255);
+	layout.Text.assign(text, length);
+	layout.Quads.clear();
 
+	const float multiplier = scale;
+	const char* cursor = text;
+	const char* end = text + length;
 	float xOff{ 0 }, yOff{ 0 };
+	uint32_t prevCodePoint = 0;
 
-	for (int i = 0; i < length; i++) {
-		glyph = font.GetGlyph(text[i], xOff, yOff);
-		xOff = glyph.OffsetX;
-		yOff = glyph.OffsetY;
+	while (cursor < end) {
+		uint32_t codePoint = DecodeUtf8(cursor, end);
 
-		if (text[i] == '\n')
+		if (codePoint == '\n')
 		{
 			yOff += font.GetLineHeight() * multiplier;
 			xOff = 0;
+			prevCodePoint = 0;
 		}
-		else if (text[i] == '\r') {
+		else if (codePoint == '\r') {
 			xOff = 0;
+			prevCodePoint = 0;
 		}
-		else if (text[i] == '\t') {
-			float xOffTemp{ 0 }, yOffTemp{ 0 };
-			glyph = font.GetGlyph(' ', xOffTemp, yOffTemp);
-			xOff += glyph.OffsetX * 4;
+		else if (codePoint == '\t') {
+			xOff += font.__GetPackedGlyph(' ').Advance * 4;
+			prevCodePoint = 0;
 		}
 		else {
-			m_MeshData[quads * 4 + 0].Position = originPos + glyph.Positions[0] * multiplier;
-			m_MeshData[quads * 4 + 0].UV = glyph.UVs[0];
-			m_MeshData[quads * 4 + 0].Color = gpuCol;
+			// Kerning only needs working out once per layout, so we can afford it now
+			if (prevCodePoint != 0) {
+				xOff += font.GetKerning(prevCodePoint, codePoint);
+			}
+			prevCodePoint = codePoint;
+
+			GlyphInfo glyph = font.GetGlyph(codePoint, xOff, yOff);
+			xOff = glyph.OffsetX;
+			yOff = glyph.OffsetY;
+
+			// Nothing to draw for whitespace
+			if (glyph.UVs[0] == glyph.UVs[2]) {
+				continue;
+			}
+
+			LayoutQuad quad;
+			for (int ix = 0; ix < 4; ix++) {
+				quad.Positions[ix] = glyph.Positions[ix] * multiplier;
+				quad.UVs[ix] = glm::vec3(glyph.UVs[ix], static_cast<float>(glyph.Page));
+			}
+			layout.Quads.push_back(quad);
+		}
+	}
 
-			m_MeshData[quads * 4 + 1].Position = originPos + glyph.Positions[1] * multiplier;
-			m_MeshData[quads * 4 + 1].UV = glyph.UVs[1];
-			m_MeshData[quads * 4 + 1].Color = gpuCol;
+	return layout;
+}
 
-			m_MeshData[quads * 4 + 2].Position = originPos + glyph.Positions[2] * multiplier;
-			m_MeshData[quads * 4 + 2].UV = glyph.UVs[2];
-			m_MeshData[quads * 4 + 2].Color = gpuCol;
+void TTK::FontRenderer::Render(TrueTypeTextureFont& font, const char* text, const glm::vec2& pos, const glm::vec4& color, float scale)
+{
+	if (font.myPageCount == 0) {
+		return;
+	}
 
-			m_MeshData[quads * 4 + 3].Position = originPos + glyph.Positions[3] * multiplier;
-			m_MeshData[quads * 4 + 3].UV = glyph.UVs[3];
-			m_MeshData[quads * 4 + 3].Color = gpuCol;
+	const CachedLayout& layout = __GetLayout(font, text, strlen(text), scale);
+	if (layout.Quads.empty()) {
+		return;
+	}
 
+	Col8 gpuCol;
+	gpuCol.R = static_cast<char>(color.r * 255);
+	gpuCol.G = static_cast<char>(color.g * 255);
+	gpuCol.B = static_cast<char>(color.b * 255);
+	gpuCol.A = static_cast<char>(color.a * 255);
 
-			m_IndexData[quads * 6 + 0] = quads * 4 + 0;
-			m_IndexData[quads * 6 + 1] = quads * 4 + 1;
-			m_IndexData[quads * 6 + 2] = quads * 4 + 2;
+	// Find (or start) this font's batch for the frame
+	FontBatch* batch = nullptr;
+	for (FontBatch& existing : m_Batches) {
+		if (existing.Font == &font) {
+			batch = &existing;
+			break;
+		}
+	}
+	if (batch == nullptr) {
+		m_Batches.push_back({ &font, {} });
+		batch = &m_Batches.back();
+	}
 
-			m_IndexData[quads * 6 + 3] = quads * 4 + 0;
-			m_IndexData[quads * 6 + 4] = quads * 4 + 2;
-			m_IndexData[quads * 6 + 5] = quads * 4 + 3;
+	// All we do per frame is offset the cached quads to where the text goes
+	const size_t first = batch->Verts.size();
+	batch->Verts.resize(first + layout.Quads.size() * 4);
+	Vert* verts = batch->Verts.data() + first;
+	for (const LayoutQuad& quad : layout.Quads) {
+		for (int ix = 0; ix < 4; ix++) {
+			verts[ix].Position = pos + quad.Positions[ix];
+			verts[ix].Color = gpuCol;
+			verts[ix].UV = quad.UVs[ix];
+		}
+		verts += 4;
+	}
+}
+
+void TTK::FontRenderer::Flush()
+{
+	m_FrameIndex++;
+	if (m_FrameIndex % LayoutLifetime == 0) {
+		__EvictLayouts();
+	}
 
-			quads++;
+	size_t vertCount = 0;
+	for (const FontBatch& batch : m_Batches) {
+		vertCount += batch.Verts.size();
+	}
+	if (vertCount == 0) {
+		return;
+	}
+	const size_t quadCount = vertCount / 4;
+
+	// Our index buffer is the same 6 indices per quad over and over, so we only rebuild it when it needs to grow
+	if (quadCount > m_QuadCapacity) {
+		m_QuadCapacity = std::max(quadCount, m_QuadCapacity * 2);
+		std::vector<GLuint> indices(m_QuadCapacity * 6);
+		for (size_t ix = 0; ix < m_QuadCapacity; ix++) {
+			GLuint base = static_cast<GLuint>(ix * 4);
+			indices[ix * 6 + 0] = base + 0;
+			indices[ix * 6 + 1] = base + 1;
+			indices[ix * 6 + 2] = base + 2;
+			indices[ix * 6 + 3] = base + 0;
+			indices[ix * 6 + 4] = base + 2;
+			indices[ix * 6 + 5] = base + 3;
 		}
+		glNamedBufferData(m_EBO, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 	}
 
-	length = quads;
+	// Re-specifying the store each frame lets the driver give us fresh memory instead of waiting on last frame's draw
+	m_VertCapacity = std::max(m_VertCapacity, vertCount);
+	glNamedBufferData(m_VBO, m_VertCapacity * sizeof(Vert), nullptr, GL_STREAM_DRAW);
+	size_t offset = 0;
+	for (const FontBatch& batch : m_Batches) {
+		glNamedBufferSubData(m_VBO, offset * sizeof(Vert), batch.Verts.size() * sizeof(Vert), batch.Verts.data());
+		offset += batch.Verts.size();
+	}
 
 	// Update and render our meshes
 	bool blendState = glIsEnabled(GL_BLEND);
@@ -283,53 +509,107 @@ void TTK::FontRenderer::Render(const TrueTypeTextureFont& font, const char* text
 	glm::mat4 proj = TTK::Context::Instance().GetOrthoProjection();
 	glUseProgram(m_ShaderHandle);
 	glProgramUniformMatrix4fv(m_ShaderHandle, 0, 1, false, &proj[0][0]);
-	glProgramUniformHandleui64ARB(m_ShaderHandle, 1, font.m_TexHandle);	
 	glBindVertexArray(m_VAO);
-	glNamedBufferSubData(m_VBO, 0, length * 4 * sizeof(Vert), m_MeshData);
-	glNamedBufferSubData(m_EBO, 0, length * 6 * sizeof(GLuint), m_IndexData);
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(length * 6), GL_UNSIGNED_INT, nullptr);
+
+	// One draw per font, the base vertex skips to where that font's quads start
+	offset = 0;
+	for (FontBatch& batch : m_Batches) {
+		if (!batch.Verts.empty()) {
+			glProgramUniformHandleui64ARB(m_ShaderHandle, 1, batch.Font->m_TexHandle);
+			glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(batch.Verts.size() / 4 * 6), GL_UNSIGNED_INT, nullptr, static_cast<GLint>(offset));
+			offset += batch.Verts.size();
+			batch.Verts.clear();
+		}
+	}
+
 	glBindVertexArray(0);
 	LOG_ASSERT(glGetError() == GL_NONE, "Failed to draw our text mesh!");
 	if (!blendState) glDisable(GL_BLEND);
 	glDepthMask(depthMaskEnabled);
 }
 
+void TTK::FontRenderer::__EvictLayouts() {
+	for (auto it = m_Layouts.begin(); it != m_Layouts.end(); ) {
+		if (m_FrameIndex - it->second.LastUsed > LayoutLifetime) {
+			it = m_Layouts.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void TTK::FontRenderer::__EvictOldestLayouts(size_t count) {
+	if (count == 0 || m_Layouts.empty()) {
+		return;
+	}
+	count = std::min(count, m_Layouts.size() - 1);
+
+	// Find the frame the count'th oldest layout was last used on
+	std::vector<uint64_t> lastUsed;
+	lastUsed.reserve(m_Layouts.size());
+	for (const auto& pair : m_Layouts) {
+		lastUsed.push_back(pair.second.LastUsed);
+	}
+	std::nth_element(lastUsed.begin(), lastUsed.begin() + count, lastUsed.end());
+	const uint64_t cutoff = lastUsed[count];
+
+	// Everything older goes, and layouts from the cutoff frame go until we've removed enough (they may all be from this frame)
+	size_t removed = 0;
+	for (auto it = m_Layouts.begin(); it != m_Layouts.end(); ) {
+		if (it->second.LastUsed < cutoff || (it->second.LastUsed == cutoff && removed < count)) {
+			it = m_Layouts.erase(it);
+			removed++;
+		} else {
+			++it;
+		}
+	}
+}
+
+void TTK::FontRenderer::__ForgetFont(const TrueTypeTextureFont* font) {
+	if (m_Instance == nullptr) {
+		return;
+	}
+
+	for (auto it = m_Instance->m_Layouts.begin(); it != m_Instance->m_Layouts.end(); ) {
+		if (it->first.Font == font) {
+			it = m_Instance->m_Layouts.erase(it);
+		} else {
+			++it;
+		}
+	}
+	m_Instance->m_Batches.erase(std::remove_if(m_Instance->m_Batches.begin(), m_Instance->m_Batches.end(),
+		[font](const FontBatch& batch) { return batch.Font == font; }), m_Instance->m_Batches.end());
+}
+
 TTK::FontRenderer::FontRenderer() {
 	LOG_INFO("Initializing font renderer");
 
-	memset(m_MeshData, 0, sizeof(m_MeshData));
-	memset(m_IndexData, 0, sizeof(m_IndexData));
+	m_VertCapacity = 0;
+	m_QuadCapacity = 0;
+	m_FrameIndex = 0;
 
-	glCreateVertexArrays(1, &m_VAO);
-	glBindVertexArray(m_VAO);
-	GLuint buffers[2];
-	glCreateBuffers(2, buffers);
-	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
-	glNamedBufferData(buffers[0], 256 * 4 * sizeof(Vert), m_MeshData, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
-	glNamedBufferData(buffers[1], 256 * 6 * sizeof(GLuint), m_IndexData, GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	#pragma warning(push)
-	#pragma warning(disable: 6011)
-	Vert* v = nullptr;
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vert), &v->Position);
-	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, false, sizeof(Vert), &v->Color);
-	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vert), &v->UV);
-	#pragma warning(pop)
-	
-	glBindVertexArray(0);
+	glCreateBuffers(1, &m_VBO);
+	glCreateBuffers(1, &m_EBO);
 
-	m_VBO = buffers[0];
-	m_EBO = buffers[1];
+	glCreateVertexArrays(1, &m_VAO);
+	glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, sizeof(Vert));
+	glVertexArrayElementBuffer(m_VAO, m_EBO);
+	glEnableVertexArrayAttrib(m_VAO, 0);
+	glEnableVertexArrayAttrib(m_VAO, 1);
+	glEnableVertexArrayAttrib(m_VAO, 2);
+	glVertexArrayAttribFormat(m_VAO, 0, 2, GL_FLOAT, false, offsetof(Vert, Position));
+	glVertexArrayAttribFormat(m_VAO, 1, 4, GL_UNSIGNED_BYTE, true, offsetof(Vert, Color));
+	glVertexArrayAttribFormat(m_VAO, 2, 3, GL_FLOAT, false, offsetof(Vert, UV));
+	glVertexArrayAttribBinding(m_VAO, 0, 0);
+	glVertexArrayAttribBinding(m_VAO, 1, 0);
+	glVertexArrayAttribBinding(m_VAO, 2, 0);
 
 	const char* vsSource = R"LIT(#version 430
             layout (location = 0) in vec2 vertexPosition;
             layout (location = 1) in vec4 vertexColor;
-            layout (location = 2) in vec2 vertexTexture;	
+            layout (location = 2) in vec3 vertexTexture;	
             layout (location = 0) out vec4 fragmentColor;
-            layout (location = 1) out vec2 fragmentTexture;
+            layout (location = 1) out vec3 fragmentTexture;
             layout (location = 0) uniform mat4 xTransform;	
             void main() {
                 gl_Position = xTransform * vec4(vertexPosition, 0, 1);
@@ -339,13 +619,13 @@ TTK::FontRenderer::FontRenderer() {
 
 	const char* fsSource = R"LIT(#version 430
 			#extension GL_ARB_bindless_texture : enable
-            layout(bindless_sampler, location = 1) uniform sampler2D xSampler;
+            layout(bindless_sampler, location = 1) uniform sampler2DArray xSampler;
             layout (location = 0) in vec4 fragColor;
-            layout (location = 1) in vec2 fragUv;            	
+            layout (location = 1) in vec3 fragUv;            	
             out vec4 frag_color;            	
             void main() {
                 frag_color = fragColor;
-				frag_color.a = texture2D(xSampler, fragUv).r;
+				frag_color.a = texture(xSampler, fragUv).r;
             })LIT";
 
 	m_ShaderHandle = glCreateProgram();
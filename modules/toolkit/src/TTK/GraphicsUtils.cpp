@@ -190,6 +190,10 @@ void TTK::Graphics::DrawLine(float* p0, float* p1, float* colour) {
 	TTK::Context::Instance().AddLine(VEC3(p0), VEC3(p1), DEFAULT_BLACK(colour));
 }
 
+void TTK::Graphics::DrawLines(const glm::vec3* points, size_t numPoints, const glm::vec4& colour) {
+	TTK::Context::Instance().AddLines(points, numPoints, colour);
+}
+
 void TTK::Graphics::DrawVector(const glm::vec3& origin, const glm::vec3& vectorToDraw, float lineWidth, const glm::vec4& colour) {
 	TTK::Context::Instance().AddLine(origin, origin + glm::normalize(vectorToDraw), colour);
 }
@@ -214,6 +218,10 @@ void TTK::Graphics::DrawPoint(float* p0, float pointSize, float* colour) {
 	DrawPoint(VEC3(p0), pointSize, DEFAULT_BLACK(colour));
 }
 
+void TTK::Graphics::DrawPoints(const glm::vec3* points, size_t numPoints, float pointSize, const glm::vec4& colour) {
+	TTK::Context::Instance().AddPoints(points, numPoints, pointSize, colour);
+}
+
 void TTK::Graphics::DrawCube(const glm::vec3& p0, float size, const glm::vec4& colour) {
 	glm::mat4 transform = glm::translate(glm::mat4(1.0f), p0) * glm::scale(glm::mat4(1.0f), glm::vec3(size));
 	TTK::Context::Instance().DrawCube(transform, colour);
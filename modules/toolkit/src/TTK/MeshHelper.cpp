@@ -16,77 +16,146 @@
 #include "TTK/Cube.h"
 #include "Logging.h"
 
+#include <algorithm>
+#include <map>
+#include <tuple>
+
 
 TTK::Impl::MeshHelper::~MeshHelper() {
-	glDeleteBuffers(1, &m_Teapot.VBO);
-	glDeleteBuffers(1, &m_Sphere.VBO);
-	glDeleteBuffers(1, &m_Cube.VBO);
-	glDeleteVertexArrays(1, &m_Teapot.VAO);
-	glDeleteVertexArrays(1, &m_Sphere.VAO);
-	glDeleteVertexArrays(1, &m_Cube.VAO);
+	glDeleteBuffers(1, &m_VBO);
+	glDeleteBuffers(1, &m_IBO);
+	glDeleteBuffers(1, &m_InstanceBuffer);
+	glDeleteVertexArrays(1, &m_VAO);
 	glDeleteProgram(m_Shader);
 }
 
-void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Teapot.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(TeapotData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderTeapot(const glm::mat4& transform, const glm::vec4& color) {
+	__Record(m_Teapot, transform, color);
 }
 
-void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color) const {
-	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Sphere.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(SphereData) / (sizeof(float) * 6));
+void TTK::Impl::MeshHelper::RenderSphere(const glm::mat4& transform, const glm::vec4& color) {
+	__Record(m_Sphere, transform, color);
 }
 
-void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color) const
-{
+void TTK::Impl::MeshHelper::RenderCube(const glm::mat4& transform, const glm::vec4& color) {
+	__Record(m_Cube, transform, color);
+}
+
+void TTK::Impl::MeshHelper::__Record(mesh& target, const glm::mat4& transform, const glm::vec4& color) {
+	target.Instances.push_back({ Context::Instance().GetViewProjection() * transform, color });
+}
+
+void TTK::Impl::MeshHelper::Flush() {
+	mesh* meshes[] = { &m_Teapot, &m_Sphere, &m_Cube };
+
+	// Pack every mesh's instances back to back, so they all go up in one upload
+	m_Upload.clear();
+	for (mesh* m : meshes) {
+		m_Upload.insert(m_Upload.end(), m->Instances.begin(), m->Instances.end());
+	}
+	if (m_Upload.empty()) {
+		return;
+	}
+
+	// Re-specifying the storage each flush lets the driver hand us fresh memory if the GPU
+	// is still reading the last batch, the buffer only ever grows
+	m_InstanceCapacity = std::max(m_InstanceCapacity, m_Upload.size());
+	glNamedBufferData(m_InstanceBuffer, m_InstanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(m_InstanceBuffer, 0, m_Upload.size() * sizeof(Instance), m_Upload.data());
+
 	glUseProgram(m_Shader);
-	glm::mat4 t = Context::Instance().GetViewProjection() * transform;
-	glProgramUniformMatrix4fv(m_Shader, 0, 1, FALSE, &t[0][0]);
-	glProgramUniform4fv(m_Shader, 1, 1, &color[0]);
-	glBindVertexArray(m_Cube.VAO);
-	glDrawArrays(GL_TRIANGLES, 0, sizeof(CubeData) / (sizeof(float) * 6));
+	glBindVertexArray(m_VAO);
+
+	// One draw per mesh, the base instance picks out where that mesh's instances start
+	GLuint baseInstance = 0;
+	for (mesh* m : meshes) {
+		if (!m->Instances.empty()) {
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, static_cast<GLsizei>(m->IndexCount), GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(m->FirstIndex * sizeof(uint32_t)), static_cast<GLsizei>(m->Instances.size()),
+				m->BaseVertex, baseInstance);
+			baseInstance += static_cast<GLuint>(m->Instances.size());
+			m->Instances.clear();
+		}
+	}
+
+	glBindVertexArray(0);
 }
 
-TTK::Impl::MeshHelper::mesh TTK::Impl::MeshHelper::__MakeMesh(const float* data, size_t size) const {
-	mesh result;
-	glCreateVertexArrays(1, &result.VAO);
-	glBindVertexArray(result.VAO);
-	glCreateBuffers(1, &result.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, size, data, GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(float) * 6, 0);
-	return result;
+void TTK::Impl::MeshHelper::__AddMesh(mesh& result, const float* data, size_t size, std::vector<glm::vec3>& verts, std::vector<uint32_t>& indices) {
+	// The source data is one position and normal per corner of every triangle, and we only
+	// use the position, so weld identical positions together and index them instead
+	std::map<std::tuple<float, float, float>, uint32_t> lookup;
+	const size_t cornerCount = size / (sizeof(float) * 6);
+
+	result.BaseVertex = static_cast<GLint>(verts.size());
+	result.FirstIndex = indices.size();
+	result.IndexCount = cornerCount;
+
+	for (size_t ix = 0; ix < cornerCount; ix++) {
+		const float* corner = data + ix * 6;
+		auto key = std::make_tuple(corner[0], corner[1], corner[2]);
+		auto it = lookup.find(key);
+		if (it == lookup.end()) {
+			uint32_t index = static_cast<uint32_t>(verts.size()) - result.BaseVertex;
+			it = lookup.emplace(key, index).first;
+			verts.push_back({ corner[0], corner[1], corner[2] });
+		}
+		indices.push_back(it->second);
+	}
 }
 
 TTK::Impl::MeshHelper::MeshHelper()
 {
-	m_Teapot = __MakeMesh(TeapotData, sizeof(TeapotData));
-	m_Sphere = __MakeMesh(SphereData, sizeof(SphereData));
-	m_Cube   = __MakeMesh(CubeData, sizeof(CubeData));
-	
-	glBindVertexArray(0);
+	// All three meshes share one vertex buffer and one index buffer
+	std::vector<glm::vec3> verts;
+	std::vector<uint32_t> indices;
+	__AddMesh(m_Teapot, TeapotData, sizeof(TeapotData), verts, indices);
+	__AddMesh(m_Sphere, SphereData, sizeof(SphereData), verts, indices);
+	__AddMesh(m_Cube, CubeData, sizeof(CubeData), verts, indices);
+
+	glCreateBuffers(1, &m_VBO);
+	glNamedBufferStorage(m_VBO, verts.size() * sizeof(glm::vec3), verts.data(), 0);
+	glCreateBuffers(1, &m_IBO);
+	glNamedBufferStorage(m_IBO, indices.size() * sizeof(uint32_t), indices.data(), 0);
+	glCreateBuffers(1, &m_InstanceBuffer);
+	m_InstanceCapacity = 0;
+
+	// Binding 0 is the mesh vertices, binding 1 steps once per instance
+	glCreateVertexArrays(1, &m_VAO);
+	glVertexArrayVertexBuffer(m_VAO, 0, m_VBO, 0, sizeof(glm::vec3));
+	glVertexArrayVertexBuffer(m_VAO, 1, m_InstanceBuffer, 0, sizeof(Instance));
+	glVertexArrayBindingDivisor(m_VAO, 1, 1);
+	glVertexArrayElementBuffer(m_VAO, m_IBO);
+
+	glEnableVertexArrayAttrib(m_VAO, 0);
+	glVertexArrayAttribFormat(m_VAO, 0, 3, GL_FLOAT, false, 0);
+	glVertexArrayAttribBinding(m_VAO, 0, 0);
+
+	// A mat4 attribute takes up four locations, one per column
+	for (GLuint col = 0; col < 4; col++) {
+		glEnableVertexArrayAttrib(m_VAO, 1 + col);
+		glVertexArrayAttribFormat(m_VAO, 1 + col, 4, GL_FLOAT, false, static_cast<GLuint>(offsetof(Instance, Transform) + sizeof(glm::vec4) * col));
+		glVertexArrayAttribBinding(m_VAO, 1 + col, 1);
+	}
+	glEnableVertexArrayAttrib(m_VAO, 5);
+	glVertexArrayAttribFormat(m_VAO, 5, 4, GL_FLOAT, false, static_cast<GLuint>(offsetof(Instance, Color)));
+	glVertexArrayAttribBinding(m_VAO, 5, 1);
 	
 	const char* vsSource = R"LIT(#version 430
             layout (location = 0) in vec3 vertexPosition;
-            layout (location = 0) uniform mat4 xTransform;	
+            layout (location = 1) in mat4 instanceTransform;
+            layout (location = 5) in vec4 instanceColor;
+            layout (location = 0) out vec4 fragmentColor;
             void main() {
-                gl_Position = xTransform * vec4(vertexPosition, 1);
+                gl_Position = instanceTransform * vec4(vertexPosition, 1);
+                fragmentColor = instanceColor;
             })LIT";
 
 	const char* fsSource = R"LIT(#version 430   
-            layout (location = 1) uniform vec4 xColor;		
+            layout (location = 0) in vec4 fragColor;
             out vec4 frag_color;            	
             void main() {
-                frag_color = xColor;
+                frag_color = fragColor;
             })LIT";
 
 	m_Shader = glCreateProgram();
@@ -12,6 +12,8 @@
 
 #include "TTK/TTKContext.h"
 #include <GLM/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include "Logging.h"
 #include "TTK/MeshHelper.h"
@@ -21,13 +23,14 @@ TTK::Context* TTK::Context::m_Instance = nullptr;
 TTK::Context::~Context() {
 	delete m_MeshHelper;
 	delete m_DefaultFont;
-	glDeleteBuffers(1, &m_Tris.VBO);
-	glDeleteBuffers(1, &m_Lines.VBO);
-	glDeleteBuffers(1, &m_Points.VBO);
+	__FreeStorage(m_Tris);
+	__FreeStorage(m_Lines);
+	__FreeStorage(m_Points);
 	glDeleteVertexArrays(1, &m_Tris.VAO);
 	glDeleteVertexArrays(1, &m_Lines.VAO);
 	glDeleteVertexArrays(1, &m_Points.VAO);
 	glDeleteProgram(m_ShaderHandle);
+	glDeleteProgram(m_PointShaderHandle);
 }
 
 glm::mat4 TTK::Context::GetOrthoProjection() const {
@@ -56,40 +59,30 @@ void TTK::Context::RenderText(const char* text, const glm::vec2& position, const
 	TTK::FontRenderer::Instance().Render(*m_DefaultFont, text, position, color, scale);
 }
 
-void TTK::Context::DrawTeapot(const glm::mat4& mat, const glm::vec4& color) const {
+void TTK::Context::DrawTeapot(const glm::mat4& mat, const glm::vec4& color) {
 	m_MeshHelper->RenderTeapot(mat, color);
 }
 
-void TTK::Context::DrawSphere(const glm::mat4& mat, const glm::vec4& color) const {
+void TTK::Context::DrawSphere(const glm::mat4& mat, const glm::vec4& color) {
 	m_MeshHelper->RenderSphere(mat, color);
 }
 
-void TTK::Context::DrawCube(const glm::mat4& mat, const glm::vec4& color) const {
+void TTK::Context::DrawCube(const glm::mat4& mat, const glm::vec4& color) {
 	m_MeshHelper->RenderCube(mat, color);
 }
 
 void TTK::Context::AddLine(const glm::vec3& a, const glm::vec3& b, const glm::vec4& color) {
-	m_LineVerts[m_Lines.Count + 0].Position = a;
-	m_LineVerts[m_Lines.Count + 0].Color = color;
-	m_LineVerts[m_Lines.Count + 1].Position = b;
-	m_LineVerts[m_Lines.Count + 1].Color = color;
-	m_Lines.Count += 2;
-	if (m_Lines.Count == MaxLineVerts) {
-		__Flush(m_Lines);
-	}
+	// We write straight into the mapped buffer, no staging copy
+	SimpleVert* verts = static_cast<SimpleVert*>(__Reserve(m_Lines, 2));
+	verts[0] = { a, color };
+	verts[1] = { b, color };
 }
 
 void TTK::Context::AddTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec4& color) {
-	m_TriVerts[m_Tris.Count + 0].Position = a;
-	m_TriVerts[m_Tris.Count + 0].Color = color;
-	m_TriVerts[m_Tris.Count + 1].Position = b;
-	m_TriVerts[m_Tris.Count + 1].Color = color;
-	m_TriVerts[m_Tris.Count + 2].Position = c;
-	m_TriVerts[m_Tris.Count + 2].Color = color;
-	m_Tris.Count += 3;
-	if (m_Tris.Count == MaxTriVerts) {
-		__Flush(m_Tris);
-	}
+	SimpleVert* verts = static_cast<SimpleVert*>(__Reserve(m_Tris, 3));
+	verts[0] = { a, color };
+	verts[1] = { b, color };
+	verts[2] = { c, color };
 }
 
 void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm::vec4& color) {
@@ -101,19 +94,47 @@ void TTK::Context::AddQuad(const glm::vec3& min, const glm::vec3& max, const glm
 
 void TTK::Context::AddPoint(const glm::vec3& pos, float size, const glm::vec4& color)
 {
-	m_PointVerts[m_Points.Count].Position = pos;
-	m_PointVerts[m_Points.Count].Color = color;
-	m_PointVerts[m_Points.Count].Size = size;
-	m_Points.Count += 1;
-	if (m_Points.Count == MaxPointVerts) {
-		__Flush(m_Points);
+	PointVert* vert = static_cast<PointVert*>(__Reserve(m_Points, 1));
+	*vert = { pos, color, size };
+}
+
+void TTK::Context::AddLines(const SimpleVert* verts, size_t vertCount) {
+	vertCount -= vertCount % 2;
+	if (vertCount == 0) return;
+	void* dest = __Reserve(m_Lines, vertCount);
+	memcpy(dest, verts, vertCount * sizeof(SimpleVert));
+}
+
+void TTK::Context::AddLines(const glm::vec3* points, size_t pointCount, const glm::vec4& color) {
+	pointCount -= pointCount % 2;
+	if (pointCount == 0) return;
+	SimpleVert* dest = static_cast<SimpleVert*>(__Reserve(m_Lines, pointCount));
+	for (size_t ix = 0; ix < pointCount; ix++) {
+		dest[ix] = { points[ix], color };
+	}
+}
+
+void TTK::Context::AddPoints(const PointVert* verts, size_t vertCount) {
+	if (vertCount == 0) return;
+	void* dest = __Reserve(m_Points, vertCount);
+	memcpy(dest, verts, vertCount * sizeof(PointVert));
+}
+
+void TTK::Context::AddPoints(const glm::vec3* points, size_t pointCount, float size, const glm::vec4& color) {
+	if (pointCount == 0) return;
+	PointVert* dest = static_cast<PointVert*>(__Reserve(m_Points, pointCount));
+	for (size_t ix = 0; ix < pointCount; ix++) {
+		dest[ix] = { points[ix], color, size };
 	}
 }
 
 void TTK::Context::Flush() {
+	m_MeshHelper->Flush();
 	__Flush(m_Tris);
 	__Flush(m_Lines);
 	__Flush(m_Points);
+	// text goes last so it sits on top of everything else
+	TTK::FontRenderer::Instance().Flush();
 }
 
 TTK::Context::Context() {
@@ -159,27 +180,21 @@ TTK::Context::Context() {
 	m_PointShaderHandle = __CompileShader(vsSourcePoint, fsSource);
 
 
-	m_Tris = __InitBuff(GL_TRIANGLES, m_ShaderHandle, m_TriVerts, sizeof(SimpleVert), MaxTriVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
-
-	m_Lines = __InitBuff(GL_LINES, m_ShaderHandle, m_LineVerts, sizeof(SimpleVert), MaxLineVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(SimpleVert), (void*)offsetof(SimpleVert, Color));
+	__InitBuff(m_Tris, GL_TRIANGLES, m_ShaderHandle, sizeof(SimpleVert), InitialTriVerts, {
+		{ 0, 3, offsetof(SimpleVert, Position) },
+		{ 1, 4, offsetof(SimpleVert, Color) }
+	});
 
-	m_Points = __InitBuff(GL_POINTS, m_PointShaderHandle, m_PointVerts, sizeof(PointVert), MaxLineVerts);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Position));
-	glVertexAttribPointer(1, 4, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Color));
-	glVertexAttribPointer(2, 1, GL_FLOAT, false, sizeof(PointVert), (void*)offsetof(PointVert, Size));
+	__InitBuff(m_Lines, GL_LINES, m_ShaderHandle, sizeof(SimpleVert), InitialLineVerts, {
+		{ 0, 3, offsetof(SimpleVert, Position) },
+		{ 1, 4, offsetof(SimpleVert, Color) }
+	});
 
-	glBindVertexArray(0);
+	__InitBuff(m_Points, GL_POINTS, m_PointShaderHandle, sizeof(PointVert), InitialPointVerts, {
+		{ 0, 3, offsetof(PointVert, Position) },
+		{ 1, 4, offsetof(PointVert, Color) },
+		{ 2, 1, offsetof(PointVert, Size) }
+	});
 
 	// Make sure that the mesh helper has a context
 	m_MeshHelper = new Impl::MeshHelper();
@@ -188,31 +203,156 @@ TTK::Context::Context() {
 	glEnable(GL_PROGRAM_POINT_SIZE);
 }
 
-TTK::Context::GLBuff TTK::Context::__InitBuff(GLenum mode, GLuint shader, void* dataSource, size_t elemSize, size_t maxElems)
+void TTK::Context::__InitBuff(GLBuff& buff, GLenum mode, GLuint shader, size_t elemSize, size_t initialElems, std::initializer_list<AttribDesc> attribs)
+{
+	buff.Mode = mode;
+	buff.Shader = shader;
+	buff.ElemSize = elemSize;
+	buff.VBO = 0;
+	buff.Capacity = 0;
+	buff.Mapped = nullptr;
+	buff.Head = 0;
+	buff.Count = 0;
+
+	// The vertex format lives on the VAO, separate from the buffer, so that when we grow
+	// we only need to point binding 0 at the new buffer
+	glCreateVertexArrays(1, &buff.VAO);
+	for (const AttribDesc& attrib : attribs) {
+		glEnableVertexArrayAttrib(buff.VAO, attrib.Index);
+		glVertexArrayAttribFormat(buff.VAO, attrib.Index, attrib.Size, GL_FLOAT, false, static_cast<GLuint>(attrib.Offset));
+		glVertexArrayAttribBinding(buff.VAO, attrib.Index, 0);
+	}
+
+	__AllocStorage(buff, initialElems);
+}
+
+void TTK::Context::__AllocStorage(GLBuff& buff, size_t elems)
 {
-	GLBuff result;
-	result.Mode = mode;
-	result.Count = 0;
-	result.Data = dataSource;
-	result.ElemSize = elemSize;
-	result.Shader = shader;
-
-	glCreateVertexArrays(1, &result.VAO);
-	glBindVertexArray(result.VAO);
-	glCreateBuffers(1, &result.VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, result.VBO);
-	glNamedBufferData(result.VBO, elemSize * maxElems, nullptr, GL_STREAM_DRAW);
+	// Immutable storage that stays mapped for the lifetime of the buffer, coherent so that
+	// anything we write is visible to the next draw without an explicit flush
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = static_cast<GLsizeiptr>(elems * buff.ElemSize);
+
+	glCreateBuffers(1, &buff.VBO);
+	glNamedBufferStorage(buff.VBO, size, nullptr, flags);
+	buff.Mapped = static_cast<uint8_t*>(glMapNamedBufferRange(buff.VBO, 0, size, flags));
+	if (buff.Mapped == nullptr) {
+		LOG_ERROR("Failed to map a {} byte TTK stream buffer!", size);
+		throw std::runtime_error("Failed to map TTK stream buffer!");
+	}
 
-	return result;
+	buff.Capacity = elems;
+	buff.Head = 0;
+	buff.Count = 0;
+	glVertexArrayVertexBuffer(buff.VAO, 0, buff.VBO, 0, static_cast<GLsizei>(buff.ElemSize));
+}
+
+void TTK::Context::__FreeStorage(GLBuff& buff)
+{
+	for (RangeFence& fence : buff.Fences) {
+		glDeleteSync(fence.Sync);
+	}
+	buff.Fences.clear();
+
+	if (buff.VBO != 0) {
+		// GL keeps the storage alive until any draws still reading from it are done
+		glUnmapNamedBuffer(buff.VBO);
+		glDeleteBuffers(1, &buff.VBO);
+	}
+	buff.VBO = 0;
+	buff.Mapped = nullptr;
+	buff.Capacity = 0;
+}
+
+void TTK::Context::__Grow(GLBuff& buff, size_t minElems)
+{
+	// Draw whatever is still pending in the old buffer first
+	__Flush(buff);
+
+	size_t newCapacity = std::max(buff.Capacity * 2, minElems);
+	if (newCapacity * buff.ElemSize > MaxStreamBytes) {
+		newCapacity = std::max(MaxStreamBytes / buff.ElemSize, minElems);
+	}
+	// Keep whole primitives, so a wrap never splits a line or a triangle
+	if (buff.Mode == GL_LINES) newCapacity += newCapacity % 2;
+	if (buff.Mode == GL_TRIANGLES) newCapacity += (3 - newCapacity % 3) % 3;
+
+	LOG_INFO("Growing TTK stream buffer from {} to {} vertices", buff.Capacity, newCapacity);
+	__FreeStorage(buff);
+	__AllocStorage(buff, newCapacity);
+}
+
+bool TTK::Context::__WaitForRange(GLBuff& buff, size_t begin, size_t end, bool block)
+{
+	// Wrapping early leaves older fences near the end of the ring queued in front of newer ones
+	// near the start, so the queue isn't sorted by position and we have to check every fence
+	for (auto it = buff.Fences.begin(); it != buff.Fences.end(); ) {
+		RangeFence& fence = *it;
+		if (fence.End <= begin || fence.Begin >= end) {
+			++it;
+			continue;
+		}
+
+		GLenum result = glClientWaitSync(fence.Sync, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			if (!block) {
+				return false;
+			}
+			do {
+				result = glClientWaitSync(fence.Sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence.Sync);
+		it = buff.Fences.erase(it);
+	}
+	return true;
+}
+
+void* TTK::Context::__Reserve(GLBuff& buff, size_t elems)
+{
+	// An array bigger than the whole ring needs a bigger ring
+	if (elems > buff.Capacity) {
+		__Grow(buff, elems);
+	}
+
+	// If we would run off the end, draw what we have and wrap back around to the start
+	if (buff.Head + buff.Count + elems > buff.Capacity) {
+		__Flush(buff);
+		buff.Head = 0;
+	}
+
+	size_t begin = buff.Head + buff.Count;
+	if (!__WaitForRange(buff, begin, begin + elems, false)) {
+		// The GPU is still reading the space we need, which means the ring is too small for how
+		// much we draw in a few frames. Grow it rather than stall, unless we've hit our limit
+		if (buff.Capacity * buff.ElemSize < MaxStreamBytes) {
+			__Grow(buff, elems);
+			begin = 0;
+		} else {
+			__WaitForRange(buff, begin, begin + elems, true);
+		}
+	}
+
+	buff.Count += elems;
+	return buff.Mapped + begin * buff.ElemSize;
 }
 
 void TTK::Context::__Flush(GLBuff& buff) {
 	if (buff.Count > 0) {
 		glUseProgram(buff.Shader);
 		glUniformMatrix4fv(0, 1, false, &m_ViewProjection[0][0]);
-		glNamedBufferSubData(buff.VBO, 0, buff.Count * buff.ElemSize, buff.Data);
 		glBindVertexArray(buff.VAO);
-		glDrawArrays(buff.Mode, 0, static_cast<GLsizei>(buff.Count));
+		glDrawArrays(buff.Mode, static_cast<GLint>(buff.Head), static_cast<GLsizei>(buff.Count));
+
+		// Fence the range we just drew, so we know when it's safe to write over it again
+		RangeFence fence;
+		fence.Sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		fence.Begin = buff.Head;
+		fence.End = buff.Head + buff.Count;
+		buff.Fences.push_back(fence);
+
+		buff.Head += buff.Count;
 		buff.Count = 0;
 	}
 }
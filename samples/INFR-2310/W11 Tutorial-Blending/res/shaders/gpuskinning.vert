@@ -5,17 +5,37 @@ NOU Framework - Created for INFR 2310 at Ontario Tech.
 gpuskinning.vert
 Vertex shader.
 For skinning on the GPU.
+
+Every character drawn this frame has its joint matrices in one big
+storage buffer, and its model and normal matrices in another.
+Characters sharing a mesh are drawn instanced, so we use the
+instance ID to find which character we're drawing.
 */
 
-#version 420 core
+#version 430 core
 
-const int MAX_JOINTS = 32;
+struct InstanceData
+{
+    mat4 model;
+    //Only the upper 3x3 is used - it's stored as a mat4 to keep the layout simple.
+    mat4 normal;
+    //x = where this character's joints start in the palette.
+    uvec4 palette;
+};
 
-uniform mat4 model;
-uniform mat3 normal;
-uniform mat4 viewproj;
+layout(std430, binding = 0) readonly buffer JointPalettes
+{
+    mat4 jointMatrices[];
+};
 
-uniform mat4 jointMatrices[MAX_JOINTS];
+layout(std430, binding = 1) readonly buffer Instances
+{
+    InstanceData instances[];
+};
+
+uniform mat4 viewproj;
+//Where the current group of characters starts in the instance buffer.
+uniform int instanceOffset;
 
 //Model-space vertex position.
 layout(location = 0) in vec4 inPos;
@@ -34,16 +54,19 @@ layout(location = 2) out vec2 outUV;
 
 void main()
 {
+    InstanceData instance = instances[instanceOffset + gl_InstanceID];
+    int firstJoint = int(instance.palette.x);
+
     mat4 skinMat = 
-        inWeights.x * jointMatrices[int(inJoints.x)] +
-        inWeights.y * jointMatrices[int(inJoints.y)] +
-        inWeights.z * jointMatrices[int(inJoints.z)] +
-        inWeights.w * jointMatrices[int(inJoints.w)];
+        inWeights.x * jointMatrices[firstJoint + int(inJoints.x)] +
+        inWeights.y * jointMatrices[firstJoint + int(inJoints.y)] +
+        inWeights.z * jointMatrices[firstJoint + int(inJoints.z)] +
+        inWeights.w * jointMatrices[firstJoint + int(inJoints.w)];
 
     vec4 skinnedPos = skinMat * inPos;
 
-    outPos = model * skinnedPos;
-    outNorm = normalize(normal * (skinMat * vec4(inNorm, 0.0)).xyz);
+    outPos = instance.model * skinnedPos;
+    outNorm = normalize(mat3(instance.normal) * (skinMat * vec4(inNorm, 0.0)).xyz);
     outUV = inUV;
 
     gl_Position = viewproj * outPos;
@@ -7,9 +7,156 @@ Classes for managing animation data and blendtrees.
 */
 
 #include "Animation.h"
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cmath>
+
+//We use SSE to process 4 joints at once where it's available
+//(every x64 CPU has it), and fall back to plain loops otherwise.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NOU_ANIM_SSE 1
+#endif
 
 namespace nou
 {
+	namespace
+	{
+		//A small set of helpers for working on 4 floats at a time.
+		//Each float is a different joint - so one Add() adds
+		//4 joints' worth of x components in a single instruction.
+#ifdef NOU_ANIM_SSE
+		typedef __m128 Float4;
+
+		inline Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+		inline void Store(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+		inline Float4 Splat(float f) { return _mm_set1_ps(f); }
+		inline Float4 Add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+		inline Float4 Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+		inline Float4 Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+		inline Float4 Div(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+		inline Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a); }
+		//Flips the sign of a wherever s is negative.
+		inline Float4 FlipSignWhereNegative(Float4 a, Float4 s)
+		{
+			Float4 signBits = _mm_and_ps(s, _mm_set1_ps(-0.0f));
+			return _mm_xor_ps(a, signBits);
+		}
+#else
+		struct Float4
+		{
+			float v[4];
+		};
+
+		inline Float4 Load(const float* p) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+		inline void Store(float* p, Float4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+		inline Float4 Splat(float f) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = f; return r; }
+		inline Float4 Add(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+		inline Float4 Sub(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+		inline Float4 Mul(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+		inline Float4 Div(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] /= b.v[i]; return a; }
+		inline Float4 Sqrt(Float4 a) { for (int i = 0; i < 4; ++i) a.v[i] = std::sqrt(a.v[i]); return a; }
+		inline Float4 FlipSignWhereNegative(Float4 a, Float4 s) { for (int i = 0; i < 4; ++i) a.v[i] = (s.v[i] < 0.0f) ? -a.v[i] : a.v[i]; return a; }
+#endif
+
+		//LERP for 4 joints: a + (b - a) * t.
+		inline Float4 Lerp(Float4 a, Float4 b, Float4 t)
+		{
+			return Add(a, Mul(Sub(b, a), t));
+		}
+
+		//A quaternion for 4 joints, one component per register.
+		struct Quat4
+		{
+			Float4 x, y, z, w;
+		};
+
+		inline Quat4 LoadQuat(const float* x, const float* y, const float* z, const float* w)
+		{
+			return { Load(x), Load(y), Load(z), Load(w) };
+		}
+
+		inline void StoreQuat(float* x, float* y, float* z, float* w, const Quat4& q)
+		{
+			Store(x, q.x);
+			Store(y, q.y);
+			Store(z, q.z);
+			Store(w, q.w);
+		}
+
+		//NLERP for 4 joints - LERP each component, then normalize.
+		//This is much cheaper than SLERP, and for keys that are close together (like animation
+		//keys usually are) the difference is too small to see.
+		inline Quat4 Nlerp(const Quat4& a, Quat4 b, Float4 t)
+		{
+			//If the quaternions are more than 90 degrees apart, flip b so
+			//we take the short way around.
+			Float4 dot = Add(Add(Mul(a.x, b.x), Mul(a.y, b.y)), Add(Mul(a.z, b.z), Mul(a.w, b.w)));
+			b.x = FlipSignWhereNegative(b.x, dot);
+			b.y = FlipSignWhereNegative(b.y, dot);
+			b.z = FlipSignWhereNegative(b.z, dot);
+			b.w = FlipSignWhereNegative(b.w, dot);
+
+			Quat4 r = { Lerp(a.x, b.x, t), Lerp(a.y, b.y, t), Lerp(a.z, b.z, t), Lerp(a.w, b.w, t) };
+
+			Float4 len = Sqrt(Add(Add(Mul(r.x, r.x), Mul(r.y, r.y)), Add(Mul(r.z, r.z), Mul(r.w, r.w))));
+			r.x = Div(r.x, len);
+			r.y = Div(r.y, len);
+			r.z = Div(r.z, len);
+			r.w = Div(r.w, len);
+
+			return r;
+		}
+
+		//Quaternion multiplication (a * b) for 4 joints - same as glm's operator*.
+		inline Quat4 QuatMul(const Quat4& a, const Quat4& b)
+		{
+			Quat4 r;
+			r.w = Sub(Sub(Mul(a.w, b.w), Mul(a.x, b.x)), Add(Mul(a.y, b.y), Mul(a.z, b.z)));
+			r.x = Sub(Add(Add(Mul(a.w, b.x), Mul(a.x, b.w)), Mul(a.y, b.z)), Mul(a.z, b.y));
+			r.y = Add(Sub(Mul(a.w, b.y), Mul(a.x, b.z)), Add(Mul(a.y, b.w), Mul(a.z, b.x)));
+			r.z = Add(Sub(Add(Mul(a.w, b.z), Mul(a.x, b.y)), Mul(a.y, b.x)), Mul(a.z, b.w));
+			return r;
+		}
+
+		//Moves a track's cursor forward to the key just before time.
+		//We stop at the second last key since we make the assumption
+		//that our animation's last frame is the same as its
+		//first (a perfect loop) - this may or may not
+		//be the case depending on how you manage your own animation work.
+		//times(key) gives a key's time - so this works for baked and compressed clips alike.
+		template<typename TimeFn>
+		inline uint32_t AdvanceCursor(TimeFn times, uint32_t first, uint32_t count, uint32_t& cursor, float time)
+		{
+			uint32_t last = first + count - 1;
+
+			//If time went backwards (or the cursor was never set), start over.
+			if (cursor < first || cursor > last || time < times(cursor))
+				cursor = first;
+
+			while (cursor + 1 < last && time > times(cursor + 1))
+				++cursor;
+
+			return cursor;
+		}
+
+		//Works out how far between its current key and the next key a track is.
+		inline float KeyT(float curTime, float nextTime, float time)
+		{
+			if (nextTime <= curTime)
+				return 0.0f;
+
+			float t = (time - curTime) / (nextTime - curTime);
+			return std::min(std::max(t, 0.0f), 1.0f);
+		}
+
+		inline size_t PadToFour(size_t n)
+		{
+			return (n + 3) & ~static_cast<size_t>(3);
+		}
+	}
+
 	JointAnim::JointAnim()
 	{
 		jointInd = 0;
@@ -17,10 +164,27 @@ namespace nou
 		posFrames = 0;
 	}
 
+	void BakedClip::Clear()
+	{
+		posTracks.clear();
+		posTimes.clear();
+		posX.clear();
+		posY.clear();
+		posZ.clear();
+
+		rotTracks.clear();
+		rotTimes.clear();
+		rotX.clear();
+		rotY.clear();
+		rotZ.clear();
+		rotW.clear();
+	}
+
 	SkeletalAnim::SkeletalAnim()
 	{
 		duration = 0.0f;
 		isDiffClip = false;
+		m_bakedDirty = true;
 	}
 
 	void SkeletalAnim::Keep(const std::vector<int> joints)
@@ -35,9 +199,11 @@ namespace nou
 				it = data.erase(it);
 				continue;
 			}
-				
+
 			++it;
 		}
+
+		MarkDirty();
 	}
 
 	void SkeletalAnim::MakeDiffWith(const Skeleton& skeleton)
@@ -58,12 +224,145 @@ namespace nou
 				data[i].rotKeys[j] = data[i].rotKeys[j] * glm::inverse(skeleton.m_joints[data[i].jointInd].m_baseRotation);
 			}
 		}
+
+		MarkDirty();
+	}
+
+	void SkeletalAnim::MarkDirty()
+	{
+		m_bakedDirty = true;
+	}
+
+	void SkeletalAnim::SetCompressed(std::shared_ptr<const CompressedClip> clip)
+	{
+		m_compressed = clip;
+
+		if (m_compressed == nullptr)
+			return;
+
+		duration = m_compressed->GetDuration();
+		isDiffClip = m_compressed->IsDiffClip();
+
+		//The compressed clip has everything we need now, so free up the full precision keys.
+		std::vector<JointAnim>().swap(data);
+		MarkDirty();
 	}
 
-	SkeletalAnimNode::JointPose::JointPose()
+	const CompressedClip* SkeletalAnim::GetCompressed() const
 	{
-		pos = glm::vec3(0.0f, 0.0f, 0.0f);
-		rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		return m_compressed.get();
+	}
+
+	const BakedClip& SkeletalAnim::GetBaked() const
+	{
+		if (!m_bakedDirty.load(std::memory_order_acquire))
+			return m_baked;
+
+		//Whoever gets the lock first does the baking, anyone else waits for them and then
+		//sees the clip is clean.
+		std::lock_guard<std::mutex> lock(m_bakeMutex);
+
+		if (!m_bakedDirty.load(std::memory_order_relaxed))
+			return m_baked;
+
+		m_baked.Clear();
+
+		for (const JointAnim& joint : data)
+		{
+			//Joints with no keys of a type don't get a track for it at all.
+			if (joint.posFrames > 0)
+			{
+				m_baked.posTracks.push_back({ joint.jointInd, (uint32_t)m_baked.posTimes.size(), (uint32_t)joint.posFrames });
+
+				for (int k = 0; k < joint.posFrames; ++k)
+				{
+					m_baked.posTimes.push_back(joint.posTimes[k]);
+					m_baked.posX.push_back(joint.posKeys[k].x);
+					m_baked.posY.push_back(joint.posKeys[k].y);
+					m_baked.posZ.push_back(joint.posKeys[k].z);
+				}
+			}
+
+			if (joint.rotFrames > 0)
+			{
+				m_baked.rotTracks.push_back({ joint.jointInd, (uint32_t)m_baked.rotTimes.size(), (uint32_t)joint.rotFrames });
+
+				for (int k = 0; k < joint.rotFrames; ++k)
+				{
+					m_baked.rotTimes.push_back(joint.rotTimes[k]);
+					m_baked.rotX.push_back(joint.rotKeys[k].x);
+					m_baked.rotY.push_back(joint.rotKeys[k].y);
+					m_baked.rotZ.push_back(joint.rotKeys[k].z);
+					m_baked.rotW.push_back(joint.rotKeys[k].w);
+				}
+			}
+		}
+
+		m_bakedDirty.store(false, std::memory_order_release);
+		return m_baked;
+	}
+
+	PoseBuffer::PoseBuffer()
+	{
+		numJoints = 0;
+	}
+
+	void PoseBuffer::Resize(size_t joints)
+	{
+		numJoints = joints;
+		size_t padded = PadToFour(joints);
+
+		posX.resize(padded);
+		posY.resize(padded);
+		posZ.resize(padded);
+		rotX.resize(padded);
+		rotY.resize(padded);
+		rotZ.resize(padded);
+		rotW.resize(padded);
+
+		SetToIdentity();
+	}
+
+	void PoseBuffer::SetToBasePose(const Skeleton& skeleton)
+	{
+		SetToIdentity();
+
+		for (size_t i = 0; i < numJoints && i < skeleton.m_joints.size(); ++i)
+		{
+			const Joint& joint = skeleton.m_joints[i];
+
+			posX[i] = joint.m_basePos.x;
+			posY[i] = joint.m_basePos.y;
+			posZ[i] = joint.m_basePos.z;
+			rotX[i] = joint.m_baseRotation.x;
+			rotY[i] = joint.m_baseRotation.y;
+			rotZ[i] = joint.m_baseRotation.z;
+			rotW[i] = joint.m_baseRotation.w;
+		}
+	}
+
+	void PoseBuffer::SetToIdentity()
+	{
+		//The padding joints get identity too - so normalizing them never divides by zero.
+		std::fill(posX.begin(), posX.end(), 0.0f);
+		std::fill(posY.begin(), posY.end(), 0.0f);
+		std::fill(posZ.begin(), posZ.end(), 0.0f);
+		std::fill(rotX.begin(), rotX.end(), 0.0f);
+		std::fill(rotY.begin(), rotY.end(), 0.0f);
+		std::fill(rotZ.begin(), rotZ.end(), 0.0f);
+		std::fill(rotW.begin(), rotW.end(), 1.0f);
+	}
+
+	void PoseBuffer::CopyFrom(const PoseBuffer& other)
+	{
+		//Same size, so this never allocates.
+		std::copy(other.posX.begin(), other.posX.end(), posX.begin());
+		std::copy(other.posY.begin(), other.posY.end(), posY.begin());
+		std::copy(other.posZ.begin(), other.posZ.end(), posZ.begin());
+		std::copy(other.rotX.begin(), other.rotX.end(), rotX.begin());
+		std::copy(other.rotY.begin(), other.rotY.end(), rotY.begin());
+		std::copy(other.rotZ.begin(), other.rotZ.end(), rotZ.begin());
+		std::copy(other.rotW.begin(), other.rotW.end(), rotW.begin());
 	}
 
 	SkeletalAnimNode::SkeletalAnimNode(const SkeletalAnim& anim, const Skeleton& skeleton)
@@ -75,34 +374,41 @@ namespace nou
 		m_mode = BlendMode::PASS;
 		m_blendParam = 0.0f;
 
-		//Should have output for each joint in our skeleton.
-		m_output.resize(skeleton.m_joints.size());
-		m_lhs.resize(skeleton.m_joints.size());
+		//All of our pose buffers are allocated once, here - updating never allocates.
+		size_t numJoints = skeleton.m_joints.size();
+		m_base.Resize(numJoints);
+		m_base.SetToBasePose(skeleton);
+
+		//Output should default to the base pose of our skeleton.
+		m_output.Resize(numJoints);
+		m_output.CopyFrom(m_base);
+
+		//Local output will depend on whether or not we're a diff clip.
+		//If we are a diff clip, transforms should be identity.
+		//If we're not a diff clip, transforms should be base pose.
+		m_lhs.Resize(numJoints);
 
-		glm::vec3 zeroPos = glm::vec3(0.0f, 0.0f, 0.0f);
-		glm::quat zeroRot = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		if (!anim.isDiffClip)
+			m_lhs.CopyFrom(m_base);
 
-		for (size_t i = 0; i < skeleton.m_joints.size(); ++i)
+		const CompressedClip* packed = m_anim.GetCompressed();
+
+		if (packed != nullptr)
 		{
-			//Output should default to the base pose of our skeleton.
-			m_output[i].pos = skeleton.m_joints[i].m_basePos;
-			m_output[i].rotation = skeleton.m_joints[i].m_baseRotation;
-
-			//Local output will depend on whether or not we're a diff clip.
-			//If we are a diff clip, transforms should be identity.
-			//If we're not a diff clip, transforms should be base pose.
-			m_lhs[i].pos = (anim.isDiffClip) ? zeroPos : skeleton.m_joints[i].m_basePos;
-			m_lhs[i].rotation = (anim.isDiffClip) ? zeroRot : skeleton.m_joints[i].m_baseRotation;
+			m_posCursor.resize(packed->GetNumPosTracks());
+			m_rotCursor.resize(packed->GetNumRotTracks());
+		}
+		else
+		{
+			const BakedClip& clip = m_anim.GetBaked();
+			m_posCursor.resize(clip.posTracks.size());
+			m_rotCursor.resize(clip.rotTracks.size());
 		}
 
-		m_rotFrame.resize(m_anim.data.size());
-		std::fill(m_rotFrame.begin(), m_rotFrame.end(), 0);
-
-		m_posFrame.resize(m_anim.data.size());
-		std::fill(m_posFrame.begin(), m_posFrame.end(), 0);
+		ResetCursors();
 	}
 
-	void SkeletalAnimNode::SetRHS(SkeletalAnimNode* rhs, 
+	void SkeletalAnimNode::SetRHS(SkeletalAnimNode* rhs,
 						          SkeletalAnimNode::BlendMode mode,
 								  float blendParam)
 	{
@@ -130,10 +436,7 @@ namespace nou
 
 			//Should we loop over to the beginning?
 			if (m_timer > m_anim.duration)
-			{
-				std::fill(m_rotFrame.begin(), m_rotFrame.end(), 0);
-				std::fill(m_posFrame.begin(), m_posFrame.end(), 0);
-			}
+				ResetCursors();
 
 			while (m_timer > m_anim.duration)
 				m_timer -= m_anim.duration;
@@ -144,156 +447,260 @@ namespace nou
 		//Interpolate joint positions.
 		UpdatePositions();
 		//Set the output of this node.
-		UpdateOutput(skeleton);
+		UpdateOutput();
 	}
 
 	void SkeletalAnimNode::Apply(Skeleton& skeleton)
 	{
-		//Indices of output match joint indices.
-		for (size_t i = 0; i < m_output.size(); ++i)
-		{
-			Joint& joint = skeleton.m_joints[i];
-			joint.m_pos = m_output[i].pos;
-			joint.m_rotation = m_output[i].rotation;
-		}
+		//Indices of output match joint indices, and the skeleton keeps its
+		//pose in the same layout as ours - so this is just a few straight copies.
+		size_t count = std::min(m_output.numJoints, skeleton.m_posX.size());
+
+		std::copy(m_output.posX.begin(), m_output.posX.begin() + count, skeleton.m_posX.begin());
+		std::copy(m_output.posY.begin(), m_output.posY.begin() + count, skeleton.m_posY.begin());
+		std::copy(m_output.posZ.begin(), m_output.posZ.begin() + count, skeleton.m_posZ.begin());
+		std::copy(m_output.rotX.begin(), m_output.rotX.begin() + count, skeleton.m_rotX.begin());
+		std::copy(m_output.rotY.begin(), m_output.rotY.begin() + count, skeleton.m_rotY.begin());
+		std::copy(m_output.rotZ.begin(), m_output.rotZ.begin() + count, skeleton.m_rotZ.begin());
+		std::copy(m_output.rotW.begin(), m_output.rotW.begin() + count, skeleton.m_rotW.begin());
 	}
 
-	const std::vector<SkeletalAnimNode::JointPose>& SkeletalAnimNode::GetOutput()
+	const PoseBuffer& SkeletalAnimNode::GetOutput()
 	{
 		return m_output;
 	}
 
-	void SkeletalAnimNode::UpdatePositions()
+	void SkeletalAnimNode::ResetCursors()
 	{
-		for (size_t i = 0; i < m_anim.data.size(); ++i)
+		const CompressedClip* packed = m_anim.GetCompressed();
+
+		if (packed != nullptr)
 		{
-			//If we have no position data for this joint, move on.
-			if (m_anim.data[i].posFrames == 0)
-				continue;
+			for (uint32_t i = 0; i < m_posCursor.size(); ++i)
+				m_posCursor[i] = packed->GetPosTrack(i).first;
 
-			JointPose& pose = m_lhs[m_anim.data[i].jointInd];
+			for (uint32_t i = 0; i < m_rotCursor.size(); ++i)
+				m_rotCursor[i] = packed->GetRotTrack(i).first;
 
-			//If we only have one frame, use that.
-			if (m_anim.data[i].posFrames == 1)
-			{
-				pose.pos = m_anim.data[i].posKeys[0];
-				continue;
-			}
+			return;
+		}
 
-			//Update our frame index.
-			//We stop at frames - 2 since we make the assumption
-			//that our animation's last frame is the same as its
-			//first (a perfect loop) - this may or may not
-			//be the case depending on how you manage your own animation work.
-			while (m_timer > m_anim.data[i].posTimes[m_posFrame[i]
-				+ static_cast<size_t>(1)]
-				&& m_posFrame[i] < m_anim.data[i].posFrames - 2)
-			{
-				++m_posFrame[i];
-			}
+		const BakedClip& clip = m_anim.GetBaked();
 
-			size_t curFrame = m_posFrame[i];
-			size_t nextFrame = m_posFrame[i] + static_cast<size_t>(1);
+		for (size_t i = 0; i < m_posCursor.size(); ++i)
+			m_posCursor[i] = clip.posTracks[i].first;
 
-			float start = m_anim.data[i].posTimes[curFrame];
-			float end = m_anim.data[i].posTimes[nextFrame];
+		for (size_t i = 0; i < m_rotCursor.size(); ++i)
+			m_rotCursor[i] = clip.rotTracks[i].first;
+	}
 
-			float t = (m_timer - start) / (end - start);
+	void SkeletalAnimNode::UpdatePositions()
+	{
+		const CompressedClip* packed = m_anim.GetCompressed();
+		//Compressed clips have no baked copy (their full precision data is gone).
+		const BakedClip* clip = (packed == nullptr) ? &m_anim.GetBaked() : nullptr;
+		const size_t numTracks = m_posCursor.size();
+
+		//We sample 4 tracks at a time - first gathering each track's
+		//current and next keys into small arrays, then doing the LERP
+		//for all 4 at once.
+		for (size_t i = 0; i < numTracks; i += 4)
+		{
+			size_t lanes = std::min(numTracks - i, static_cast<size_t>(4));
 
-			if (t < 0.0f)
-				t = 0.0f;
+			float t[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float ax[4] = {}, ay[4] = {}, az[4] = {};
+			float bx[4] = {}, by[4] = {}, bz[4] = {};
+			int joints[4] = {};
 
-			else if (t > 1.0f)
-				t = 1.0f;
+			for (size_t lane = 0; lane < lanes; ++lane)
+			{
+				//Compressed clips are decoded right here, only the two keys we need.
+				if (packed != nullptr)
+				{
+					const CompressedClip::PosTrack& track = packed->GetPosTrack((uint32_t)(i + lane));
+					auto times = [packed](uint32_t key) { return packed->GetPosTime(key); };
+
+					uint32_t cur = AdvanceCursor(times, track.first, track.count, m_posCursor[i + lane], m_timer);
+					uint32_t next = std::min(cur + 1, track.first + track.count - 1);
+
+					t[lane] = KeyT(times(cur), times(next), m_timer);
+					glm::vec3 a = packed->DecodePos(track, cur);
+					glm::vec3 b = packed->DecodePos(track, next);
+					ax[lane] = a.x;
+					ay[lane] = a.y;
+					az[lane] = a.z;
+					bx[lane] = b.x;
+					by[lane] = b.y;
+					bz[lane] = b.z;
+					joints[lane] = track.jointInd;
+					continue;
+				}
+
+				const AnimTrack& track = clip->posTracks[i + lane];
+				auto times = [clip](uint32_t key) { return clip->posTimes[key]; };
+
+				uint32_t cur = AdvanceCursor(times, track.first, track.count, m_posCursor[i + lane], m_timer);
+				uint32_t next = std::min(cur + 1, track.first + track.count - 1);
+
+				t[lane] = KeyT(times(cur), times(next), m_timer);
+				ax[lane] = clip->posX[cur];
+				ay[lane] = clip->posY[cur];
+				az[lane] = clip->posZ[cur];
+				bx[lane] = clip->posX[next];
+				by[lane] = clip->posY[next];
+				bz[lane] = clip->posZ[next];
+				joints[lane] = track.jointInd;
+			}
 
-			//For vectors, glm::mix does LERP.
-			pose.pos = glm::mix(m_anim.data[i].posKeys[curFrame],
-								m_anim.data[i].posKeys[nextFrame],
-								t);
+			Float4 t4 = Load(t);
+			float outX[4], outY[4], outZ[4];
+			Store(outX, Lerp(Load(ax), Load(bx), t4));
+			Store(outY, Lerp(Load(ay), Load(by), t4));
+			Store(outZ, Lerp(Load(az), Load(bz), t4));
+
+			//Then write each result out to the joint its track belongs to.
+			for (size_t lane = 0; lane < lanes; ++lane)
+			{
+				int joint = joints[lane];
+				m_lhs.posX[joint] = outX[lane];
+				m_lhs.posY[joint] = outY[lane];
+				m_lhs.posZ[joint] = outZ[lane];
+			}
 		}
 	}
 
 	void SkeletalAnimNode::UpdateRotations()
 	{
-		for (size_t i = 0; i < m_anim.data.size(); ++i)
+		const CompressedClip* packed = m_anim.GetCompressed();
+		//Compressed clips have no baked copy (their full precision data is gone).
+		const BakedClip* clip = (packed == nullptr) ? &m_anim.GetBaked() : nullptr;
+		const size_t numTracks = m_rotCursor.size();
+
+		for (size_t i = 0; i < numTracks; i += 4)
 		{
-			if (m_anim.data[i].rotFrames == 0)
-				continue;
+			size_t lanes = std::min(numTracks - i, static_cast<size_t>(4));
 
-			JointPose& pose = m_lhs[m_anim.data[i].jointInd];
+			//Unused lanes are left as identity so they normalize safely.
+			float t[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float ax[4] = {}, ay[4] = {}, az[4] = {}, aw[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			float bx[4] = {}, by[4] = {}, bz[4] = {}, bw[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			int joints[4] = {};
 
-			if (m_anim.data[i].rotFrames == 1)
+			for (size_t lane = 0; lane < lanes; ++lane)
 			{
-				pose.rotation = m_anim.data[i].rotKeys[0];
-				continue;
+				if (packed != nullptr)
+				{
+					const CompressedClip::RotTrack& track = packed->GetRotTrack((uint32_t)(i + lane));
+					auto times = [packed](uint32_t key) { return packed->GetRotTime(key); };
+
+					uint32_t cur = AdvanceCursor(times, track.first, track.count, m_rotCursor[i + lane], m_timer);
+					uint32_t next = std::min(cur + 1, track.first + track.count - 1);
+
+					t[lane] = KeyT(times(cur), times(next), m_timer);
+					glm::quat a = packed->DecodeRot(cur);
+					glm::quat b = packed->DecodeRot(next);
+					ax[lane] = a.x;
+					ay[lane] = a.y;
+					az[lane] = a.z;
+					aw[lane] = a.w;
+					bx[lane] = b.x;
+					by[lane] = b.y;
+					bz[lane] = b.z;
+					bw[lane] = b.w;
+					joints[lane] = track.jointInd;
+					continue;
+				}
+
+				const AnimTrack& track = clip->rotTracks[i + lane];
+				auto times = [clip](uint32_t key) { return clip->rotTimes[key]; };
+
+				uint32_t cur = AdvanceCursor(times, track.first, track.count, m_rotCursor[i + lane], m_timer);
+				uint32_t next = std::min(cur + 1, track.first + track.count - 1);
+
+				t[lane] = KeyT(times(cur), times(next), m_timer);
+				ax[lane] = clip->rotX[cur];
+				ay[lane] = clip->rotY[cur];
+				az[lane] = clip->rotZ[cur];
+				aw[lane] = clip->rotW[cur];
+				bx[lane] = clip->rotX[next];
+				by[lane] = clip->rotY[next];
+				bz[lane] = clip->rotZ[next];
+				bw[lane] = clip->rotW[next];
+				joints[lane] = track.jointInd;
 			}
 
-			//Update our frame index.
-			//We stop at frames - 2 since we make the assumption
-			//that our animation's last frame is the same as its
-			//first (a perfect loop) - this may or may not
-			//be the case depending on how you manage your own animation work.
-			while (m_timer > m_anim.data[i].rotTimes[m_rotFrame[i]
-				+ static_cast<size_t>(1)]
-				&& m_rotFrame[i] < m_anim.data[i].rotFrames - 2)
+			float outX[4], outY[4], outZ[4], outW[4];
+			Quat4 result = Nlerp(LoadQuat(ax, ay, az, aw), LoadQuat(bx, by, bz, bw), Load(t));
+			StoreQuat(outX, outY, outZ, outW, result);
+
+			for (size_t lane = 0; lane < lanes; ++lane)
 			{
-				++m_rotFrame[i];
+				int joint = joints[lane];
+				m_lhs.rotX[joint] = outX[lane];
+				m_lhs.rotY[joint] = outY[lane];
+				m_lhs.rotZ[joint] = outZ[lane];
+				m_lhs.rotW[joint] = outW[lane];
 			}
-
-			size_t curFrame = m_rotFrame[i];
-			size_t nextFrame = m_rotFrame[i] + static_cast<size_t>(1);
-
-			float start = m_anim.data[i].rotTimes[curFrame];
-			float end = m_anim.data[i].rotTimes[nextFrame];
-
-			float t = (m_timer - start) / (end - start);
-
-			if (t < 0.0f)
-				t = 0.0f;
-
-			else if (t > 1.0f)
-				t = 1.0f;
-	
-			//For quaternions, glm::mix does SLERP.
-			pose.rotation = glm::mix(m_anim.data[i].rotKeys[curFrame],
-									 m_anim.data[i].rotKeys[nextFrame],
-									 t);
 		}
 	}
 
-	void SkeletalAnimNode::UpdateOutput(const Skeleton& skeleton)
+	void SkeletalAnimNode::UpdateOutput()
 	{
-		//If we don't have an RHS node, or we don't care about it 
+		//Our pose buffers are padded to a multiple of 4 joints, so
+		//every loop below can go 4 joints at a time with no leftovers.
+		const size_t size = m_output.PaddedSize();
+
+		//If we don't have an RHS node, or we don't care about it
 		//- copy our own data to the output of blending.
 		if (m_rhs == nullptr || m_mode == BlendMode::PASS)
 		{
-			for (size_t i = 0; i < m_lhs.size(); ++i)
+			//If we're not a diff clip, just copy the LHS data outright.
+			if (!m_anim.isDiffClip)
 			{
-				//If we're a diff clip, stack the result of our animation
-				//with the skeleton's base transform.
-				//Otherwise, just copy the LHS data outright.
-				m_output[i].pos = (m_anim.isDiffClip) 
-					? skeleton.m_joints[i].m_basePos + m_lhs[i].pos
-					: m_lhs[i].pos;
-
-				m_output[i].rotation = (m_anim.isDiffClip)
-					? m_lhs[i].rotation * skeleton.m_joints[i].m_baseRotation
-					: m_lhs[i].rotation;
+				m_output.CopyFrom(m_lhs);
+				return;
+			}
+
+			//If we're a diff clip, stack the result of our animation
+			//with the skeleton's base transform.
+			for (size_t i = 0; i < size; i += 4)
+			{
+				Store(&m_output.posX[i], Add(Load(&m_base.posX[i]), Load(&m_lhs.posX[i])));
+				Store(&m_output.posY[i], Add(Load(&m_base.posY[i]), Load(&m_lhs.posY[i])));
+				Store(&m_output.posZ[i], Add(Load(&m_base.posZ[i]), Load(&m_lhs.posZ[i])));
+
+				Quat4 lhs = LoadQuat(&m_lhs.rotX[i], &m_lhs.rotY[i], &m_lhs.rotZ[i], &m_lhs.rotW[i]);
+				Quat4 base = LoadQuat(&m_base.rotX[i], &m_base.rotY[i], &m_base.rotZ[i], &m_base.rotW[i]);
+				StoreQuat(&m_output.rotX[i], &m_output.rotY[i], &m_output.rotZ[i], &m_output.rotW[i], QuatMul(lhs, base));
 			}
 
 			return;
 		}
 
-		const std::vector<JointPose>& rhs_output = m_rhs->GetOutput();
+		const PoseBuffer& rhs = m_rhs->GetOutput();
 
-		if(rhs_output.size() != m_output.size())
+		if(rhs.PaddedSize() != size)
 			return;
 
+		Float4 blend = Splat(m_blendParam);
+
 		switch (m_mode)
 		{
 			case BlendMode::BLEND:
 
-			//TODO: Implement this blend mode.
+			//Linear blending - mix between the RHS output and our own pose
+			//per the blend strength parameter.
+			for (size_t i = 0; i < size; i += 4)
+			{
+				Store(&m_output.posX[i], Lerp(Load(&rhs.posX[i]), Load(&m_lhs.posX[i]), blend));
+				Store(&m_output.posY[i], Lerp(Load(&rhs.posY[i]), Load(&m_lhs.posY[i]), blend));
+				Store(&m_output.posZ[i], Lerp(Load(&rhs.posZ[i]), Load(&m_lhs.posZ[i]), blend));
+
+				Quat4 rhsRot = LoadQuat(&rhs.rotX[i], &rhs.rotY[i], &rhs.rotZ[i], &rhs.rotW[i]);
+				Quat4 lhsRot = LoadQuat(&m_lhs.rotX[i], &m_lhs.rotY[i], &m_lhs.rotZ[i], &m_lhs.rotW[i]);
+				StoreQuat(&m_output.rotX[i], &m_output.rotY[i], &m_output.rotZ[i], &m_output.rotW[i], Nlerp(rhsRot, lhsRot, blend));
+			}
 
 			break;
 
@@ -301,23 +708,24 @@ namespace nou
 
 			//Additive blending - "stack" our transform on the
 			//RHS.
-			for (size_t i = 0; i < m_output.size(); ++i)
+			for (size_t i = 0; i < size; i += 4)
 			{
 				//For position, add our position to the RHS output.
-				m_output[i].pos = rhs_output[i].pos + m_lhs[i].pos;
-				//For rotation, multiply our rotation by the RHS output
-				//(RHS rotation happens first).
-				m_output[i].rotation = m_lhs[i].rotation * rhs_output[i].rotation;
-
 				//Our output mixes between "no addition" and "full addition"
 				//per the blend strength parameter.
-				m_output[i].pos = glm::mix(rhs_output[i].pos,
-										   m_output[i].pos,
-										   m_blendParam);
+				Float4 rhsX = Load(&rhs.posX[i]);
+				Float4 rhsY = Load(&rhs.posY[i]);
+				Float4 rhsZ = Load(&rhs.posZ[i]);
+				Store(&m_output.posX[i], Lerp(rhsX, Add(rhsX, Load(&m_lhs.posX[i])), blend));
+				Store(&m_output.posY[i], Lerp(rhsY, Add(rhsY, Load(&m_lhs.posY[i])), blend));
+				Store(&m_output.posZ[i], Lerp(rhsZ, Add(rhsZ, Load(&m_lhs.posZ[i])), blend));
 
-				m_output[i].rotation = glm::mix(rhs_output[i].rotation,
-												m_output[i].rotation,
-												m_blendParam);
+				//For rotation, multiply our rotation by the RHS output
+				//(RHS rotation happens first).
+				Quat4 rhsRot = LoadQuat(&rhs.rotX[i], &rhs.rotY[i], &rhs.rotZ[i], &rhs.rotW[i]);
+				Quat4 lhsRot = LoadQuat(&m_lhs.rotX[i], &m_lhs.rotY[i], &m_lhs.rotZ[i], &m_lhs.rotW[i]);
+				Quat4 added = QuatMul(lhsRot, rhsRot);
+				StoreQuat(&m_output.rotX[i], &m_output.rotY[i], &m_output.rotZ[i], &m_output.rotW[i], Nlerp(rhsRot, added, blend));
 			}
 
 			break;
@@ -328,7 +736,7 @@ namespace nou
 		}
 	}
 
-	Blendtree::Blendtree(const Skeleton& skeleton) 
+	Blendtree::Blendtree(const Skeleton& skeleton)
 	{
 		m_skeleton = &skeleton;
 	}
@@ -368,7 +776,7 @@ namespace nou
 	{
 		if(m_tree.empty())
 			return;
-		
+
 		m_tree.front()->Apply(skeleton);
 	}
-}
\ No newline at end of file
+}
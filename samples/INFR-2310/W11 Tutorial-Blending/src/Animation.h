@@ -14,9 +14,15 @@ Classes for managing animation data and blendtrees.
 
 #include <vector>
 #include <deque>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
 
 namespace nou
-{	
+{
+	class CompressedClip;
+
 	//Store the data for an animation clip for one joint.
 	struct JointAnim
 	{
@@ -33,6 +39,33 @@ namespace nou
 		JointAnim();
 	};
 
+	//The keys for one joint in a BakedClip - where they start, and how many there are.
+	struct AnimTrack
+	{
+		int jointInd;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	//A "baked" copy of a clip that's laid out for fast sampling.
+	//Instead of each joint having its own little vectors of keys, every
+	//joint's keys sit back to back in one set of arrays, and each component
+	//(x, y, z...) gets its own array (structure of arrays, or SoA).
+	//That way sampling walks through memory in order, and we can
+	//load the same component for several joints straight into SIMD registers.
+	struct BakedClip
+	{
+		std::vector<AnimTrack> posTracks;
+		std::vector<float> posTimes;
+		std::vector<float> posX, posY, posZ;
+
+		std::vector<AnimTrack> rotTracks;
+		std::vector<float> rotTimes;
+		std::vector<float> rotX, rotY, rotZ, rotW;
+
+		void Clear();
+	};
+
 	//Store the data for an animation clip for an entire skeleton.
 	struct SkeletalAnim
 	{
@@ -49,6 +82,50 @@ namespace nou
 		//Turn this animation into a diff clip with the base pose
 		//of the given skeleton.
 		void MakeDiffWith(const Skeleton& skeleton);
+
+		//Get the baked copy of our data, baking it first if data has changed since.
+		//(If you edit data yourself, call MarkDirty() afterwards.)
+		//Safe to call from several threads at once (e.g., animators updating in parallel),
+		//but don't edit data while anything might be sampling the clip.
+		const BakedClip& GetBaked() const;
+		void MarkDirty();
+
+		//Sample from a compressed clip instead of data (see CompressedClip.h).
+		//This takes the clip's duration, and frees data since we won't need it anymore.
+		void SetCompressed(std::shared_ptr<const CompressedClip> clip);
+		//Returns nullptr if we're not compressed.
+		const CompressedClip* GetCompressed() const;
+
+		protected:
+
+		mutable BakedClip m_baked;
+		mutable std::atomic<bool> m_bakedDirty;
+		//Only one thread gets to rebuild m_baked.
+		mutable std::mutex m_bakeMutex;
+		std::shared_ptr<const CompressedClip> m_compressed;
+	};
+
+	//A pose for every joint in a skeleton, stored as SoA like our baked clips.
+	//The arrays are padded out to a multiple of 4 joints so we can always
+	//process 4 joints at a time without worrying about the leftovers.
+	struct PoseBuffer
+	{
+		size_t numJoints;
+		std::vector<float> posX, posY, posZ;
+		std::vector<float> rotX, rotY, rotZ, rotW;
+
+		PoseBuffer();
+
+		//Resize for the given number of joints (resets everything to identity).
+		void Resize(size_t joints);
+		//Fill with the base pose of a skeleton.
+		void SetToBasePose(const Skeleton& skeleton);
+		//Fill with identity transforms (no movement, no rotation).
+		void SetToIdentity();
+		//Copy another pose of the same size.
+		void CopyFrom(const PoseBuffer& other);
+
+		size_t PaddedSize() const { return posX.size(); }
 	};
 
 	//Manage an animation clip.
@@ -58,15 +135,6 @@ namespace nou
 	{
 		public:
 
-		struct JointPose
-		{
-			glm::vec3 pos;
-			glm::quat rotation;
-
-			JointPose();
-			~JointPose() = default;
-		};
-
 		enum class BlendMode
 		{
 			//Don't blend at all (ignore RHS' output).
@@ -91,7 +159,7 @@ namespace nou
 		void Apply(Skeleton& skeleton);
 
 		//Get the output of this node.
-		const std::vector<JointPose>& GetOutput();
+		const PoseBuffer& GetOutput();
 
 		protected:
 
@@ -106,20 +174,25 @@ namespace nou
 		float m_timer;
 		//The data for our animation clip.
 		const SkeletalAnim& m_anim;
-		//Which frame indices we are on for each joint.
-		std::vector<int> m_rotFrame;
-		std::vector<int> m_posFrame;
-
+		//Which key each track is currently on (an index into the baked or compressed clip's arrays).
+		//We remember these between updates so we only ever step forward a key or two
+		//rather than searching from the start.
+		std::vector<uint32_t> m_rotCursor;
+		std::vector<uint32_t> m_posCursor;
+
+		//The base pose of the skeleton (diff clips are stacked on top of it).
+		PoseBuffer m_base;
 		//The result of our own animation update.
 		//(Ignoring the right-hand-side node.)
-		std::vector<JointPose> m_lhs;
+		PoseBuffer m_lhs;
 		//The output of blending between our own animation
 		//and our RHS node.
-		std::vector<JointPose> m_output;
+		PoseBuffer m_output;
 
+		void ResetCursors();
 		void UpdateRotations();
 		void UpdatePositions();
-		void UpdateOutput(const Skeleton& skeleton);
+		void UpdateOutput();
 	};
 
 	class Blendtree
@@ -149,4 +222,4 @@ namespace nou
 		//between idle and walk.
 		std::deque<std::unique_ptr<SkeletalAnimNode>> m_tree;
 	};
-}
\ No newline at end of file
+}
@@ -12,6 +12,9 @@ that we intend the class for use as a component with the ENTT framework.
 #include "CAnimator.h"
 #include "CSkinnedMeshRenderer.h"
 
+#include <algorithm>
+#include <execution>
+
 namespace nou
 {
 	CAnimator::CAnimator(Entity& owner)
@@ -37,4 +40,13 @@ namespace nou
 		skeleton.DoFK();
 		rend.UpdateJointMatrices();
 	}
+
+	void CAnimator::UpdateAll(const std::vector<CAnimator*>& animators, float deltaTime)
+	{
+		//The parallel execution policy hands chunks of the list out to a pool of worker threads for us.
+		std::for_each(std::execution::par, animators.begin(), animators.end(), [deltaTime](CAnimator* animator)
+		{
+			animator->Update(deltaTime);
+		});
+	}
 }
\ No newline at end of file
@@ -13,6 +13,8 @@ that we intend the class for use as a component with the ENTT framework.
 #include "NOU/Entity.h"
 #include "Animation.h"
 
+#include <vector>
+
 namespace nou
 {
 	class CAnimator
@@ -27,6 +29,10 @@ namespace nou
 
 		void Update(float deltaTime);
 
+		//Updates lots of animators at once, spread across all of the CPU's cores.
+		//Every animator works on its own skeleton, so they can safely run at the same time.
+		static void UpdateAll(const std::vector<CAnimator*>& animators, float deltaTime);
+
 		Blendtree* GetBlendtree();
 
 		protected:
@@ -10,19 +10,10 @@ that we intend the class for use as a component with the ENTT framework.
 */
 
 #include "CSkinnedMeshRenderer.h"
-#include "NOU/CCamera.h"
+#include "SkinnedMeshBatcher.h"
 
 namespace nou
 {
-	CSkinnedMeshRenderer::JointMatrices::JointMatrices()
-	{
-		for (int i = 0; i < MAX_NUM_JOINTS; ++i)
-		{
-			//This initializes our joint matrices to identity.
-			data[i] = glm::mat4(1.0f);
-		}
-	}
-
 	CSkinnedMeshRenderer::CSkinnedMeshRenderer(Entity& owner,
 		const SkinnedMesh& mesh,
 		Material& mat)
@@ -31,7 +22,7 @@ namespace nou
 		m_mat = &mat;
 		m_vao = std::make_unique<VertexArray>();
 		m_skeleton = std::make_unique<Skeleton>();
-		m_jointMatrices = std::make_unique<JointMatrices>();
+		m_mesh = nullptr;
 
 		SetMesh(mesh);
 	}
@@ -45,9 +36,11 @@ namespace nou
 	{
 		//The joint matrices we send to the GPU will premultiply each 
 		//joint's global transform with its inverse bind pose matrix.
-		for (size_t i = 0; i < m_skeleton->m_joints.size(); ++i)
+		m_jointMatrices.resize(m_skeleton->m_global.size());
+
+		for (size_t i = 0; i < m_skeleton->m_global.size(); ++i)
 		{
-			m_jointMatrices->data[i] = m_skeleton->m_joints[i].m_global * m_skeleton->m_joints[i].m_invBind;
+			m_jointMatrices[i] = m_skeleton->m_global[i] * m_skeleton->m_joints[i].m_invBind;
 		}
 	}
 
@@ -72,21 +65,19 @@ namespace nou
 
 		//This will make a copy of the skeleton data from our base mesh.
 		*m_skeleton = mesh.m_skeleton;
+		m_mesh = &mesh;
+
+		//Start off in the bind pose (identity joint matrices) until we're animated.
+		m_jointMatrices.assign(m_skeleton->m_joints.size(), glm::mat4(1.0f));
 	}
 
 	void CSkinnedMeshRenderer::Draw()
 	{
-		m_mat->Use();
-
 		auto& transform = m_owner->transform;
 
-		//In addition to what we usually send (model, viewprojection, and normal matrix),
-		//We'll send our joint matrices as well.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
-		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
-		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
-		ShaderProgram::Current()->SetUniformArray("jointMatrices", m_jointMatrices->data, MAX_NUM_JOINTS);
-
-		m_vao->Draw();
+		//Instead of sending our joint matrices as a uniform array and drawing right away,
+		//we hand them (along with our model and normal matrices) to the batcher, which puts 
+		//every character's joints into one big buffer and draws characters with the same mesh together.
+		SkinnedMeshBatcher::Submit(m_mesh, *m_vao, *m_mat, transform.GetGlobal(), transform.GetNormal(), m_jointMatrices);
 	}
 }
\ No newline at end of file
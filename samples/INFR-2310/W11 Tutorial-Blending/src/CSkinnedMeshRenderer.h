@@ -15,6 +15,7 @@ that we intend the class for use as a component with the ENTT framework.
 #include "SkinnedMesh.h"
 
 #include <memory>
+#include <vector>
 
 namespace nou
 {
@@ -22,15 +23,6 @@ namespace nou
 	{
 		public:
 
-		static const int MAX_NUM_JOINTS = 64;
-
-		struct JointMatrices
-		{
-			glm::mat4 data[MAX_NUM_JOINTS];
-
-			JointMatrices();
-		};
-
 		CSkinnedMeshRenderer(Entity& owner,
 						     const SkinnedMesh& mesh,
 							 Material& mat);
@@ -43,11 +35,19 @@ namespace nou
 		void UpdateJointMatrices();
 
 		void SetMesh(const SkinnedMesh& mesh);
+
+		//Queues our character up with the SkinnedMeshBatcher.
+		//Nothing actually gets drawn until SkinnedMeshBatcher::Flush() is called,
+		//so that every character sharing our mesh can be drawn at once.
 		virtual void Draw();
 
 		protected:
 
 		std::unique_ptr<Skeleton> m_skeleton;
-		std::unique_ptr<JointMatrices> m_jointMatrices;
+		//One matrix per joint in our skeleton (no fixed maximum, since
+		//they go in a storage buffer rather than a uniform array).
+		std::vector<glm::mat4> m_jointMatrices;
+		//The mesh we were made from, so the batcher knows which characters can be drawn together.
+		const SkinnedMesh* m_mesh;
 	};	
 }
\ No newline at end of file
@@ -0,0 +1,475 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+CompressedClip.cpp
+A compact binary format for skeletal animation clips.
+*/
+
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nou
+{
+	namespace
+	{
+		const float SQRT2 = 1.41421356f;
+		const float MAX_15_BIT = 32767.0f;
+		const float MAX_16_BIT = 65535.0f;
+
+		inline uint32_t AlignToFour(size_t n)
+		{
+			return static_cast<uint32_t>((n + 3) & ~static_cast<size_t>(3));
+		}
+
+		inline uint16_t Quantize16(float value, float min, float scale)
+		{
+			if (scale == 0.0f)
+				return 0;
+
+			float q = std::round((value - min) / scale);
+			return static_cast<uint16_t>(std::min(std::max(q, 0.0f), MAX_16_BIT));
+		}
+
+		//"Smallest three" encoding.
+		//We find the largest component, make sure it's positive (q and -q are the same rotation),
+		//and store the other three. Since they're smaller than the largest, none of them can be
+		//bigger than 1/sqrt(2), so we spend all 15 bits on that range.
+		//The spare bit in each value holds 2 bits of which component we left out.
+		void EncodeQuat(const glm::quat& q, uint16_t out[3])
+		{
+			float c[4] = { q.x, q.y, q.z, q.w };
+
+			int largest = 0;
+			for (int i = 1; i < 4; ++i)
+			{
+				if (std::fabs(c[i]) > std::fabs(c[largest]))
+					largest = i;
+			}
+
+			float sign = (c[largest] < 0.0f) ? -1.0f : 1.0f;
+
+			int n = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest)
+					continue;
+
+				float v = std::min(std::max(c[i] * sign * SQRT2, -1.0f), 1.0f);
+				uint16_t bits = static_cast<uint16_t>(std::round((v * 0.5f + 0.5f) * MAX_15_BIT));
+				out[n] = static_cast<uint16_t>((bits << 1) | ((largest >> n) & 1));
+				++n;
+			}
+		}
+
+		glm::quat DecodeQuat(const uint16_t in[3])
+		{
+			int largest = (in[0] & 1) | ((in[1] & 1) << 1);
+
+			float c[4];
+			float sumSq = 0.0f;
+
+			int n = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (i == largest)
+					continue;
+
+				c[i] = ((in[n] >> 1) / MAX_15_BIT * 2.0f - 1.0f) / SQRT2;
+				sumSq += c[i] * c[i];
+				++n;
+			}
+
+			c[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+
+			return glm::quat(c[3], c[0], c[1], c[2]);
+		}
+
+		//The same NLERP the sampler uses, so the baker measures the error the sampler will see.
+		glm::quat Nlerp(const glm::quat& a, glm::quat b, float t)
+		{
+			if (glm::dot(a, b) < 0.0f)
+				b = -b;
+
+			return glm::normalize(glm::quat(a.w + (b.w - a.w) * t, a.x + (b.x - a.x) * t,
+											a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t));
+		}
+
+		float AngleBetween(const glm::quat& a, const glm::quat& b)
+		{
+			float d = std::min(std::fabs(glm::dot(a, b)), 1.0f);
+			return 2.0f * std::acos(d);
+		}
+
+		//Works out which keys we need to keep.
+		//We start at the first key, and keep stretching a line out to later keys for
+		//as long as every key we'd skip stays within the error budget. When
+		//it doesn't, the last key that worked is kept and we start again from there.
+		//error(k, a, b, t) should return how far key k is from interpolating keys a and b by t.
+		template<typename ErrorFn>
+		std::vector<uint32_t> ReduceKeys(const std::vector<float>& times, float tolerance, ErrorFn error)
+		{
+			std::vector<uint32_t> kept;
+			size_t count = times.size();
+
+			if (count == 0)
+				return kept;
+
+			kept.push_back(0);
+			uint32_t anchor = 0;
+
+			for (uint32_t end = 2; end < count; ++end)
+			{
+				bool fits = true;
+				float span = times[end] - times[anchor];
+
+				for (uint32_t k = anchor + 1; k < end && fits; ++k)
+				{
+					float t = (span > 0.0f) ? (times[k] - times[anchor]) / span : 0.0f;
+					fits = error(k, anchor, end, t) <= tolerance;
+				}
+
+				if (!fits)
+				{
+					anchor = end - 1;
+					kept.push_back(anchor);
+				}
+			}
+
+			if (count > 1)
+				kept.push_back(static_cast<uint32_t>(count - 1));
+
+			return kept;
+		}
+	}
+
+	bool ClipSource::FromFile(const std::string& filename, ClipSource& source)
+	{
+		std::error_code error;
+		source.size = static_cast<uint64_t>(std::filesystem::file_size(filename, error));
+		if (error)
+			return false;
+
+		source.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+		return !error;
+	}
+
+	std::vector<uint8_t> CompressedClip::Bake(const SkeletalAnim& anim, const ClipCompressionSettings& settings,
+											  const ClipSource& source)
+	{
+		std::vector<PosTrack> posTracks;
+		std::vector<RotTrack> rotTracks;
+		std::vector<uint16_t> posTimes, posKeys, rotTimes, rotKeys;
+
+		float timeScale = (anim.duration > 0.0f) ? anim.duration / MAX_16_BIT : 0.0f;
+
+		for (const JointAnim& joint : anim.data)
+		{
+			if (joint.posFrames > 0)
+			{
+				std::vector<float> times(joint.posTimes.begin(), joint.posTimes.begin() + joint.posFrames);
+
+				std::vector<uint32_t> kept = ReduceKeys(times, settings.posTolerance,
+					[&joint](uint32_t k, uint32_t a, uint32_t b, float t)
+					{
+						glm::vec3 rebuilt = glm::mix(joint.posKeys[a], joint.posKeys[b], t);
+						return glm::length(rebuilt - joint.posKeys[k]);
+					});
+
+				PosTrack track;
+				track.jointInd = joint.jointInd;
+				track.first = static_cast<uint32_t>(posTimes.size());
+				track.count = static_cast<uint32_t>(kept.size());
+
+				//Each joint gets its own range to quantize within, so a joint that barely
+				//moves gets far more precision than the whole skeleton's range would give it.
+				glm::vec3 min = joint.posKeys[kept[0]];
+				glm::vec3 max = min;
+				for (uint32_t k : kept)
+				{
+					min = glm::min(min, joint.posKeys[k]);
+					max = glm::max(max, joint.posKeys[k]);
+				}
+
+				for (int c = 0; c < 3; ++c)
+				{
+					track.min[c] = min[c];
+					track.scale[c] = (max[c] - min[c]) / MAX_16_BIT;
+				}
+
+				for (uint32_t k : kept)
+				{
+					posTimes.push_back(Quantize16(joint.posTimes[k], 0.0f, timeScale));
+
+					for (int c = 0; c < 3; ++c)
+						posKeys.push_back(Quantize16(joint.posKeys[k][c], track.min[c], track.scale[c]));
+				}
+
+				posTracks.push_back(track);
+			}
+
+			if (joint.rotFrames > 0)
+			{
+				std::vector<float> times(joint.rotTimes.begin(), joint.rotTimes.begin() + joint.rotFrames);
+
+				std::vector<uint32_t> kept = ReduceKeys(times, settings.rotTolerance,
+					[&joint](uint32_t k, uint32_t a, uint32_t b, float t)
+					{
+						return AngleBetween(Nlerp(joint.rotKeys[a], joint.rotKeys[b], t), joint.rotKeys[k]);
+					});
+
+				RotTrack track;
+				track.jointInd = joint.jointInd;
+				track.first = static_cast<uint32_t>(rotTimes.size());
+				track.count = static_cast<uint32_t>(kept.size());
+
+				for (uint32_t k : kept)
+				{
+					rotTimes.push_back(Quantize16(joint.rotTimes[k], 0.0f, timeScale));
+
+					uint16_t encoded[3];
+					EncodeQuat(joint.rotKeys[k], encoded);
+					rotKeys.insert(rotKeys.end(), encoded, encoded + 3);
+				}
+
+				rotTracks.push_back(track);
+			}
+		}
+
+		//Lay everything out one section after another, each starting on a 4 byte boundary.
+		Header header = {};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.duration = anim.duration;
+		header.flags = anim.isDiffClip ? FLAG_DIFF_CLIP : 0;
+		header.sourceSize = source.size;
+		header.sourceWriteTime = source.writeTime;
+		header.posTolerance = settings.posTolerance;
+		header.rotTolerance = settings.rotTolerance;
+		header.numPosTracks = static_cast<uint32_t>(posTracks.size());
+		header.numRotTracks = static_cast<uint32_t>(rotTracks.size());
+		header.numPosKeys = static_cast<uint32_t>(posTimes.size());
+		header.numRotKeys = static_cast<uint32_t>(rotTimes.size());
+
+		header.posTracksOffset = AlignToFour(sizeof(Header));
+		header.rotTracksOffset = AlignToFour(header.posTracksOffset + posTracks.size() * sizeof(PosTrack));
+		header.posTimesOffset = AlignToFour(header.rotTracksOffset + rotTracks.size() * sizeof(RotTrack));
+		header.posKeysOffset = AlignToFour(header.posTimesOffset + posTimes.size() * sizeof(uint16_t));
+		header.rotTimesOffset = AlignToFour(header.posKeysOffset + posKeys.size() * sizeof(uint16_t));
+		header.rotKeysOffset = AlignToFour(header.rotTimesOffset + rotTimes.size() * sizeof(uint16_t));
+		header.totalSize = AlignToFour(header.rotKeysOffset + rotKeys.size() * sizeof(uint16_t));
+
+		std::vector<uint8_t> baked(header.totalSize, 0);
+
+		auto write = [&baked](uint32_t offset, const void* data, size_t size)
+		{
+			if (size > 0)
+				memcpy(baked.data() + offset, data, size);
+		};
+
+		write(0, &header, sizeof(Header));
+		write(header.posTracksOffset, posTracks.data(), posTracks.size() * sizeof(PosTrack));
+		write(header.rotTracksOffset, rotTracks.data(), rotTracks.size() * sizeof(RotTrack));
+		write(header.posTimesOffset, posTimes.data(), posTimes.size() * sizeof(uint16_t));
+		write(header.posKeysOffset, posKeys.data(), posKeys.size() * sizeof(uint16_t));
+		write(header.rotTimesOffset, rotTimes.data(), rotTimes.size() * sizeof(uint16_t));
+		write(header.rotKeysOffset, rotKeys.data(), rotKeys.size() * sizeof(uint16_t));
+
+		return baked;
+	}
+
+	bool CompressedClip::Save(const std::vector<uint8_t>& baked, const std::string& filename)
+	{
+		//Write to a temporary file first, so a crash halfway through never leaves a broken clip behind.
+		std::string tempName = filename + ".tmp";
+
+		{
+			std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+
+			if (!file)
+				return false;
+
+			file.write(reinterpret_cast<const char*>(baked.data()), baked.size());
+
+			if (!file)
+				return false;
+		}
+
+		std::remove(filename.c_str());
+		return std::rename(tempName.c_str(), filename.c_str()) == 0;
+	}
+
+	std::shared_ptr<CompressedClip> CompressedClip::LoadFromFile(const std::string& filename)
+	{
+		std::shared_ptr<CompressedClip> clip(new CompressedClip());
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+								  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return nullptr;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		//The view keeps the file open by itself, so we can let go of these straight away.
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		CloseHandle(file);
+
+		if (view == nullptr)
+			return nullptr;
+
+		clip->m_mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+		int file = open(filename.c_str(), O_RDONLY);
+
+		if (file < 0)
+			return nullptr;
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close(file);
+			return nullptr;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+
+		if (view == MAP_FAILED)
+			return nullptr;
+
+		clip->m_mappedSize = static_cast<size_t>(info.st_size);
+#endif
+
+		clip->m_mapping = view;
+
+		if (!clip->Setup(static_cast<const uint8_t*>(view), clip->m_mappedSize))
+			return nullptr;
+
+		return clip;
+	}
+
+	std::shared_ptr<CompressedClip> CompressedClip::FromMemory(std::vector<uint8_t> baked)
+	{
+		std::shared_ptr<CompressedClip> clip(new CompressedClip());
+		clip->m_owned = std::move(baked);
+
+		if (!clip->Setup(clip->m_owned.data(), clip->m_owned.size()))
+			return nullptr;
+
+		return clip;
+	}
+
+	bool CompressedClip::IsUpToDate(const ClipSource& source, const ClipCompressionSettings& settings) const
+	{
+		return m_header->sourceSize == source.size && m_header->sourceWriteTime == source.writeTime
+			&& m_header->posTolerance == settings.posTolerance && m_header->rotTolerance == settings.rotTolerance;
+	}
+
+	CompressedClip::~CompressedClip()
+	{
+		if (m_mapping == nullptr)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_mapping);
+#else
+		munmap(m_mapping, m_mappedSize);
+#endif
+	}
+
+	bool CompressedClip::Setup(const uint8_t* data, size_t size)
+	{
+		if (size < sizeof(Header))
+			return false;
+
+		const Header* header = reinterpret_cast<const Header*>(data);
+
+		if (header->magic != MAGIC || header->version != VERSION || header->totalSize > size)
+			return false;
+
+		//Make sure every section actually fits in the clip before we trust it.
+		auto fits = [header](uint32_t offset, size_t count, size_t elementSize)
+		{
+			return offset % 4 == 0 && offset <= header->totalSize
+				&& count <= (header->totalSize - offset) / elementSize;
+		};
+
+		if (!fits(header->posTracksOffset, header->numPosTracks, sizeof(PosTrack)) ||
+			!fits(header->rotTracksOffset, header->numRotTracks, sizeof(RotTrack)) ||
+			!fits(header->posTimesOffset, header->numPosKeys, sizeof(uint16_t)) ||
+			!fits(header->posKeysOffset, static_cast<size_t>(header->numPosKeys) * 3, sizeof(uint16_t)) ||
+			!fits(header->rotTimesOffset, header->numRotKeys, sizeof(uint16_t)) ||
+			!fits(header->rotKeysOffset, static_cast<size_t>(header->numRotKeys) * 3, sizeof(uint16_t)))
+		{
+			return false;
+		}
+
+		m_header = header;
+		m_posTracks = reinterpret_cast<const PosTrack*>(data + header->posTracksOffset);
+		m_rotTracks = reinterpret_cast<const RotTrack*>(data + header->rotTracksOffset);
+		m_posTimes = reinterpret_cast<const uint16_t*>(data + header->posTimesOffset);
+		m_posKeys = reinterpret_cast<const uint16_t*>(data + header->posKeysOffset);
+		m_rotTimes = reinterpret_cast<const uint16_t*>(data + header->rotTimesOffset);
+		m_rotKeys = reinterpret_cast<const uint16_t*>(data + header->rotKeysOffset);
+		m_timeScale = header->duration / MAX_16_BIT;
+
+		//And that every track's keys are inside the key arrays.
+		for (uint32_t i = 0; i < header->numPosTracks; ++i)
+		{
+			const PosTrack& track = m_posTracks[i];
+			if (track.jointInd < 0 || track.count == 0 || track.first > header->numPosKeys || track.count > header->numPosKeys - track.first)
+				return false;
+		}
+
+		for (uint32_t i = 0; i < header->numRotTracks; ++i)
+		{
+			const RotTrack& track = m_rotTracks[i];
+			if (track.jointInd < 0 || track.count == 0 || track.first > header->numRotKeys || track.count > header->numRotKeys - track.first)
+				return false;
+		}
+
+		return true;
+	}
+
+	glm::vec3 CompressedClip::DecodePos(const PosTrack& track, uint32_t key) const
+	{
+		const uint16_t* q = m_posKeys + static_cast<size_t>(key) * 3;
+
+		return glm::vec3(track.min[0] + q[0] * track.scale[0],
+						 track.min[1] + q[1] * track.scale[1],
+						 track.min[2] + q[2] * track.scale[2]);
+	}
+
+	glm::quat CompressedClip::DecodeRot(uint32_t key) const
+	{
+		return DecodeQuat(m_rotKeys + static_cast<size_t>(key) * 3);
+	}
+}
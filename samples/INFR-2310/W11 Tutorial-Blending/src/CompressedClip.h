@@ -0,0 +1,174 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+CompressedClip.h
+A compact binary format for skeletal animation clips.
+
+glTF stores every key at full precision (a float time plus a vec3 or quat),
+which adds up fast for long motion capture clips. A compressed clip instead:
+- Drops keys that can be rebuilt by interpolating their neighbours,
+  as long as the result stays within an error budget.
+- Stores times as 16 bit fractions of the clip's duration.
+- Stores positions as 16 bit fixed point within each joint's range of motion.
+- Stores rotations with "smallest three" encoding - since a rotation quaternion
+  always has a length of 1, we can leave out its largest component and rebuild
+  it from the other three, which are each stored in 15 bits.
+
+The whole clip is one block of memory laid out exactly as it is on disk,
+so a baked file can be memory mapped and sampled straight away with no parsing.
+*/
+
+#pragma once
+
+#include "Animation.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nou
+{
+	//How much error the baker is allowed to introduce when dropping keys.
+	struct ClipCompressionSettings
+	{
+		//Maximum distance a joint's position may move (in model units).
+		float posTolerance = 0.0005f;
+		//Maximum angle a joint's rotation may be off by (in radians).
+		float rotTolerance = 0.001f;
+	};
+
+	//The file a clip was baked from. If it changes, the baked clip is out of date.
+	struct ClipSource
+	{
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+
+		//Look up a file's size and last write time. Returns false if it doesn't exist.
+		static bool FromFile(const std::string& filename, ClipSource& source);
+	};
+
+	class CompressedClip
+	{
+		public:
+
+		static const uint32_t MAGIC = 0x41554F4E; //The bytes "NOUA" at the start of the file.
+		//Bump this whenever the layout or meaning of the data changes, so old files get rebaked.
+		//Version 2: joint indices follow our skeletons' parent-first sorted order (see GLTF::SortJoints).
+		//Version 3: the header records the source file and compression settings.
+		static const uint32_t VERSION = 3;
+
+		//The header at the start of every clip.
+		//Offsets are in bytes from the start of the clip.
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			float duration;
+			uint32_t flags;
+
+			uint32_t numPosTracks;
+			uint32_t numRotTracks;
+			uint32_t numPosKeys;
+			uint32_t numRotKeys;
+
+			uint32_t posTracksOffset;
+			uint32_t rotTracksOffset;
+			uint32_t posTimesOffset;
+			uint32_t posKeysOffset;
+			uint32_t rotTimesOffset;
+			uint32_t rotKeysOffset;
+
+			uint32_t totalSize;
+			uint32_t padding;
+
+			//What the clip was baked from, so we know when to rebake it.
+			//(Both are 0 if the clip wasn't baked from a file.)
+			uint64_t sourceSize;
+			int64_t sourceWriteTime;
+			float posTolerance;
+			float rotTolerance;
+		};
+
+		static const uint32_t FLAG_DIFF_CLIP = 1;
+
+		//A joint's position keys, and the range they're quantized within.
+		struct PosTrack
+		{
+			int32_t jointInd;
+			uint32_t first;
+			uint32_t count;
+			float min[3];
+			float scale[3];
+		};
+
+		//A joint's rotation keys.
+		struct RotTrack
+		{
+			int32_t jointInd;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		//Compresses a clip (e.g., one we just loaded from glTF) into a block of memory
+		//in the same layout as the file.
+		static std::vector<uint8_t> Bake(const SkeletalAnim& anim, const ClipCompressionSettings& settings = ClipCompressionSettings(),
+										 const ClipSource& source = ClipSource());
+		//Writes a baked clip to a file.
+		static bool Save(const std::vector<uint8_t>& baked, const std::string& filename);
+
+		//Memory maps a baked clip file. Returns nullptr if it's missing or invalid.
+		static std::shared_ptr<CompressedClip> LoadFromFile(const std::string& filename);
+		//Wraps a baked clip that's already in memory.
+		static std::shared_ptr<CompressedClip> FromMemory(std::vector<uint8_t> baked);
+
+		~CompressedClip();
+
+		CompressedClip(const CompressedClip&) = delete;
+		CompressedClip& operator=(const CompressedClip&) = delete;
+
+		float GetDuration() const { return m_header->duration; }
+		bool IsDiffClip() const { return (m_header->flags & FLAG_DIFF_CLIP) != 0; }
+		//How many bytes the clip takes up.
+		size_t GetSize() const { return m_header->totalSize; }
+
+		//Returns true if the clip was baked from this version of its source file, with these settings.
+		bool IsUpToDate(const ClipSource& source, const ClipCompressionSettings& settings) const;
+
+		uint32_t GetNumPosTracks() const { return m_header->numPosTracks; }
+		uint32_t GetNumRotTracks() const { return m_header->numRotTracks; }
+		const PosTrack& GetPosTrack(uint32_t track) const { return m_posTracks[track]; }
+		const RotTrack& GetRotTrack(uint32_t track) const { return m_rotTracks[track]; }
+
+		//Decode a key's time.
+		float GetPosTime(uint32_t key) const { return m_posTimes[key] * m_timeScale; }
+		float GetRotTime(uint32_t key) const { return m_rotTimes[key] * m_timeScale; }
+
+		//Decode a key's value.
+		glm::vec3 DecodePos(const PosTrack& track, uint32_t key) const;
+		glm::quat DecodeRot(uint32_t key) const;
+
+		protected:
+
+		CompressedClip() = default;
+
+		//Points our accessors into the clip's memory, returns false if the clip is malformed.
+		bool Setup(const uint8_t* data, size_t size);
+
+		const Header* m_header = nullptr;
+		const PosTrack* m_posTracks = nullptr;
+		const RotTrack* m_rotTracks = nullptr;
+		const uint16_t* m_posTimes = nullptr;
+		const uint16_t* m_posKeys = nullptr;
+		const uint16_t* m_rotTimes = nullptr;
+		const uint16_t* m_rotKeys = nullptr;
+		float m_timeScale = 0.0f;
+
+		//If we were made from memory, we own the data here.
+		std::vector<uint8_t> m_owned;
+		//If we were memory mapped, these let us unmap the file.
+		void* m_mapping = nullptr;
+		size_t m_mappedSize = 0;
+	};
+}
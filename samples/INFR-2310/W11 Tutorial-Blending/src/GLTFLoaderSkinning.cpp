@@ -105,6 +105,68 @@ namespace nou::GLTF
 		printf("Loaded animation clip from %s.\n", filename.c_str());
 	}
 
+	bool BakeAnimation(const std::string& filename, const std::string& outFilename,
+					   const ClipCompressionSettings& settings)
+	{
+		SkeletalAnim anim;
+		LoadAnimation(filename, anim);
+
+		if (anim.data.empty())
+			return false;
+
+		//Remember which version of the file we baked, so we know when to bake it again.
+		ClipSource source;
+		ClipSource::FromFile(filename, source);
+
+		std::vector<uint8_t> baked = CompressedClip::Bake(anim, settings, source);
+
+		if (!CompressedClip::Save(baked, outFilename))
+		{
+			printf("Failed to write compressed clip %s.\n", outFilename.c_str());
+			return false;
+		}
+
+		//Compare against what the keys take up at full precision.
+		size_t fullSize = 0;
+		for (const JointAnim& joint : anim.data)
+		{
+			fullSize += joint.posFrames * (sizeof(float) + sizeof(glm::vec3));
+			fullSize += joint.rotFrames * (sizeof(float) + sizeof(glm::quat));
+		}
+
+		printf("Baked %s to %s (%zu bytes -> %zu bytes).\n", filename.c_str(),
+			   outFilename.c_str(), fullSize, baked.size());
+
+		return true;
+	}
+
+	bool LoadCompressedAnimation(const std::string& filename, SkeletalAnim& anim,
+								 const std::string& sourceFilename,
+								 const ClipCompressionSettings& settings)
+	{
+		std::shared_ptr<CompressedClip> clip = CompressedClip::LoadFromFile(filename);
+
+		if (clip == nullptr)
+			return false;
+
+		if (!sourceFilename.empty())
+		{
+			ClipSource source;
+
+			//If the source is missing we keep using the baked clip - it's all we've got.
+			if (ClipSource::FromFile(sourceFilename, source) && !clip->IsUpToDate(source, settings))
+			{
+				printf("Compressed clip %s is out of date with %s.\n", filename.c_str(), sourceFilename.c_str());
+				return false;
+			}
+		}
+
+		anim.SetCompressed(clip);
+		printf("Loaded compressed animation clip from %s.\n", filename.c_str());
+
+		return true;
+	}
+
 	bool ExtractSkeleton(const tinygltf::Model& gltf, SkinnedMesh& mesh,
 					     JointIndexLookup& jointLookup,
 					     std::string& err, std::string& warn)
@@ -127,6 +189,7 @@ namespace nou::GLTF
 
 		//Resize our collection of joints to match the skeleton in the file.
 		skeleton.m_joints.resize(skin.joints.size());
+		skeleton.m_parents.assign(skin.joints.size(), -1);
 
 		DataGetter invBindGetter = BuildGetter(gltf, skin.inverseBindMatrices);
 
@@ -139,26 +202,10 @@ namespace nou::GLTF
 			return false;
 		}
 
-		//Find our root node.
-		int root_id = skin.skeleton;
-
-		if (root_id == -1)
-		{
-			//Some converters might not explicitly specify a root.
-			//To make FK work, we need to make an educated guess.
-			warn += "\nFile does not specify a root skeleton node. " \
-				   "Assuming minimum joint index as root.";
-
-			root_id = INT_MAX;
-
-			//We already checked to make sure this container has
-			//at least one element.
-			for (size_t i = 0; i < skin.joints.size(); ++i)
-			{
-				if(skin.joints[i] < root_id)
-					root_id = skin.joints[i];
-			}
-		}
+		//glTF doesn't promise to list parents before their children, so
+		//we put our joints in our own order (see SortJoints) - order[i] is
+		//where our joint i sits in the file's list of joints.
+		std::vector<int> order = SortJoints(gltf);
 
 		glm::mat4 jointMat = glm::mat4();
 		glm::vec3 jointScale;
@@ -166,24 +213,19 @@ namespace nou::GLTF
 		glm::vec4 jointPersp;
 		
 		//Grab all the joint transform data for our skeleton.
-		for (size_t i = 0; i < skin.joints.size(); ++i)
+		for (size_t i = 0; i < order.size(); ++i)
 		{
 			//The current joint...
 			Joint& joint = skeleton.m_joints[i];
-			joint.m_owner = &skeleton;
 
-			int j_id = skin.joints[i];
-
-			//If we're the root, set ourselves up as the root.
-			if (j_id == root_id)
-				skeleton.m_rootInd = static_cast<int>(i);
+			int j_id = skin.joints[order[i]];
 
 			//Register our NOU index (i) as corresponding with
 			//the glTF node index (j_id).
 			jointLookup[j_id] = static_cast<int>(i);
 
 			//The node representing our joint in the glTF hierarchy...
-			const tinygltf::Node& node = gltf.nodes[skin.joints[i]];
+			const tinygltf::Node& node = gltf.nodes[j_id];
 			joint.m_name = node.name;
 
 			//If the glTF file specifies position/rotation separately...
@@ -193,8 +235,6 @@ namespace nou::GLTF
 					static_cast<float>(node.translation[1]),
 					static_cast<float>(node.translation[2]));
 
-				joint.m_pos = joint.m_basePos;
-
 				//VERY IMPORTANT: glTF will specify quaternions in XYZW order.
 				//GLM specifies quaternions in WXYZ order.
 				//Any time a quaternion is "translated" into GLM, make sure to 
@@ -203,8 +243,6 @@ namespace nou::GLTF
 					static_cast<float>(node.rotation[0]),
 					static_cast<float>(node.rotation[1]),
 					static_cast<float>(node.rotation[2]));
-
-				joint.m_rotation = joint.m_baseRotation;
 			}
 			else if (node.matrix.size() == 16)
 			{
@@ -223,9 +261,6 @@ namespace nou::GLTF
 				glm::decompose(jointMat, jointScale,
 							   joint.m_baseRotation, joint.m_basePos,
 							   jointSkew, jointPersp);
-
-				joint.m_rotation = joint.m_baseRotation;
-				joint.m_pos = joint.m_basePos;
 			}
 			else
 			{
@@ -237,20 +272,15 @@ namespace nou::GLTF
 			}
 
 			memcpy(&joint.m_invBind,
-				   &invBindGetter.data[i * invBindGetter.stride],
+				   &invBindGetter.data[order[i] * invBindGetter.stride],
 				   16 * sizeof(GLfloat));
 		}
 
 		//Set up the parent-child relationship between all our joints.
-		for (size_t i = 0; i < skin.joints.size(); ++i)
+		for (size_t i = 0; i < order.size(); ++i)
 		{
-			int j_id = skin.joints[i];
-
-			//Our current joint...
-			Joint& joint = skeleton[jointLookup[j_id]];
-
 			//Which node represents our joint in the glTF file...
-			const tinygltf::Node& node = gltf.nodes[j_id];
+			const tinygltf::Node& node = gltf.nodes[skin.joints[order[i]]];
 
 			//node.children contains glTF IDs for the joints
 			//that should be "under" our current joint in the hierarchy.
@@ -258,17 +288,13 @@ namespace nou::GLTF
 			{
 				auto it = jointLookup.find(node.children[j]);
 
+				//Set up ourselves as the parent of the current child node.
 				if (it != jointLookup.end())
-				{
-					//Set up ourselves as a parent of the current child node.
-					skeleton[it->second].m_parent = true;
-					skeleton[it->second].m_parentInd = jointLookup[j_id];
-					//Add the current child node to our list of children.
-					joint.m_childrenInd.push_back(it->second);
-				}
+					skeleton.m_parents[it->second] = static_cast<int>(i);
 			}
 		}
 
+		skeleton.ResetToBasePose();
 		skeleton.DoFK();
 		return true;
 	}
@@ -291,15 +317,81 @@ namespace nou::GLTF
 			return false;
 		}
 
-		for (size_t i = 0; i < skin.joints.size(); ++i)
+		//Use the same order as ExtractSkeleton, so animations line up with our skeletons.
+		std::vector<int> order = SortJoints(gltf);
+
+		for (size_t i = 0; i < order.size(); ++i)
 		{
-			int j_id = skin.joints[i];
+			int j_id = skin.joints[order[i]];
 			jointLookup[j_id] = static_cast<int>(i);
 		}
 
 		return true;
 	}
 
+	std::vector<int> SortJoints(const tinygltf::Model& gltf)
+	{
+		std::vector<int> order;
+
+		if (gltf.skins.size() == 0)
+			return order;
+
+		const tinygltf::Skin& skin = gltf.skins[0];
+
+		//Where each glTF node sits in the skin's list of joints.
+		std::map<int, int> skinLookup;
+		for (size_t i = 0; i < skin.joints.size(); ++i)
+			skinLookup[skin.joints[i]] = static_cast<int>(i);
+
+		//Any joint that isn't a child of another joint is a root.
+		std::vector<bool> hasParent(skin.joints.size(), false);
+		for (size_t i = 0; i < skin.joints.size(); ++i)
+		{
+			for (int child : gltf.nodes[skin.joints[i]].children)
+			{
+				auto it = skinLookup.find(child);
+				if (it != skinLookup.end())
+					hasParent[it->second] = true;
+			}
+		}
+
+		//Walk down from each root depth-first, so each joint's
+		//children end up close behind it.
+		std::vector<int> stack;
+		for (size_t i = skin.joints.size(); i > 0; --i)
+		{
+			if (!hasParent[i - 1])
+				stack.push_back(static_cast<int>(i - 1));
+		}
+
+		std::vector<bool> visited(skin.joints.size(), false);
+		order.reserve(skin.joints.size());
+
+		while (!stack.empty())
+		{
+			int joint = stack.back();
+			stack.pop_back();
+
+			//(A badly formed file could list a joint under two parents.)
+			if (visited[joint])
+				continue;
+
+			visited[joint] = true;
+			order.push_back(joint);
+
+			//Push children in reverse so they come off the stack in their original order.
+			const std::vector<int>& children = gltf.nodes[skin.joints[joint]].children;
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+			{
+				auto found = skinLookup.find(*it);
+				if (found != skinLookup.end())
+					stack.push_back(found->second);
+			}
+		}
+
+		return order;
+	}
+
 	bool ExtractSkinWeights(const tinygltf::Model& gltf, SkinnedMesh& mesh, 
 						    std::string& err, std::string& warn)
 	{
@@ -358,6 +450,15 @@ namespace nou::GLTF
 			return false;
 		}
 
+		//Our joints aren't in the same order as the file's (see SortJoints),
+		//so we need to know where each of the file's joints ended up.
+		std::vector<int> order = SortJoints(gltf);
+		std::vector<float> remap(order.size(), 0.0f);
+		for (size_t i = 0; i < order.size(); ++i)
+			remap[order[i]] = static_cast<float>(i);
+
+		auto toNOU = [&remap](GLushort j) { return (j < remap.size()) ? remap[j] : 0.0f; };
+
 		std::vector<glm::vec4> influences;
 		std::vector<glm::vec4> weights;
 
@@ -381,10 +482,9 @@ namespace nou::GLTF
 			//Note: glTF appears to "switch" between how joints are indexed
 			//when it comes to skin weights - the joint IDs will match
 			//the ORDER of nodes in the skeleton definition, rather than the
-			//IDENTIFIERS of those nodes. This means we no longer need
-			//to go through our joint lookup to convert the indices - 
-			//they're already following the same convention we use in NOU.
-			influences[i] = glm::vec4(j0, j1, j2, j3);
+			//IDENTIFIERS of those nodes. So rather than our joint lookup,
+			//we just need to map them from the file's order to ours.
+			influences[i] = glm::vec4(toNOU(j0), toNOU(j1), toNOU(j2), toNOU(j3));
 
 			memcpy(&weights[i], &wtGetter.data[face * wtGetter.stride], sizeof(glm::vec4));
 		}
@@ -11,8 +11,10 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 
 #include "SkinnedMesh.h"
 #include "Animation.h"
+#include "CompressedClip.h"
 
 #include <string>
+#include <vector>
 
 //Forward declaration of TinyGLTF classes.
 namespace tinygltf
@@ -43,6 +45,18 @@ namespace nou::GLTF
 	//Grab a joint animation from a glTF file.
 	void LoadAnimation(const std::string& filename, SkeletalAnim& anim);
 
+	//Load a joint animation from a glTF file and save it as a compressed clip (see CompressedClip.h).
+	bool BakeAnimation(const std::string& filename, const std::string& outFilename,
+					   const ClipCompressionSettings& settings = ClipCompressionSettings());
+
+	//Memory map a compressed clip made by BakeAnimation.
+	//Returns false (leaving anim untouched) if the file is missing or invalid.
+	//If sourceFilename is given, also returns false if the clip was baked from an older
+	//version of that file or with different settings (so it should be rebaked).
+	bool LoadCompressedAnimation(const std::string& filename, SkeletalAnim& anim,
+								 const std::string& sourceFilename = "",
+								 const ClipCompressionSettings& settings = ClipCompressionSettings());
+
 	//Extract skeletal data (used by LoadSkinnedMesh).
 	bool ExtractSkeleton(const tinygltf::Model& gltf, SkinnedMesh& mesh, 
 						 JointIndexLookup& jointLookup,
@@ -54,6 +68,10 @@ namespace nou::GLTF
 							JointIndexLookup& jointLookup,
 							std::string& err, std::string& warn);
 
+	//Work out the order our skeletons store joints in - every parent before its
+	//children, as Skeleton::DoFK expects. Returns indices into the skin's list of joints.
+	std::vector<int> SortJoints(const tinygltf::Model& gltf);
+
 	//Extract skin weights (used by LoadSkinnedMesh).
 	bool ExtractSkinWeights(const tinygltf::Model& gltf, SkinnedMesh& mesh, 
 						    std::string& err, std::string& warn);
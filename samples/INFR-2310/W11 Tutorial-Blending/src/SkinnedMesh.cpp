@@ -8,105 +8,106 @@ Basic classes for managing the data associated with a skinned 3D model.
 
 #include "SkinnedMesh.h"
 
-#include "GLM/gtx/transform.hpp"
-
 namespace nou
 {
-	Joint::Joint(Skeleton* owner)
+	Joint::Joint()
 	{
 		m_name = "NULL";
-		m_owner = owner;
 
-		m_global = glm::mat4(1.0f);
-		m_pos = glm::vec3(0.0f, 0.0f, 0.0f);
-		m_basePos = m_pos;
-		m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
-		m_baseRotation = m_baseRotation;
+		m_basePos = glm::vec3(0.0f, 0.0f, 0.0f);
+		m_baseRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 		m_invBind = glm::mat4(1.0f);
+	}
 
-		m_parent = false;
-		m_parentInd = 0;
+	Skeleton::Skeleton()
+	{
 	}
 
-	//Copy a joint's data to a new skeleton.
-	Joint::Joint(Skeleton* owner, const Joint& other)
+	void Skeleton::ResetToBasePose()
 	{
-		m_name = other.m_name;
-		m_owner = owner;
+		size_t numJoints = m_joints.size();
 
-		m_global = other.m_global;
-		m_pos = other.m_pos;
-		m_basePos = other.m_basePos;
-		m_rotation = other.m_rotation;
-		m_baseRotation = other.m_baseRotation;
-		m_invBind = other.m_invBind;
+		//Any joint we weren't told the parent of is treated as a root.
+		m_parents.resize(numJoints, -1);
 
-		m_parent = other.m_parent;
-		m_parentInd = other.m_parentInd;
+		m_posX.resize(numJoints);
+		m_posY.resize(numJoints);
+		m_posZ.resize(numJoints);
+		m_rotX.resize(numJoints);
+		m_rotY.resize(numJoints);
+		m_rotZ.resize(numJoints);
+		m_rotW.resize(numJoints);
+		m_global.resize(numJoints);
 
-		m_childrenInd = other.m_childrenInd;
+		for (size_t i = 0; i < numJoints; ++i)
+		{
+			const Joint& joint = m_joints[i];
+
+			m_posX[i] = joint.m_basePos.x;
+			m_posY[i] = joint.m_basePos.y;
+			m_posZ[i] = joint.m_basePos.z;
+			m_rotX[i] = joint.m_baseRotation.x;
+			m_rotY[i] = joint.m_baseRotation.y;
+			m_rotZ[i] = joint.m_baseRotation.z;
+			m_rotW[i] = joint.m_baseRotation.w;
+		}
 	}
 
 	//Forward kinematics.
-	void Joint::DoFK()
+	void Skeleton::DoFK()
 	{
-		//If we don't have a skeleton, something is wrong.
-		if(m_owner == nullptr)
-			return;
-
-		//Local transform...
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(glm::normalize(m_rotation));
-
-		//If we have a parent, get its global transform
-		//and concatenate with our local transform to get
-		//our own global transform.
-		if (m_parent)
-			m_global = (*m_owner)[m_parentInd].m_global * local;
-		else
-			m_global = local;
-
-		//Repeat the process for our child joints.
-		for (auto childInd : m_childrenInd)
+		const size_t numJoints = m_global.size();
+
+		//One pass, first joint to last. Each step only reads the local pose arrays
+		//in order and a parent's global transform we've already computed -
+		//no recursion and no jumping around in memory.
+		for (size_t i = 0; i < numJoints; ++i)
 		{
-			(*m_owner)[childInd].DoFK();
+			float x = m_rotX[i];
+			float y = m_rotY[i];
+			float z = m_rotZ[i];
+			float w = m_rotW[i];
+
+			//Quaternion to rotation matrix. Scaling by 2 / length squared
+			//normalizes the quaternion at the same time.
+			float lenSq = x * x + y * y + z * z + w * w;
+			float s = (lenSq > 0.0f) ? 2.0f / lenSq : 0.0f;
+
+			float xx = x * x * s, yy = y * y * s, zz = z * z * s;
+			float xy = x * y * s, xz = x * z * s, yz = y * z * s;
+			float wx = w * x * s, wy = w * y * s, wz = w * z * s;
+
+			//Local transform (translation * rotation).
+			glm::mat4 local(1.0f - (yy + zz), xy + wz, xz - wy, 0.0f,
+							xy - wz, 1.0f - (xx + zz), yz + wx, 0.0f,
+							xz + wy, yz - wx, 1.0f - (xx + yy), 0.0f,
+							m_posX[i], m_posY[i], m_posZ[i], 1.0f);
+
+			//If we have a parent, concatenate its global transform
+			//with our local transform to get our own global transform.
+			int parent = m_parents[i];
+
+			if (parent >= 0)
+				m_global[i] = m_global[parent] * local;
+			else
+				m_global[i] = local;
 		}
 	}
 
-	Skeleton::Skeleton()
+	Joint& Skeleton::operator[](int index)
 	{
-		m_rootInd = 0;
+		return m_joints[index];
 	}
 
-	//To copy a skeleton.
-	Skeleton& Skeleton::operator=(const Skeleton& other)
+	int Skeleton::FindJoint(const std::string& name) const
 	{
-		if (&other != this)
+		for (size_t i = 0; i < m_joints.size(); ++i)
 		{
-			m_joints.resize(other.m_joints.size());
-
-			for (size_t i = 0; i < m_joints.size(); ++i)
-			{
-				m_joints[i] = Joint(this, other.m_joints[i]);
-			}
-
-			m_rootInd = other.m_rootInd;
+			if (m_joints[i].m_name == name)
+				return static_cast<int>(i);
 		}
 
-		return *this;
-	}
-
-	//Forward kinematics.
-	void Skeleton::DoFK()
-	{
-		//Since FK is recursive, we just call it on the root joint.
-		if (m_rootInd < m_joints.size())
-			m_joints[m_rootInd].DoFK();
-	}
-
-	Joint& Skeleton::operator[](int index)
-	{
-		return m_joints[index];
+		return -1;
 	}
 
 	void SkinnedMesh::SetJointInfluences(const std::vector<glm::vec4>& jointInfluences)
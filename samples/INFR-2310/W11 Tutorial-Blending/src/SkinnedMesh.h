@@ -11,53 +11,34 @@ Basic classes for managing the data associated with a skinned 3D model.
 #include "NOU/Mesh.h"
 #include "NOU/Transform.h"
 
+#include <string>
 #include <vector>
 
 namespace nou
 {
-	class Skeleton;
-
+	//The data for a joint that doesn't change as we animate.
+	//(The animated pose lives in the Skeleton, in flat arrays.)
 	class Joint
 	{
 		public:
 
-		Joint(Skeleton* owner = nullptr);
-
-		//We have this constructor for making a copy of
-		//a skeleton - e.g., every instance
-		//of a skinned mesh renderer needs its own copy
-		//of skeletal data for animation.
-		Joint(Skeleton* owner, const Joint& other);
+		Joint();
 		~Joint() = default;
 
-		//Forward kinematics.
-		void DoFK();
-
-		Skeleton* m_owner;
 		std::string m_name;
 
-		//Global transformation matrix.
-		glm::mat4 m_global;
-		//Local position.
-		glm::vec3 m_pos;
 		//Local position in base pose.
 		glm::vec3 m_basePos;
-		//Local rotation.
-		glm::quat m_rotation;
 		//Local rotation in base pose.
 		glm::quat m_baseRotation;
 		//Inverse bind matrix.
 		glm::mat4 m_invBind;
-
-		//Do we have a parent?
-		bool m_parent;
-		//What is the index of our parent in the skeleton's list of joints?
-		int m_parentInd;
-
-		//What are the indices of our children in the skeleton's list of joints?
-		std::vector<int> m_childrenInd;
 	};
 
+	//A skeleton stored as flat arrays rather than a tree of joints.
+	//Joints are sorted so that every parent comes before its children - that
+	//way forward kinematics is a single loop from the first joint to the last,
+	//since by the time we reach a joint its parent is always already done.
 	class Skeleton
 	{
 		public:
@@ -65,18 +46,30 @@ namespace nou
 		Skeleton();
 		~Skeleton() = default;
 
-		//To copy our skeleton.
-		Skeleton& operator=(const Skeleton& other);
+		//Size our pose arrays to match m_joints, and put every joint in its base pose.
+		//(Call this after filling in m_joints and m_parents.)
+		void ResetToBasePose();
 
 		//Forward kinematics.
 		void DoFK();
 		//To quickly grab a joint by its index.
 		Joint& operator[](int index);
+		//Find a joint's index by name (-1 if there isn't one).
+		int FindJoint(const std::string& name) const;
 
-		//The root joint.
-		int m_rootInd;
 		//Our set of joints.
 		std::vector<Joint> m_joints;
+		//The index of each joint's parent (-1 for a root).
+		//A parent's index is always less than its children's.
+		std::vector<int> m_parents;
+
+		//The local pose of each joint, one array per component
+		//(this is what the animation system writes to).
+		std::vector<float> m_posX, m_posY, m_posZ;
+		std::vector<float> m_rotX, m_rotY, m_rotZ, m_rotW;
+
+		//Global transformation matrix of each joint (the output of FK).
+		std::vector<glm::mat4> m_global;
 	};
 
 	class SkinnedMesh : public Mesh
@@ -0,0 +1,150 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+SkinnedMeshBatcher.cpp
+Collects every skinned mesh drawn in a frame and draws them as crowds.
+*/
+
+#include "SkinnedMeshBatcher.h"
+#include "NOU/CCamera.h"
+#include "NOU/Shader.h"
+
+#include <algorithm>
+
+namespace nou
+{
+	std::vector<SkinnedMeshBatcher::DrawItem> SkinnedMeshBatcher::m_items;
+	std::vector<glm::mat4> SkinnedMeshBatcher::m_palette;
+	std::vector<SkinnedMeshBatcher::InstanceData> SkinnedMeshBatcher::m_instances;
+	std::vector<size_t> SkinnedMeshBatcher::m_order;
+
+	GLuint SkinnedMeshBatcher::m_paletteBuffer = 0;
+	GLuint SkinnedMeshBatcher::m_instanceBuffer = 0;
+	size_t SkinnedMeshBatcher::m_drawCount = 0;
+
+	void SkinnedMeshBatcher::Submit(const void* meshKey, VertexArray& vao, Material& mat,
+									const glm::mat4& model, const glm::mat3& normal,
+									const std::vector<glm::mat4>& jointMatrices)
+	{
+		DrawItem item;
+		item.meshKey = meshKey;
+		item.vao = &vao;
+		item.mat = &mat;
+		item.instance.model = model;
+		item.instance.normal = glm::mat4(normal);
+
+		//Our joints go on the end of the palette - the shader
+		//just needs to know where they start.
+		item.instance.palette = glm::uvec4((GLuint)m_palette.size(), 0, 0, 0);
+		m_palette.insert(m_palette.end(), jointMatrices.begin(), jointMatrices.end());
+
+		m_items.push_back(item);
+	}
+
+	void SkinnedMeshBatcher::Flush()
+	{
+		m_drawCount = 0;
+
+		if (m_items.empty())
+			return;
+
+		if (m_paletteBuffer == 0)
+			CreateBuffers();
+
+		//Sort our characters so those with the same mesh and material end up next to each other.
+		//(Their order in the buffer is what lets us draw each group with one call.)
+		m_order.resize(m_items.size());
+		for (size_t i = 0; i < m_order.size(); ++i)
+			m_order[i] = i;
+
+		std::sort(m_order.begin(), m_order.end(), [](size_t a, size_t b)
+		{
+			const DrawItem& itemA = m_items[a];
+			const DrawItem& itemB = m_items[b];
+
+			if (itemA.meshKey != itemB.meshKey)
+				return std::less<const void*>()(itemA.meshKey, itemB.meshKey);
+			if (itemA.mat != itemB.mat)
+				return std::less<const Material*>()(itemA.mat, itemB.mat);
+			return a < b;
+		});
+
+		m_instances.resize(m_items.size());
+		for (size_t i = 0; i < m_order.size(); ++i)
+			m_instances[i] = m_items[m_order[i]].instance;
+
+		//Everything for the frame goes up to the GPU in two uploads, no matter how many characters we have.
+		Upload(m_paletteBuffer, PALETTE_BINDING, m_palette.data(), m_palette.size() * sizeof(glm::mat4));
+		Upload(m_instanceBuffer, INSTANCE_BINDING, m_instances.data(), m_instances.size() * sizeof(InstanceData));
+
+		const glm::mat4& viewProj = CCamera::current->Get<CCamera>().GetVP();
+
+		//Now draw each group of characters that share a mesh and material.
+		size_t groupStart = 0;
+		while (groupStart < m_order.size())
+		{
+			const DrawItem& first = m_items[m_order[groupStart]];
+
+			size_t groupEnd = groupStart + 1;
+			while (groupEnd < m_order.size() &&
+				   m_items[m_order[groupEnd]].meshKey == first.meshKey &&
+				   m_items[m_order[groupEnd]].mat == first.mat)
+			{
+				++groupEnd;
+			}
+
+			first.mat->Use();
+
+			//The shader adds this to gl_InstanceID to find where this group's characters start in the instance buffer.
+			ShaderProgram::Current()->SetUniform("viewproj", viewProj);
+			ShaderProgram::Current()->SetUniform("instanceOffset", (int)groupStart);
+
+			//Every character with this mesh has identical vertex data, so any of their VAOs will do.
+			first.vao->DrawInstanced((GLsizei)(groupEnd - groupStart));
+			++m_drawCount;
+
+			groupStart = groupEnd;
+		}
+
+		//And clear everything out for the next frame.
+		m_items.clear();
+		m_palette.clear();
+	}
+
+	void SkinnedMeshBatcher::Cleanup()
+	{
+		if (m_paletteBuffer != 0)
+		{
+			glDeleteBuffers(1, &m_paletteBuffer);
+			glDeleteBuffers(1, &m_instanceBuffer);
+			m_paletteBuffer = 0;
+			m_instanceBuffer = 0;
+		}
+
+		m_items.clear();
+		m_palette.clear();
+		m_instances.clear();
+	}
+
+	size_t SkinnedMeshBatcher::GetDrawCount()
+	{
+		return m_drawCount;
+	}
+
+	void SkinnedMeshBatcher::CreateBuffers()
+	{
+		glGenBuffers(1, &m_paletteBuffer);
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	void SkinnedMeshBatcher::Upload(GLuint buffer, GLuint binding, const void* data, size_t size)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		//Calling glBufferData every frame "orphans" the old storage - if the GPU is still
+		//drawing with last frame's data, the driver gives us fresh memory instead of making us wait.
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_STREAM_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
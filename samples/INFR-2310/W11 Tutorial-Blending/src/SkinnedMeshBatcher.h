@@ -0,0 +1,85 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+SkinnedMeshBatcher.h
+Collects every skinned mesh drawn in a frame and draws them as crowds.
+
+Rather than sending each character's joint matrices as a uniform array
+and drawing characters one at a time, every character's joints are
+written into one big shader storage buffer (SSBO) each frame.
+Characters that share a mesh and material are then drawn with a single
+instanced draw call, and the shader uses the instance ID to find the
+right model matrix and the right set of joints.
+*/
+
+#pragma once
+
+#include "NOU/GLObjects.h"
+#include "NOU/Material.h"
+
+#include "GLM/glm.hpp"
+
+#include <vector>
+
+namespace nou
+{
+	class SkinnedMeshBatcher
+	{
+		public:
+
+		//The binding points our shader expects the buffers at.
+		static const GLuint PALETTE_BINDING = 0;
+		static const GLuint INSTANCE_BINDING = 1;
+
+		//Queues a character to be drawn this frame.
+		//meshKey should be the same for every character using the same mesh
+		//(we just use the address of the mesh), since those are the ones we can draw together.
+		static void Submit(const void* meshKey, VertexArray& vao, Material& mat,
+						   const glm::mat4& model, const glm::mat3& normal,
+						   const std::vector<glm::mat4>& jointMatrices);
+
+		//Uploads everything submitted this frame and draws it.
+		//Should be called once per frame after all the skinned meshes have been submitted.
+		static void Flush();
+
+		//Deletes our buffers - should be called before the OpenGL context goes away.
+		static void Cleanup();
+
+		//How many draw calls the last flush took (handy for seeing the batching work).
+		static size_t GetDrawCount();
+
+		protected:
+
+		//The per-character data the shader reads, laid out to match std430 rules.
+		//(A mat3 gets padded out to 3 vec4 columns on the GPU, so we just store a mat4.)
+		struct InstanceData
+		{
+			glm::mat4 model;
+			glm::mat4 normal;
+			//x = the index of the character's first joint matrix in the palette buffer.
+			glm::uvec4 palette;
+		};
+
+		//A character waiting to be drawn.
+		struct DrawItem
+		{
+			const void* meshKey;
+			VertexArray* vao;
+			Material* mat;
+			InstanceData instance;
+		};
+
+		static void CreateBuffers();
+		static void Upload(GLuint buffer, GLuint binding, const void* data, size_t size);
+
+		static std::vector<DrawItem> m_items;
+		static std::vector<glm::mat4> m_palette;
+		static std::vector<InstanceData> m_instances;
+		static std::vector<size_t> m_order;
+
+		static GLuint m_paletteBuffer;
+		static GLuint m_instanceBuffer;
+		static size_t m_drawCount;
+	};
+}
@@ -11,6 +11,7 @@ Week 11 Tutorial Sample - Created for INFR 2310 at Ontario Tech.
 #include "NOU/GLTFLoader.h"
 
 #include "CSkinnedMeshRenderer.h"
+#include "SkinnedMeshBatcher.h"
 #include "CAnimator.h"
 #include "GLTFLoaderSkinning.h"
 
@@ -19,6 +20,7 @@ Week 11 Tutorial Sample - Created for INFR 2310 at Ontario Tech.
 #include "imgui.h"
 
 #include <memory>
+#include <vector>
 
 using namespace nou;
 
@@ -63,17 +65,29 @@ int main()
 	auto idleAnim = std::make_unique<SkeletalAnim>();
 	auto headAnim = std::make_unique<SkeletalAnim>();
 	
-	GLTF::LoadAnimation("models/boi/Idle.gltf", *(idleAnim.get()));
+	//Our idle clip gets baked into the compressed format the first time we run
+	//(or whenever the glTF file changes), and from then on we just memory map the baked file.
+	if (!GLTF::LoadCompressedAnimation("models/boi/Idle.nouanim", *idleAnim, "models/boi/Idle.gltf"))
+	{
+		if (!GLTF::BakeAnimation("models/boi/Idle.gltf", "models/boi/Idle.nouanim") ||
+			!GLTF::LoadCompressedAnimation("models/boi/Idle.nouanim", *idleAnim))
+		{
+			GLTF::LoadAnimation("models/boi/Idle.gltf", *(idleAnim.get()));
+		}
+	}
+
 	GLTF::LoadAnimation("models/boi/HeadShake.gltf", *(headAnim.get()));
 
 	//We only want the movement of the head joint for our diff clip.
 	//(Mixamo's head shake animation has arms at the side - so we'd be overrotating
 	//our arms if we tried to use it "naked" as a diff clip.)
-	//(I just figured out which joint the head was via autos when loading
-	//the mesh - yes, this is hacky. If you're using a clip for
+	//(We look the head up by name since our skeletons sort their joints -
+	//yes, this is still hacky. If you're using a clip for
 	//additive blending, you'd generally clean this up in Blender/animation software.)
-	headAnim->Keep({13});
+	headAnim->Keep({ boiMesh->m_skeleton.FindJoint("mixamorig:Head") });
 	headAnim->MakeDiffWith(boiMesh->m_skeleton);
+	//Once it's cleaned up we can compress it too - no file needed.
+	headAnim->SetCompressed(CompressedClip::FromMemory(CompressedClip::Bake(*headAnim)));
 	 
 	//Make our camera...
 	Entity camEntity = Entity::Create();
@@ -100,6 +114,35 @@ int main()
 	jointEntity.transform.SetParent(&(boiEntity.transform));
 	jointEntity.transform.m_scale = glm::vec3(0.05f, 0.05f, 0.05f);
 	
+	//Make a crowd of extra bois standing behind the first one.
+	//Since they all share a mesh and material, the SkinnedMeshBatcher
+	//draws the whole crowd with a single instanced draw call.
+	const int crowdWidth = 10;
+	const int crowdDepth = 10;
+	const float crowdSpacing = 0.6f;
+	std::vector<std::unique_ptr<Entity>> crowd;
+	std::vector<CAnimator*> crowdAnimators;
+
+	for (int x = 0; x < crowdWidth; ++x)
+	{
+		for (int z = 0; z < crowdDepth; ++z)
+		{
+			std::unique_ptr<Entity> member = Entity::Allocate();
+			member->Add<CSkinnedMeshRenderer>(*member, *boiMesh, boiMat);
+			member->transform.m_pos = glm::vec3((x - (crowdWidth - 1) * 0.5f) * crowdSpacing, -0.75f, -2.0f - z * crowdSpacing);
+			member->transform.m_scale = glm::vec3(0.5f, 0.5f, 0.5f);
+			member->transform.RecomputeGlobal();
+
+			auto& animator = member->Add<CAnimator>(*member);
+			animator.GetBlendtree()->Insert(*idleAnim);
+			//Start everyone at a different point in the animation so the crowd isn't perfectly in sync.
+			animator.Update((x * crowdDepth + z) * 0.13f);
+
+			crowdAnimators.push_back(&animator);
+			crowd.push_back(std::move(member));
+		}
+	}
+
 	//To spin our boi every frame. 
 	float anglePerSecond = 30.0f;
 
@@ -122,6 +165,20 @@ int main()
 		boiEntity.Get<CAnimator>().Update(deltaTime);
 		boiEntity.Get<CSkinnedMeshRenderer>().Draw();
 
+		static bool showCrowd = false;
+
+		if (showCrowd)
+		{
+			//Animate the whole crowd across every core, then queue them all up to draw.
+			CAnimator::UpdateAll(crowdAnimators, deltaTime);
+
+			for (auto& member : crowd)
+				member->Get<CSkinnedMeshRenderer>().Draw();
+		}
+
+		//Skinned meshes only get queued up when we call Draw() - this actually draws them.
+		SkinnedMeshBatcher::Flush();
+
 		//As a debug utility/demo: Draw our joints.
 		glDisable(GL_DEPTH_TEST); 
 
@@ -132,9 +189,9 @@ int main()
 
 		const Skeleton& skeleton = boiEntity.Get<CSkinnedMeshRenderer>().GetSkeleton();
 
-		for (auto& joint : skeleton.m_joints)
+		for (auto& global : skeleton.m_global)
 		{
-			glm::decompose(joint.m_global,
+			glm::decompose(global,
 						   scale,
 						   jointTransform.m_rotation,
 						   jointTransform.m_pos,
@@ -156,6 +213,9 @@ int main()
 		ImGui::SliderFloat("Head Shake", &addParam, 0.0f, 1.0f);
 		addNode->SetBlendParam(addParam);
 
+		ImGui::Checkbox("Show Crowd", &showCrowd);
+		ImGui::Text("Skinned draw calls: %d", (int)SkinnedMeshBatcher::GetDrawCount());
+
 		ImGui::End();
 
 		App::EndImgui();
@@ -163,6 +223,9 @@ int main()
 		App::SwapBuffers();
 	}
 
+	crowd.clear();
+	SkinnedMeshBatcher::Cleanup();
+
 	App::Cleanup();
 
 	return 0;